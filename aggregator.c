@@ -0,0 +1,86 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Agregador
+/ Descrição: Baldes horários/diários alinhados ao epoch com estatísticas de temperatura e tempo de porta aberta.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <string.h>
+#include "aggregator.h"
+
+static void bucket_reset(aggregator_t *agg, uint32_t start, bool partial) {
+    agg->start = start;
+    agg->partial = partial;
+    agg->temp_min = 0.0f;
+    agg->temp_max = 0.0f;
+    agg->temp_sum = 0.0;
+    agg->temp_count = 0;
+    agg->door_open_ms = 0;
+    // Uma porta que atravessa a virada conta como aberta no novo balde, sem nova abertura
+    agg->door_openings = 0;
+    agg->open = true;
+}
+
+void aggregator_init(aggregator_t *agg, uint32_t period_s) {
+    memset(agg, 0, sizeof(*agg));
+    agg->period_s = period_s;
+}
+
+void aggregator_add_temperature(aggregator_t *agg, float temperature) {
+    if (!agg->open) {
+        return;
+    }
+    if (agg->temp_count == 0 || temperature < agg->temp_min) {
+        agg->temp_min = temperature;
+    }
+    if (agg->temp_count == 0 || temperature > agg->temp_max) {
+        agg->temp_max = temperature;
+    }
+    agg->temp_sum += temperature;
+    agg->temp_count++;
+}
+
+static void accumulate_door(aggregator_t *agg, uint32_t now_ms) {
+    if (agg->open && agg->door_open) {
+        agg->door_open_ms += now_ms - agg->last_tick_ms;
+    }
+    agg->last_tick_ms = now_ms;
+}
+
+void aggregator_set_door(aggregator_t *agg, bool open, uint32_t now_ms) {
+    accumulate_door(agg, now_ms);
+    if (open && !agg->door_open && agg->open) {
+        agg->door_openings++;
+    }
+    agg->door_open = open;
+}
+
+bool aggregator_tick(aggregator_t *agg, uint32_t epoch_s, uint32_t now_ms, agg_summary_t *summary) {
+    accumulate_door(agg, now_ms);
+    if (epoch_s == 0) {
+        return false;  // sem hora sincronizada não há como alinhar os baldes
+    }
+
+    uint32_t aligned = epoch_s - (epoch_s % agg->period_s);
+    if (!agg->open) {
+        bucket_reset(agg, aligned, epoch_s != aligned);
+        return false;
+    }
+    if (aligned == agg->start) {
+        return false;
+    }
+
+    summary->start = agg->start;
+    summary->period_s = agg->period_s;
+    summary->temp_min = agg->temp_min;
+    summary->temp_max = agg->temp_max;
+    summary->temp_avg = agg->temp_count ? (float)(agg->temp_sum / agg->temp_count) : 0.0f;
+    summary->temp_count = agg->temp_count;
+    summary->door_open_ms = agg->door_open_ms;
+    summary->door_openings = agg->door_openings;
+    // Virada normal: o novo balde começa agora. Um salto do SNTP corta o balde fechado e
+    // abre o novo no meio do período.
+    bool contiguous = aligned == agg->start + agg->period_s;
+    summary->partial = agg->partial || !contiguous;
+
+    bucket_reset(agg, aligned, !contiguous && epoch_s != aligned);
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef AGGREGATOR_H
+#define AGGREGATOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Agregação em baldes alinhados ao relógio (hora cheia, dia UTC): temperatura
+ * mín/máx/média e minutos de porta aberta, publicados como resumo no fechamento. */
+
+typedef struct {
+    uint32_t start;         // epoch do início do balde
+    uint32_t period_s;
+    float temp_min;
+    float temp_max;
+    float temp_avg;
+    uint32_t temp_count;
+    uint32_t door_open_ms;
+    uint32_t door_openings;
+    bool partial;           // balde aberto no meio do período (boot, 1ª sincronização ou salto do relógio)
+} agg_summary_t;
+
+typedef struct {
+    uint32_t period_s;
+    bool open;
+    uint32_t start;
+    bool partial;
+    float temp_min;
+    float temp_max;
+    double temp_sum;
+    uint32_t temp_count;
+    bool door_open;
+    uint32_t door_open_ms;
+    uint32_t door_openings;
+    uint32_t last_tick_ms;
+} aggregator_t;
+
+void aggregator_init(aggregator_t *agg, uint32_t period_s);
+
+void aggregator_add_temperature(aggregator_t *agg, float temperature);
+
+void aggregator_set_door(aggregator_t *agg, bool open, uint32_t now_ms);
+
+/* Avança o balde com a hora sincronizada (epoch_s = 0 enquanto não sincronizado).
+ * Retorna true ao fechar um balde, preenchendo *summary. O primeiro balde depois da
+ * sincronização, e o que segue um salto do relógio, só cobrem parte do período e saem
+ * com summary->partial. */
+bool aggregator_tick(aggregator_t *agg, uint32_t epoch_s, uint32_t now_ms, agg_summary_t *summary);
+
+#endif /* AGGREGATOR_H */
@@ -0,0 +1,229 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Lista de brokers
+/ Descrição: Failover entre brokers MQTT com rastreamento de saúde por conexão e retorno ao primário via sondagem TCP.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "pico/cyw43_arch.h"
+#include "lwip/dns.h"
+#include "lwip/tcp.h"
+#include "broker_list.h"
+
+typedef enum {
+    PROBE_IDLE,
+    PROBE_RESOLVING,
+    PROBE_CONNECTING,
+    PROBE_HEALTHY,
+    PROBE_FAILED,
+} probe_state_t;
+
+static broker_entry_t brokers[BROKER_LIST_MAX];
+static size_t broker_count = 0;
+static size_t current_index = 0;
+static uint16_t broker_port = 0;
+
+static bool in_outage = false;
+static size_t outage_broker = 0;
+static uint32_t outage_start_ms = 0;
+static uint32_t failover_count = 0;
+static uint32_t last_failover_ms = 0;
+
+static volatile probe_state_t probe_state = PROBE_IDLE;
+static struct tcp_pcb *probe_pcb = NULL;
+static ip_addr_t probe_ip;
+static uint32_t probe_started_ms = 0;
+static uint32_t next_probe_ms = 0;
+
+void broker_list_init(const char *brokers_csv, uint16_t port) {
+    memset(brokers, 0, sizeof(brokers));
+    broker_count = 0;
+    current_index = 0;
+    broker_port = port;
+    in_outage = false;
+    outage_broker = 0;
+    outage_start_ms = 0;
+    failover_count = 0;
+    last_failover_ms = 0;
+    probe_state = PROBE_IDLE;
+    probe_pcb = NULL;
+    probe_started_ms = 0;
+    next_probe_ms = 0;
+
+    const char *p = brokers_csv;
+    while (*p != '\0' && broker_count < BROKER_LIST_MAX) {
+        while (*p == ',' || isspace((unsigned char)*p)) {
+            p++;
+        }
+        size_t len = 0;
+        while (p[len] != '\0' && p[len] != ',' && !isspace((unsigned char)p[len])) {
+            len++;
+        }
+        if (len == 0) {
+            break;
+        }
+        if (len < BROKER_HOST_MAX) {
+            memcpy(brokers[broker_count].host, p, len);
+            brokers[broker_count].host[len] = '\0';
+            printf("[BROKER] %u: %s\n", (unsigned)broker_count, brokers[broker_count].host);
+            broker_count++;
+        } else {
+            printf("[BROKER] Nome de broker muito longo, ignorado\n");
+        }
+        p += len;
+    }
+}
+
+size_t broker_list_count(void) {
+    return broker_count;
+}
+
+size_t broker_list_current_index(void) {
+    return current_index;
+}
+
+const char *broker_list_current(void) {
+    return brokers[current_index].host;
+}
+
+const broker_entry_t *broker_list_entry(size_t index) {
+    return index < broker_count ? &brokers[index] : NULL;
+}
+
+void broker_list_report_success(uint32_t now_ms) {
+    broker_entry_t *entry = &brokers[current_index];
+    entry->consecutive_failures = 0;
+    entry->connects++;
+
+    if (in_outage && current_index != outage_broker) {
+        last_failover_ms = now_ms - outage_start_ms;
+        printf("[BROKER] Failover para %s concluído em %u ms\n", entry->host, (unsigned)last_failover_ms);
+    }
+    in_outage = false;
+
+    if (current_index != 0) {
+        next_probe_ms = now_ms + BROKER_PRIMARY_PROBE_MS;
+    }
+}
+
+void broker_list_report_failure(uint32_t now_ms) {
+    broker_entry_t *entry = &brokers[current_index];
+    entry->consecutive_failures++;
+    entry->total_failures++;
+
+    if (!in_outage) {
+        in_outage = true;
+        outage_broker = current_index;
+        outage_start_ms = now_ms;
+    }
+
+    if (entry->consecutive_failures >= BROKER_FAILOVER_THRESHOLD && broker_count > 1) {
+        entry->consecutive_failures = 0;
+        current_index = (current_index + 1) % broker_count;
+        failover_count++;
+        printf("[BROKER] %s falhou %d vezes seguidas, trocando para %s\n",
+               entry->host, BROKER_FAILOVER_THRESHOLD, brokers[current_index].host);
+    }
+}
+
+// Callbacks da sondagem (contexto lwIP)
+static void probe_err_callback(void *arg, err_t err) {
+    probe_pcb = NULL;  // o lwIP já liberou o pcb
+    probe_state = PROBE_FAILED;
+}
+
+static err_t probe_connected_callback(void *arg, struct tcp_pcb *tpcb, err_t err) {
+    probe_pcb = NULL;
+    tcp_err(tpcb, NULL);
+    if (tcp_close(tpcb) != ERR_OK) {
+        tcp_abort(tpcb);
+        probe_state = PROBE_HEALTHY;
+        return ERR_ABRT;
+    }
+    probe_state = PROBE_HEALTHY;
+    return ERR_OK;
+}
+
+static void probe_connect(const ip_addr_t *ipaddr) {
+    probe_pcb = tcp_new();
+    if (probe_pcb == NULL) {
+        probe_state = PROBE_FAILED;
+        return;
+    }
+    tcp_err(probe_pcb, probe_err_callback);
+    probe_state = PROBE_CONNECTING;
+    if (tcp_connect(probe_pcb, ipaddr, broker_port, probe_connected_callback) != ERR_OK) {
+        tcp_abort(probe_pcb);  // dispara probe_err_callback
+    }
+}
+
+static void probe_dns_callback(const char *name, const ip_addr_t *ipaddr, void *callback_arg) {
+    if (probe_state != PROBE_RESOLVING) {
+        return;  // sondagem já expirou
+    }
+    if (ipaddr == NULL) {
+        probe_state = PROBE_FAILED;
+        return;
+    }
+    probe_ip = *ipaddr;
+    probe_connect(&probe_ip);
+}
+
+bool broker_list_poll_primary(uint32_t now_ms) {
+    if (current_index == 0) {
+        return false;
+    }
+
+    switch (probe_state) {
+        case PROBE_IDLE:
+            if ((int32_t)(now_ms - next_probe_ms) >= 0) {
+                printf("[BROKER] Sondando primário %s\n", brokers[0].host);
+                probe_started_ms = now_ms;
+                probe_state = PROBE_RESOLVING;
+                cyw43_arch_lwip_begin();
+                err_t err = dns_gethostbyname(brokers[0].host, &probe_ip, probe_dns_callback, NULL);
+                if (err == ERR_OK) {
+                    probe_connect(&probe_ip);
+                } else if (err != ERR_INPROGRESS) {
+                    probe_state = PROBE_FAILED;
+                }
+                cyw43_arch_lwip_end();
+            }
+            return false;
+
+        case PROBE_RESOLVING:
+        case PROBE_CONNECTING:
+            if (now_ms - probe_started_ms >= BROKER_PROBE_TIMEOUT_MS) {
+                cyw43_arch_lwip_begin();
+                if (probe_pcb != NULL) {
+                    tcp_abort(probe_pcb);
+                }
+                cyw43_arch_lwip_end();
+                probe_state = PROBE_FAILED;
+            }
+            return false;
+
+        case PROBE_HEALTHY:
+            printf("[BROKER] Primário %s saudável, retornando\n", brokers[0].host);
+            probe_state = PROBE_IDLE;
+            brokers[0].consecutive_failures = 0;
+            current_index = 0;
+            return true;
+
+        case PROBE_FAILED:
+        default:
+            printf("[BROKER] Primário %s ainda indisponível\n", brokers[0].host);
+            probe_state = PROBE_IDLE;
+            next_probe_ms = now_ms + BROKER_PRIMARY_PROBE_MS;
+            return false;
+    }
+}
+
+uint32_t broker_list_failovers(void) {
+    return failover_count;
+}
+
+uint32_t broker_list_last_failover_ms(void) {
+    return last_failover_ms;
+}
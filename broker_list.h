@@ -0,0 +1,46 @@
+#ifndef BROKER_LIST_H
+#define BROKER_LIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Lista ordenada de brokers MQTT (MQTT_BROKER="primario,secundario,...", nomes ou IPs).
+ * Acompanha a saúde de cada broker pelas tentativas de conexão, troca para o próximo
+ * após falhas consecutivas e volta ao primário quando uma sondagem TCP indica que ele
+ * está saudável de novo. */
+
+#define BROKER_LIST_MAX            4
+#define BROKER_HOST_MAX            64
+#define BROKER_FAILOVER_THRESHOLD  3        // falhas consecutivas antes de trocar de broker
+#define BROKER_PRIMARY_PROBE_MS    300000   // sondagem do primário enquanto em um secundário
+#define BROKER_PROBE_TIMEOUT_MS    10000
+
+typedef struct {
+    char host[BROKER_HOST_MAX];
+    uint32_t consecutive_failures;
+    uint32_t total_failures;
+    uint32_t connects;
+} broker_entry_t;
+
+void broker_list_init(const char *brokers_csv, uint16_t port);
+
+size_t broker_list_count(void);
+size_t broker_list_current_index(void);
+const char *broker_list_current(void);
+const broker_entry_t *broker_list_entry(size_t index);
+
+// Resultado de uma tentativa de conexão ao broker corrente
+void broker_list_report_success(uint32_t now_ms);
+void broker_list_report_failure(uint32_t now_ms);
+
+/* Sonda periodicamente o primário enquanto conectado a um secundário. Retorna true
+ * uma única vez quando o primário respondeu: o chamador deve desconectar e reconectar. */
+bool broker_list_poll_primary(uint32_t now_ms);
+
+uint32_t broker_list_failovers(void);
+
+// Duração do último failover: do início da indisponibilidade até conectar em outro broker
+uint32_t broker_list_last_failover_ms(void);
+
+#endif /* BROKER_LIST_H */
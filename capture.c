@@ -0,0 +1,154 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Captura disparada
+/ Descrição: Amostragem em alta taxa com janela pré/pós-gatilho em torno de alarmes, enviada em blocos sob demanda.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <math.h>
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "capture.h"
+
+#define CAPTURE_SAMPLES (CAPTURE_PRE_SAMPLES + CAPTURE_POST_SAMPLES)
+
+typedef enum {
+    CAPTURE_ARMED,       // preenchendo o anel de pré-gatilho
+    CAPTURE_TRIGGERED,   // coletando as amostras pós-gatilho
+    CAPTURE_FROZEN,      // janela congelada aguardando envio
+} capture_state_t;
+
+// Compartilhados com o callback do timer (IRQ)
+static uint16_t samples[CAPTURE_SAMPLES];
+static volatile capture_state_t state = CAPTURE_ARMED;
+static volatile uint16_t write_index = 0;
+static volatile uint16_t filled = 0;
+static volatile uint16_t post_remaining = 0;
+
+static repeating_timer_t sample_timer;
+static capture_convert_fn convert_sample;
+static capture_info_t info;
+static uint16_t window_start;
+static uint32_t triggers = 0;
+static uint32_t rejected = 0;
+
+// O canal do ADC (sensor interno) já foi selecionado em main(); leituras no loop desabilitam IRQs
+static bool sample_timer_callback(repeating_timer_t *timer) {
+    if (state == CAPTURE_FROZEN) {
+        return true;
+    }
+
+    samples[write_index] = adc_read();
+    write_index = (write_index + 1) % CAPTURE_SAMPLES;
+    if (filled < CAPTURE_SAMPLES) {
+        filled++;
+    }
+
+    if (state == CAPTURE_TRIGGERED && --post_remaining == 0) {
+        state = CAPTURE_FROZEN;
+    }
+    return true;
+}
+
+void capture_init(capture_convert_fn convert) {
+    convert_sample = convert;
+    state = CAPTURE_ARMED;
+    write_index = 0;
+    filled = 0;
+
+    // Período negativo: intervalo medido entre inícios de callback, sem acumular atraso
+    add_repeating_timer_ms(-(1000 / CAPTURE_RATE_HZ), sample_timer_callback, NULL, &sample_timer);
+}
+
+bool capture_trigger(const char *reason, uint32_t now_ms) {
+    uint32_t irq_state = save_and_disable_interrupts();
+    if (state != CAPTURE_ARMED) {
+        restore_interrupts(irq_state);
+        rejected++;
+        return false;
+    }
+    uint16_t pre = filled < CAPTURE_PRE_SAMPLES ? filled : CAPTURE_PRE_SAMPLES;
+    post_remaining = CAPTURE_POST_SAMPLES;
+    state = CAPTURE_TRIGGERED;
+    restore_interrupts(irq_state);
+
+    triggers++;
+    info.id++;
+    info.reason = reason;
+    info.trigger_ms = now_ms;
+    info.pre_samples = pre;
+    info.total_samples = pre + CAPTURE_POST_SAMPLES;
+    info.chunks = (info.total_samples + CAPTURE_CHUNK_SAMPLES - 1) / CAPTURE_CHUNK_SAMPLES;
+
+    printf("[CAPTURE] Captura %u disparada por '%s' (%u amostras pré-gatilho)\n", info.id, reason, pre);
+    return true;
+}
+
+bool capture_ready(capture_info_t *out) {
+    if (state != CAPTURE_FROZEN) {
+        return false;
+    }
+    // Congelado: o callback não escreve mais no anel
+    window_start = (uint16_t)((write_index + CAPTURE_SAMPLES - info.total_samples) % CAPTURE_SAMPLES);
+    *out = info;
+    return true;
+}
+
+size_t capture_serialize(uint16_t chunk, uint8_t *buf, size_t len) {
+    if (state != CAPTURE_FROZEN || chunk >= info.chunks) {
+        return 0;
+    }
+
+    uint16_t first = chunk * CAPTURE_CHUNK_SAMPLES;
+    uint16_t count = info.total_samples - first;
+    if (count > CAPTURE_CHUNK_SAMPLES) {
+        count = CAPTURE_CHUNK_SAMPLES;
+    }
+    if (len < 4u + 2u * count) {
+        return 0;
+    }
+
+    int16_t centi[CAPTURE_CHUNK_SAMPLES];
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t raw = samples[(window_start + first + i) % CAPTURE_SAMPLES];
+        centi[i] = (int16_t)lroundf(convert_sample(raw) * 100.0f);
+    }
+
+    size_t pos = 0;
+    buf[pos++] = (uint8_t)first;
+    buf[pos++] = (uint8_t)(first >> 8);
+    buf[pos++] = (uint8_t)count;
+
+    ts_encoder_t encoder;
+    ts_encoder_init(&encoder, &buf[pos + 1], len - pos - 1);
+    uint16_t encoded = 0;
+    while (encoded < count && ts_encode(&encoder, centi[encoded])) {
+        encoded++;
+    }
+    if (encoded == count) {
+        buf[pos++] = CAPTURE_ENC_DOD;
+        return pos + ts_encoder_bytes(&encoder);
+    }
+
+    // Trecho ruidoso demais para comprimir dentro do limite: envia as amostras cruas
+    buf[pos++] = CAPTURE_ENC_RAW;
+    for (uint16_t i = 0; i < count; i++) {
+        buf[pos++] = (uint8_t)centi[i];
+        buf[pos++] = (uint8_t)((uint16_t)centi[i] >> 8);
+    }
+    return pos;
+}
+
+void capture_rearm(void) {
+    uint32_t irq_state = save_and_disable_interrupts();
+    filled = 0;   // o pré-gatilho da próxima captura não deve reaproveitar a janela enviada
+    state = CAPTURE_ARMED;
+    restore_interrupts(irq_state);
+}
+
+uint32_t capture_triggers(void) {
+    return triggers;
+}
+
+uint32_t capture_rejected(void) {
+    return rejected;
+}
@@ -0,0 +1,53 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "ts_compress.h"
+
+/* Captura disparada em alta taxa, como o gatilho de um osciloscópio: um timer amostra o ADC
+ * continuamente num anel de pré-gatilho; ao disparar, coleta mais CAPTURE_POST_SAMPLES e
+ * congela a janela até o loop principal enviá-la e rearmar a captura. */
+
+#define CAPTURE_RATE_HZ       10
+#define CAPTURE_PRE_SAMPLES   200    // 20 s antes do gatilho
+#define CAPTURE_POST_SAMPLES  200    // 20 s depois do gatilho
+#define CAPTURE_CHUNK_SAMPLES 56     // amostras por mensagem (cabe em OUTBOX_PAYLOAD_MAX)
+
+// Conversão da leitura bruta do ADC para a unidade publicada (chamada só no envio)
+typedef float (*capture_convert_fn)(uint16_t raw);
+
+typedef struct {
+    uint16_t id;            // incrementa a cada captura disparada
+    const char *reason;
+    uint32_t trigger_ms;    // tempo desde o boot do disparo
+    uint16_t pre_samples;   // amostras anteriores ao gatilho (menos que o máximo logo após o boot)
+    uint16_t total_samples;
+    uint16_t chunks;
+} capture_info_t;
+
+void capture_init(capture_convert_fn convert);
+
+// Dispara a captura; ignorado (retorna false) se já houver uma captura em coleta ou aguardando envio
+bool capture_trigger(const char *reason, uint32_t now_ms);
+
+// Janela congelada, pronta para envio
+bool capture_ready(capture_info_t *info);
+
+// Codificação das amostras de um trecho serializado
+#define CAPTURE_ENC_RAW 0    // i16 little-endian em centésimos
+#define CAPTURE_ENC_DOD 1    // fluxo ts_compress em centésimos
+
+/* Serializa o trecho `chunk` da janela congelada (little-endian: primeira amostra u16,
+ * quantidade u8, codificação u8, amostras). Usa ts_compress e recai para RAW quando o trecho
+ * comprimido não cabe em `len`. Retorna 0 fora da faixa ou se não estiver congelada. */
+size_t capture_serialize(uint16_t chunk, uint8_t *buf, size_t len);
+
+// Libera a janela enviada e volta a preencher o anel de pré-gatilho
+void capture_rearm(void);
+
+uint32_t capture_triggers(void);
+uint32_t capture_rejected(void);
+
+#endif /* CAPTURE_H */
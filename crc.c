@@ -0,0 +1,28 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: CRC
+/ Descrição: Somas de verificação bit a bit (sem tabelas, para poupar flash) usadas na persistência, nos streams e no Modbus RTU.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include "crc.h"
+
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len) {
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (uint32_t)-(int32_t)(crc & 1u));
+        }
+    }
+    return ~crc;
+}
+
+uint16_t crc16_modbus(const uint8_t *data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1u) ? (uint16_t)((crc >> 1) ^ 0xA001u) : (uint16_t)(crc >> 1);
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,13 @@
+#ifndef CRC_H
+#define CRC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// CRC-32 (IEEE 802.3, refletido); encadeável: crc32_update(crc32_update(0, a), b) == CRC de a||b
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len);
+
+// CRC-16/MODBUS (polinômio 0xA001 refletido, início 0xFFFF); vai no quadro RTU com o byte baixo primeiro
+uint16_t crc16_modbus(const uint8_t *data, size_t len);
+
+#endif /* CRC_H */
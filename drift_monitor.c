@@ -0,0 +1,80 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Monitor de deriva
+/ Descrição: Histórico circular dos recursos do firmware para detectar crescimento sem limite em operação prolongada.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <string.h>
+#include "drift_monitor.h"
+
+static const char *const gauge_names[DRIFT_GAUGE_COUNT] = {
+    [DRIFT_OUTBOX_DEPTH] = "outbox_depth",
+    [DRIFT_POOL_IN_USE]  = "pool_in_use",
+    [DRIFT_STACK_CORE0]  = "stack_core0",
+    [DRIFT_LATE_ALLOCS]  = "late_allocs",
+    [DRIFT_MSG_RATE]     = "msg_rate",
+};
+
+static uint32_t history[DRIFT_WINDOW_SAMPLES][DRIFT_GAUGE_COUNT];
+static uint32_t sample_count = 0;
+static uint32_t next_sample_ms = 0;
+static uint32_t drift_flags = 0;
+
+// Verdadeiro se o medidor cresceu estritamente em todas as amostras da janela
+static bool gauge_is_growing(drift_gauge_t gauge) {
+    uint32_t newest = (sample_count - 1) % DRIFT_WINDOW_SAMPLES;
+    for (uint32_t i = 0; i < DRIFT_WINDOW_SAMPLES - 1; i++) {
+        uint32_t cur = (newest + DRIFT_WINDOW_SAMPLES - i) % DRIFT_WINDOW_SAMPLES;
+        uint32_t prev = (cur + DRIFT_WINDOW_SAMPLES - 1) % DRIFT_WINDOW_SAMPLES;
+        if (history[cur][gauge] <= history[prev][gauge]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void drift_monitor_init(uint32_t now_ms) {
+    memset(history, 0, sizeof(history));
+    sample_count = 0;
+    drift_flags = 0;
+    next_sample_ms = now_ms + DRIFT_SAMPLE_INTERVAL_MS;
+}
+
+bool drift_monitor_due(uint32_t now_ms) {
+    return (int32_t)(now_ms - next_sample_ms) >= 0;
+}
+
+uint32_t drift_monitor_sample(uint32_t now_ms, const uint32_t values[DRIFT_GAUGE_COUNT]) {
+    memcpy(history[sample_count % DRIFT_WINDOW_SAMPLES], values, sizeof(history[0]));
+    sample_count++;
+    next_sample_ms = now_ms + DRIFT_SAMPLE_INTERVAL_MS;
+
+    if (sample_count < DRIFT_WINDOW_SAMPLES) {
+        return drift_flags;
+    }
+
+    uint32_t flags = 0;
+    for (int gauge = 0; gauge < DRIFT_GAUGE_COUNT; gauge++) {
+        if (gauge_is_growing((drift_gauge_t)gauge)) {
+            flags |= 1u << gauge;
+            if (!(drift_flags & (1u << gauge))) {
+                printf("[DRIFT] '%s' cresceu nas últimas %d amostras (atual: %u)\n",
+                       gauge_names[gauge], DRIFT_WINDOW_SAMPLES, (unsigned)values[gauge]);
+            }
+        }
+    }
+    drift_flags = flags;
+    return drift_flags;
+}
+
+uint32_t drift_monitor_flags(void) {
+    return drift_flags;
+}
+
+uint32_t drift_monitor_samples(void) {
+    return sample_count;
+}
+
+const char *drift_monitor_gauge_name(drift_gauge_t gauge) {
+    return gauge < DRIFT_GAUGE_COUNT ? gauge_names[gauge] : "?";
+}
@@ -0,0 +1,39 @@
+#ifndef DRIFT_MONITOR_H
+#define DRIFT_MONITOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Detector de vazamento/deriva para operação de longa duração: amostra periodicamente
+ * os recursos do firmware e sinaliza os que crescem em todas as amostras da janela.
+ * O tempo é sempre recebido como parâmetro, permitindo acelerar semanas de operação
+ * com um relógio virtual. */
+
+#define DRIFT_SAMPLE_INTERVAL_MS (60u * 60u * 1000u)  // uma amostra por hora
+#define DRIFT_WINDOW_SAMPLES     6                   // crescimento contínuo por 6 h sinaliza deriva
+
+typedef enum {
+    DRIFT_OUTBOX_DEPTH = 0,   // mensagens na fila de saída
+    DRIFT_POOL_IN_USE,        // blocos ocupados no pool de mensagens
+    DRIFT_STACK_CORE0,        // pico de pilha do core 0 (inclui IRQs)
+    DRIFT_LATE_ALLOCS,        // alocações após a inicialização
+    DRIFT_MSG_RATE,           // mensagens enfileiradas no intervalo
+    DRIFT_GAUGE_COUNT
+} drift_gauge_t;
+
+void drift_monitor_init(uint32_t now_ms);
+
+// Indica se já é hora de coletar uma nova amostra
+bool drift_monitor_due(uint32_t now_ms);
+
+// Registra uma amostra de todos os medidores; retorna a máscara de medidores em deriva
+uint32_t drift_monitor_sample(uint32_t now_ms, const uint32_t values[DRIFT_GAUGE_COUNT]);
+
+// Máscara (1 << drift_gauge_t) dos medidores que cresceram em toda a janela
+uint32_t drift_monitor_flags(void);
+
+uint32_t drift_monitor_samples(void);
+
+const char *drift_monitor_gauge_name(drift_gauge_t gauge);
+
+#endif /* DRIFT_MONITOR_H */
@@ -0,0 +1,259 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Injeção de falhas de rede
+/ Descrição: Shim entre o driver CYW43 e o lwIP que aplica perda, latência, blackhole, reset e falha de DNS conforme um roteiro.
+/ Obs: Destinado a bancada; habilitado apenas com a opção RACK_FAULT_INJECTION do CMake.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "lwip/opt.h"
+#include "lwip/pbuf.h"
+#include "lwip/timeouts.h"
+#include "fault_inject.h"
+
+// Roteiro executado após a primeira conexão saudável; cada passo espera a recuperação do anterior
+static const fault_step_t fault_script[] = {
+    { FAULT_LOSS,      10,   120000 },
+    { FAULT_LOSS,      50,   60000  },
+    { FAULT_LATENCY,   500,  120000 },
+    { FAULT_BLACKHOLE, 0,    90000  },
+    { FAULT_RESET,     0,    1000   },
+    { FAULT_DNS_FAIL,  0,    60000  },
+};
+#define FAULT_SCRIPT_STEPS (sizeof(fault_script) / sizeof(fault_script[0]))
+
+// Intervalo de estabilização entre a recuperação de um passo e o início do próximo
+#define FAULT_SETTLE_MS 30000
+
+// Quadros retidos simultaneamente para FAULT_LATENCY, nos dois sentidos: FAULT_DELAY_SLOTS vem de
+// lwipopts.h, que reserva um sys_timeout por slot
+#if FAULT_DELAY_SLOTS <= 0
+#error "FAULT_DELAY_SLOTS deve ser definido em lwipopts.h com RACK_FAULT_INJECTION"
+#endif
+
+typedef enum {
+    SCRIPT_WAIT_HEALTHY,
+    SCRIPT_ACTIVE,
+    SCRIPT_RECOVERING,
+    SCRIPT_DONE,
+} script_state_t;
+
+typedef struct {
+    struct pbuf *p;
+    struct netif *netif;
+    bool tx;               // cópia de um quadro transmitido (o lwIP continua dono do original)
+} delayed_frame_t;
+
+static struct netif *fault_netif = NULL;
+static netif_input_fn orig_input = NULL;
+static netif_linkoutput_fn orig_linkoutput = NULL;
+static void (*fault_reset_handler)(void) = NULL;
+
+static volatile fault_type_t active_fault = FAULT_NONE;
+static volatile uint32_t active_param = 0;
+static volatile uint32_t dropped_tx = 0;
+static volatile uint32_t dropped_rx = 0;
+static volatile uint32_t delay_overflow = 0;
+static delayed_frame_t delayed[FAULT_DELAY_SLOTS];
+static uint32_t rng_state = 0x2545F491u;
+
+static script_state_t script_state = SCRIPT_WAIT_HEALTHY;
+static uint32_t script_step = 0;
+static uint32_t step_deadline_ms = 0;
+static uint32_t step_lost_start = 0;
+static fault_result_t last_result;
+static bool has_result = false;
+
+static uint32_t fault_rand(void) {
+    // xorshift32: suficiente para decidir descartes, sem depender de pico_rand
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static bool should_drop(void) {
+    switch (active_fault) {
+        case FAULT_BLACKHOLE:
+            return true;
+        case FAULT_LOSS:
+            return (fault_rand() % 100) < active_param;
+        default:
+            return false;
+    }
+}
+
+static void delayed_release(void *arg) {
+    delayed_frame_t *slot = (delayed_frame_t *)arg;
+    struct pbuf *p = slot->p;
+    slot->p = NULL;
+    if (slot->tx) {
+        orig_linkoutput(slot->netif, p);
+        pbuf_free(p);
+    } else if (orig_input(p, slot->netif) != ERR_OK) {
+        pbuf_free(p);
+    }
+}
+
+/* Retém o quadro por active_param ms. Sem slot livre (ou sem memória para a cópia de um quadro
+ * transmitido) ele é perdido, como numa fila de roteador cheia; essas perdas ficam em
+ * delay_overflow, fora dos descartes sorteados. */
+static bool delay_frame(struct pbuf *p, struct netif *netif, bool tx) {
+    for (int i = 0; i < FAULT_DELAY_SLOTS; i++) {
+        if (delayed[i].p == NULL) {
+            delayed[i].p = p;
+            delayed[i].netif = netif;
+            delayed[i].tx = tx;
+            sys_timeout(active_param, delayed_release, &delayed[i]);
+            return true;
+        }
+    }
+    delay_overflow++;
+    return false;
+}
+
+static err_t fault_input(struct pbuf *p, struct netif *netif) {
+    if (should_drop()) {
+        dropped_rx++;
+        pbuf_free(p);
+        return ERR_OK;
+    }
+    if (active_fault == FAULT_LATENCY) {
+        if (!delay_frame(p, netif, false)) {
+            pbuf_free(p);
+        }
+        return ERR_OK;
+    }
+    return orig_input(p, netif);
+}
+
+static err_t fault_linkoutput(struct netif *netif, struct pbuf *p) {
+    if (should_drop()) {
+        dropped_tx++;
+        return ERR_OK;  // o lwIP considera enviado; o quadro some no "meio"
+    }
+    if (active_fault == FAULT_LATENCY) {
+        // O chamador libera p ao retornar (e o TCP o reaproveita na retransmissão): retém uma cópia
+        struct pbuf *copy = pbuf_alloc(PBUF_RAW, p->tot_len, PBUF_RAM);
+        if (copy == NULL) {
+            delay_overflow++;
+        } else if (pbuf_copy(copy, p) != ERR_OK || !delay_frame(copy, netif, true)) {
+            pbuf_free(copy);
+        }
+        return ERR_OK;
+    }
+    return orig_linkoutput(netif, p);
+}
+
+void fault_inject_init(struct netif *netif, void (*reset_handler)(void)) {
+    fault_netif = netif;
+    fault_reset_handler = reset_handler;
+    rng_state ^= time_us_32();
+    memset(delayed, 0, sizeof(delayed));
+
+    orig_input = netif->input;
+    orig_linkoutput = netif->linkoutput;
+    netif->input = fault_input;
+    netif->linkoutput = fault_linkoutput;
+
+    step_deadline_ms = to_ms_since_boot(get_absolute_time()) + FAULT_SETTLE_MS;
+    printf("[FAULT] Injeção de falhas ativa: %u passos no roteiro\n", (unsigned)FAULT_SCRIPT_STEPS);
+}
+
+static void start_step(uint32_t now_ms, uint32_t lost_total) {
+    const fault_step_t *step = &fault_script[script_step];
+
+    step_lost_start = lost_total;
+    dropped_tx = dropped_rx = delay_overflow = 0;
+
+    printf("[FAULT] Passo %u: %s (param=%u) por %u ms\n", (unsigned)script_step,
+           fault_inject_type_name(step->type), (unsigned)step->param, (unsigned)step->duration_ms);
+
+    active_param = step->param;
+    active_fault = step->type;
+    if (step->type == FAULT_RESET && fault_reset_handler != NULL) {
+        fault_reset_handler();
+    }
+    step_deadline_ms = now_ms + step->duration_ms;
+    script_state = SCRIPT_ACTIVE;
+}
+
+void fault_inject_tick(uint32_t now_ms, bool healthy, uint32_t lost_total) {
+    if (fault_netif == NULL) {
+        return;
+    }
+
+    switch (script_state) {
+        case SCRIPT_WAIT_HEALTHY:
+            if (healthy && (int32_t)(now_ms - step_deadline_ms) >= 0) {
+                start_step(now_ms, lost_total);
+            }
+            break;
+
+        case SCRIPT_ACTIVE:
+            if ((int32_t)(now_ms - step_deadline_ms) >= 0) {
+                active_fault = FAULT_NONE;
+                script_state = SCRIPT_RECOVERING;
+            }
+            break;
+
+        case SCRIPT_RECOVERING:
+            if (healthy) {
+                // Só aqui: até o fim do passo seguinte, fault_inject_last_result() devolve este
+                last_result.step = script_step;
+                last_result.type = fault_script[script_step].type;
+                last_result.recovery_ms = now_ms - step_deadline_ms;
+                last_result.lost_messages = lost_total - step_lost_start;
+                last_result.dropped_tx = dropped_tx;
+                last_result.dropped_rx = dropped_rx;
+                last_result.delay_overflow = delay_overflow;
+                has_result = true;
+
+                printf("[FAULT] Passo %u (%s): recuperação em %u ms, %u mensagens perdidas, quadros descartados tx=%u rx=%u, "
+                       "sem slot de atraso %u\n",
+                       (unsigned)last_result.step, fault_inject_type_name(last_result.type), (unsigned)last_result.recovery_ms,
+                       (unsigned)last_result.lost_messages, (unsigned)last_result.dropped_tx, (unsigned)last_result.dropped_rx,
+                       (unsigned)last_result.delay_overflow);
+
+                script_step++;
+                if (script_step >= FAULT_SCRIPT_STEPS) {
+                    printf("[FAULT] Roteiro concluído\n");
+                    script_state = SCRIPT_DONE;
+                } else {
+                    step_deadline_ms = now_ms + FAULT_SETTLE_MS;
+                    script_state = SCRIPT_WAIT_HEALTHY;
+                }
+            }
+            break;
+
+        case SCRIPT_DONE:
+            break;
+    }
+}
+
+bool fault_inject_dns_should_fail(void) {
+    return active_fault == FAULT_DNS_FAIL;
+}
+
+fault_type_t fault_inject_active(void) {
+    return active_fault;
+}
+
+bool fault_inject_last_result(fault_result_t *result) {
+    if (has_result) {
+        *result = last_result;
+    }
+    return has_result;
+}
+
+const char *fault_inject_type_name(fault_type_t type) {
+    switch (type) {
+        case FAULT_LOSS:      return "loss";
+        case FAULT_LATENCY:   return "latency";
+        case FAULT_BLACKHOLE: return "blackhole";
+        case FAULT_RESET:     return "reset";
+        case FAULT_DNS_FAIL:  return "dns_fail";
+        default:              return "none";
+    }
+}
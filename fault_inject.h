@@ -0,0 +1,54 @@
+#ifndef FAULT_INJECT_H
+#define FAULT_INJECT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lwip/netif.h"
+
+/* Camada de injeção de falhas de rede (somente com RACK_FAULT_INJECTION).
+ * Intercepta input/linkoutput da netif do Wi-Fi, logo abaixo do lwIP, e executa um
+ * roteiro de falhas medindo o tempo de recuperação e a perda de dados de cada passo. */
+
+typedef enum {
+    FAULT_NONE = 0,
+    FAULT_LOSS,        // descarta param% dos quadros em ambos os sentidos
+    FAULT_LATENCY,     // atrasa param ms em cada sentido (o RTT cresce 2 x param)
+    FAULT_BLACKHOLE,   // descarta todo o tráfego
+    FAULT_RESET,       // derruba a sessão MQTT/TCP (uma vez, no início do passo)
+    FAULT_DNS_FAIL,    // toda resolução DNS falha
+} fault_type_t;
+
+typedef struct {
+    fault_type_t type;
+    uint32_t param;
+    uint32_t duration_ms;
+} fault_step_t;
+
+typedef struct {
+    uint32_t step;
+    fault_type_t type;
+    uint32_t recovery_ms;     // fim da falha até o link voltar a ficar saudável
+    uint32_t lost_messages;   // mensagens perdidas durante o passo
+    uint32_t dropped_tx;      // quadros descartados pela camada (perda sorteada, blackhole)
+    uint32_t dropped_rx;
+    uint32_t delay_overflow;  // quadros perdidos em FAULT_LATENCY por falta de slot de atraso
+} fault_result_t;
+
+// Instala os ganchos na netif; reset_handler derruba a sessão MQTT para FAULT_RESET
+void fault_inject_init(struct netif *netif, void (*reset_handler)(void));
+
+/* Avança o roteiro. healthy indica MQTT conectado e fila de saída vazia;
+ * lost_total é o contador acumulado de mensagens perdidas pela aplicação. */
+void fault_inject_tick(uint32_t now_ms, bool healthy, uint32_t lost_total);
+
+bool fault_inject_dns_should_fail(void);
+
+// Falha em curso; FAULT_NONE entre os passos e durante a recuperação
+fault_type_t fault_inject_active(void);
+
+// Resultado do último passo concluído; false enquanto nenhum passo terminou
+bool fault_inject_last_result(fault_result_t *result);
+
+const char *fault_inject_type_name(fault_type_t type);
+
+#endif /* FAULT_INJECT_H */
@@ -0,0 +1,69 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Detector de oscilação
+/ Descrição: Detecta chatter em entradas digitais (ex.: reed switch da porta) e resume os eventos enquanto o canal oscila.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <string.h>
+#include "flap_detector.h"
+
+void flap_detector_init(flap_detector_t *detector, uint8_t threshold, uint32_t window_ms, uint32_t summary_ms, uint32_t quiet_ms) {
+    memset(detector, 0, sizeof(*detector));
+    detector->threshold = threshold > FLAP_MAX_THRESHOLD ? FLAP_MAX_THRESHOLD : (threshold < 2 ? 2 : threshold);
+    detector->window_ms = window_ms;
+    detector->summary_ms = summary_ms;
+    detector->quiet_ms = quiet_ms;
+}
+
+flap_result_t flap_detector_transition(flap_detector_t *detector, uint32_t now_ms) {
+    detector->last_transition_ms = now_ms;
+
+    if (detector->flapping) {
+        detector->interval_transitions++;
+        return FLAP_SUPPRESSED;
+    }
+
+    // Guarda o instante no histórico circular das últimas `threshold` transições
+    detector->history[detector->history_head] = now_ms;
+    detector->history_head = (detector->history_head + 1) % detector->threshold;
+    if (detector->history_len < detector->threshold) {
+        detector->history_len++;
+    }
+
+    // Com o histórico cheio, a posição head é a transição mais antiga das últimas `threshold`
+    if (detector->history_len == detector->threshold &&
+        now_ms - detector->history[detector->history_head] <= detector->window_ms) {
+        detector->flapping = true;
+        detector->episodes++;
+        // As `threshold` transições da detecção vão no evento de entrada; o resumo conta só as suprimidas
+        detector->interval_transitions = 0;
+        detector->next_summary_ms = now_ms + detector->summary_ms;
+        detector->history_len = 0;
+        printf("[FLAP] %u transições em %u ms, suprimindo eventos individuais\n",
+               (unsigned)detector->threshold, (unsigned)detector->window_ms);
+        return FLAP_ENTERED;
+    }
+    return FLAP_PASS;
+}
+
+flap_tick_t flap_detector_tick(flap_detector_t *detector, uint32_t now_ms, uint32_t *transitions) {
+    if (!detector->flapping) {
+        return FLAP_TICK_NONE;
+    }
+
+    if (now_ms - detector->last_transition_ms >= detector->quiet_ms) {
+        detector->flapping = false;
+        *transitions = detector->interval_transitions;
+        detector->interval_transitions = 0;
+        printf("[FLAP] Canal estável novamente\n");
+        return FLAP_TICK_EXITED;
+    }
+
+    if ((int32_t)(now_ms - detector->next_summary_ms) >= 0) {
+        *transitions = detector->interval_transitions;
+        detector->interval_transitions = 0;
+        detector->next_summary_ms = now_ms + detector->summary_ms;
+        return FLAP_TICK_SUMMARY;
+    }
+    return FLAP_TICK_NONE;
+}
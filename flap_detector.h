@@ -0,0 +1,54 @@
+#ifndef FLAP_DETECTOR_H
+#define FLAP_DETECTOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Detector de oscilação (flapping) para entradas digitais: N transições dentro de uma
+ * janela colocam o canal em estado "flapping", no qual os eventos individuais são
+ * suprimidos e apenas resumos periódicos com a contagem são publicados. O canal sai
+ * desse estado após um período sem transições. */
+
+#define FLAP_MAX_THRESHOLD 16
+
+typedef enum {
+    FLAP_PASS,         // transição normal: publicar o evento
+    FLAP_ENTERED,      // a transição colocou o canal em flapping
+    FLAP_SUPPRESSED,   // canal em flapping: evento contabilizado, não publicado
+} flap_result_t;
+
+typedef enum {
+    FLAP_TICK_NONE,
+    FLAP_TICK_SUMMARY, // hora de publicar o resumo do intervalo
+    FLAP_TICK_EXITED,  // canal estabilizou: publicar o estado atual
+} flap_tick_t;
+
+typedef struct {
+    uint32_t window_ms;
+    uint32_t summary_ms;
+    uint32_t quiet_ms;
+    uint8_t threshold;
+
+    uint32_t history[FLAP_MAX_THRESHOLD];  // instantes das últimas transições
+    uint8_t history_len;
+    uint8_t history_head;
+
+    bool flapping;
+    uint32_t last_transition_ms;
+    uint32_t next_summary_ms;
+    uint32_t interval_transitions;  // transições suprimidas desde o último resumo
+    uint32_t episodes;              // quantas vezes o canal entrou em flapping
+} flap_detector_t;
+
+void flap_detector_init(flap_detector_t *detector, uint8_t threshold, uint32_t window_ms, uint32_t summary_ms, uint32_t quiet_ms);
+
+/* Em FLAP_ENTERED a transição completou `threshold` dentro da janela; o evento de entrada
+ * reporta essas `threshold` (as anteriores já saíram como eventos individuais) e os resumos
+ * seguintes contam só as transições suprimidas, sem repetir as da detecção. */
+flap_result_t flap_detector_transition(flap_detector_t *detector, uint32_t now_ms);
+
+/* Chamado periodicamente. Em FLAP_TICK_SUMMARY, *transitions recebe a contagem do
+ * intervalo (zerada em seguida); em FLAP_TICK_EXITED, a contagem final pendente. */
+flap_tick_t flap_detector_tick(flap_detector_t *detector, uint32_t now_ms, uint32_t *transitions);
+
+#endif /* FLAP_DETECTOR_H */
@@ -0,0 +1,22 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Espalhamento da frota
+/ Descrição: Fatias por rack e jitter para boot, reconexão e publicações periódicas, evitando rajadas sincronizadas no broker.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include "pico/rand.h"
+#include "fleet_slot.h"
+
+static uint32_t slot = 0;
+
+void fleet_slot_init(int rack_number) {
+    // Racks costumam ser numerados em sequência, então o módulo já distribui bem as fatias
+    slot = (uint32_t)(rack_number < 0 ? -rack_number : rack_number) % FLEET_SLOTS;
+}
+
+uint32_t fleet_slot_offset_ms(uint32_t window_ms) {
+    return slot * (window_ms / FLEET_SLOTS);
+}
+
+uint32_t fleet_jitter_ms(uint32_t max_ms) {
+    return max_ms > 0 ? get_rand_32() % max_ms : 0;
+}
@@ -0,0 +1,25 @@
+#ifndef FLEET_SLOT_H
+#define FLEET_SLOT_H
+
+#include <stdint.h>
+
+/* Espalhamento da frota: quando a energia de um site volta, todos os racks iniciam juntos.
+ * Cada rack recebe uma fatia determinística (número do rack módulo FLEET_SLOTS) de uma
+ * janela, somada a um jitter aleatório para desempatar racks na mesma fatia. */
+
+#define FLEET_SLOTS 16
+
+#define FLEET_BOOT_WINDOW_MS      8000   // atraso de boot antes do Wi-Fi/DNS/broker
+#define FLEET_BOOT_JITTER_MS      500
+#define FLEET_RECONNECT_WINDOW_MS 5000   // reconexão após queda do broker
+#define FLEET_PUBLISH_JITTER_MS   2000   // publicações periódicas (métricas)
+
+void fleet_slot_init(int rack_number);
+
+// Deslocamento determinístico do rack dentro de uma janela
+uint32_t fleet_slot_offset_ms(uint32_t window_ms);
+
+// Jitter aleatório uniforme em [0, max_ms)
+uint32_t fleet_jitter_ms(uint32_t max_ms);
+
+#endif /* FLEET_SLOT_H */
@@ -0,0 +1,55 @@
+# Verificação pós-link do RACK_HEAP_FREE (executado como script: cmake -P)
+#
+# Falha o build se algum objeto do firmware (os .c deste diretório, não o SDK) referencia as
+# rotinas de alocação da libc ou o construtor dinâmico do cliente MQTT. As alocações internas
+# da newlib e do SDK (printf, etc.) não aparecem aqui: essas são pegas em tempo de execução
+# pelo heap_guard.c depois de heap_guard_lock().
+#
+# Variáveis esperadas:
+#   NM       - binutils nm da toolchain (arm-none-eabi-nm)
+#   OBJ_DIR  - diretório dos objetos do alvo (CMakeFiles/<alvo>.dir)
+#   ALLOW    - objetos que podem alocar, só na inicialização (separados por ';', padrão heap_guard.c.obj)
+
+if(NOT DEFINED NM OR NOT DEFINED OBJ_DIR)
+    message(FATAL_ERROR "Uso: cmake -DNM=<nm> -DOBJ_DIR=<dir> [-DALLOW=<objetos>] -P heap_free_check.cmake")
+endif()
+if(NOT DEFINED ALLOW)
+    set(ALLOW heap_guard.c.obj)
+endif()
+
+set(forbidden malloc calloc realloc free strdup _malloc_r _calloc_r _realloc_r _free_r mqtt_client_new)
+
+# Só o primeiro nível: os objetos do SDK ficam em subdiretórios com o caminho da fonte
+file(GLOB objects "${OBJ_DIR}/*.obj")
+
+set(violations "")
+foreach(object ${objects})
+    get_filename_component(object_name "${object}" NAME)
+    list(FIND ALLOW "${object_name}" allowed)
+    if(NOT allowed EQUAL -1)
+        continue()
+    endif()
+    execute_process(COMMAND ${NM} -u "${object}" OUTPUT_VARIABLE undefined RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "[heap] ${NM} falhou em ${object_name}")
+    endif()
+    string(REPLACE "\n" ";" undefined "${undefined}")
+    foreach(line ${undefined})
+        # Formato: "         U símbolo"
+        if(line MATCHES "U[ \t]+([A-Za-z0-9_]+)$")
+            list(FIND forbidden "${CMAKE_MATCH_1}" index)
+            if(NOT index EQUAL -1)
+                list(APPEND violations "${object_name}: ${CMAKE_MATCH_1}")
+            endif()
+        endif()
+    endforeach()
+endforeach()
+
+list(LENGTH objects total)
+if(violations)
+    foreach(violation ${violations})
+        message(STATUS "[heap] ${violation}")
+    endforeach()
+    message(FATAL_ERROR "[heap] RACK_HEAP_FREE: objetos do firmware chamam a alocação dinâmica")
+endif()
+message(STATUS "[heap] ${total} objetos do firmware sem chamadas de alocação dinâmica")
@@ -0,0 +1,60 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Guarda de heap
+/ Descrição: Intercepta as rotinas reentrantes de alocação da newlib para garantir operação sem heap após a inicialização.
+/ Obs: Só é ligado com a opção RACK_HEAP_FREE (ver CMakeLists.txt). O pico_malloc já usa --wrap=malloc, por isso o
+/      redirecionamento é feito um nível abaixo, em _malloc_r/_calloc_r/_realloc_r.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "heap_guard.h"
+
+struct _reent;
+
+void *__real__malloc_r(struct _reent *r, size_t size);
+void *__real__calloc_r(struct _reent *r, size_t count, size_t size);
+void *__real__realloc_r(struct _reent *r, void *ptr, size_t size);
+
+static volatile bool heap_locked = false;
+static volatile uint32_t init_allocs = 0;
+static volatile uint32_t late_allocs = 0;
+
+static void heap_guard_check(const char *func, size_t size) {
+    if (!heap_locked) {
+        init_allocs++;
+        return;
+    }
+    late_allocs++;
+    // Também em release: uma alocação tardia é um defeito, não algo para descobrir nas métricas
+    panic("[HEAP] %s(%u) chamado após a inicialização", func, (unsigned)size);
+}
+
+void *__wrap__malloc_r(struct _reent *r, size_t size) {
+    heap_guard_check("malloc", size);
+    return __real__malloc_r(r, size);
+}
+
+void *__wrap__calloc_r(struct _reent *r, size_t count, size_t size) {
+    heap_guard_check("calloc", count * size);
+    return __real__calloc_r(r, count, size);
+}
+
+void *__wrap__realloc_r(struct _reent *r, void *ptr, size_t size) {
+    heap_guard_check("realloc", size);
+    return __real__realloc_r(r, ptr, size);
+}
+
+void heap_guard_lock(void) {
+    heap_locked = true;
+    printf("[HEAP] Inicialização concluída com %u alocações; heap bloqueado\n", (unsigned)init_allocs);
+}
+
+uint32_t heap_guard_init_allocs(void) {
+    return init_allocs;
+}
+
+uint32_t heap_guard_late_allocs(void) {
+    return late_allocs;
+}
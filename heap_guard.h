@@ -0,0 +1,21 @@
+#ifndef HEAP_GUARD_H
+#define HEAP_GUARD_H
+
+#include <stdint.h>
+
+/* Guarda de heap: com RACK_HEAP_FREE o linker redireciona _malloc_r/_calloc_r/_realloc_r
+ * (--wrap) para este módulo. Depois de heap_guard_lock() qualquer alocação dinâmica é
+ * contabilizada como violação e derruba o firmware (panic), também em release. As chamadas
+ * diretas dos objetos do firmware já são barradas no link por heap_free_check.cmake; esta
+ * guarda cobre as alocações internas da newlib e do SDK. */
+
+// Encerra a fase de inicialização: a partir daqui nenhuma alocação é permitida
+void heap_guard_lock(void);
+
+// Alocações feitas durante a inicialização (antes do lock)
+uint32_t heap_guard_init_allocs(void);
+
+// Alocações feitas depois do lock (deve permanecer zero)
+uint32_t heap_guard_late_allocs(void);
+
+#endif /* HEAP_GUARD_H */
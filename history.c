@@ -0,0 +1,116 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Histórico de amostras
+/ Descrição: Buffer circular comprimido (delta-de-delta) com a última hora de temperatura a 1 Hz para análise forense sob demanda.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <string.h>
+#include <math.h>
+#include "history.h"
+
+static history_block_t blocks[HISTORY_BLOCKS];
+static uint32_t next_seq = 0;       // próximo bloco a ser aberto
+static bool block_open = false;
+static ts_encoder_t encoder;        // estado de codificação do bloco aberto
+
+static history_block_t *current_block(void) {
+    return &blocks[(next_seq - 1) % HISTORY_BLOCKS];
+}
+
+static void open_block(uint32_t now_ms, int16_t value) {
+    history_block_t *block = &blocks[next_seq % HISTORY_BLOCKS];
+    block->seq = next_seq++;
+    block->start_ms = now_ms;
+    block->end_ms = now_ms;
+    ts_encoder_init(&encoder, block->data, sizeof(block->data));
+    ts_encode(&encoder, value);
+    block->count = 1;
+    block->bits = (uint16_t)encoder.bits;
+    block_open = true;
+}
+
+void history_init(void) {
+    memset(blocks, 0, sizeof(blocks));
+    next_seq = 0;
+    block_open = false;
+}
+
+void history_add(uint32_t now_ms, float value) {
+    float scaled = roundf(value * 100.0f);
+    if (scaled > INT16_MAX) {
+        scaled = INT16_MAX;
+    } else if (scaled < INT16_MIN) {
+        scaled = INT16_MIN;
+    }
+    int16_t centi = (int16_t)scaled;
+
+    if (!block_open) {
+        open_block(now_ms, centi);
+        return;
+    }
+
+    history_block_t *block = current_block();
+    if (block->count >= HISTORY_BLOCK_SAMPLES || !ts_encode(&encoder, centi)) {
+        open_block(now_ms, centi);
+        return;
+    }
+
+    block->count++;
+    block->bits = (uint16_t)encoder.bits;
+    block->end_ms = now_ms;
+}
+
+void history_gap(void) {
+    block_open = false;
+}
+
+uint32_t history_oldest_seq(void) {
+    return next_seq > HISTORY_BLOCKS ? next_seq - HISTORY_BLOCKS : 0;
+}
+
+uint32_t history_next_seq(void) {
+    return next_seq;
+}
+
+uint32_t history_seq_since(uint32_t since_ms) {
+    for (uint32_t seq = history_oldest_seq(); seq < next_seq; seq++) {
+        if ((int32_t)(blocks[seq % HISTORY_BLOCKS].end_ms - since_ms) >= 0) {
+            return seq;
+        }
+    }
+    return next_seq;
+}
+
+static size_t put_u32(uint8_t *buf, uint32_t value) {
+    buf[0] = (uint8_t)value;
+    buf[1] = (uint8_t)(value >> 8);
+    buf[2] = (uint8_t)(value >> 16);
+    buf[3] = (uint8_t)(value >> 24);
+    return 4;
+}
+
+size_t history_serialize(uint32_t seq, uint8_t *buf, size_t len) {
+    if (seq < history_oldest_seq() || seq >= next_seq) {
+        return 0;
+    }
+    const history_block_t *block = &blocks[seq % HISTORY_BLOCKS];
+    if (block->seq != seq) {
+        return 0;
+    }
+
+    size_t data_len = (block->bits + 7u) / 8u;
+    size_t needed = 15 + data_len;
+    if (len < needed) {
+        return 0;
+    }
+
+    size_t pos = 0;
+    pos += put_u32(&buf[pos], block->seq);
+    pos += put_u32(&buf[pos], block->start_ms);
+    pos += put_u32(&buf[pos], block->end_ms);
+    buf[pos++] = block->count;
+    buf[pos++] = (uint8_t)block->bits;
+    buf[pos++] = (uint8_t)(block->bits >> 8);
+    memcpy(&buf[pos], block->data, data_len);
+    pos += data_len;
+    return pos;
+}
@@ -0,0 +1,44 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "ts_compress.h"
+
+/* Histórico circular em RAM das amostras de temperatura (1 Hz, última hora), em blocos
+ * comprimidos com ts_compress (centésimos de grau). Um bloco é fechado ao atingir
+ * HISTORY_BLOCK_SAMPLES, quando o fluxo de bits enche ou numa lacuna de leitura. */
+
+#define HISTORY_BLOCK_SAMPLES 120
+#define HISTORY_BLOCK_BYTES   96     // ~6 bits por amostra com o ruído típico do sensor interno
+#define HISTORY_BLOCKS        64     // 1 h a 1 Hz com folga para blocos fechados antes do tempo
+
+typedef struct {
+    uint32_t seq;          // número de sequência monotônico do bloco
+    uint32_t start_ms;     // tempo desde o boot da primeira amostra
+    uint32_t end_ms;       // tempo desde o boot da última amostra
+    uint8_t count;         // amostras no bloco
+    uint16_t bits;         // comprimento do fluxo comprimido
+    uint8_t data[HISTORY_BLOCK_BYTES];
+} history_block_t;
+
+void history_init(void);
+
+void history_add(uint32_t now_ms, float value);
+
+// Leitura indisponível: fecha o bloco corrente para não interpolar sobre a lacuna
+void history_gap(void);
+
+// Faixa de sequências disponíveis [oldest, next) para leitura incremental
+uint32_t history_oldest_seq(void);
+uint32_t history_next_seq(void);
+
+// Primeiro bloco disponível com amostras a partir de since_ms (history_next_seq() se nenhum)
+uint32_t history_seq_since(uint32_t since_ms);
+
+/* Serializa o bloco `seq` (little-endian: seq u32, start_ms u32, end_ms u32, count u8,
+ * bits u16, fluxo ts_compress de (bits + 7) / 8 bytes). Retorna 0 se o bloco já foi sobrescrito (o bloco aberto também é serializado). */
+size_t history_serialize(uint32_t seq, uint8_t *buf, size_t len);
+
+#endif /* HISTORY_H */
@@ -12,12 +12,15 @@
 #ifndef LWIP_SOCKET
 #define LWIP_SOCKET                 0
 #endif
-#if PICO_CYW43_ARCH_POLL
+#if PICO_CYW43_ARCH_POLL && !RACK_HEAP_FREE
 #define MEM_LIBC_MALLOC             1
 #else
 // MEM_LIBC_MALLOC is incompatible with non polling versions
+// RACK_HEAP_FREE: mantém o lwIP no heap estático de MEM_SIZE bytes, nunca na libc
 #define MEM_LIBC_MALLOC             0
 #endif
+// Pools memp sempre dimensionados em tempo de compilação
+#define MEMP_MEM_MALLOC             0
 #define MEM_ALIGNMENT               4
 #define MEM_SIZE                    10000
 #define MEMP_NUM_TCP_SEG            32
@@ -86,8 +89,54 @@
 #define SLIP_DEBUG                  LWIP_DBG_OFF
 #define DHCP_DEBUG                  LWIP_DBG_OFF
 
+// SNTP: hora sincronizada para agregações alinhadas ao relógio (ver rack_time.c)
+#define SNTP_SERVER_DNS             1
+#define SNTP_STARTUP_DELAY          0
+#include <stdint.h>
+void rack_time_set_epoch(uint32_t epoch_s);
+#define SNTP_SET_SYSTEM_TIME(sec)   rack_time_set_epoch(sec)
+
+/* Cliente MQTT do lwIP por perfil (opção RACK_MQTT_PROFILE do CMake). Os padrões do lwIP
+ * (anel de 256 bytes, 4 requisições em voo) mal cabem uma mensagem cheia da fila de saída
+ * (tópico 64 + payload 160 + cabeçalho), o que serializa a drenagem do backlog.
+ *   small:    anel 512,  4 em voo  - uma mensagem cheia por vez, menor RAM
+ *   balanced: anel 1024, 8 em voo  - padrão
+ *   burst:    anel 4096, 16 em voo - replay rápido após quedas longas */
+#if defined(RACK_MQTT_PROFILE_SMALL)
+#define MQTT_OUTPUT_RINGBUF_SIZE    512
+#define MQTT_REQ_MAX_IN_FLIGHT      4
+#define MQTT_VAR_HEADER_BUFFER_LEN  128
+#elif defined(RACK_MQTT_PROFILE_BURST)
+#define MQTT_OUTPUT_RINGBUF_SIZE    4096
+#define MQTT_REQ_MAX_IN_FLIGHT      16
+#define MQTT_VAR_HEADER_BUFFER_LEN  256
+#else
+#define MQTT_OUTPUT_RINGBUF_SIZE    1024
+#define MQTT_REQ_MAX_IN_FLIGHT      8
+#define MQTT_VAR_HEADER_BUFFER_LEN  256
+#endif
+
+// Agente SNMP (opção RACK_SNMP do CMake): só a MIB do rack, sem MIB-II, sobre UDP raw
+#if RACK_SNMP
+#define LWIP_SNMP                   1
+#define SNMP_USE_RAW                1
+#define SNMP_USE_NETCONN            0
+#define SNMP_LWIP_MIB2              0
+#define SNMP_TRAP_DESTINATIONS      1
+#define MEMP_NUM_UDP_PCB            6
+#endif
+
+/* Injeção de falhas (opção RACK_FAULT_INJECTION do CMake): cada quadro retido pela falha de
+ * latência, nos dois sentidos, ocupa um sys_timeout próprio, além dos ~10 usados pelos timers
+ * do lwIP; as cópias dos quadros transmitidos saem do heap do lwIP (MEM_SIZE) */
+#if RACK_FAULT_INJECTION
+#define FAULT_DELAY_SLOTS           16
+#else
+#define FAULT_DELAY_SLOTS           0
+#endif
+
 // Aumenta o número de sys_timeouts disponíveis (padrão pode ser 10)
-#define MEMP_NUM_SYS_TIMEOUT 20
+#define MEMP_NUM_SYS_TIMEOUT (20 + FAULT_DELAY_SLOTS)
 
 // Opcional: aumentar também outros pools caso necessário
 #define MEMP_NUM_TCP_PCB 20
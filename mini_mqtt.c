@@ -0,0 +1,527 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Cliente MQTT mínimo
+/ Descrição: MQTT 3.1.1 direto sobre TCP raw do lwIP, só com CONNECT, PUBLISH/PUBACK, SUBSCRIBE e PINGREQ e buffers estáticos.
+/ Obs: Roda inteiro em contexto lwIP. Os pacotes são escritos no TCP com cópia, em pedaços (cabeçalho, tópico, payload),
+/      sem montar a mensagem num buffer intermediário; a recepção guarda só os primeiros MINI_MQTT_RX_MAX bytes do pacote.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <string.h>
+#include "lwip/tcp.h"
+#include "lwip/sys.h"
+#include "mini_mqtt.h"
+
+// Primeiro byte do cabeçalho fixo (tipo nos 4 bits altos)
+#define MQTT_CONNECT    0x10
+#define MQTT_CONNACK    0x20
+#define MQTT_PUBLISH    0x30
+#define MQTT_PUBACK     0x40
+#define MQTT_SUBSCRIBE  0x82    // SUBSCRIBE exige os flags 0010
+#define MQTT_SUBACK     0x90
+#define MQTT_PINGREQ    0xC0
+#define MQTT_PINGRESP   0xD0
+
+#define MQTT_CONNECT_FLAG_CLEAN_SESSION 0x02
+#define MQTT_CONNECT_FLAG_PASSWORD      0x40
+#define MQTT_CONNECT_FLAG_USERNAME      0x80
+
+enum {
+    RX_HEADER,
+    RX_LENGTH,
+    RX_BODY,
+};
+
+// Pedaço de um pacote a ser escrito no TCP
+typedef struct {
+    const void *data;
+    uint16_t len;
+} segment_t;
+
+static void store_u16(uint8_t *out, uint16_t value) {
+    out[0] = (uint8_t)(value >> 8);
+    out[1] = (uint8_t)value;
+}
+
+static uint16_t read_u16(const uint8_t *in) {
+    return (uint16_t)((in[0] << 8) | in[1]);
+}
+
+static uint16_t next_packet_id(mini_mqtt_t *client) {
+    if (client->next_pkt_id == 0) {
+        client->next_pkt_id = 1;  // 0 não é um identificador válido
+    }
+    return client->next_pkt_id++;
+}
+
+static void detach_pcb(struct tcp_pcb *pcb) {
+    tcp_arg(pcb, NULL);
+    tcp_err(pcb, NULL);
+    tcp_recv(pcb, NULL);
+    tcp_poll(pcb, NULL, 0);
+}
+
+/* Encerra a conexão e esquece as publicações em voo sem chamar seus callbacks (como o app
+ * MQTT do lwIP); `notify` avisa o callback de conexão. Retorna ERR_ABRT se foi preciso
+ * abortar o pcb, o que os callbacks do TCP devem repassar ao lwIP. */
+static err_t close_connection(mini_mqtt_t *client, mqtt_connection_status_t status, bool notify) {
+    err_t result = ERR_OK;
+    if (client->pcb != NULL) {
+        struct tcp_pcb *pcb = client->pcb;
+        client->pcb = NULL;
+        detach_pcb(pcb);
+        if (tcp_close(pcb) != ERR_OK) {
+            tcp_abort(pcb);
+            result = ERR_ABRT;
+        }
+    }
+    client->state = MINI_MQTT_IDLE;
+    client->rx_state = RX_HEADER;
+    client->ping_pending = false;
+    memset(client->requests, 0, sizeof(client->requests));
+
+    if (notify && client->connect_cb != NULL) {
+        client->connect_cb(client, client->connect_arg, status);
+    }
+    return result;
+}
+
+static err_t protocol_error(mini_mqtt_t *client) {
+    printf("[MQTT] Pacote inválido do broker (0x%02x), fechando conexão\n", client->rx_header);
+    return close_connection(client, MQTT_CONNECT_DISCONNECTED, true);
+}
+
+/* Escreve cabeçalho fixo + pedaços de uma vez. Só começa se o pacote inteiro couber no
+ * buffer e na fila de segmentos do TCP, para nunca deixar um pacote pela metade no fluxo. */
+static err_t send_packet(mini_mqtt_t *client, uint8_t type, const segment_t *segments, size_t count) {
+    uint32_t remaining = 0;
+    for (size_t i = 0; i < count; i++) {
+        remaining += segments[i].len;
+    }
+
+    uint8_t header[5];
+    size_t header_len = 0;
+    header[header_len++] = type;
+    uint32_t value = remaining;
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        header[header_len++] = value > 0 ? (uint8_t)(byte | 0x80) : byte;
+    } while (value > 0);
+
+    struct tcp_pcb *pcb = client->pcb;
+    if (tcp_sndbuf(pcb) < header_len + remaining || tcp_sndqueuelen(pcb) + count + 1 > TCP_SND_QUEUELEN) {
+        return ERR_MEM;
+    }
+
+    err_t err = tcp_write(pcb, header, (uint16_t)header_len, TCP_WRITE_FLAG_COPY | (count > 0 ? TCP_WRITE_FLAG_MORE : 0));
+    for (size_t i = 0; i < count && err == ERR_OK; i++) {
+        if (segments[i].len > 0) {
+            err = tcp_write(pcb, segments[i].data, segments[i].len,
+                            TCP_WRITE_FLAG_COPY | (i + 1 < count ? TCP_WRITE_FLAG_MORE : 0));
+        }
+    }
+    if (err != ERR_OK) {
+        // Pacote parcial no fluxo: a sessão não tem mais como continuar
+        printf("[MQTT] Erro %d escrevendo no TCP, fechando conexão\n", err);
+        close_connection(client, MQTT_CONNECT_DISCONNECTED, true);
+        return ERR_CONN;
+    }
+    tcp_output(pcb);
+    client->last_tx_ms = sys_now();
+    return ERR_OK;
+}
+
+static err_t handle_publish(mini_mqtt_t *client) {
+    const uint8_t *body = client->rx_buf;
+    uint32_t len = client->rx_remaining;
+    uint32_t stored = len < MINI_MQTT_RX_MAX ? len : MINI_MQTT_RX_MAX;
+    uint8_t qos = (client->rx_header >> 1) & 0x03;
+
+    if (stored < 2) {
+        return protocol_error(client);
+    }
+    uint16_t topic_len = read_u16(body);
+    uint32_t header_len = 2u + topic_len + (qos > 0 ? 2u : 0u);
+    if (header_len > len) {
+        return protocol_error(client);
+    }
+    if (header_len > stored || topic_len > MINI_MQTT_TOPIC_MAX) {
+        client->rx_dropped++;
+        printf("[MQTT] Publicação recebida com tópico longo demais, descartada\n");
+        return ERR_OK;
+    }
+
+    char topic[MINI_MQTT_TOPIC_MAX + 1];
+    memcpy(topic, &body[2], topic_len);
+    topic[topic_len] = '\0';
+    uint32_t payload_len = len - header_len;
+
+    if (qos > 0) {
+        // Sem espaço no TCP o PUBACK fica para a reentrega do broker
+        segment_t puback = { &body[2 + topic_len], 2 };
+        send_packet(client, MQTT_PUBACK, &puback, 1);
+    }
+
+    if (client->publish_cb != NULL) {
+        client->publish_cb(client->inpub_arg, topic, payload_len);
+    }
+    if (len <= MINI_MQTT_RX_MAX) {
+        if (client->data_cb != NULL) {
+            client->data_cb(client->inpub_arg, &body[header_len], (uint16_t)payload_len, MQTT_DATA_FLAG_LAST);
+        }
+    } else {
+        client->rx_dropped++;  // só o tópico e o tamanho foram anunciados
+    }
+    return ERR_OK;
+}
+
+static err_t handle_packet(mini_mqtt_t *client) {
+    const uint8_t *body = client->rx_buf;
+    uint32_t len = client->rx_remaining;
+    client->last_rx_ms = sys_now();
+
+    switch (client->rx_header & 0xF0) {
+        case MQTT_CONNACK:
+            if (client->state != MINI_MQTT_CONNECTING || len < 2) {
+                return protocol_error(client);
+            }
+            if (body[1] != 0) {
+                printf("[MQTT] Broker recusou a conexão: %u\n", body[1]);
+                return close_connection(client, (mqtt_connection_status_t)body[1], true);
+            }
+            client->state = MINI_MQTT_CONNECTED;
+            if (client->connect_cb != NULL) {
+                client->connect_cb(client, client->connect_arg, MQTT_CONNECT_ACCEPTED);
+            }
+            break;
+
+        case MQTT_PUBACK:
+            if (len >= 2) {
+                uint16_t pkt_id = read_u16(body);
+                for (size_t i = 0; i < MQTT_REQ_MAX_IN_FLIGHT; i++) {
+                    mini_mqtt_request_t *request = &client->requests[i];
+                    if (request->pkt_id == pkt_id) {
+                        request->pkt_id = 0;  // libera a vaga antes do callback, que pode publicar de novo
+                        if (request->cb != NULL) {
+                            request->cb(request->arg, ERR_OK);
+                        }
+                        break;
+                    }
+                }
+            }
+            break;
+
+        case MQTT_SUBACK:
+            if (len >= 3 && body[2] == 0x80) {
+                printf("[MQTT] Assinatura recusada pelo broker\n");
+            }
+            break;
+
+        case MQTT_PINGRESP:
+            client->ping_pending = false;
+            break;
+
+        case MQTT_PUBLISH:
+            return handle_publish(client);
+
+        default:
+            break;  // QoS 2 e UNSUBACK não são usados
+    }
+    return ERR_OK;
+}
+
+// Consome bytes recebidos; retorna ERR_ABRT se a conexão teve de ser abortada
+static err_t feed(mini_mqtt_t *client, const uint8_t *data, uint32_t len) {
+    while (len > 0 && client->pcb != NULL) {
+        switch (client->rx_state) {
+            case RX_HEADER:
+                client->rx_header = *data++;
+                len--;
+                client->rx_remaining = 0;
+                client->rx_shift = 0;
+                client->rx_state = RX_LENGTH;
+                break;
+
+            case RX_LENGTH: {
+                uint8_t byte = *data++;
+                len--;
+                client->rx_remaining |= (uint32_t)(byte & 0x7F) << client->rx_shift;
+                client->rx_shift += 7;
+                if (byte & 0x80) {
+                    if (client->rx_shift >= 28) {
+                        return protocol_error(client);
+                    }
+                    break;
+                }
+                client->rx_read = 0;
+                if (client->rx_remaining > 0) {
+                    client->rx_state = RX_BODY;
+                    break;
+                }
+                client->rx_state = RX_HEADER;
+                err_t err = handle_packet(client);
+                if (err != ERR_OK) {
+                    return err;
+                }
+                break;
+            }
+
+            case RX_BODY: {
+                uint32_t chunk = client->rx_remaining - client->rx_read;
+                if (chunk > len) {
+                    chunk = len;
+                }
+                if (client->rx_read < MINI_MQTT_RX_MAX) {
+                    uint32_t room = MINI_MQTT_RX_MAX - client->rx_read;
+                    memcpy(&client->rx_buf[client->rx_read], data, chunk < room ? chunk : room);
+                }
+                client->rx_read += chunk;
+                data += chunk;
+                len -= chunk;
+                if (client->rx_read == client->rx_remaining) {
+                    client->rx_state = RX_HEADER;
+                    err_t err = handle_packet(client);
+                    if (err != ERR_OK) {
+                        return err;
+                    }
+                }
+                break;
+            }
+        }
+    }
+    return ERR_OK;
+}
+
+// Callbacks do TCP (contexto lwIP)
+static err_t tcp_recv_callback(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err) {
+    mini_mqtt_t *client = (mini_mqtt_t *)arg;
+    if (p == NULL) {
+        printf("[MQTT] Broker fechou a conexão\n");
+        return close_connection(client, MQTT_CONNECT_DISCONNECTED, true);
+    }
+    tcp_recved(tpcb, p->tot_len);
+
+    err_t result = ERR_OK;
+    for (struct pbuf *q = p; q != NULL && result == ERR_OK && client->pcb == tpcb; q = q->next) {
+        result = feed(client, (const uint8_t *)q->payload, q->len);
+    }
+    pbuf_free(p);
+    return result;
+}
+
+static void tcp_err_callback(void *arg, err_t err) {
+    mini_mqtt_t *client = (mini_mqtt_t *)arg;
+    printf("[MQTT] Erro na conexão TCP: %d\n", err);
+    client->pcb = NULL;  // o lwIP já liberou o pcb
+    close_connection(client, MQTT_CONNECT_DISCONNECTED, true);
+}
+
+static err_t tcp_connected_callback(void *arg, struct tcp_pcb *tpcb, err_t err) {
+    mini_mqtt_t *client = (mini_mqtt_t *)arg;
+    client->last_rx_ms = sys_now();
+    tcp_output(tpcb);  // CONNECT enfileirado em SYN_SENT
+    return ERR_OK;
+}
+
+// A cada MINI_MQTT_POLL_INTERVAL: prazo dos PUBACKs e keep-alive
+static err_t tcp_poll_callback(void *arg, struct tcp_pcb *tpcb) {
+    mini_mqtt_t *client = (mini_mqtt_t *)arg;
+    if (client->state != MINI_MQTT_CONNECTED) {
+        return ERR_OK;
+    }
+    uint32_t now_ms = sys_now();
+
+    for (size_t i = 0; i < MQTT_REQ_MAX_IN_FLIGHT; i++) {
+        mini_mqtt_request_t *request = &client->requests[i];
+        if (request->pkt_id != 0 && now_ms - request->sent_ms >= MINI_MQTT_REQ_TIMEOUT_MS) {
+            request->pkt_id = 0;
+            if (request->cb != NULL) {
+                request->cb(request->arg, ERR_TIMEOUT);
+            }
+        }
+    }
+
+    if (client->keep_alive_s > 0) {
+        uint32_t keep_alive_ms = client->keep_alive_s * 1000u;
+        // Como no lwIP: sem nada do broker por 1,5 keep-alive a conexão é dada como morta
+        if (now_ms - client->last_rx_ms >= keep_alive_ms + keep_alive_ms / 2) {
+            printf("[MQTT] Broker sem resposta, fechando conexão\n");
+            return close_connection(client, MQTT_CONNECT_TIMEOUT, true);
+        }
+        // Só publicações QoS 0 não geram resposta, então o silêncio na recepção também pede PINGREQ
+        if (!client->ping_pending &&
+            (now_ms - client->last_tx_ms >= keep_alive_ms || now_ms - client->last_rx_ms >= keep_alive_ms)) {
+            if (send_packet(client, MQTT_PINGREQ, NULL, 0) == ERR_OK) {
+                client->ping_pending = true;
+            }
+        }
+    }
+    return ERR_OK;
+}
+
+void mini_mqtt_init(mini_mqtt_t *client) {
+    memset(client, 0, sizeof(*client));
+    client->clean_session = true;
+    client->next_pkt_id = 1;
+}
+
+void mini_mqtt_set_clean_session(mini_mqtt_t *client, bool clean_session) {
+    client->clean_session = clean_session;
+}
+
+err_t mini_mqtt_connect(mini_mqtt_t *client, const ip_addr_t *ip, uint16_t port, mini_mqtt_connection_cb_t cb,
+                        void *arg, const struct mqtt_connect_client_info_t *client_info) {
+    if (client->state != MINI_MQTT_IDLE) {
+        return ERR_ISCONN;
+    }
+    size_t id_len = strlen(client_info->client_id);
+    size_t user_len = client_info->client_user != NULL ? strlen(client_info->client_user) : 0;
+    size_t pass_len = client_info->client_pass != NULL ? strlen(client_info->client_pass) : 0;
+    if (id_len > UINT16_MAX || user_len > UINT16_MAX || pass_len > UINT16_MAX) {
+        return ERR_VAL;
+    }
+
+    struct tcp_pcb *pcb = tcp_new();
+    if (pcb == NULL) {
+        return ERR_MEM;
+    }
+    tcp_arg(pcb, client);
+    tcp_err(pcb, tcp_err_callback);
+    tcp_recv(pcb, tcp_recv_callback);
+    tcp_poll(pcb, tcp_poll_callback, MINI_MQTT_POLL_INTERVAL);
+
+    err_t err = tcp_connect(pcb, ip, port, tcp_connected_callback);
+    if (err != ERR_OK) {
+        detach_pcb(pcb);
+        tcp_abort(pcb);
+        return err;
+    }
+
+    client->pcb = pcb;
+    client->state = MINI_MQTT_CONNECTING;
+    client->connect_cb = cb;
+    client->connect_arg = arg;
+    client->keep_alive_s = client_info->keep_alive;
+    client->rx_state = RX_HEADER;
+    client->ping_pending = false;
+
+    uint8_t flags = client->clean_session ? MQTT_CONNECT_FLAG_CLEAN_SESSION : 0;
+    if (user_len > 0) {
+        flags |= MQTT_CONNECT_FLAG_USERNAME;
+    }
+    if (pass_len > 0) {
+        flags |= MQTT_CONNECT_FLAG_PASSWORD;
+    }
+    uint8_t variable_header[10] = { 0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04, flags };
+    store_u16(&variable_header[8], client_info->keep_alive);
+
+    uint8_t id_len_bytes[2], user_len_bytes[2], pass_len_bytes[2];
+    store_u16(id_len_bytes, (uint16_t)id_len);
+    store_u16(user_len_bytes, (uint16_t)user_len);
+    store_u16(pass_len_bytes, (uint16_t)pass_len);
+
+    segment_t segments[7] = {
+        { variable_header, sizeof(variable_header) },
+        { id_len_bytes, 2 },
+        { client_info->client_id, (uint16_t)id_len },
+    };
+    size_t count = 3;
+    if (user_len > 0) {
+        segments[count++] = (segment_t){ user_len_bytes, 2 };
+        segments[count++] = (segment_t){ client_info->client_user, (uint16_t)user_len };
+    }
+    if (pass_len > 0) {
+        segments[count++] = (segment_t){ pass_len_bytes, 2 };
+        segments[count++] = (segment_t){ client_info->client_pass, (uint16_t)pass_len };
+    }
+
+    // O lwIP aceita tcp_write em SYN_SENT: o CONNECT sai assim que o TCP conectar
+    err = send_packet(client, MQTT_CONNECT, segments, count);
+    if (err != ERR_OK) {
+        close_connection(client, MQTT_CONNECT_DISCONNECTED, false);
+    }
+    return err;
+}
+
+void mini_mqtt_disconnect(mini_mqtt_t *client) {
+    close_connection(client, MQTT_CONNECT_DISCONNECTED, false);
+}
+
+bool mini_mqtt_is_connected(const mini_mqtt_t *client) {
+    return client->state == MINI_MQTT_CONNECTED;
+}
+
+err_t mini_mqtt_publish(mini_mqtt_t *client, const char *topic, const void *payload, uint16_t payload_length,
+                        uint8_t qos, uint8_t retain, mqtt_request_cb_t cb, void *arg) {
+    if (client->state != MINI_MQTT_CONNECTED) {
+        return ERR_CONN;
+    }
+    size_t topic_len = strlen(topic);
+    if (topic_len == 0 || topic_len > UINT16_MAX || qos > 1) {
+        return ERR_ARG;
+    }
+
+    mini_mqtt_request_t *request = NULL;
+    if (qos > 0) {
+        for (size_t i = 0; i < MQTT_REQ_MAX_IN_FLIGHT && request == NULL; i++) {
+            if (client->requests[i].pkt_id == 0) {
+                request = &client->requests[i];
+            }
+        }
+        if (request == NULL) {
+            return ERR_MEM;  // todas as vagas aguardando PUBACK
+        }
+    }
+
+    uint8_t topic_len_bytes[2], pkt_id_bytes[2];
+    store_u16(topic_len_bytes, (uint16_t)topic_len);
+    segment_t segments[4] = {
+        { topic_len_bytes, 2 },
+        { topic, (uint16_t)topic_len },
+    };
+    size_t count = 2;
+    uint16_t pkt_id = 0;
+    if (request != NULL) {
+        pkt_id = next_packet_id(client);
+        store_u16(pkt_id_bytes, pkt_id);
+        segments[count++] = (segment_t){ pkt_id_bytes, 2 };
+    }
+    segments[count++] = (segment_t){ payload, payload_length };
+
+    err_t err = send_packet(client, (uint8_t)(MQTT_PUBLISH | (qos << 1) | (retain ? 1 : 0)), segments, count);
+    if (err == ERR_OK && request != NULL) {
+        request->pkt_id = pkt_id;
+        request->cb = cb;
+        request->arg = arg;
+        request->sent_ms = client->last_tx_ms;
+    }
+    return err;
+}
+
+err_t mini_mqtt_subscribe(mini_mqtt_t *client, const char *topic, uint8_t qos) {
+    if (client->state != MINI_MQTT_CONNECTED) {
+        return ERR_CONN;
+    }
+    size_t topic_len = strlen(topic);
+    if (topic_len == 0 || topic_len > UINT16_MAX) {
+        return ERR_ARG;
+    }
+
+    uint8_t pkt_id_bytes[2], topic_len_bytes[2];
+    store_u16(pkt_id_bytes, next_packet_id(client));
+    store_u16(topic_len_bytes, (uint16_t)topic_len);
+    segment_t segments[4] = {
+        { pkt_id_bytes, 2 },
+        { topic_len_bytes, 2 },
+        { topic, (uint16_t)topic_len },
+        { &qos, 1 },
+    };
+    return send_packet(client, MQTT_SUBSCRIBE, segments, 4);
+}
+
+void mini_mqtt_set_inpub_callback(mini_mqtt_t *client, mqtt_incoming_publish_cb_t publish_cb,
+                                  mqtt_incoming_data_cb_t data_cb, void *arg) {
+    client->publish_cb = publish_cb;
+    client->data_cb = data_cb;
+    client->inpub_arg = arg;
+}
@@ -0,0 +1,101 @@
+#ifndef MINI_MQTT_H
+#define MINI_MQTT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lwip/tcp.h"
+#include "lwip/apps/mqtt.h"
+
+/* Cliente MQTT 3.1.1 mínimo sobre TCP raw do lwIP (opção RACK_MQTT_BACKEND=mini do CMake).
+ * Só o que o rack usa: CONNECT (clean session configurável), PUBLISH QoS 0/1, PUBACK,
+ * SUBSCRIBE e PINGREQ. Sem anel de saída próprio: cada pacote vai direto para o buffer
+ * de envio do TCP (tcp_write com cópia), então a "fila cheia" é o próprio TCP_SND_BUF.
+ * Os tipos de callback e os códigos de status são os do app MQTT do lwIP, para que
+ * mqtt_backend.h troque um cliente pelo outro sem mudar quem os usa.
+ * Todas as funções devem ser chamadas em contexto lwIP (ou sob cyw43_arch_lwip_begin()). */
+
+#define MINI_MQTT_RX_MAX          128     // maior pacote recebido guardado inteiro (comandos)
+#define MINI_MQTT_TOPIC_MAX       64      // maior tópico de publicação recebida
+#define MINI_MQTT_REQ_TIMEOUT_MS  30000   // sem PUBACK nesse prazo: callback com ERR_TIMEOUT
+#define MINI_MQTT_POLL_INTERVAL   2       // tcp_poll em ciclos de 500 ms
+
+typedef struct mini_mqtt mini_mqtt_t;
+
+typedef void (*mini_mqtt_connection_cb_t)(mini_mqtt_t *client, void *arg, mqtt_connection_status_t status);
+
+typedef enum {
+    MINI_MQTT_IDLE,
+    MINI_MQTT_CONNECTING,     // TCP em andamento ou CONNECT enviado, aguardando CONNACK
+    MINI_MQTT_CONNECTED,
+} mini_mqtt_state_t;
+
+// Publicação QoS 1 aguardando PUBACK
+typedef struct {
+    uint16_t pkt_id;            // 0 = livre
+    mqtt_request_cb_t cb;
+    void *arg;
+    uint32_t sent_ms;
+} mini_mqtt_request_t;
+
+struct mini_mqtt {
+    struct tcp_pcb *pcb;
+    mini_mqtt_state_t state;
+    bool clean_session;
+    uint16_t keep_alive_s;
+    uint16_t next_pkt_id;
+    uint32_t last_tx_ms;
+    uint32_t last_rx_ms;
+    bool ping_pending;
+
+    mini_mqtt_connection_cb_t connect_cb;
+    void *connect_arg;
+    mqtt_incoming_publish_cb_t publish_cb;
+    mqtt_incoming_data_cb_t data_cb;
+    void *inpub_arg;
+
+    mini_mqtt_request_t requests[MQTT_REQ_MAX_IN_FLIGHT];
+
+    // Recepção: cabeçalho fixo, tamanho restante e o início do corpo do pacote corrente
+    uint8_t rx_state;
+    uint8_t rx_header;
+    uint8_t rx_shift;
+    uint32_t rx_remaining;
+    uint32_t rx_read;
+    uint8_t rx_buf[MINI_MQTT_RX_MAX];
+
+    uint32_t rx_dropped;        // publicações recebidas maiores que MINI_MQTT_RX_MAX
+};
+
+// Estado inicial (clean session ligado); a estrutura é do chamador, normalmente estática
+void mini_mqtt_init(mini_mqtt_t *client);
+
+// Vale para o próximo CONNECT; false = sessão persistente no broker
+void mini_mqtt_set_clean_session(mini_mqtt_t *client, bool clean_session);
+
+/* Abre o TCP e já enfileira o CONNECT (o lwIP aceita dados em SYN_SENT), então as
+ * strings de `client_info` só precisam valer durante a chamada. Os campos de "will"
+ * não são suportados e são ignorados. O resultado chega em `cb`: MQTT_CONNECT_ACCEPTED,
+ * o código de recusa do CONNACK, ou MQTT_CONNECT_DISCONNECTED/TIMEOUT na queda. */
+err_t mini_mqtt_connect(mini_mqtt_t *client, const ip_addr_t *ip, uint16_t port, mini_mqtt_connection_cb_t cb,
+                        void *arg, const struct mqtt_connect_client_info_t *client_info);
+
+// Fecha o TCP sem chamar o callback de conexão; publicações sem PUBACK são esquecidas sem callback
+void mini_mqtt_disconnect(mini_mqtt_t *client);
+
+bool mini_mqtt_is_connected(const mini_mqtt_t *client);
+
+/* Publica `payload`. QoS 1 ocupa uma das MQTT_REQ_MAX_IN_FLIGHT vagas até o PUBACK
+ * (cb com ERR_OK) ou o prazo (cb com ERR_TIMEOUT); em QoS 0 `cb` não é usado.
+ * ERR_MEM: sem vaga ou sem espaço no buffer de envio do TCP, tente de novo depois.
+ * ERR_CONN: sem sessão. */
+err_t mini_mqtt_publish(mini_mqtt_t *client, const char *topic, const void *payload, uint16_t payload_length,
+                        uint8_t qos, uint8_t retain, mqtt_request_cb_t cb, void *arg);
+
+// Assina `topic`; o SUBACK só é verificado (recusa vai para o log)
+err_t mini_mqtt_subscribe(mini_mqtt_t *client, const char *topic, uint8_t qos);
+
+// Publicações recebidas: `publish_cb` com tópico e tamanho, depois `data_cb` com o payload inteiro
+void mini_mqtt_set_inpub_callback(mini_mqtt_t *client, mqtt_incoming_publish_cb_t publish_cb,
+                                  mqtt_incoming_data_cb_t data_cb, void *arg);
+
+#endif /* MINI_MQTT_H */
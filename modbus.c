@@ -0,0 +1,244 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Mestre Modbus RTU
+/ Descrição: Leitura periódica de registradores de PDUs/nobreaks em RS-485, com UART por DMA e reporte só de mudanças.
+/ Obs: Uma transação por vez. O DMA de recepção é armado antes da requisição e o pino DE é liberado por um alarme de
+/      hardware quando o último caractere termina de sair, a tempo da resposta do escravo. Quadros, queda/volta do escravo
+/      e deadband ficam em modbus_rtu.c, compilável no host.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/uart.h"
+#include "hardware/dma.h"
+#include "modbus.h"
+#include "modbus_rtu.h"
+#include "persist.h"
+
+#define MODBUS_UART           uart1
+#define MODBUS_PARITY         UART_PARITY_NONE
+#define MODBUS_BITS_PER_CHAR  10      // início + 8 dados + parada
+#define MODBUS_RELEASE_POLL_US 100    // nova checagem do fim da transmissão
+
+// Mapa usado sem mapa válido na flash: um PDU no endereço 1 e um nobreak no 2 (registradores de exemplo)
+static const modbus_reg_t default_regs[] = {
+    { "pdu_volts", 1, 4, 0x0000, 1, 0, 20, 10 },   // tensão de entrada, 0,1 V
+    { "pdu_amps",  1, 4, 0x0001, 1, 0, 5,  5  },   // corrente total, 0,1 A
+    { "pdu_watts", 1, 4, 0x0002, 2, 0, 50, 5  },   // potência ativa, 32 bits (alto, baixo)
+    { "ups_batt",  2, 4, 0x0000, 3, 0, 1,  10 },   // carga %, autonomia em min, estado
+};
+
+static modbus_map_t map;
+static modbus_entry_t entries[MODBUS_MAP_MAX];
+static modbus_stats_t stats;
+
+static uint tx_dma;
+static uint rx_dma;
+static uint8_t tx_frame[MODBUS_RTU_REQUEST_LEN];
+static uint8_t rx_frame[MODBUS_RTU_RESPONSE_LEN(MODBUS_REGS_MAX)];
+
+static bool bus_busy = false;
+static int current_entry = -1;           // -1: resultado descartado (entrada alterada durante a transação)
+static modbus_reg_t current_reg;         // cópia da leitura em curso: o mapa pode mudar antes da resposta
+static uint32_t expected_len;
+static uint32_t request_ms;
+static uint32_t next_entry = 0;          // rodízio entre entradas devidas no mesmo ciclo
+static volatile bool transmitting = false;
+
+static bool load_map(void) {
+    if (!persist_load(PERSIST_SLOT_MODBUS, &map, sizeof(map)) || map.version != MODBUS_MAP_VERSION ||
+        map.count > MODBUS_MAP_MAX) {
+        return false;
+    }
+    for (uint32_t i = 0; i < map.count; i++) {
+        if (!modbus_reg_valid(&map.regs[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool save_map(void) {
+    bool ok = persist_save(PERSIST_SLOT_MODBUS, &map, sizeof(map));
+    printf("[MODBUS] Mapa com %u leituras %s\n", map.count, ok ? "gravado" : "não gravado na flash");
+    return ok;
+}
+
+// Alarme de hardware: solta o barramento quando o último caractere terminar de sair
+static int64_t release_bus_callback(alarm_id_t id, void *user_data) {
+    if (dma_channel_is_busy(tx_dma) || (uart_get_hw(MODBUS_UART)->fr & UART_UARTFR_BUSY_BITS)) {
+        return -MODBUS_RELEASE_POLL_US;
+    }
+    gpio_put(MODBUS_DE_PIN, 0);
+    transmitting = false;
+    return 0;
+}
+
+static void start_transaction(uint32_t index, uint32_t now_ms) {
+    current_reg = map.regs[index];
+    modbus_rtu_build_request(&current_reg, tx_frame);
+
+    // Descarta ruído recebido com o barramento parado e arma a recepção antes de transmitir
+    while (uart_is_readable(MODBUS_UART)) {
+        uart_getc(MODBUS_UART);
+    }
+    expected_len = MODBUS_RTU_RESPONSE_LEN(current_reg.count);
+    dma_channel_set_write_addr(rx_dma, rx_frame, false);
+    dma_channel_set_trans_count(rx_dma, expected_len, true);
+
+    transmitting = true;
+    gpio_put(MODBUS_DE_PIN, 1);
+    dma_channel_transfer_from_buffer_now(tx_dma, tx_frame, sizeof(tx_frame));
+    uint32_t frame_us = sizeof(tx_frame) * MODBUS_BITS_PER_CHAR * 1000000u / MODBUS_BAUD;
+    if (add_alarm_in_us(frame_us, release_bus_callback, NULL, true) < 0) {
+        // Sem alarme livre a transação se perde, mas o barramento não pode ficar preso em transmissão
+        printf("[MODBUS] Sem alarme de hardware livre, abortando leitura\n");
+        gpio_put(MODBUS_DE_PIN, 0);
+        transmitting = false;
+    }
+
+    current_entry = (int)index;
+    request_ms = now_ms;
+    bus_busy = true;
+    stats.polls++;
+}
+
+static void count_result(modbus_rtu_result_t result, uint8_t exception) {
+    switch (result) {
+        case MODBUS_RTU_OK:
+            stats.ok++;
+            break;
+        case MODBUS_RTU_TIMEOUT:
+            stats.timeouts++;
+            break;
+        case MODBUS_RTU_BAD_FRAME:
+            stats.crc_errors++;
+            break;
+        case MODBUS_RTU_EXCEPTION:
+            stats.exceptions++;
+            stats.last_exception = exception;
+            printf("[MODBUS] %s: exceção %u\n", current_reg.name, exception);
+            break;
+    }
+}
+
+void modbus_init(uint32_t now_ms) {
+    uart_init(MODBUS_UART, MODBUS_BAUD);
+    uart_set_format(MODBUS_UART, 8, 1, MODBUS_PARITY);
+    uart_set_fifo_enabled(MODBUS_UART, true);
+    gpio_set_function(MODBUS_TX_PIN, GPIO_FUNC_UART);
+    gpio_set_function(MODBUS_RX_PIN, GPIO_FUNC_UART);
+    gpio_pull_up(MODBUS_RX_PIN);   // o transceptor solta a linha enquanto transmite
+
+    gpio_init(MODBUS_DE_PIN);
+    gpio_set_dir(MODBUS_DE_PIN, GPIO_OUT);
+    gpio_put(MODBUS_DE_PIN, 0);
+
+    tx_dma = (uint)dma_claim_unused_channel(true);
+    dma_channel_config config = dma_channel_get_default_config(tx_dma);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, false);
+    channel_config_set_dreq(&config, uart_get_dreq(MODBUS_UART, true));
+    dma_channel_configure(tx_dma, &config, &uart_get_hw(MODBUS_UART)->dr, tx_frame, 0, false);
+
+    rx_dma = (uint)dma_claim_unused_channel(true);
+    config = dma_channel_get_default_config(rx_dma);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+    channel_config_set_read_increment(&config, false);
+    channel_config_set_write_increment(&config, true);
+    channel_config_set_dreq(&config, uart_get_dreq(MODBUS_UART, false));
+    dma_channel_configure(rx_dma, &config, rx_frame, &uart_get_hw(MODBUS_UART)->dr, 0, false);
+
+    if (load_map()) {
+        printf("[MODBUS] Mapa da flash: %u leituras\n", map.count);
+    } else {
+        memset(&map, 0, sizeof(map));
+        map.version = MODBUS_MAP_VERSION;
+        map.count = count_of(default_regs);
+        memcpy(map.regs, default_regs, sizeof(default_regs));
+        printf("[MODBUS] Sem mapa na flash, usando o padrão (%u leituras)\n", map.count);
+    }
+    for (uint32_t i = 0; i < MODBUS_MAP_MAX; i++) {
+        modbus_entry_reset(&entries[i], now_ms);
+    }
+}
+
+void modbus_tick(uint32_t now_ms) {
+    if (bus_busy) {
+        uint32_t received = expected_len - dma_channel_hw_addr(rx_dma)->transfer_count;
+        if (transmitting || !modbus_rtu_response_done(&current_reg, rx_frame, received, now_ms - request_ms)) {
+            return;
+        }
+        dma_channel_abort(rx_dma);
+        bus_busy = false;
+        if (current_entry >= 0) {
+            uint8_t exception = 0;
+            modbus_rtu_result_t result = modbus_rtu_check_response(&current_reg, rx_frame, received, &exception);
+            count_result(result, exception);
+            modbus_entry_update(&entries[current_entry], &current_reg, result, rx_frame);
+        }
+    }
+
+    for (uint32_t i = 0; i < map.count; i++) {
+        uint32_t index = (next_entry + i) % map.count;
+        if ((int32_t)(now_ms - entries[index].next_poll_ms) >= 0) {
+            entries[index].next_poll_ms = now_ms + map.regs[index].period_s * 1000u;
+            next_entry = index + 1;
+            start_transaction(index, now_ms);
+            break;
+        }
+    }
+}
+
+bool modbus_take_change(modbus_change_t *change) {
+    for (uint32_t i = 0; i < map.count; i++) {
+        if (modbus_entry_take(&entries[i], &map.regs[i], change)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool modbus_map_set(uint32_t index, const modbus_reg_t *reg) {
+    if (index > map.count || index >= MODBUS_MAP_MAX || !modbus_reg_valid(reg)) {
+        return false;
+    }
+    map.regs[index] = *reg;
+    if (index == map.count) {
+        map.count++;
+    }
+    if (current_entry == (int)index) {
+        current_entry = -1;
+    }
+    modbus_entry_reset(&entries[index], to_ms_since_boot(get_absolute_time()));
+    return save_map();
+}
+
+bool modbus_map_remove(uint32_t index) {
+    if (index >= map.count) {
+        return false;
+    }
+    uint32_t tail = map.count - index - 1;
+    memmove(&map.regs[index], &map.regs[index + 1], tail * sizeof(map.regs[0]));
+    memmove(&entries[index], &entries[index + 1], tail * sizeof(entries[0]));
+    map.count--;
+    memset(&map.regs[map.count], 0, sizeof(map.regs[0]));
+
+    if (current_entry == (int)index) {
+        current_entry = -1;
+    } else if (current_entry > (int)index) {
+        current_entry--;
+    }
+    next_entry = 0;
+    return save_map();
+}
+
+const modbus_map_t *modbus_map(void) {
+    return &map;
+}
+
+void modbus_get_stats(modbus_stats_t *stats_out) {
+    *stats_out = stats;
+}
@@ -0,0 +1,84 @@
+#ifndef MODBUS_H
+#define MODBUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Mestre Modbus RTU em RS-485 para PDUs e nobreaks do rack. Um transceptor half-duplex
+ * (DE e /RE ligados juntos em MODBUS_DE_PIN) fica na UART1 em 8N1; requisição e resposta vão
+ * por DMA e o fim da transmissão é detectado por alarme de hardware, então modbus_tick()
+ * nunca bloqueia: cada chamada conclui a transação anterior e inicia a próxima devida.
+ *
+ * O mapa de registradores (até MODBUS_MAP_MAX leituras com função 3 ou 4) fica no slot
+ * PERSIST_SLOT_MODBUS da flash; sem mapa válido gravado vale o mapa padrão compilado.
+ * Como em sensor_health, as mudanças são consumidas com modbus_take_change(): uma leitura
+ * só é reportada quando algum registrador se afasta mais que `deadband` do último valor
+ * reportado, ou quando o dispositivo cai/volta (MODBUS_FAIL_THRESHOLD falhas seguidas). */
+
+#define MODBUS_TX_PIN         8
+#define MODBUS_RX_PIN         9
+#define MODBUS_DE_PIN         10
+#define MODBUS_BAUD           9600
+#define MODBUS_TIMEOUT_MS     300    // na prática arredondado para cima pelo ciclo do loop principal
+#define MODBUS_FAIL_THRESHOLD 3
+
+#define MODBUS_MAP_MAX        16
+#define MODBUS_REGS_MAX       8      // registradores por leitura
+#define MODBUS_NAME_MAX       12     // subtópico: <rack>/modbus/<name>
+#define MODBUS_MAP_VERSION    1
+
+// Uma leitura do mapa (formato gravado em flash: não reordenar campos)
+typedef struct {
+    char name[MODBUS_NAME_MAX];
+    uint8_t unit;          // endereço do escravo (1 a 247)
+    uint8_t function;      // 3 = holding registers, 4 = input registers
+    uint16_t address;
+    uint8_t count;         // 1 a MODBUS_REGS_MAX
+    uint8_t reserved;
+    uint16_t deadband;     // variação mínima, em unidades brutas, para reportar
+    uint16_t period_s;     // intervalo entre leituras
+} modbus_reg_t;
+
+typedef struct {
+    uint16_t version;
+    uint16_t count;
+    modbus_reg_t regs[MODBUS_MAP_MAX];
+} modbus_map_t;
+
+// Mudança pendente de uma leitura do mapa
+typedef struct {
+    const modbus_reg_t *reg;
+    bool online;
+    uint16_t values[MODBUS_REGS_MAX];
+} modbus_change_t;
+
+typedef struct {
+    uint32_t polls;
+    uint32_t ok;
+    uint32_t timeouts;
+    uint32_t crc_errors;
+    uint32_t exceptions;     // respostas de exceção do escravo
+    uint8_t last_exception;
+} modbus_stats_t;
+
+// Configura UART, DMA e pino DE e carrega o mapa da flash (ou o padrão)
+void modbus_init(uint32_t now_ms);
+
+// Avança a transação em curso e agenda a próxima; chamar a cada iteração do loop principal
+void modbus_tick(uint32_t now_ms);
+
+// Copia a próxima mudança pendente e a marca como reportada; false se não houver
+bool modbus_take_change(modbus_change_t *change);
+
+/* Grava a entrada `index` do mapa (index == quantidade atual acrescenta uma nova) e salva
+ * o mapa na flash; false se a entrada for inválida. */
+bool modbus_map_set(uint32_t index, const modbus_reg_t *reg);
+
+// Remove a entrada `index` do mapa e salva na flash
+bool modbus_map_remove(uint32_t index);
+
+const modbus_map_t *modbus_map(void);
+
+void modbus_get_stats(modbus_stats_t *stats);
+
+#endif /* MODBUS_H */
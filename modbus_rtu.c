@@ -0,0 +1,144 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Quadros e estado do mestre Modbus RTU
+/ Descrição: Requisição e validação da resposta RTU, queda/volta do escravo e reporte por deadband de cada leitura do mapa.
+/ Obs: Sem dependências do Pico SDK: modbus.c faz a UART/DMA e chama estas funções, e tests/test_modbus.c as exercita no host.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "modbus_rtu.h"
+#include "crc.h"
+
+static uint16_t frame_crc(const uint8_t *frame, uint32_t len) {
+    return (uint16_t)(frame[len - 2] | (frame[len - 1] << 8));
+}
+
+static bool is_exception(const modbus_reg_t *reg, const uint8_t *frame, uint32_t received) {
+    return received >= MODBUS_RTU_EXCEPTION_LEN && frame[0] == reg->unit && frame[1] == (reg->function | 0x80) &&
+           crc16_modbus(frame, 3) == frame_crc(frame, MODBUS_RTU_EXCEPTION_LEN);
+}
+
+bool modbus_reg_valid(const modbus_reg_t *reg) {
+    const char *end = memchr(reg->name, '\0', MODBUS_NAME_MAX);
+    size_t name_len = end != NULL ? (size_t)(end - reg->name) : 0;
+    if (name_len == 0) {
+        return false;  // vazio ou sem terminador
+    }
+    for (size_t i = 0; i < name_len; i++) {
+        char c = reg->name[i];
+        if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_')) {
+            return false;  // vai direto no tópico MQTT
+        }
+    }
+    return reg->unit >= 1 && reg->unit <= 247 && (reg->function == 3 || reg->function == 4) &&
+           reg->count >= 1 && reg->count <= MODBUS_REGS_MAX && reg->period_s > 0;
+}
+
+void modbus_rtu_build_request(const modbus_reg_t *reg, uint8_t frame[MODBUS_RTU_REQUEST_LEN]) {
+    frame[0] = reg->unit;
+    frame[1] = reg->function;
+    frame[2] = (uint8_t)(reg->address >> 8);
+    frame[3] = (uint8_t)reg->address;
+    frame[4] = 0;
+    frame[5] = reg->count;
+    uint16_t crc = crc16_modbus(frame, 6);
+    frame[6] = (uint8_t)crc;
+    frame[7] = (uint8_t)(crc >> 8);
+}
+
+bool modbus_rtu_response_done(const modbus_reg_t *reg, const uint8_t *frame, uint32_t received,
+                              uint32_t elapsed_ms) {
+    return received >= MODBUS_RTU_RESPONSE_LEN(reg->count) || elapsed_ms >= MODBUS_TIMEOUT_MS ||
+           is_exception(reg, frame, received);
+}
+
+modbus_rtu_result_t modbus_rtu_check_response(const modbus_reg_t *reg, const uint8_t *frame, uint32_t received,
+                                              uint8_t *exception) {
+    if (is_exception(reg, frame, received)) {
+        *exception = frame[2];
+        return MODBUS_RTU_EXCEPTION;
+    }
+    uint32_t expected = MODBUS_RTU_RESPONSE_LEN(reg->count);
+    if (received < expected) {
+        return MODBUS_RTU_TIMEOUT;
+    }
+    if (crc16_modbus(frame, expected - 2) != frame_crc(frame, expected) || frame[0] != reg->unit ||
+        frame[1] != reg->function || frame[2] != 2 * reg->count) {
+        return MODBUS_RTU_BAD_FRAME;
+    }
+    return MODBUS_RTU_OK;
+}
+
+void modbus_entry_reset(modbus_entry_t *entry, uint32_t now_ms) {
+    memset(entry, 0, sizeof(*entry));
+    entry->online = true;
+    entry->next_poll_ms = now_ms;
+}
+
+void modbus_entry_update(modbus_entry_t *entry, const modbus_reg_t *reg, modbus_rtu_result_t result,
+                         const uint8_t *frame) {
+    if (result != MODBUS_RTU_OK) {
+        if (entry->online && ++entry->failures >= MODBUS_FAIL_THRESHOLD) {
+            printf("[MODBUS] %s: escravo %u sem resposta\n", reg->name, reg->unit);
+            entry->online = false;
+            entry->pending = true;
+        }
+        return;
+    }
+
+    bool changed = !entry->has_report || !entry->online;
+    for (uint32_t i = 0; i < reg->count; i++) {
+        uint16_t value = (uint16_t)((frame[3 + 2 * i] << 8) | frame[4 + 2 * i]);
+        uint16_t delta = value > entry->reported[i] ? value - entry->reported[i] : entry->reported[i] - value;
+        if (delta > reg->deadband) {
+            changed = true;
+        }
+        entry->latest[i] = value;
+    }
+    entry->failures = 0;
+    entry->online = true;
+    if (changed) {
+        entry->pending = true;
+    }
+}
+
+bool modbus_entry_take(modbus_entry_t *entry, const modbus_reg_t *reg, modbus_change_t *change) {
+    if (!entry->pending) {
+        return false;
+    }
+    entry->pending = false;
+    if (entry->online) {
+        memcpy(entry->reported, entry->latest, sizeof(entry->reported));
+        entry->has_report = true;
+    }
+    change->reg = reg;
+    change->online = entry->online;
+    memcpy(change->values, entry->reported, sizeof(change->values));
+    return true;
+}
+
+// Acrescenta em buf[*pos]; depois de estourar só soma o comprimento, sem escrever fora de buf
+static void append(char *buf, size_t len, size_t *pos, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(*pos < len ? buf + *pos : NULL, *pos < len ? len - *pos : 0, format, args);
+    va_end(args);
+    *pos += n > 0 ? (size_t)n : 0;
+}
+
+int modbus_format_change(char *buf, size_t len, const modbus_change_t *change) {
+    const modbus_reg_t *reg = change->reg;
+    size_t pos = 0;
+    append(buf, len, &pos, "{\"unit\":%u,\"fc\":%u,\"addr\":%u,\"online\":%s", reg->unit, reg->function,
+           reg->address, change->online ? "true" : "false");
+    if (change->online) {
+        append(buf, len, &pos, ",\"v\":[");
+        for (uint32_t i = 0; i < reg->count; i++) {
+            append(buf, len, &pos, "%s%u", i > 0 ? "," : "", change->values[i]);
+        }
+        append(buf, len, &pos, "]");
+    }
+    append(buf, len, &pos, "}");
+    return (int)pos;
+}
@@ -0,0 +1,67 @@
+#ifndef MODBUS_RTU_H
+#define MODBUS_RTU_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "modbus.h"
+
+/* Lógica pura do mestre Modbus (sem Pico SDK: compilável no host, como rate_limit e outbox):
+ * montagem da requisição, validação da resposta, estado de cada leitura do mapa (falhas
+ * seguidas, queda/volta do escravo, deadband) e o JSON publicado. modbus.c só cuida da UART,
+ * do DMA, do pino DE e da flash. */
+
+#define MODBUS_RTU_REQUEST_LEN      8
+#define MODBUS_RTU_RESPONSE_LEN(count) (5u + 2u * (count))
+#define MODBUS_RTU_EXCEPTION_LEN    5
+
+typedef enum {
+    MODBUS_RTU_OK,
+    MODBUS_RTU_TIMEOUT,      // resposta incompleta no prazo
+    MODBUS_RTU_BAD_FRAME,    // CRC, escravo, função ou contagem de bytes errados
+    MODBUS_RTU_EXCEPTION,    // função | 0x80 com o código de exceção
+} modbus_rtu_result_t;
+
+// Estado de uma leitura do mapa entre transações
+typedef struct {
+    uint16_t latest[MODBUS_REGS_MAX];
+    uint16_t reported[MODBUS_REGS_MAX];
+    bool has_report;
+    bool online;
+    bool pending;
+    uint8_t failures;
+    uint32_t next_poll_ms;
+} modbus_entry_t;
+
+// Nome [a-z0-9_] (vai no tópico), escravo 1 a 247, função 3 ou 4, 1 a MODBUS_REGS_MAX registradores
+bool modbus_reg_valid(const modbus_reg_t *reg);
+
+// Requisição de leitura (função 3/4) com o CRC, byte baixo primeiro
+void modbus_rtu_build_request(const modbus_reg_t *reg, uint8_t frame[MODBUS_RTU_REQUEST_LEN]);
+
+/* A transação terminou: resposta completa (inclusive uma exceção de 5 bytes, que não
+ * precisa esperar o prazo) ou MODBUS_TIMEOUT_MS desde a requisição. */
+bool modbus_rtu_response_done(const modbus_reg_t *reg, const uint8_t *frame, uint32_t received,
+                              uint32_t elapsed_ms);
+
+/* Classifica os `received` bytes recebidos para a leitura `reg`; em MODBUS_RTU_EXCEPTION
+ * grava o código em *exception. */
+modbus_rtu_result_t modbus_rtu_check_response(const modbus_reg_t *reg, const uint8_t *frame, uint32_t received,
+                                              uint8_t *exception);
+
+void modbus_entry_reset(modbus_entry_t *entry, uint32_t now_ms);
+
+/* Aplica o resultado de uma transação: MODBUS_FAIL_THRESHOLD falhas seguidas derrubam a
+ * leitura; uma resposta válida a traz de volta. Marca a leitura pendente na queda, na volta,
+ * na primeira leitura e quando algum registrador se afasta mais que `deadband` do último
+ * valor reportado. `frame` só é lido em MODBUS_RTU_OK. */
+void modbus_entry_update(modbus_entry_t *entry, const modbus_reg_t *reg, modbus_rtu_result_t result,
+                         const uint8_t *frame);
+
+// Consome a mudança pendente da leitura; false se não houver
+bool modbus_entry_take(modbus_entry_t *entry, const modbus_reg_t *reg, modbus_change_t *change);
+
+// JSON de <rack>/modbus/<nome>; retorna o comprimento como snprintf (>= len se não couber)
+int modbus_format_change(char *buf, size_t len, const modbus_change_t *change);
+
+#endif /* MODBUS_RTU_H */
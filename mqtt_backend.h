@@ -0,0 +1,42 @@
+#ifndef MQTT_BACKEND_H
+#define MQTT_BACKEND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lwip/apps/mqtt.h"
+
+/* Cliente MQTT usado por mqtt_link e outbox, escolhido em tempo de compilação pela opção
+ * RACK_MQTT_BACKEND do CMake:
+ *   lwip: app MQTT do lwIP (pico_lwip_mqtt), anel de saída de MQTT_OUTPUT_RINGBUF_SIZE
+ *   mini: mini_mqtt.h, pacotes direto no buffer de envio do TCP (TCP_SND_BUF)
+ * Os dois usam os mesmos callbacks e códigos de erro do lwIP. */
+
+#if RACK_MQTT_MINI
+#include "mini_mqtt.h"
+
+typedef mini_mqtt_t mqtt_backend_t;
+
+#define MQTT_BACKEND_NAME   "mini"
+// Maior rajada que o cliente aceita de uma vez antes de devolver ERR_MEM
+#define MQTT_BACKEND_TX_SIZE TCP_SND_BUF
+
+#define mqtt_backend_connect            mini_mqtt_connect
+#define mqtt_backend_disconnect         mini_mqtt_disconnect
+#define mqtt_backend_publish            mini_mqtt_publish
+#define mqtt_backend_subscribe          mini_mqtt_subscribe
+#define mqtt_backend_set_inpub_callback mini_mqtt_set_inpub_callback
+
+#else
+typedef mqtt_client_t mqtt_backend_t;
+
+#define MQTT_BACKEND_NAME   "lwip"
+#define MQTT_BACKEND_TX_SIZE MQTT_OUTPUT_RINGBUF_SIZE
+
+#define mqtt_backend_connect            mqtt_client_connect
+#define mqtt_backend_disconnect         mqtt_disconnect
+#define mqtt_backend_publish            mqtt_publish
+#define mqtt_backend_subscribe(client, topic, qos) mqtt_subscribe(client, topic, qos, NULL, NULL)
+#define mqtt_backend_set_inpub_callback mqtt_set_inpub_callback
+#endif
+
+#endif /* MQTT_BACKEND_H */
@@ -0,0 +1,366 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Conexão MQTT
+/ Descrição: Máquina de estados DNS -> CONNECT -> conectado, com reconexão, backoff e failover entre brokers.
+/ Obs: A parte do DNS foi adaptada de códigos de exemplos encontrado na internet.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/cyw43_arch.h"
+#include "mqtt_backend.h"
+#if !RACK_MQTT_MINI && (RACK_HEAP_FREE || RACK_MQTT_PERSISTENT_SESSION)
+#include "lwip/apps/mqtt_priv.h"
+#endif
+#include "lwip/ip_addr.h"
+#include "lwip/dns.h"
+#include "rack_inteligente.h"
+#include "broker_list.h"
+#include "mqtt_link.h"
+#include "rack_format.h"
+#include "fleet_slot.h"
+#if RACK_FAULT_INJECTION
+#include "fault_inject.h"
+#endif
+
+// Maior comando aceito no tópico de comandos
+#define MQTT_LINK_COMMAND_MAX 64
+
+typedef enum {
+    LINK_IDLE,
+    LINK_RESOLVING,
+    LINK_CONNECTING,
+    LINK_CONNECTED,
+} link_state_t;
+
+// Eventos gerados nos callbacks do lwIP e tratados em mqtt_link_tick()
+typedef enum {
+    LINK_EVENT_NONE,
+    LINK_EVENT_CONNECTED,
+    LINK_EVENT_FAILED,
+    LINK_EVENT_LOST,
+} link_event_t;
+
+static mqtt_backend_t *mqtt_client;
+#if RACK_HEAP_FREE || RACK_MQTT_MINI
+static mqtt_backend_t mqtt_client_storage;  // Cliente estático: sem mqtt_client_new() (malloc)
+#endif
+static ip_addr_t broker_ip;
+static char client_id[16];  // estável entre reconexões e reboots: "rack-<número do rack>"
+static void (*on_session_up)(uint32_t now_ms) = NULL;
+static void (*on_session_down)(void) = NULL;
+
+static char command_topic[64];
+static char command_rx[MQTT_LINK_COMMAND_MAX];   // montagem do comando em recepção (contexto lwIP)
+static size_t command_rx_len = 0;
+static bool command_rx_active = false;
+static char command_pending[MQTT_LINK_COMMAND_MAX];
+static volatile bool command_ready = false;
+
+static volatile link_state_t link_state = LINK_IDLE;
+static volatile link_event_t link_event = LINK_EVENT_NONE;
+static volatile bool mqtt_connected = false;
+static uint32_t attempt_start_ms = 0;
+static uint32_t next_attempt_ms = 0;
+static uint32_t backoff_ms = MQTT_LINK_BACKOFF_MIN_MS;
+static uint32_t reconnect_count = 0;
+
+// Callback de conexão MQTT
+static void mqtt_connection_callback(mqtt_backend_t *client, void *arg, mqtt_connection_status_t status) {
+    if (status == MQTT_CONNECT_ACCEPTED) {
+        printf("[MQTT] Conectado ao broker!\n");
+        mqtt_connected = true;
+        link_state = LINK_CONNECTED;
+        link_event = LINK_EVENT_CONNECTED;
+    } else {
+        printf("[MQTT] Falha na conexão MQTT. Código: %d\n", status);
+        link_event = mqtt_connected ? LINK_EVENT_LOST : LINK_EVENT_FAILED;
+        mqtt_connected = false;
+    }
+}
+
+// Início de uma publicação recebida (contexto lwIP)
+static void mqtt_incoming_publish_callback(void *arg, const char *topic, uint32_t tot_len) {
+    command_rx_active = strcmp(topic, command_topic) == 0 && tot_len < MQTT_LINK_COMMAND_MAX;
+    command_rx_len = 0;
+    if (!command_rx_active) {
+        printf("[MQTT] Mensagem ignorada em '%s' (%u bytes)\n", topic, (unsigned)tot_len);
+    }
+}
+
+static void mqtt_incoming_data_callback(void *arg, const uint8_t *data, uint16_t len, uint8_t flags) {
+    if (!command_rx_active) {
+        return;
+    }
+    if (command_rx_len + len >= MQTT_LINK_COMMAND_MAX) {
+        command_rx_active = false;
+        return;
+    }
+    memcpy(&command_rx[command_rx_len], data, len);
+    command_rx_len += len;
+
+    if (flags & MQTT_DATA_FLAG_LAST) {
+        command_rx_active = false;
+        if (command_ready) {
+            printf("[MQTT] Comando anterior ainda pendente, descartando o novo\n");
+            return;
+        }
+        memcpy(command_pending, command_rx, command_rx_len);
+        command_pending[command_rx_len] = '\0';
+        command_ready = true;
+    }
+}
+
+static void subscribe_commands(void) {
+    if (command_topic[0] == '\0') {
+        return;
+    }
+    cyw43_arch_lwip_begin();
+    err_t err = mqtt_backend_subscribe(mqtt_client, command_topic, 1);
+    cyw43_arch_lwip_end();
+    if (err == ERR_OK) {
+        printf("[MQTT] Assinando comandos em '%s'\n", command_topic);
+    } else {
+        printf("[MQTT] Erro ao assinar '%s': %d\n", command_topic, err);
+    }
+}
+
+#if RACK_MQTT_PERSISTENT_SESSION && !RACK_MQTT_MINI
+/* O app MQTT do lwIP sempre conecta com clean session e não tem opção para isso. O pacote
+ * CONNECT fica no anel de saída até o TCP conectar, então o flag é limpo ali mesmo, depois de
+ * validar o cabeçalho. Depende do layout interno do anel (mqtt_priv.h): por isso a opção vem
+ * desligada no backend lwip. A sessão guarda só as assinaturas e os comandos QoS 1 pendentes
+ * no broker; as publicações sem PUBACK não são retomadas com DUP, a outbox as publica de novo. */
+static void request_persistent_session(mqtt_client_t *client) {
+    static const uint8_t protocol[] = { 0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04 };
+    const uint8_t clean_session_flag = 0x02;
+    uint8_t *buf = client->output.buf;
+
+    // Cabeçalho fixo: tipo (1 byte) + tamanho restante (1 a 4 bytes)
+    size_t pos = 1;
+    while (pos < 4 && (buf[pos] & 0x80)) {
+        pos++;
+    }
+    pos++;
+
+    if (client->output.get != 0 || client->output.put < pos + sizeof(protocol) + 1 ||
+        buf[0] != 0x10 || memcmp(&buf[pos], protocol, sizeof(protocol)) != 0) {
+        printf("[MQTT] CONNECT inesperado no anel de saída, mantendo clean session\n");
+        return;
+    }
+    buf[pos + sizeof(protocol)] &= (uint8_t)~clean_session_flag;
+}
+#endif
+
+// Callback de DNS
+static void dns_check_callback(const char *name, const ip_addr_t *ipaddr, void *callback_arg) {
+#if RACK_FAULT_INJECTION
+    if (fault_inject_dns_should_fail()) {
+        ipaddr = NULL;
+    }
+#endif
+    if (link_state != LINK_RESOLVING) {
+        return;  // tentativa já expirou
+    }
+    if (ipaddr == NULL) {
+        printf("[DNS] Falha ao resolver DNS para %s\n", name);
+        link_event = LINK_EVENT_FAILED;
+        return;
+    }
+
+    broker_ip = *ipaddr;
+    printf("[DNS] Resolvido: %s -> %s\n", name, ipaddr_ntoa(ipaddr));
+
+    struct mqtt_connect_client_info_t ci = {
+        .client_id = client_id,
+        .keep_alive = 60,
+        .client_user = NULL,
+        .client_pass = NULL,
+        .will_topic = NULL,
+        .will_msg = NULL,
+        .will_qos = 0,
+        .will_retain = 0
+    };
+
+    printf("[MQTT] Conectando ao broker...\n");
+    link_state = LINK_CONNECTING;
+    err_t err = mqtt_backend_connect(mqtt_client, &broker_ip, MQTT_BROKER_PORT, mqtt_connection_callback, NULL, &ci);
+    if (err != ERR_OK) {
+        printf("[MQTT] Erro ao iniciar conexão: %d\n", err);
+        link_event = LINK_EVENT_FAILED;
+        return;
+    }
+    /* mqtt_client_connect() zera o cliente; o callback precisa estar instalado antes do CONNACK,
+     * pois com sessão persistente o broker entrega os comandos QoS 1 enfileirados logo em seguida */
+    mqtt_backend_set_inpub_callback(mqtt_client, mqtt_incoming_publish_callback, mqtt_incoming_data_callback, NULL);
+#if RACK_MQTT_PERSISTENT_SESSION && !RACK_MQTT_MINI
+    request_persistent_session(mqtt_client);
+#endif
+}
+
+static void start_attempt(uint32_t now_ms) {
+    const char *host = broker_list_current();
+    attempt_start_ms = now_ms;
+    link_state = LINK_RESOLVING;
+
+    printf("[DNS] Resolvendo %s...\n", host);
+    cyw43_arch_lwip_begin();
+    err_t err = dns_gethostbyname(host, &broker_ip, dns_check_callback, NULL);
+    if (err == ERR_OK) {
+        dns_check_callback(host, &broker_ip, NULL);
+    } else if (err != ERR_INPROGRESS) {
+        printf("[DNS] Erro ao resolver DNS: %d\n", err);
+        link_event = LINK_EVENT_FAILED;
+    }
+    cyw43_arch_lwip_end();
+}
+
+// Backoff com "equal jitter" (metade fixa, metade aleatória) para não sincronizar a frota
+static void schedule_retry(uint32_t now_ms, uint32_t extra_delay_ms) {
+    uint32_t delay_ms = extra_delay_ms + backoff_ms / 2 + fleet_jitter_ms(backoff_ms / 2);
+    link_state = LINK_IDLE;
+    next_attempt_ms = now_ms + delay_ms;
+    printf("[MQTT] Nova tentativa em %u ms\n", (unsigned)delay_ms);
+    backoff_ms = backoff_ms * 2 > MQTT_LINK_BACKOFF_MAX_MS ? MQTT_LINK_BACKOFF_MAX_MS : backoff_ms * 2;
+}
+
+void mqtt_link_init(void) {
+#if RACK_MQTT_MINI
+    // O cliente mínimo escolhe clean session no próprio CONNECT
+    mqtt_client = &mqtt_client_storage;
+    mini_mqtt_init(mqtt_client);
+#if RACK_MQTT_PERSISTENT_SESSION
+    mini_mqtt_set_clean_session(mqtt_client, false);
+#endif
+#elif RACK_HEAP_FREE
+    mqtt_client = &mqtt_client_storage;
+#else
+    mqtt_client = mqtt_client_new();
+#endif
+    // Estado zerado aqui (e não só na declaração) para que os testes no host repitam cenários
+    link_state = LINK_IDLE;
+    link_event = LINK_EVENT_NONE;
+    mqtt_connected = false;
+    attempt_start_ms = 0;
+    next_attempt_ms = 0;
+    backoff_ms = MQTT_LINK_BACKOFF_MIN_MS;
+    reconnect_count = 0;
+    on_session_up = NULL;
+    on_session_down = NULL;
+    command_topic[0] = '\0';
+    command_rx_len = 0;
+    command_rx_active = false;
+    command_ready = false;
+
+    broker_list_init(MQTT_BROKER, MQTT_BROKER_PORT);
+    format_rack_client_id(client_id, sizeof(client_id), rack_number_parse(MQTT_RACK_NUMBER));
+}
+
+void mqtt_link_set_command_topic(const char *topic) {
+    snprintf(command_topic, sizeof(command_topic), "%s", topic);
+}
+
+bool mqtt_link_take_command(char *buf, size_t len) {
+    if (!command_ready) {
+        return false;
+    }
+    snprintf(buf, len, "%s", command_pending);
+    command_ready = false;
+    return true;
+}
+
+void mqtt_link_set_session_callbacks(void (*session_up)(uint32_t now_ms), void (*session_down)(void)) {
+    on_session_up = session_up;
+    on_session_down = session_down;
+}
+
+void mqtt_link_tick(uint32_t now_ms) {
+    // Os callbacks do lwIP escrevem link_event em contexto de IRQ: ler e limpar sob a trava
+    cyw43_arch_lwip_begin();
+    link_event_t event = link_event;
+    link_event = LINK_EVENT_NONE;
+    cyw43_arch_lwip_end();
+
+    switch (event) {
+        case LINK_EVENT_CONNECTED:
+            broker_list_report_success(now_ms);
+            backoff_ms = MQTT_LINK_BACKOFF_MIN_MS;
+            // Com sessão persistente a assinatura sobrevive, mas reassinar é inofensivo e cobre sessões novas
+            subscribe_commands();
+            if (on_session_up != NULL) {
+                on_session_up(now_ms);
+            }
+            break;
+        case LINK_EVENT_FAILED:
+            cyw43_arch_lwip_begin();
+            mqtt_backend_disconnect(mqtt_client);
+            cyw43_arch_lwip_end();
+            broker_list_report_failure(now_ms);
+            schedule_retry(now_ms, 0);
+            break;
+        case LINK_EVENT_LOST:
+            /* Queda após sessão estabelecida: reconecta logo, sem penalizar o broker, mas na
+             * fatia do rack, já que uma reinicialização do broker derruba a frota inteira */
+            reconnect_count++;
+            backoff_ms = MQTT_LINK_BACKOFF_MIN_MS;
+            if (on_session_down != NULL) {
+                on_session_down();
+            }
+            schedule_retry(now_ms, fleet_slot_offset_ms(FLEET_RECONNECT_WINDOW_MS));
+            break;
+        default:
+            break;
+    }
+
+    switch (link_state) {
+        case LINK_IDLE:
+            if (broker_list_count() > 0 && (int32_t)(now_ms - next_attempt_ms) >= 0) {
+                start_attempt(now_ms);
+            }
+            break;
+
+        case LINK_RESOLVING:
+        case LINK_CONNECTING:
+            if (now_ms - attempt_start_ms >= MQTT_LINK_ATTEMPT_TIMEOUT_MS) {
+                cyw43_arch_lwip_begin();
+                bool timed_out = link_event == LINK_EVENT_NONE;
+                if (timed_out) {
+                    link_event = LINK_EVENT_FAILED;
+                }
+                cyw43_arch_lwip_end();
+                if (timed_out) {
+                    printf("[MQTT] Tempo esgotado conectando a %s\n", broker_list_current());
+                }
+            }
+            break;
+
+        case LINK_CONNECTED:
+            if (broker_list_poll_primary(now_ms)) {
+                mqtt_link_drop();
+                next_attempt_ms = now_ms;
+            }
+            break;
+    }
+}
+
+bool mqtt_link_is_connected(void) {
+    return mqtt_connected;
+}
+
+mqtt_backend_t *mqtt_link_client(void) {
+    return mqtt_client;
+}
+
+void mqtt_link_drop(void) {
+    cyw43_arch_lwip_begin();
+    mqtt_backend_disconnect(mqtt_client);
+    if (mqtt_connected) {
+        mqtt_connected = false;
+        link_event = LINK_EVENT_LOST;
+    }
+    cyw43_arch_lwip_end();
+}
+
+uint32_t mqtt_link_reconnects(void) {
+    return reconnect_count;
+}
@@ -0,0 +1,42 @@
+#ifndef MQTT_LINK_H
+#define MQTT_LINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "mqtt_backend.h"
+
+/* Gerência da conexão MQTT: resolução DNS, conexão ao broker corrente da lista de
+ * failover, reconexão com backoff exponencial e retorno ao primário. */
+
+#define MQTT_BROKER_PORT              1883
+#define MQTT_LINK_BACKOFF_MIN_MS      1000
+#define MQTT_LINK_BACKOFF_MAX_MS      60000
+#define MQTT_LINK_ATTEMPT_TIMEOUT_MS  20000   // DNS + CONNECT/CONNACK
+
+void mqtt_link_init(void);
+
+/* Notificações de sessão, chamadas a partir de mqtt_link_tick() (contexto do loop principal).
+ * session_up recebe o instante do CONNACK; session_down indica queda de sessão estabelecida. */
+void mqtt_link_set_session_callbacks(void (*session_up)(uint32_t now_ms), void (*session_down)(void));
+
+// Avança a máquina de estados da conexão; chamar a cada iteração do loop principal
+void mqtt_link_tick(uint32_t now_ms);
+
+/* Tópico de comandos assinado (QoS 1) a cada sessão. As mensagens recebidas ficam
+ * pendentes até o loop principal buscá-las com mqtt_link_take_command(). */
+void mqtt_link_set_command_topic(const char *topic);
+
+// Copia o comando pendente (terminado em '\0') e o consome; false se não houver
+bool mqtt_link_take_command(char *buf, size_t len);
+
+bool mqtt_link_is_connected(void);
+
+mqtt_backend_t *mqtt_link_client(void);
+
+// Derruba a sessão atual; a reconexão segue o backoff normal
+void mqtt_link_drop(void);
+
+uint32_t mqtt_link_reconnects(void);
+
+#endif /* MQTT_LINK_H */
@@ -0,0 +1,104 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Pool de mensagens
+/ Descrição: Alocador de blocos fixos para registros de telemetria e mensagens de saída, sem uso de heap.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <string.h>
+#include "pico/stdlib.h"
+#include "msg_pool.h"
+
+#ifndef NDEBUG
+#define MSG_POOL_POISON_FREE  0xDD  // conteúdo de um bloco livre
+#define MSG_POOL_POISON_ALLOC 0xCD  // conteúdo de um bloco recém-alocado
+#endif
+
+static bool msg_pool_owns(const msg_pool_t *pool, const void *block) {
+    const uint8_t *p = (const uint8_t *)block;
+    if (p < pool->storage || p >= pool->storage + pool->block_size * pool->block_count) {
+        return false;
+    }
+    return ((size_t)(p - pool->storage) % pool->block_size) == 0;
+}
+
+#ifndef NDEBUG
+// Verifica se o bloco livre continua envenenado (tudo após o ponteiro da lista livre)
+static bool msg_pool_poison_intact(const msg_pool_t *pool, const msg_pool_block_t *block) {
+    const uint8_t *p = (const uint8_t *)block + sizeof(msg_pool_block_t);
+    const uint8_t *end = (const uint8_t *)block + pool->block_size;
+    while (p < end) {
+        if (*p++ != MSG_POOL_POISON_FREE) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+void msg_pool_init(msg_pool_t *pool, const char *name, void *storage, size_t block_size, size_t block_count) {
+    memset(pool, 0, sizeof(*pool));
+    pool->name = name;
+    pool->storage = (uint8_t *)storage;
+    pool->block_size = MSG_POOL_BLOCK_SIZE(block_size);
+    pool->block_count = block_count;
+
+    // Encadeia os blocos em ordem para que as primeiras alocações fiquem no início do armazenamento
+    for (size_t i = block_count; i > 0; i--) {
+        msg_pool_block_t *block = (msg_pool_block_t *)(pool->storage + (i - 1) * pool->block_size);
+#ifndef NDEBUG
+        memset(block, MSG_POOL_POISON_FREE, pool->block_size);
+#endif
+        block->next = pool->free_list;
+        pool->free_list = block;
+    }
+}
+
+void *msg_pool_alloc(msg_pool_t *pool) {
+    uint32_t irq_state = save_and_disable_interrupts();
+
+    msg_pool_block_t *block = pool->free_list;
+    if (block == NULL) {
+        pool->alloc_failures++;
+        restore_interrupts(irq_state);
+        return NULL;
+    }
+    pool->free_list = block->next;
+    pool->in_use++;
+    pool->alloc_count++;
+    if (pool->in_use > pool->peak_in_use) {
+        pool->peak_in_use = pool->in_use;
+    }
+
+    restore_interrupts(irq_state);
+
+#ifndef NDEBUG
+    if (!msg_pool_poison_intact(pool, block)) {
+        panic("[POOL] %s: bloco %p modificado após free", pool->name, block);
+    }
+    memset(block, MSG_POOL_POISON_ALLOC, pool->block_size);
+#endif
+    return block;
+}
+
+void msg_pool_free(msg_pool_t *pool, void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    if (!msg_pool_owns(pool, ptr)) {
+        panic("[POOL] %s: free de ponteiro inválido %p", pool->name, ptr);
+    }
+
+    msg_pool_block_t *block = (msg_pool_block_t *)ptr;
+#ifndef NDEBUG
+    // Um bloco já livre continua envenenado; um bloco em uso foi preenchido com POISON_ALLOC ou dados
+    if (msg_pool_poison_intact(pool, block)) {
+        panic("[POOL] %s: free duplo do bloco %p", pool->name, ptr);
+    }
+    memset(block, MSG_POOL_POISON_FREE, pool->block_size);
+#endif
+
+    uint32_t irq_state = save_and_disable_interrupts();
+    block->next = pool->free_list;
+    pool->free_list = block;
+    pool->in_use--;
+    restore_interrupts(irq_state);
+}
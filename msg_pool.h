@@ -0,0 +1,48 @@
+#ifndef MSG_POOL_H
+#define MSG_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Alocador de blocos de tamanho fixo com alloc/free O(1) (lista livre intrusiva).
+ * Seguro para uso a partir do loop principal e de callbacks do lwIP (IRQ).
+ * Em builds de debug (sem NDEBUG) os blocos livres são envenenados e verificados
+ * na alocação, detectando uso após free e free duplo. */
+
+typedef struct msg_pool_block {
+    struct msg_pool_block *next;
+} msg_pool_block_t;
+
+typedef struct {
+    const char *name;
+    uint8_t *storage;
+    size_t block_size;
+    size_t block_count;
+    msg_pool_block_t *free_list;
+    size_t in_use;
+    size_t peak_in_use;
+    uint32_t alloc_count;
+    uint32_t alloc_failures;
+} msg_pool_t;
+
+// Tamanho de bloco arredondado para o alinhamento de ponteiro
+#define MSG_POOL_BLOCK_SIZE(size) \
+    ((((size) < sizeof(msg_pool_block_t) ? sizeof(msg_pool_block_t) : (size)) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+// Declara o armazenamento estático para `count` blocos do tipo `type`
+#define MSG_POOL_STORAGE(storage_name, type, count) \
+    static uint32_t storage_name[(MSG_POOL_BLOCK_SIZE(sizeof(type)) * (count)) / sizeof(uint32_t)]
+
+void msg_pool_init(msg_pool_t *pool, const char *name, void *storage, size_t block_size, size_t block_count);
+
+// Retorna NULL quando o pool está esgotado (contabilizado em alloc_failures)
+void *msg_pool_alloc(msg_pool_t *pool);
+
+void msg_pool_free(msg_pool_t *pool, void *block);
+
+static inline size_t msg_pool_available(const msg_pool_t *pool) {
+    return pool->block_count - pool->in_use;
+}
+
+#endif /* MSG_POOL_H */
@@ -0,0 +1,403 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Fila de saída MQTT
+/ Descrição: Bufferiza as publicações em blocos do pool de mensagens, em filas por prioridade com envelhecimento, e as
+/            entrega ao cliente lwIP quando conectado.
+/ Obs: Mensagens QoS 1 ficam na lista "em voo" até o PUBACK e voltam para a fila se a sessão cair. As listas também são
+/      alteradas pelos callbacks do lwIP, por isso todo acesso no loop principal é feito sob cyw43_arch_lwip_begin().
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/cyw43_arch.h"
+#include "outbox.h"
+#include "rate_limit.h"
+
+MSG_POOL_STORAGE(outbox_storage, outbox_msg_t, OUTBOX_CAPACITY);
+static msg_pool_t outbox_msg_pool;
+
+typedef struct {
+    outbox_msg_t *head;
+    outbox_msg_t *tail;
+} msg_queue_t;
+
+static msg_queue_t queues[TELEMETRY_PRIO_COUNT];
+static outbox_msg_t *inflight_head = NULL;
+static outbox_stats_t stats;
+
+static bool resync_pending = false;
+static uint32_t resync_start_ms = 0;
+static uint32_t resync_sent = 0;
+
+// Uma mensagem cheia precisa caber no anel de saída do cliente, senão a fila trava nela
+_Static_assert(MQTT_BACKEND_TX_SIZE >= OUTBOX_TOPIC_MAX + OUTBOX_PAYLOAD_MAX + 8,
+               "Buffer de saída do cliente MQTT menor que uma mensagem cheia da fila (ver RACK_MQTT_PROFILE)");
+
+#ifndef RACK_MSG_SEQ
+#define RACK_MSG_SEQ 1
+#endif
+
+static void depth_changed(const outbox_msg_t *msg, int delta) {
+    stats.depth += delta;
+    stats.depth_by_priority[msg->priority] += delta;
+    if (stats.depth > stats.peak_depth) {
+        stats.peak_depth = stats.depth;
+    }
+}
+
+static outbox_msg_t *queue_pop(msg_queue_t *queue) {
+    outbox_msg_t *msg = queue->head;
+    if (msg != NULL) {
+        queue->head = msg->next;
+        if (queue->head == NULL) {
+            queue->tail = NULL;
+        }
+        depth_changed(msg, -1);
+    }
+    return msg;
+}
+
+static void queue_push(outbox_msg_t *msg) {
+    msg_queue_t *queue = &queues[msg->priority];
+    msg->next = NULL;
+    if (queue->tail != NULL) {
+        queue->tail->next = msg;
+    } else {
+        queue->head = msg;
+    }
+    queue->tail = msg;
+    depth_changed(msg, 1);
+}
+
+static void queue_push_front(outbox_msg_t *msg) {
+    msg_queue_t *queue = &queues[msg->priority];
+    msg->next = queue->head;
+    queue->head = msg;
+    if (queue->tail == NULL) {
+        queue->tail = msg;
+    }
+    depth_changed(msg, 1);
+}
+
+static bool queues_empty(void) {
+    return stats.depth == 0;
+}
+
+/* Fila a servir: menor nível efetivo (prioridade menos um nível por OUTBOX_AGING_MS de
+ * espera da cabeça, sem chegar ao nível de alarme); empate favorece a prioridade original. */
+static msg_queue_t *select_queue(uint32_t now_ms, bool *aged) {
+    msg_queue_t *best = NULL;
+    uint32_t best_level = UINT32_MAX;
+
+    for (uint32_t priority = 0; priority < TELEMETRY_PRIO_COUNT; priority++) {
+        outbox_msg_t *head = queues[priority].head;
+        if (head == NULL) {
+            continue;
+        }
+        uint32_t level = priority;
+        if (priority > TELEMETRY_PRIO_ALARM) {
+            uint32_t boost = (now_ms - head->enqueued_ms) / OUTBOX_AGING_MS;
+            level = boost >= priority ? TELEMETRY_PRIO_ALARM + 1 : priority - boost;
+        }
+        if (level < best_level) {
+            best_level = level;
+            best = &queues[priority];
+        }
+    }
+
+    *aged = best != NULL && best->head->priority != best_level;
+    return best;
+}
+
+static void inflight_append(outbox_msg_t *msg) {
+    msg->next = NULL;
+    outbox_msg_t **link = &inflight_head;
+    while (*link != NULL) {
+        link = &(*link)->next;
+    }
+    *link = msg;
+    stats.inflight++;
+}
+
+static bool inflight_remove(outbox_msg_t *msg) {
+    for (outbox_msg_t **link = &inflight_head; *link != NULL; link = &(*link)->next) {
+        if (*link == msg) {
+            *link = msg->next;
+            stats.inflight--;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Callback de requisição do lwIP (contexto lwIP): PUBACK recebido ou tempo esgotado
+static void finish_msg(outbox_msg_t *msg, bool ok) {
+    if (msg->done != NULL) {
+        msg->done(msg->done_arg, ok);
+    }
+    msg_pool_free(&outbox_msg_pool, msg);
+}
+
+static void outbox_publish_callback(void *arg, err_t err) {
+    outbox_msg_t *msg = (outbox_msg_t *)arg;
+    if (!inflight_remove(msg)) {
+        return;  // já devolvida à fila por queda de sessão
+    }
+    if (err == ERR_OK) {
+        stats.acked++;
+        finish_msg(msg, true);
+    } else {
+        // Sem PUBACK no prazo: retransmite antes das mensagens mais novas da mesma prioridade
+        stats.retransmits++;
+        queue_push_front(msg);
+    }
+}
+
+#if RACK_MSG_SEQ
+static bool channel_is_binary(telemetry_channel_t channel) {
+    return channel == TELEMETRY_CH_HISTORY || channel == TELEMETRY_CH_CAPTURE;
+}
+
+static bool text_is_number(const char *text) {
+    // strtod também aceita "nan"/"inf", que não são números JSON
+    if (!(text[0] == '-' || (text[0] >= '0' && text[0] <= '9'))) {
+        return false;
+    }
+    char *end;
+    strtod(text, &end);
+    return end != text && *end == '\0';
+}
+
+/* Monta em `out` o payload carimbado com canal, boot e sequência; retorna o novo tamanho
+ * ou 0 se não couber (a sequência só é consumida quando o carimbo é aplicado). */
+static uint16_t stamp_payload(telemetry_channel_t channel, const void *payload, uint16_t payload_len, uint8_t *out) {
+    char text[OUTBOX_PRODUCER_MAX + 1];
+    if (payload_len > OUTBOX_PRODUCER_MAX) {
+        return 0;
+    }
+    memcpy(text, payload, payload_len);
+    text[payload_len] = '\0';
+
+    int len;
+    uint32_t seq = stats.seq[channel];
+    if (payload_len >= 2 && text[0] == '{') {
+        // Objeto JSON: insere os campos logo após a chave de abertura
+        len = snprintf((char *)out, OUTBOX_PAYLOAD_MAX, "{\"c\":%u,\"b\":%u,\"q\":%u%s%s",
+                       (unsigned)channel, (unsigned)stats.boot_epoch, (unsigned)seq,
+                       text[1] == '}' ? "" : ",", &text[1]);
+    } else {
+        const char *quote = text_is_number(text) ? "" : "\"";
+        len = snprintf((char *)out, OUTBOX_PAYLOAD_MAX, "{\"c\":%u,\"b\":%u,\"q\":%u,\"v\":%s%s%s}",
+                       (unsigned)channel, (unsigned)stats.boot_epoch, (unsigned)seq, quote, text, quote);
+    }
+    if (len < 0 || len >= OUTBOX_PAYLOAD_MAX) {
+        return 0;
+    }
+    stats.seq[channel]++;
+    return (uint16_t)len;
+}
+#endif
+
+void outbox_init(uint32_t boot_epoch) {
+    msg_pool_init(&outbox_msg_pool, "outbox", outbox_storage, sizeof(outbox_msg_t), OUTBOX_CAPACITY);
+    memset(queues, 0, sizeof(queues));
+    inflight_head = NULL;
+    memset(&stats, 0, sizeof(stats));
+    stats.boot_epoch = boot_epoch;
+}
+
+bool outbox_publish(telemetry_channel_t channel, telemetry_priority_t priority, const char *topic,
+                    const void *payload, uint16_t payload_len, uint8_t qos, uint8_t retain) {
+    return outbox_publish_notify(channel, priority, topic, payload, payload_len, qos, retain, NULL, NULL);
+}
+
+bool outbox_publish_notify(telemetry_channel_t channel, telemetry_priority_t priority, const char *topic,
+                           const void *payload, uint16_t payload_len, uint8_t qos, uint8_t retain,
+                           outbox_done_fn done, void *done_arg) {
+    if (strlen(topic) >= OUTBOX_TOPIC_MAX || payload_len > OUTBOX_PAYLOAD_MAX) {
+        printf("[OUTBOX] Mensagem grande demais para a fila: tópico='%s' (%u bytes)\n", topic, payload_len);
+        return false;
+    }
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    if (!rate_limit_admit(channel, priority, now_ms)) {
+        return false;
+    }
+
+    cyw43_arch_lwip_begin();
+    outbox_msg_t *msg = msg_pool_alloc(&outbox_msg_pool);
+    if (msg == NULL) {
+        /* Fila cheia: a leitura mais recente vale mais que a mais antiga, e nunca se descarta
+         * uma mensagem de prioridade maior que a que está chegando */
+        for (int victim = TELEMETRY_PRIO_COUNT - 1; victim >= (int)priority; victim--) {
+            if (queues[victim].head != NULL) {
+                finish_msg(queue_pop(&queues[victim]), false);
+                stats.dropped++;
+                printf("[OUTBOX] Fila cheia, descartando mensagem mais antiga (prioridade %d)\n", victim);
+                msg = msg_pool_alloc(&outbox_msg_pool);
+                break;
+            }
+        }
+    }
+    if (msg == NULL) {
+        // Todos os blocos estão em voo aguardando PUBACK ou com mensagens mais prioritárias
+        stats.dropped++;
+        cyw43_arch_lwip_end();
+        return false;
+    }
+
+    strcpy(msg->topic, topic);
+#if RACK_MSG_SEQ
+    uint16_t stamped_len = channel_is_binary(channel) ? 0 : stamp_payload(channel, payload, payload_len, msg->payload);
+    if (stamped_len > 0) {
+        payload_len = stamped_len;
+    } else {
+        memcpy(msg->payload, payload, payload_len);
+    }
+#else
+    memcpy(msg->payload, payload, payload_len);
+#endif
+    msg->payload_len = payload_len;
+    msg->qos = qos;
+    msg->retain = retain;
+    msg->channel = (uint8_t)channel;
+    msg->priority = (uint8_t)priority;
+    msg->enqueued_ms = now_ms;
+    msg->done = done;
+    msg->done_arg = done_arg;
+    queue_push(msg);
+    stats.enqueued++;
+    cyw43_arch_lwip_end();
+    return true;
+}
+
+// Custo de cada chamada ao cliente MQTT, para comparar os backends na placa
+static void record_publish_time(uint32_t elapsed_us) {
+    stats.publish_us_last = elapsed_us;
+    if (elapsed_us > stats.publish_us_max) {
+        stats.publish_us_max = elapsed_us;
+    }
+    stats.publish_us_avg = stats.publish_us_avg == 0 ? elapsed_us : stats.publish_us_avg - stats.publish_us_avg / 8 + elapsed_us / 8;
+}
+
+size_t outbox_drain(mqtt_backend_t *client, uint32_t now_ms) {
+    size_t sent = 0;
+    bool global_exhausted = false;
+
+    cyw43_arch_lwip_begin();
+    while (true) {
+        bool aged;
+        msg_queue_t *queue = select_queue(now_ms, &aged);
+        if (global_exhausted && queues[TELEMETRY_PRIO_ALARM].head != NULL) {
+            queue = &queues[TELEMETRY_PRIO_ALARM];  // sem tokens, só os alarmes seguem
+            aged = false;
+        } else if (global_exhausted) {
+            break;
+        }
+        if (queue == NULL) {
+            break;
+        }
+        outbox_msg_t *msg = queue->head;
+
+        // Sem tokens no bucket global só os alarmes seguem; o resto aguarda na ordem da fila
+        if (!rate_limit_drain((telemetry_priority_t)msg->priority, now_ms)) {
+            global_exhausted = true;
+            continue;
+        }
+
+        mqtt_request_cb_t cb = msg->qos > 0 ? outbox_publish_callback : NULL;
+        uint32_t publish_start_us = time_us_32();
+        err_t err = mqtt_backend_publish(client, msg->topic, msg->payload, msg->payload_len, msg->qos, msg->retain, cb, msg);
+        record_publish_time(time_us_32() - publish_start_us);
+
+        if (err == ERR_MEM || err == ERR_CONN) {
+            // Anel de saída cheio ou conexão caiu: mantém a mensagem (e o token) para o próximo ciclo
+            rate_limit_drain_cancel();
+            if (err == ERR_MEM) {
+                stats.ring_stalls++;
+            }
+            break;
+        }
+
+        queue_pop(queue);
+        if (err == ERR_OK) {
+            printf("[MQTT] Publicação enviada com sucesso: tópico='%s'\n", msg->topic);
+            stats.sent++;
+            sent++;
+            resync_sent++;
+            if (aged) {
+                stats.aged++;
+            }
+            if (msg->priority == TELEMETRY_PRIO_ALARM) {
+                stats.alarm_latency_last_ms = now_ms - msg->enqueued_ms;
+                if (stats.alarm_latency_last_ms > stats.alarm_latency_max_ms) {
+                    stats.alarm_latency_max_ms = stats.alarm_latency_last_ms;
+                }
+            }
+            if (msg->qos > 0) {
+                inflight_append(msg);
+            } else {
+                finish_msg(msg, true);
+            }
+        } else {
+            printf("[MQTT] Erro ao publicar em '%s': %d\n", msg->topic, err);
+            stats.publish_errors++;
+            finish_msg(msg, false);
+        }
+    }
+
+    if (resync_pending && queues_empty() && inflight_head == NULL) {
+        resync_pending = false;
+        stats.last_resync_ms = now_ms - resync_start_ms;
+        stats.last_resync_sent = resync_sent;
+        stats.drain_rate = stats.last_resync_ms > 0 ? resync_sent * 1000u / stats.last_resync_ms : resync_sent;
+        printf("[OUTBOX] Ressincronização concluída em %u ms (%u mensagens, %u msg/s)\n",
+               (unsigned)stats.last_resync_ms, (unsigned)resync_sent, (unsigned)stats.drain_rate);
+    }
+    cyw43_arch_lwip_end();
+
+    return sent;
+}
+
+void outbox_session_started(uint32_t now_ms) {
+    resync_pending = true;
+    resync_start_ms = now_ms;
+    resync_sent = 0;
+}
+
+void outbox_session_lost(void) {
+    // O lwIP descarta as requisições pendentes sem chamar os callbacks: devolve tudo às filas, na ordem original
+    cyw43_arch_lwip_begin();
+    if (inflight_head != NULL) {
+        // Inverte a lista em voo para que as inserções pela frente preservem a ordem de envio
+        outbox_msg_t *reversed = NULL;
+        size_t count = 0;
+        while (inflight_head != NULL) {
+            outbox_msg_t *msg = inflight_head;
+            inflight_head = msg->next;
+            msg->next = reversed;
+            reversed = msg;
+            count++;
+        }
+        while (reversed != NULL) {
+            outbox_msg_t *msg = reversed;
+            reversed = msg->next;
+            queue_push_front(msg);
+        }
+        stats.inflight = 0;
+        stats.retransmits += count;
+        printf("[OUTBOX] %u mensagens QoS 1 sem PUBACK voltaram para a fila\n", (unsigned)count);
+    }
+    resync_pending = false;
+    cyw43_arch_lwip_end();
+}
+
+void outbox_get_stats(outbox_stats_t *stats_out) {
+    cyw43_arch_lwip_begin();
+    *stats_out = stats;
+    cyw43_arch_lwip_end();
+}
+
+const msg_pool_t *outbox_pool(void) {
+    return &outbox_msg_pool;
+}
@@ -0,0 +1,104 @@
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "mqtt_backend.h"
+#include "msg_pool.h"
+#include "telemetry.h"
+
+/* Fila de saída MQTT: toda publicação do firmware passa por aqui. As mensagens são
+ * alocadas no pool estático e drenadas para o cliente MQTT no loop principal,
+ * sobrevivendo a desconexões enquanto houver blocos livres. Mensagens QoS 1 só
+ * são liberadas após o PUBACK e são publicadas de novo na sessão seguinte, como
+ * PUBLISH novos (outro identificador, sem DUP): entrega "pelo menos uma vez", e o
+ * consumidor descarta as cópias pela sequência carimbada (RACK_MSG_SEQ).
+ *
+ * Há uma fila FIFO por prioridade (alarme > estado > telemetria > bulk). A drenagem
+ * serve sempre a fila de maior prioridade efetiva: a cada OUTBOX_AGING_MS de espera
+ * a cabeça de uma fila sobe um nível, sem nunca ultrapassar os alarmes, para que um
+ * backlog de bulk não fique parado para sempre atrás de telemetria contínua. */
+
+#define OUTBOX_TOPIC_MAX   64
+#define OUTBOX_PAYLOAD_MAX 160    // 128 do produtor + carimbo de sequência
+#define OUTBOX_PRODUCER_MAX 128   // maior payload que os módulos montam antes do carimbo
+#define OUTBOX_CAPACITY    32
+#define OUTBOX_AGING_MS    30000
+
+/* Notificação de conclusão: ok=true na entrega ao cliente MQTT (QoS 0) ou no PUBACK (QoS 1);
+ * ok=false se a mensagem for descartada. Pode ser chamada em contexto lwIP (IRQ). */
+typedef void (*outbox_done_fn)(void *arg, bool ok);
+
+typedef struct outbox_msg {
+    struct outbox_msg *next;
+    uint16_t payload_len;
+    uint8_t qos;
+    uint8_t retain;
+    uint8_t channel;    // telemetry_channel_t
+    uint8_t priority;   // telemetry_priority_t
+    uint32_t enqueued_ms;
+    outbox_done_fn done;
+    void *done_arg;
+    char topic[OUTBOX_TOPIC_MAX];
+    uint8_t payload[OUTBOX_PAYLOAD_MAX];
+} outbox_msg_t;
+
+typedef struct {
+    size_t depth;
+    size_t peak_depth;
+    uint32_t enqueued;
+    uint32_t sent;
+    uint32_t dropped;          // descartadas por falta de espaço (mais antigas primeiro)
+    uint32_t publish_errors;   // rejeitadas pelo cliente MQTT
+    size_t inflight;           // QoS 1 aguardando PUBACK
+    uint32_t acked;
+    uint32_t retransmits;      // QoS 1 reenviadas após timeout ou queda de sessão
+    uint32_t last_resync_ms;   // CONNACK até fila e mensagens em voo zeradas
+    uint32_t last_resync_sent; // mensagens entregues nessa ressincronização
+    uint32_t drain_rate;       // mensagens/s da última ressincronização (vazão do backlog)
+    uint32_t ring_stalls;      // drenagens interrompidas pelo anel de saída do cliente cheio
+    uint32_t publish_us_last;  // duração da chamada de publicação do cliente MQTT (RACK_MQTT_BACKEND)
+    uint32_t publish_us_max;
+    uint32_t publish_us_avg;   // média móvel (1/8)
+    size_t depth_by_priority[TELEMETRY_PRIO_COUNT];
+    uint32_t aged;             // envios adiantados pelo envelhecimento
+    uint32_t alarm_latency_max_ms;    // enfileiramento até a entrega ao cliente MQTT
+    uint32_t alarm_latency_last_ms;
+    uint32_t boot_epoch;
+    uint32_t seq[TELEMETRY_CH_COUNT];   // próxima sequência de cada canal
+} outbox_stats_t;
+
+/* Numeração das mensagens (RACK_MSG_SEQ): cada canal tem uma sequência monotônica por boot
+ * e o par (boot_epoch, seq) nunca se repete entre reboots. Payloads JSON recebem os campos
+ * "c" (canal), "b" (boot) e "q" (sequência) no início; payloads de texto são embrulhados
+ * em {"c":..,"b":..,"q":..,"v":<texto>}. Canais binários (histórico, captura) já trazem
+ * numeração própria e não são alterados. */
+void outbox_init(uint32_t boot_epoch);
+
+/* Enfileira uma publicação. Com o pool esgotado é descartada a mensagem mais antiga
+ * da fila de menor prioridade não vazia.
+ * Retorna false se o tópico/payload não couber nos limites da fila ou se o canal
+ * excedeu sua taxa (ver rate_limit.h). */
+bool outbox_publish(telemetry_channel_t channel, telemetry_priority_t priority, const char *topic,
+                    const void *payload, uint16_t payload_len, uint8_t qos, uint8_t retain);
+
+// Como outbox_publish(), avisando `done` quando a mensagem for concluída ou descartada
+bool outbox_publish_notify(telemetry_channel_t channel, telemetry_priority_t priority, const char *topic,
+                           const void *payload, uint16_t payload_len, uint8_t qos, uint8_t retain,
+                           outbox_done_fn done, void *done_arg);
+
+// Entrega ao cliente MQTT o máximo de mensagens que o anel de saída aceitar; retorna quantas foram enviadas
+size_t outbox_drain(mqtt_backend_t *client, uint32_t now_ms);
+
+// Sessão MQTT (re)estabelecida: inicia a medição do tempo de ressincronização
+void outbox_session_started(uint32_t now_ms);
+
+// Sessão perdida: mensagens QoS 1 sem PUBACK voltam ao início da fila para serem publicadas de novo
+void outbox_session_lost(void);
+
+void outbox_get_stats(outbox_stats_t *stats);
+
+const msg_pool_t *outbox_pool(void);
+
+#endif /* OUTBOX_H */
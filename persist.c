@@ -0,0 +1,85 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Persistência em flash
+/ Descrição: Slots de configuração/estado com CRC no fim da flash, gravados com segurança junto ao Wi-Fi em segundo plano.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+#include "persist.h"
+#include "crc.h"
+
+#define PERSIST_MAGIC 0x53504B52u   // "RKPS"
+
+// Os últimos PERSIST_SLOT_COUNT setores ficam fora da imagem do firmware
+#define PERSIST_SLOT_OFFSET(slot) (PICO_FLASH_SIZE_BYTES - ((uint32_t)(slot) + 1u) * FLASH_SECTOR_SIZE)
+
+typedef struct {
+    uint32_t magic;
+    uint16_t slot;
+    uint16_t len;
+    uint32_t crc;
+} persist_header_t;
+
+// Buffer de programação: múltiplo de FLASH_PAGE_SIZE, estático por não caber com folga na pilha
+static uint8_t program_buf[2 * FLASH_PAGE_SIZE];
+static uint32_t program_offset;
+
+_Static_assert(sizeof(persist_header_t) + PERSIST_MAX_LEN <= sizeof(program_buf), "PERSIST_MAX_LEN excede o buffer de programação");
+
+static const persist_header_t *slot_header(persist_slot_t slot) {
+    return (const persist_header_t *)(uintptr_t)(XIP_BASE + PERSIST_SLOT_OFFSET(slot));
+}
+
+bool persist_load(persist_slot_t slot, void *data, size_t len) {
+    const persist_header_t *header = slot_header(slot);
+    if (header->magic != PERSIST_MAGIC || header->slot != slot || header->len != len) {
+        return false;
+    }
+    const uint8_t *payload = (const uint8_t *)(header + 1);
+    if (crc32_update(0, payload, len) != header->crc) {
+        printf("[PERSIST] Slot %u corrompido, ignorado\n", slot);
+        return false;
+    }
+    memcpy(data, payload, len);
+    return true;
+}
+
+// Executado por flash_safe_execute com o XIP e o outro core pausados
+static void erase_and_program(void *param) {
+    flash_range_erase(program_offset, FLASH_SECTOR_SIZE);
+    flash_range_program(program_offset, program_buf, sizeof(program_buf));
+}
+
+bool persist_save(persist_slot_t slot, const void *data, size_t len) {
+    if (slot >= PERSIST_SLOT_COUNT || len > PERSIST_MAX_LEN) {
+        return false;
+    }
+
+    persist_header_t header = {
+        .magic = PERSIST_MAGIC,
+        .slot = (uint16_t)slot,
+        .len = (uint16_t)len,
+        .crc = crc32_update(0, data, len),
+    };
+
+    const persist_header_t *current = slot_header(slot);
+    if (memcmp(current, &header, sizeof(header)) == 0 && memcmp(current + 1, data, len) == 0) {
+        return true;
+    }
+
+    memset(program_buf, 0xFF, sizeof(program_buf));
+    memcpy(program_buf, &header, sizeof(header));
+    memcpy(program_buf + sizeof(header), data, len);
+    program_offset = PERSIST_SLOT_OFFSET(slot);
+
+    int rc = flash_safe_execute(erase_and_program, NULL, 100);
+    if (rc != PICO_OK) {
+        printf("[PERSIST] Falha ao gravar slot %u: %d\n", slot, rc);
+        return false;
+    }
+    printf("[PERSIST] Slot %u gravado (%u bytes)\n", slot, (unsigned)len);
+    return true;
+}
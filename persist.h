@@ -0,0 +1,26 @@
+#ifndef PERSIST_H
+#define PERSIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Persistência de pequenos registros em flash: um setor de 4 KB por slot no fim da flash,
+ * com cabeçalho (magic, slot, tamanho) e CRC32. A gravação apaga e programa o setor via
+ * flash_safe_execute e é pulada quando o conteúdo não mudou, para poupar ciclos de apagamento. */
+
+typedef enum {
+    PERSIST_SLOT_WIFI = 0,     // BSSID, canal e concessão de IP da última conexão
+    PERSIST_SLOT_BOOT,         // contador de boots (época das sequências de mensagens)
+    PERSIST_SLOT_MODBUS,       // mapa de registradores do mestre Modbus
+    PERSIST_SLOT_COUNT
+} persist_slot_t;
+
+#define PERSIST_MAX_LEN 500
+
+// Retorna false se o slot estiver vazio, corrompido ou com tamanho diferente de `len`
+bool persist_load(persist_slot_t slot, void *data, size_t len);
+
+bool persist_save(persist_slot_t slot, const void *data, size_t len);
+
+#endif /* PERSIST_H */
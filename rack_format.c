@@ -0,0 +1,42 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Conversão e formatação
+/ Descrição: Conversão do ADC para temperatura e montagem de tópicos/identificadores, isoladas do hardware.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "rack_format.h"
+
+/* References for this implementation:
+ * raspberry-pi-pico-c-sdk.pdf, Section '4.1.1. hardware_adc'
+ * pico-examples/adc/adc_console/adc_console.c */
+float convert_rack_temperature(uint16_t raw, const char unit) {
+    /* 12-bit conversion, assume max value == ADC_VREF == 3.3 V */
+    const float conversionFactor = 3.3f / (1 << 12);
+
+    float adc = (float)raw * conversionFactor;
+    float tempC = 27.0f - (adc - 0.706f) / 0.001721f;
+
+    if (unit == 'C') {
+        return tempC;
+    } else if (unit == 'F') {
+        return tempC * 9 / 5 + 32;
+    }
+
+    // Unidade inválida: NaN é sinalizado como falha de leitura pela saúde do sensor
+    return NAN;
+}
+
+int rack_number_parse(const char *rack_number) {
+    int number = atoi(rack_number);
+    return (number < 0 || number > 99999) ? 0 : number;
+}
+
+int format_rack_topic(char *buf, size_t len, const char *base_topic, int rack_number) {
+    return snprintf(buf, len, "%s/%05d", base_topic, rack_number);
+}
+
+int format_rack_client_id(char *buf, size_t len, int rack_number) {
+    return snprintf(buf, len, "rack-%05d", rack_number);
+}
@@ -0,0 +1,22 @@
+#ifndef RACK_FORMAT_H
+#define RACK_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Lógica pura de conversão e formatação (sem dependências do Pico SDK ou do lwIP),
+ * compartilhada pelo loop principal e pelo link MQTT e compilável também no host. */
+
+// Leitura bruta de 12 bits do sensor interno para 'C' ou 'F'; NaN para unidade inválida
+float convert_rack_temperature(uint16_t raw, const char unit);
+
+// Número do rack (MQTT_RACK_NUMBER) normalizado: "7" -> 7; valores inválidos viram 0
+int rack_number_parse(const char *rack_number);
+
+// "<base>/<rack com 5 dígitos>"; retorna o comprimento como snprintf
+int format_rack_topic(char *buf, size_t len, const char *base_topic, int rack_number);
+
+// "rack-<rack com 5 dígitos>", estável entre boots para a sessão persistente
+int format_rack_client_id(char *buf, size_t len, int rack_number);
+
+#endif /* RACK_FORMAT_H */
@@ -11,16 +11,41 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include "pico/stdlib.h"
 #include "hardware/gpio.h"
 #include "hardware/adc.h"
 #include "pico/cyw43_arch.h"
 #include "lwip/apps/mqtt.h"
-#include "lwip/ip_addr.h"
-#include "lwip/dns.h"
+#if RACK_HEAP_FREE
+#include "heap_guard.h"
+#endif
 #include "rack_inteligente.h"
-
-#define MQTT_BROKER_PORT 1883
+#include "stack_monitor.h"
+#include "outbox.h"
+#include "drift_monitor.h"
+#include "mqtt_link.h"
+#include "broker_list.h"
+#include "rate_limit.h"
+#include "flap_detector.h"
+#include "sensor_health.h"
+#include "rack_time.h"
+#include "aggregator.h"
+#include "history.h"
+#include "capture.h"
+#include "rack_format.h"
+#include "fleet_slot.h"
+#include "wifi_link.h"
+#include "persist.h"
+#include "stream_pub.h"
+#include "modbus.h"
+#include "modbus_rtu.h"
+#if RACK_FAULT_INJECTION
+#include "fault_inject.h"
+#endif
+#if RACK_SNMP
+#include "snmp_agent.h"
+#endif
 
 // Configurações do Botão
 #define RACK_PORT_STATE 5
@@ -28,29 +53,103 @@
 /* Choose 'C' for Celsius or 'F' for Fahrenheit. */
 #define TEMPERATURE_UNITS 'C'
 
+// Saúde do sensor de temperatura (faixa de junção do RP2040: -40 a 125 °C)
+#if TEMPERATURE_UNITS == 'F'
+#define TEMPERATURE_MIN_VALID   -40.0f
+#define TEMPERATURE_MAX_VALID   257.0f
+#define TEMPERATURE_NOISE_LIMIT 7.2f
+#else
+#define TEMPERATURE_MIN_VALID   -40.0f
+#define TEMPERATURE_MAX_VALID   125.0f
+#define TEMPERATURE_NOISE_LIMIT 4.0f
+#endif
+#define TEMPERATURE_STUCK_SAMPLES 600   // 10 min com leitura idêntica
+
+// Detecção de oscilação da porta: 6 transições em 30 s entram em "flapping",
+// resumo a cada 60 s e saída após 60 s sem transições
+#define DOOR_FLAP_THRESHOLD  6
+#define DOOR_FLAP_WINDOW_MS  30000
+#define DOOR_FLAP_SUMMARY_MS 60000
+#define DOOR_FLAP_QUIET_MS   60000
+
+// Baldes de agregação alinhados ao relógio sincronizado
+#define AGG_HOURLY_PERIOD_S 3600
+#define AGG_DAILY_PERIOD_S  86400
+
+/* RACK_REPORT_RAW=0 (opção do CMake) deixa de publicar cada leitura de temperatura;
+ * apenas os resumos agregados saem do rack. Eventos de porta continuam sendo enviados. */
+#ifndef RACK_REPORT_RAW
+#define RACK_REPORT_RAW 1
+#endif
+
+// Alarme de temperatura (dispara a captura em alta taxa); volta ao normal abaixo de ALARM - HYSTERESIS
+#if TEMPERATURE_UNITS == 'F'
+#define TEMPERATURE_ALARM            113.0f
+#define TEMPERATURE_ALARM_HYSTERESIS 3.6f
+#else
+#define TEMPERATURE_ALARM            45.0f
+#define TEMPERATURE_ALARM_HYSTERESIS 2.0f
+#endif
+
+// Ciclo do loop principal; entre ciclos a fila é drenada a cada OUTBOX_DRAIN_INTERVAL_MS enquanto houver backlog
+#define MAIN_LOOP_PERIOD_MS      1000
+#define OUTBOX_DRAIN_INTERVAL_MS 50
+
+// Intervalo de publicação das métricas internas do firmware
+#define METRICS_INTERVAL_MS 60000
+
+// Posição GPS (latitude + longitude): dentro do limite do canal em rate_limit.c
+#define GPS_INTERVAL_MS 10000
+
 // Variáveis Globais
-static mqtt_client_t *mqtt_client;
-static ip_addr_t broker_ip;
 static char mqtt_rack_topic[50];  
-static bool mqtt_connected = false;
 static bool last_rack_door_state = false;
+static flap_detector_t door_flap;
+static aggregator_t hourly_agg;
+static aggregator_t daily_agg;
+
+// Despejo do histórico em andamento (comando "history [minutos]"): cursor do fluxo
+static stream_t history_stream;
+static struct {
+    uint16_t id;
+    uint32_t index;     // trecho produzido por último
+    uint32_t seq;       // bloco do histórico desse trecho
+    uint32_t end_seq;
+} history_dump;
+
+// Envio da captura congelada em andamento
+static stream_t capture_stream;
+static bool temperature_alarm = false;
 static float last_rack_temperature = -1.0f;
+static sensor_health_t temperature_health;
 static float latitude = -3.924263;
 static float longitude = -38.453483;
 
 // Protótipos de Funções
-static void mqtt_connection_callback(mqtt_client_t *client, void *arg, mqtt_connection_status_t status);
-
 float read_rack_temperature(const char unit);
+static float capture_convert(uint16_t raw);
 
 void publish_door_state(bool pressed);
-void publish_rack_temperature(float temperature);
+void publish_door_flapping(bool entered, bool flapping, uint32_t transitions, bool pressed);
+void publish_rack_temperature(float temperature, uint8_t quality);
 void publish_rack_gps_position();
-
-void dns_check_callback(const char *name, const ip_addr_t *ipaddr, void *callback_arg);
+void publish_sensor_health(sensor_health_t *health, const char *subtopic);
+void publish_aggregate_summary(const char *name, const agg_summary_t *summary);
+void publish_temperature_alarm(bool alarm, float temperature);
+static void publish_modbus_change(const modbus_change_t *change);
+static void service_capture_upload(void);
+static void handle_command(const char *command);
+static void handle_modbus_command(const char *args);
+static void start_history_dump(uint32_t minutes);
+static size_t history_fill(void *ctx, uint32_t index, uint8_t *buf, size_t len);
+static size_t capture_fill(void *ctx, uint32_t index, uint8_t *buf, size_t len);
+void publish_rack_metrics();
+static void sample_drift_monitor(uint32_t now_ms);
+static uint32_t next_boot_epoch(void);
 
 // Função Principal
 int main() {
+    stack_monitor_init();
     stdio_init_all();
     /* Initialize hardware AD converter, enable onboard temperature sensor and
      *   select its channel (do this once for efficiency, but beware that this
@@ -62,6 +161,12 @@ int main() {
     sleep_ms(2000);
     printf("\n=== Iniciando MQTT Button Monitor ===\n");
 
+    // Racks religados juntos após queda de energia não devem chegar ao mesmo tempo no broker
+    fleet_slot_init(rack_number_parse(MQTT_RACK_NUMBER));
+    uint32_t boot_delay_ms = fleet_slot_offset_ms(FLEET_BOOT_WINDOW_MS) + fleet_jitter_ms(FLEET_BOOT_JITTER_MS);
+    printf("[FROTA] Aguardando %u ms antes de conectar\n", (unsigned)boot_delay_ms);
+    sleep_ms(boot_delay_ms);
+
     // Inicializa Wi-Fi
     if (cyw43_arch_init()) {
         printf("Erro na inicialização do Wi-Fi\n");
@@ -69,63 +174,202 @@ int main() {
     }
     cyw43_arch_enable_sta_mode();
 
-    printf("[Wi-Fi] Conectando...\n");
-    if (cyw43_arch_wifi_connect_timeout_ms(WIFI_SSID, WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK, 10000)) {
-        printf("[Wi-Fi] Falha na conexão Wi-Fi\n");
-        return -1;
+    // Reaproveita AP, canal e IP da última conexão quando possível (ver wifi_link.h)
+    wifi_link_init(WIFI_SSID, WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK);
+    if (!wifi_link_connect_blocking(30000)) {
+        printf("[Wi-Fi] Falha na conexão Wi-Fi, nova tentativa no loop principal\n");
     } else {
         printf("[Wi-Fi] Conectado com sucesso!\n");
     }
 
+#if RACK_FAULT_INJECTION
+    cyw43_arch_lwip_begin();
+    fault_inject_init(&cyw43_state.netif[CYW43_ITF_STA], mqtt_link_drop);
+    cyw43_arch_lwip_end();
+#endif
+
+#if RACK_SNMP
+    snmp_agent_init(rack_number_parse(MQTT_RACK_NUMBER));
+#endif
+
     // Configura GPIO do botão
     gpio_init(RACK_PORT_STATE);
     gpio_set_dir(RACK_PORT_STATE, GPIO_IN);
     gpio_pull_up(RACK_PORT_STATE); // <<< ATENÇÃO: pull-up ativado
-
-    char mqtt_rack_number_str[6];
-    snprintf(mqtt_rack_number_str, sizeof(mqtt_rack_number_str), "%05d", atoi(MQTT_RACK_NUMBER));
-    snprintf(mqtt_rack_topic, sizeof(mqtt_rack_topic), "%s/%s", MQTT_BASE_TOPIC, mqtt_rack_number_str);
-
-    // Inicializa cliente MQTT
-    mqtt_client = mqtt_client_new();
-
-    // Resolve DNS do broker MQTT
-    err_t err = dns_gethostbyname(MQTT_BROKER, &broker_ip, dns_check_callback, NULL);
-    if (err == ERR_OK) {
-        dns_check_callback(MQTT_BROKER, &broker_ip, NULL);
-    } else if (err == ERR_INPROGRESS) {
-        printf("[DNS] Resolvendo...\n");
-    } else {
-        printf("[DNS] Erro ao resolver DNS: %d\n", err);
-        return -1;
-    }
+    sensor_health_init(&temperature_health, "temperature", TEMPERATURE_MIN_VALID, TEMPERATURE_MAX_VALID,
+                       TEMPERATURE_STUCK_SAMPLES, TEMPERATURE_NOISE_LIMIT);
+    flap_detector_init(&door_flap, DOOR_FLAP_THRESHOLD, DOOR_FLAP_WINDOW_MS, DOOR_FLAP_SUMMARY_MS, DOOR_FLAP_QUIET_MS);
+
+    format_rack_topic(mqtt_rack_topic, sizeof(mqtt_rack_topic), MQTT_BASE_TOPIC, rack_number_parse(MQTT_RACK_NUMBER));
+
+    char mqtt_command_topic[64];
+    snprintf(mqtt_command_topic, sizeof(mqtt_command_topic), "%s/cmd", mqtt_rack_topic);
+
+    // Inicializa cliente MQTT; a conexão ao broker é feita pelo loop principal
+    mqtt_link_init();
+    outbox_init(next_boot_epoch());
+    rate_limit_init(to_ms_since_boot(get_absolute_time()));
+    rack_time_init();
+    aggregator_init(&hourly_agg, AGG_HOURLY_PERIOD_S);
+    aggregator_init(&daily_agg, AGG_DAILY_PERIOD_S);
+    mqtt_link_set_session_callbacks(outbox_session_started, outbox_session_lost);
+    mqtt_link_set_command_topic(mqtt_command_topic);
+    history_init();
+    capture_init(capture_convert);
+    modbus_init(to_ms_since_boot(get_absolute_time()));
+
+    // Métricas em fase própria por rack, com jitter a cada período
+    absolute_time_t next_metrics_time = make_timeout_time_ms(METRICS_INTERVAL_MS + fleet_slot_offset_ms(METRICS_INTERVAL_MS));
+    absolute_time_t next_gps_time = get_absolute_time();
+    drift_monitor_init(to_ms_since_boot(get_absolute_time()));
+
+#if RACK_HEAP_FREE
+    // Daqui em diante nenhuma alocação dinâmica é permitida
+    heap_guard_lock();
+#endif
 
     // Loop principal
     while (true) {
+        absolute_time_t cycle_deadline = make_timeout_time_ms(MAIN_LOOP_PERIOD_MS);
+
         // Atualiza tarefas de rede
         cyw43_arch_poll();
 
+        uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+        wifi_link_tick(now_ms);
+        mqtt_link_tick(now_ms);
+
         // Lê o estado do botão
         bool rack_port_state = !gpio_get(RACK_PORT_STATE); // <<< Inverte porque é pull-up
 
-        // Se mudou de estado, publica
+        // Se mudou de estado, publica (ou resume, se a porta estiver oscilando)
         if (rack_port_state != last_rack_door_state) {
             printf("[BOTÃO] Estado mudou para: %s\n", rack_port_state ? "ON" : "OFF");
-            publish_door_state(rack_port_state);
+            switch (flap_detector_transition(&door_flap, now_ms)) {
+                case FLAP_PASS:
+                    publish_door_state(rack_port_state);
+                    if (rack_port_state) {
+                        capture_trigger("door", now_ms);
+                    }
+                    break;
+                case FLAP_ENTERED:
+                    publish_door_flapping(true, true, door_flap.threshold, rack_port_state);
+                    capture_trigger("door_flapping", now_ms);
+                    break;
+                case FLAP_SUPPRESSED:
+                    break;
+            }
+            aggregator_set_door(&hourly_agg, rack_port_state, now_ms);
+            aggregator_set_door(&daily_agg, rack_port_state, now_ms);
             last_rack_door_state = rack_port_state;
         }
 
+        uint32_t door_transitions;
+        switch (flap_detector_tick(&door_flap, now_ms, &door_transitions)) {
+            case FLAP_TICK_SUMMARY:
+                publish_door_flapping(false, true, door_transitions, rack_port_state);
+                break;
+            case FLAP_TICK_EXITED:
+                publish_door_flapping(false, false, door_transitions, rack_port_state);
+                publish_door_state(rack_port_state);
+                break;
+            default:
+                break;
+        }
+
         // Lê a temperatura do rack
         float rack_temperature = read_rack_temperature(TEMPERATURE_UNITS);
-        if (rack_temperature != last_rack_temperature) {
+        sensor_health_update(&temperature_health, rack_temperature);
+        publish_sensor_health(&temperature_health, "temperature");
+
+        // Leituras falhas ou impossíveis não são publicadas; travadas ou ruidosas saem com as flags, sem agir sobre elas
+        if (sensor_health_value_trusted(&temperature_health)) {
+            history_add(now_ms, rack_temperature);
+
+            // Alarme com histerese: dispara a captura ao entrar, normaliza só bem abaixo do limite
+            if (!temperature_alarm && rack_temperature >= TEMPERATURE_ALARM) {
+                temperature_alarm = true;
+                publish_temperature_alarm(true, rack_temperature);
+                capture_trigger("temperature", now_ms);
+            } else if (temperature_alarm && rack_temperature < TEMPERATURE_ALARM - TEMPERATURE_ALARM_HYSTERESIS) {
+                temperature_alarm = false;
+                publish_temperature_alarm(false, rack_temperature);
+            }
+            aggregator_add_temperature(&hourly_agg, rack_temperature);
+            aggregator_add_temperature(&daily_agg, rack_temperature);
+        } else {
+            history_gap();
+        }
+        if (sensor_health_value_usable(&temperature_health) && rack_temperature != last_rack_temperature) {
             printf("[TEMPERATURA] Temperatura mudou para: %.2f\n", rack_temperature);
-            publish_rack_temperature(rack_temperature);
+#if RACK_REPORT_RAW
+            publish_rack_temperature(rack_temperature, temperature_health.flags);
+#endif
             last_rack_temperature = rack_temperature;
         }
+#if RACK_SNMP
+        // Consultas SNMP veem a última leitura válida
+        snmp_agent_update(rack_port_state, last_rack_temperature, temperature_alarm);
+#endif
+
+        agg_summary_t summary;
+        uint32_t epoch_s = rack_time_epoch();
+        if (aggregator_tick(&hourly_agg, epoch_s, now_ms, &summary)) {
+            publish_aggregate_summary("hourly", &summary);
+        }
+        if (aggregator_tick(&daily_agg, epoch_s, now_ms, &summary)) {
+            publish_aggregate_summary("daily", &summary);
+        }
+
+        if (time_reached(next_gps_time)) {
+            publish_rack_gps_position();
+            next_gps_time = make_timeout_time_ms(GPS_INTERVAL_MS);
+        }
 
-        publish_rack_gps_position();
+        // PDUs e nobreaks no RS-485: só as leituras que mudaram são publicadas
+        modbus_tick(now_ms);
+        modbus_change_t modbus_change;
+        while (modbus_take_change(&modbus_change)) {
+            publish_modbus_change(&modbus_change);
+        }
 
-        sleep_ms(1000); // Ajuste conforme desejado
+        char command[64];
+        if (mqtt_link_take_command(command, sizeof(command))) {
+            handle_command(command);
+        }
+        stream_tick(&history_stream, now_ms);
+        service_capture_upload();
+
+        if (time_reached(next_metrics_time)) {
+            publish_rack_metrics();
+            next_metrics_time = make_timeout_time_ms(METRICS_INTERVAL_MS + fleet_jitter_ms(FLEET_PUBLISH_JITTER_MS));
+        }
+
+        if (drift_monitor_due(now_ms)) {
+            sample_drift_monitor(now_ms);
+        }
+
+#if RACK_FAULT_INJECTION
+        outbox_stats_t outbox;
+        outbox_get_stats(&outbox);
+        fault_inject_tick(now_ms, mqtt_link_is_connected() && outbox.depth == 0, outbox.dropped + outbox.publish_errors);
+#endif
+
+        /* Entrega as mensagens pendentes na fila de saída. Com backlog (replay após queda),
+         * continua drenando até o próximo ciclo à medida que o anel do cliente MQTT esvazia. */
+        while (true) {
+            if (mqtt_link_is_connected()) {
+                outbox_drain(mqtt_link_client(), to_ms_since_boot(get_absolute_time()));
+            }
+            outbox_stats_t outbox;
+            outbox_get_stats(&outbox);
+            if (!mqtt_link_is_connected() || outbox.depth == 0 ||
+                absolute_time_diff_us(get_absolute_time(), cycle_deadline) < OUTBOX_DRAIN_INTERVAL_MS * 1000) {
+                break;
+            }
+            sleep_ms(OUTBOX_DRAIN_INTERVAL_MS);
+        }
+        sleep_until(cycle_deadline);
     }
 
     // Finaliza (nunca chega aqui)
@@ -133,39 +377,18 @@ int main() {
     return 0;
 }
 
-/* References for this implementation:
- * raspberry-pi-pico-c-sdk.pdf, Section '4.1.1. hardware_adc'
- * pico-examples/adc/adc_console/adc_console.c */
+// Leitura do sensor interno; a conversão fica em rack_format.c
 float read_rack_temperature(const char unit) {
-    
-    /* 12-bit conversion, assume max value == ADC_VREF == 3.3 V */
-    const float conversionFactor = 3.3f / (1 << 12);
+    // O timer da captura também lê o ADC a partir de IRQ; a conversão leva ~2 us
+    uint32_t irq_state = save_and_disable_interrupts();
+    uint16_t raw = adc_read();
+    restore_interrupts(irq_state);
 
-    float adc = (float)adc_read() * conversionFactor;
-    float tempC = 27.0f - (adc - 0.706f) / 0.001721f;
-
-    if (unit == 'C') {
-        return tempC;
-    } else if (unit == 'F') {
-        return tempC * 9 / 5 + 32;
-    }
-
-    return -1.0f;
-}
-
-// Callback de conexão MQTT
-static void mqtt_connection_callback(mqtt_client_t *client, void *arg, mqtt_connection_status_t status) {
-    if (status == MQTT_CONNECT_ACCEPTED) {
-        printf("[MQTT] Conectado ao broker!\n");
-        mqtt_connected = true;
-    } else {
-        printf("[MQTT] Falha na conexão MQTT. Código: %d\n", status);
-        mqtt_connected = false;
-    }
+    return convert_rack_temperature(raw, unit);
 }
 
 void publish_rack_gps_position(){
-    if (!mqtt_connected) {
+    if (!mqtt_link_is_connected()) {
         printf("[MQTT] Não conectado, não publicando posição do rack\n");
         return;
     }
@@ -181,51 +404,30 @@ void publish_rack_gps_position(){
 
     char topic_rack_gps_position_latitude[50];
     snprintf(topic_rack_gps_position_latitude, sizeof(topic_rack_gps_position_latitude), "%s/latitude", topic_rack_gps_position);
-    err_t err = mqtt_publish(mqtt_client, topic_rack_gps_position_latitude, message_latitude, strlen(message_latitude), 0, 0, NULL, NULL);
+    outbox_publish(TELEMETRY_CH_GPS, TELEMETRY_PRIO_TELEMETRY, topic_rack_gps_position_latitude, message_latitude, strlen(message_latitude), 0, 0);
 
-    if (err == ERR_OK) {
-        printf("[MQTT] Publicação latitude enviada com sucesso\n");
-    } else {
-        printf("[MQTT] Erro ao publicar latitude: %d\n", err);
-    }
-    
     char topic_rack_gps_position_longitude[50];
     snprintf(topic_rack_gps_position_longitude, sizeof(topic_rack_gps_position_longitude), "%s/longitude", topic_rack_gps_position);
-    err = mqtt_publish(mqtt_client, topic_rack_gps_position_longitude, message_longitude, strlen(message_longitude), 0, 0, NULL, NULL);
-    if (err == ERR_OK) {
-        printf("[MQTT] Publicação longitude enviada com sucesso\n");
-    } else {
-        printf("[MQTT] Erro ao publicar longitude: %d\n", err);
-    }
+    outbox_publish(TELEMETRY_CH_GPS, TELEMETRY_PRIO_TELEMETRY, topic_rack_gps_position_longitude, message_longitude, strlen(message_longitude), 0, 0);
 }
 
-void publish_rack_temperature(float temperature) {
-    if (!mqtt_connected) {
-        printf("[MQTT] Não conectado, não publicando temperatura do rack\n");
-        return;
-    }
+// Eventos (porta, temperatura) são enfileirados mesmo desconectado e entregues na reconexão
+void publish_rack_temperature(float temperature, uint8_t quality) {
     char topic_rack_temperature[50];
     snprintf(topic_rack_temperature, sizeof(topic_rack_temperature), "%s/temperature", mqtt_rack_topic);
 
-    char message[16];
-    snprintf(message, sizeof(message), "%.2f", temperature);
+    // A leitura leva a própria qualidade ("ok" ou "stuck,noisy"), não só o tópico retido /temperature/quality
+    char quality_text[32];
+    sensor_health_describe(quality, quality_text, sizeof(quality_text));
+    char message[64];
+    snprintf(message, sizeof(message), "{\"value\":%.2f,\"quality\":\"%s\"}", temperature, quality_text);
 
     printf("[MQTT] Publicando: tópico='%s', mensagem='%s'\n", topic_rack_temperature, message);
 
-    err_t err = mqtt_publish(mqtt_client, topic_rack_temperature, message, strlen(message), 0, 0, NULL, NULL);
-
-    if (err == ERR_OK) {
-        printf("[MQTT] Publicação enviada com sucesso\n");
-    } else {
-        printf("[MQTT] Erro ao publicar: %d\n", err);
-    }
+    outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_TELEMETRY, topic_rack_temperature, message, strlen(message), 0, 0);
 }
 
 void publish_door_state(bool pressed) {
-    if (!mqtt_connected) {
-        printf("[MQTT] Não conectado, não publicando estado da porta\n");
-        return;
-    }
     char topic_door_state[50];
     snprintf(topic_door_state, sizeof(topic_door_state), "%s/door", mqtt_rack_topic);
 
@@ -233,35 +435,398 @@ void publish_door_state(bool pressed) {
 
     printf("[MQTT] Publicando: tópico='%s', mensagem='%s'\n", topic_door_state, message);
 
-    err_t err = mqtt_publish(mqtt_client, topic_door_state, message, strlen(message), 0, 0, NULL, NULL);
+    // Eventos de porta usam QoS 1: só saem da fila após o PUBACK do broker
+    outbox_publish(TELEMETRY_CH_DOOR, TELEMETRY_PRIO_ALARM, topic_door_state, message, strlen(message), 1, 0);
+#if RACK_SNMP
+    // O trap sai direto para o NOC, sem depender do broker MQTT
+    snmp_agent_trap_door(pressed);
+#endif
+}
+
+// Publica a qualidade do canal (retida) e um evento em <rack>/sensor_fault quando surgem falhas
+void publish_sensor_health(sensor_health_t *health, const char *subtopic) {
+    uint8_t new_faults, cleared;
+    if (!sensor_health_take_change(health, &new_faults, &cleared)) {
+        return;
+    }
+
+    char topic_quality[50];
+    snprintf(topic_quality, sizeof(topic_quality), "%s/%s/quality", mqtt_rack_topic, subtopic);
+
+    char quality[32];
+    sensor_health_describe(health->flags, quality, sizeof(quality));
+
+    printf("[SENSOR] %s: qualidade '%s'\n", health->name, quality);
+
+    outbox_publish(TELEMETRY_CH_SENSOR, TELEMETRY_PRIO_STATE, topic_quality, quality, strlen(quality), 1, 1);
+
+    char topic_fault[50];
+    snprintf(topic_fault, sizeof(topic_fault), "%s/sensor_fault", mqtt_rack_topic);
+
+    char faults[32];
+    char cleared_faults[32];
+    sensor_health_describe(new_faults, faults, sizeof(faults));
+    sensor_health_describe(cleared, cleared_faults, sizeof(cleared_faults));
+
+    char message[96];
+    snprintf(message, sizeof(message), "{\"sensor\":\"%s\",\"faults\":\"%s\",\"cleared\":\"%s\",\"quality\":\"%s\"}",
+             health->name, new_faults ? faults : "", cleared ? cleared_faults : "", quality);
+
+    printf("[MQTT] Publicando: tópico='%s', mensagem='%s'\n", topic_fault, message);
 
-    if (err == ERR_OK) {
-        printf("[MQTT] Publicação enviada com sucesso\n");
+    outbox_publish(TELEMETRY_CH_SENSOR, new_faults ? TELEMETRY_PRIO_ALARM : TELEMETRY_PRIO_STATE,
+                   topic_fault, message, strlen(message), 1, 0);
+}
+
+// Resumo do balde fechado em <rack>/summary/<name> (QoS 1: é o único registro quando RACK_REPORT_RAW=0);
+// "partial":true marca o balde que só cobriu parte do período (boot, sincronização ou salto do relógio)
+void publish_aggregate_summary(const char *name, const agg_summary_t *summary) {
+    char topic_summary[50];
+    snprintf(topic_summary, sizeof(topic_summary), "%s/summary/%s", mqtt_rack_topic, name);
+
+    char message[OUTBOX_PRODUCER_MAX];
+    snprintf(message, sizeof(message), "{\"ts\":%u,\"p\":%u,\"min\":%.2f,\"max\":%.2f,\"avg\":%.2f,\"n\":%u,\"door_min\":%.1f,\"opens\":%u%s}",
+             (unsigned)summary->start, (unsigned)summary->period_s, summary->temp_min, summary->temp_max, summary->temp_avg,
+             (unsigned)summary->temp_count, summary->door_open_ms / 60000.0f, (unsigned)summary->door_openings,
+             summary->partial ? ",\"partial\":true" : "");
+
+    printf("[MQTT] Publicando: tópico='%s', mensagem='%s'\n", topic_summary, message);
+
+    outbox_publish(TELEMETRY_CH_SUMMARY, TELEMETRY_PRIO_STATE, topic_summary, message, strlen(message), 1, 0);
+}
+
+// Porta oscilando: "FLAPPING" no tópico da porta ao entrar, resumos periódicos em door/flapping
+void publish_door_flapping(bool entered, bool flapping, uint32_t transitions, bool pressed) {
+    char topic_door_flapping[50];
+    snprintf(topic_door_flapping, sizeof(topic_door_flapping), "%s/door/flapping", mqtt_rack_topic);
+
+    char message[64];
+    snprintf(message, sizeof(message), "{\"flapping\":%s,\"transitions\":%u,\"state\":\"%s\"}",
+             flapping ? "true" : "false", (unsigned)transitions, pressed ? "ON" : "OFF");
+
+    printf("[MQTT] Publicando: tópico='%s', mensagem='%s'\n", topic_door_flapping, message);
+
+    outbox_publish(TELEMETRY_CH_DOOR, TELEMETRY_PRIO_STATE, topic_door_flapping, message, strlen(message), 1, 0);
+
+    if (entered) {
+        // Entrada no estado: o tópico principal da porta sinaliza a oscilação uma única vez
+        char topic_door_state[50];
+        snprintf(topic_door_state, sizeof(topic_door_state), "%s/door", mqtt_rack_topic);
+        outbox_publish(TELEMETRY_CH_DOOR, TELEMETRY_PRIO_ALARM, topic_door_state, "FLAPPING", 8, 1, 0);
+    }
+}
+
+// Publica um grupo de métricas em <rack>/metrics/<name>
+static void publish_metric(const char *name, const char *message) {
+    char topic_rack_metric[50];
+    snprintf(topic_rack_metric, sizeof(topic_rack_metric), "%s/metrics/%s", mqtt_rack_topic, name);
+
+    printf("[MQTT] Publicando: tópico='%s', mensagem='%s'\n", topic_rack_metric, message);
+
+    outbox_publish(TELEMETRY_CH_METRICS, TELEMETRY_PRIO_BULK, topic_rack_metric, message, strlen(message), 0, 0);
+}
+
+void publish_rack_metrics() {
+    if (!mqtt_link_is_connected()) {
+        printf("[MQTT] Não conectado, não publicando métricas do rack\n");
+        return;
+    }
+    char message[OUTBOX_PRODUCER_MAX];
+
+    stack_usage_t core0 = stack_monitor_core0();
+    stack_usage_t core1 = stack_monitor_core1();
+
+    // IRQs compartilham a pilha do core 0 (MSP), então "core0" já inclui o pior caso de IRQ
+    snprintf(message, sizeof(message), "{\"core0\":{\"size\":%u,\"peak\":%u},\"core1\":{\"size\":%u,\"peak\":%u}}",
+             (unsigned)core0.size, (unsigned)core0.peak_used, (unsigned)core1.size, (unsigned)core1.peak_used);
+    publish_metric("stack", message);
+
+#if RACK_HEAP_FREE
+    snprintf(message, sizeof(message), "{\"init_allocs\":%u,\"late_allocs\":%u}",
+             (unsigned)heap_guard_init_allocs(), (unsigned)heap_guard_late_allocs());
+    publish_metric("heap", message);
+#endif
+
+    outbox_stats_t outbox;
+    outbox_get_stats(&outbox);
+    const msg_pool_t *pool = outbox_pool();
+    snprintf(message, sizeof(message), "{\"depth\":%u,\"peak\":%u,\"sent\":%u,\"dropped\":%u,\"errors\":%u,\"pool_peak\":%u,\"pool_fail\":%u}",
+             (unsigned)outbox.depth, (unsigned)outbox.peak_depth, (unsigned)outbox.sent, (unsigned)outbox.dropped,
+             (unsigned)outbox.publish_errors, (unsigned)pool->peak_in_use, (unsigned)pool->alloc_failures);
+    publish_metric("outbox", message);
+
+    snprintf(message, sizeof(message), "{\"inflight\":%u,\"acked\":%u,\"retransmits\":%u,\"resync_ms\":%u}",
+             (unsigned)outbox.inflight, (unsigned)outbox.acked, (unsigned)outbox.retransmits, (unsigned)outbox.last_resync_ms);
+    publish_metric("session", message);
+
+    snprintf(message, sizeof(message), "{\"resync_n\":%u,\"rate\":%u,\"stalls\":%u,\"ring\":%u}",
+             (unsigned)outbox.last_resync_sent, (unsigned)outbox.drain_rate, (unsigned)outbox.ring_stalls,
+             (unsigned)MQTT_BACKEND_TX_SIZE);
+    publish_metric("drain", message);
+
+    snprintf(message, sizeof(message), "{\"backend\":\"%s\",\"last_us\":%u,\"avg_us\":%u,\"max_us\":%u}",
+             MQTT_BACKEND_NAME, (unsigned)outbox.publish_us_last, (unsigned)outbox.publish_us_avg,
+             (unsigned)outbox.publish_us_max);
+    publish_metric("publish", message);
+
+    snprintf(message, sizeof(message), "{\"alarm\":%u,\"state\":%u,\"telemetry\":%u,\"bulk\":%u,\"aged\":%u,\"alarm_max_ms\":%u,\"alarm_last_ms\":%u}",
+             (unsigned)outbox.depth_by_priority[TELEMETRY_PRIO_ALARM], (unsigned)outbox.depth_by_priority[TELEMETRY_PRIO_STATE],
+             (unsigned)outbox.depth_by_priority[TELEMETRY_PRIO_TELEMETRY], (unsigned)outbox.depth_by_priority[TELEMETRY_PRIO_BULK],
+             (unsigned)outbox.aged, (unsigned)outbox.alarm_latency_max_ms, (unsigned)outbox.alarm_latency_last_ms);
+    publish_metric("queue", message);
+
+    snprintf(message, sizeof(message), "{\"door\":%u,\"temperature\":%u,\"gps\":%u,\"metrics\":%u,\"deferred\":%u}",
+             (unsigned)rate_limit_throttled(TELEMETRY_CH_DOOR), (unsigned)rate_limit_throttled(TELEMETRY_CH_TEMPERATURE),
+             (unsigned)rate_limit_throttled(TELEMETRY_CH_GPS), (unsigned)rate_limit_throttled(TELEMETRY_CH_METRICS),
+             (unsigned)rate_limit_deferred());
+    publish_metric("throttled", message);
+
+    // Canais de volume em grupo próprio: os nove contadores não cabem em um payload de métricas
+    snprintf(message, sizeof(message), "{\"summary\":%u,\"history\":%u,\"capture\":%u,\"modbus\":%u,\"sensor\":%u}",
+             (unsigned)rate_limit_throttled(TELEMETRY_CH_SUMMARY), (unsigned)rate_limit_throttled(TELEMETRY_CH_HISTORY),
+             (unsigned)rate_limit_throttled(TELEMETRY_CH_CAPTURE), (unsigned)rate_limit_throttled(TELEMETRY_CH_MODBUS),
+             (unsigned)rate_limit_throttled(TELEMETRY_CH_SENSOR));
+    publish_metric("throttled_bulk", message);
+
+    wifi_link_stats_t wifi;
+    wifi_link_get_stats(&wifi);
+    snprintf(message, sizeof(message), "{\"connects\":%u,\"fast\":%u,\"fallbacks\":%u,\"cached_ip\":%u,\"assoc_ms\":%u,\"ip_ms\":%u,\"dhcp_ms\":%u}",
+             (unsigned)wifi.connects, (unsigned)wifi.fast_joins, (unsigned)wifi.fast_fallbacks, (unsigned)wifi.cached_leases,
+             (unsigned)wifi.last_assoc_ms, (unsigned)wifi.last_ip_ms, (unsigned)wifi.last_dhcp_ms);
+    publish_metric("wifi", message);
+
+    snprintf(message, sizeof(message), "{\"rssi\":%d,\"avg\":%d,\"min\":%d,\"scans\":%u,\"roams\":%u,\"roam_ms\":%u}",
+             (int)wifi.rssi, (int)wifi.rssi_avg, (int)wifi.rssi_min, (unsigned)wifi.roam_scans,
+             (unsigned)wifi.roams, (unsigned)wifi.last_roam_ms);
+    publish_metric("link", message);
+
+    snprintf(message, sizeof(message), "{\"index\":%u,\"failovers\":%u,\"last_failover_ms\":%u,\"reconnects\":%u}",
+             (unsigned)broker_list_current_index(), (unsigned)broker_list_failovers(),
+             (unsigned)broker_list_last_failover_ms(), (unsigned)mqtt_link_reconnects());
+    publish_metric("broker", message);
+
+    snprintf(message, sizeof(message), "{\"samples\":%u,\"growing\":%u}",
+             (unsigned)drift_monitor_samples(), (unsigned)drift_monitor_flags());
+    publish_metric("drift", message);
+
+    snprintf(message, sizeof(message), "{\"triggers\":%u,\"rejected\":%u,\"uploading\":%s}",
+             (unsigned)capture_triggers(), (unsigned)capture_rejected(), stream_active(&capture_stream) ? "true" : "false");
+    publish_metric("capture", message);
+
+    modbus_stats_t modbus;
+    modbus_get_stats(&modbus);
+    snprintf(message, sizeof(message), "{\"entries\":%u,\"polls\":%u,\"ok\":%u,\"timeouts\":%u,\"crc\":%u,\"exceptions\":%u,\"last_exc\":%u}",
+             (unsigned)modbus_map()->count, (unsigned)modbus.polls, (unsigned)modbus.ok, (unsigned)modbus.timeouts,
+             (unsigned)modbus.crc_errors, (unsigned)modbus.exceptions, (unsigned)modbus.last_exception);
+    publish_metric("modbus", message);
+
+    stream_stats_t stream;
+    stream_get_stats(&stream);
+    snprintf(message, sizeof(message), "{\"streams\":%u,\"chunks\":%u,\"bytes\":%u,\"ms\":%u,\"rate\":%u,\"failed\":%u}",
+             (unsigned)stream.streams, (unsigned)stream.last_chunks, (unsigned)stream.last_bytes,
+             (unsigned)stream.last_ms, (unsigned)stream.last_rate, (unsigned)stream.last_failed);
+    publish_metric("stream", message);
+
+#if RACK_SNMP
+    snmp_agent_stats_t snmp;
+    snmp_agent_get_stats(&snmp);
+    snprintf(message, sizeof(message), "{\"traps\":%u,\"errors\":%u,\"last_us\":%u,\"max_us\":%u}",
+             (unsigned)snmp.traps, (unsigned)snmp.errors, (unsigned)snmp.last_us, (unsigned)snmp.max_us);
+    publish_metric("snmp", message);
+#endif
+
+#if RACK_FAULT_INJECTION
+    fault_result_t fault;
+    if (fault_inject_last_result(&fault)) {
+        snprintf(message, sizeof(message), "{\"step\":%u,\"fault\":\"%s\",\"recovery_ms\":%u,\"lost\":%u,\"drop_tx\":%u,\"drop_rx\":%u,\"drop_slot\":%u}",
+                 (unsigned)fault.step, fault_inject_type_name(fault.type), (unsigned)fault.recovery_ms,
+                 (unsigned)fault.lost_messages, (unsigned)fault.dropped_tx, (unsigned)fault.dropped_rx,
+                 (unsigned)fault.delay_overflow);
+        publish_metric("fault", message);
+    }
+#endif
+}
+
+// Coleta os medidores de recursos para o detector de vazamento/deriva
+static void sample_drift_monitor(uint32_t now_ms) {
+    static uint32_t last_enqueued = 0;
+
+    outbox_stats_t outbox;
+    outbox_get_stats(&outbox);
+
+    uint32_t values[DRIFT_GAUGE_COUNT] = {
+        [DRIFT_OUTBOX_DEPTH] = outbox.depth,
+        [DRIFT_POOL_IN_USE]  = outbox_pool()->in_use,
+        [DRIFT_STACK_CORE0]  = stack_monitor_core0().peak_used,
+#if RACK_HEAP_FREE
+        [DRIFT_LATE_ALLOCS]  = heap_guard_late_allocs(),
+#endif
+        [DRIFT_MSG_RATE]     = outbox.enqueued - last_enqueued,
+    };
+    last_enqueued = outbox.enqueued;
+
+    drift_monitor_sample(now_ms, values);
+}
+
+// Comandos recebidos em <rack>/cmd
+static void handle_command(const char *command) {
+    printf("[CMD] Recebido: '%s'\n", command);
+
+    if (strncmp(command, "history", 7) == 0 && (command[7] == '\0' || command[7] == ' ')) {
+        uint32_t minutes = (uint32_t)atoi(command + 7);
+        start_history_dump(minutes);
+    } else if (strcmp(command, "capture") == 0) {
+        capture_trigger("manual", to_ms_since_boot(get_absolute_time()));
+    } else if (strncmp(command, "modbus ", 7) == 0) {
+        handle_modbus_command(command + 7);
     } else {
-        printf("[MQTT] Erro ao publicar: %d\n", err);
+        printf("[CMD] Comando desconhecido\n");
     }
 }
 
-// Callback de DNS
-void dns_check_callback(const char *name, const ip_addr_t *ipaddr, void *callback_arg) {
-    if (ipaddr != NULL) {
-        broker_ip = *ipaddr;
-        printf("[DNS] Resolvido: %s -> %s\n", name, ipaddr_ntoa(ipaddr));
-
-        struct mqtt_connect_client_info_t ci = {
-            .client_id = "pico-client",
-            .keep_alive = 60,
-            .client_user = NULL,
-            .client_pass = NULL,
-            .will_topic = NULL,
-            .will_msg = NULL,
-            .will_qos = 0,
-            .will_retain = 0
+/* Edição do mapa Modbus gravado em flash:
+ *   modbus set <índice> <nome> <escravo> <função> <endereço> <quantidade> <deadband> <período_s>
+ *   modbus del <índice> */
+static void handle_modbus_command(const char *args) {
+    unsigned index, unit, function, address, count, deadband, period_s;
+    char name[MODBUS_NAME_MAX];
+    bool ok = false;
+
+    if (sscanf(args, "set %u %11s %u %u %u %u %u %u", &index, name, &unit, &function, &address, &count,
+               &deadband, &period_s) == 8) {
+        modbus_reg_t reg = {
+            .unit = (uint8_t)unit,
+            .function = (uint8_t)function,
+            .address = (uint16_t)address,
+            .count = (uint8_t)count,
+            .deadband = (uint16_t)deadband,
+            .period_s = (uint16_t)period_s,
         };
+        snprintf(reg.name, sizeof(reg.name), "%s", name);
+        ok = unit <= UINT8_MAX && address <= UINT16_MAX && count <= UINT8_MAX && deadband <= UINT16_MAX &&
+             period_s <= UINT16_MAX && modbus_map_set(index, &reg);
+    } else if (sscanf(args, "del %u", &index) == 1) {
+        ok = modbus_map_remove(index);
+    }
+    printf("[CMD] Mapa Modbus %s\n", ok ? "atualizado" : "não alterado (comando ou entrada inválida)");
+}
 
-        printf("[MQTT] Conectando ao broker...\n");
-        mqtt_client_connect(mqtt_client, &broker_ip, MQTT_BROKER_PORT, mqtt_connection_callback, NULL, &ci);
-    } else {
-        printf("[DNS] Falha ao resolver DNS para %s\n", name);
+/* Despeja o histórico como fluxo em <rack>/history/<id> (ver stream_pub.h): um bloco binário
+ * por trecho, no formato de history.h, com o meta descrevendo a faixa de blocos. */
+static void start_history_dump(uint32_t minutes) {
+    if (stream_active(&history_stream)) {
+        printf("[HISTORY] Despejo %u já em andamento\n", history_dump.id);
+        return;
     }
-}
\ No newline at end of file
+    // minutes == 0: todo o histórico disponível
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    uint32_t window_ms = minutes * 60000u;
+    uint32_t from_seq = (minutes > 0 && window_ms < now_ms) ? history_seq_since(now_ms - window_ms) : history_oldest_seq();
+    uint32_t end_seq = history_next_seq();
+
+    char topic[OUTBOX_TOPIC_MAX];
+    snprintf(topic, sizeof(topic), "%s/history/%u", mqtt_rack_topic, history_dump.id + 1u);
+
+    char message[OUTBOX_PRODUCER_MAX];
+    snprintf(message, sizeof(message), "{\"from\":%u,\"to\":%u,\"now_ms\":%u,\"epoch\":%u,\"scale\":100,\"unit\":\"%c\",\"enc\":\"dod\"}",
+             (unsigned)from_seq, (unsigned)end_seq, (unsigned)now_ms, (unsigned)rack_time_epoch(), TEMPERATURE_UNITS);
+
+    if (!stream_begin(&history_stream, TELEMETRY_CH_HISTORY, topic, message, history_fill, NULL)) {
+        printf("[HISTORY] Fila sem espaço para iniciar o despejo\n");
+        return;
+    }
+    history_dump.id++;
+    history_dump.index = 0;
+    history_dump.seq = from_seq;
+    history_dump.end_seq = end_seq;
+    printf("[HISTORY] Iniciando despejo %u: blocos %u a %u\n", history_dump.id, (unsigned)from_seq, (unsigned)end_seq);
+}
+
+// Trecho `index` do despejo; um índice repetido (trecho recusado pela fila) reproduz o mesmo bloco
+static size_t history_fill(void *ctx, uint32_t index, uint8_t *buf, size_t len) {
+    if (index != history_dump.index) {
+        history_dump.index = index;
+        history_dump.seq++;
+    }
+    // Blocos sobrescritos durante o despejo são pulados
+    for (; history_dump.seq < history_dump.end_seq; history_dump.seq++) {
+        size_t block_len = history_serialize(history_dump.seq, buf, len);
+        if (block_len > 0) {
+            return block_len;
+        }
+    }
+    return 0;
+}
+
+static float capture_convert(uint16_t raw) {
+    return convert_rack_temperature(raw, TEMPERATURE_UNITS);
+}
+
+void publish_temperature_alarm(bool alarm, float temperature) {
+    char topic_temperature_alarm[OUTBOX_TOPIC_MAX];
+    snprintf(topic_temperature_alarm, sizeof(topic_temperature_alarm), "%s/temperature/alarm", mqtt_rack_topic);
+
+    char message[48];
+    snprintf(message, sizeof(message), "{\"state\":\"%s\",\"value\":%.2f}", alarm ? "HIGH" : "NORMAL", temperature);
+
+    printf("[TEMPERATURA] Alarme %s em %.2f\n", alarm ? "ativado" : "normalizado", temperature);
+    outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_ALARM, topic_temperature_alarm, message, strlen(message), 1, 1);
+#if RACK_SNMP
+    snmp_agent_trap_temperature(alarm, temperature);
+#endif
+}
+
+/* Envia a janela congelada como fluxo em <rack>/capture/<id> (trechos no formato de capture.h)
+ * e rearma a captura quando o último trecho for confirmado. */
+static void service_capture_upload(void) {
+    capture_info_t info;
+
+    if (!stream_active(&capture_stream) && capture_ready(&info)) {
+        char topic[OUTBOX_TOPIC_MAX];
+        snprintf(topic, sizeof(topic), "%s/capture/%u", mqtt_rack_topic, info.id);
+
+        char message[OUTBOX_PRODUCER_MAX];
+        snprintf(message, sizeof(message),
+                 "{\"reason\":\"%s\",\"trigger_ms\":%u,\"epoch\":%u,\"rate_hz\":%u,\"pre\":%u,\"n\":%u,\"chunks\":%u,\"scale\":100}",
+                 info.reason, (unsigned)info.trigger_ms, (unsigned)rack_time_epoch(), CAPTURE_RATE_HZ,
+                 info.pre_samples, info.total_samples, info.chunks);
+        stream_begin(&capture_stream, TELEMETRY_CH_CAPTURE, topic, message, capture_fill, NULL);
+    }
+
+    if (stream_tick(&capture_stream, to_ms_since_boot(get_absolute_time())) == STREAM_DONE) {
+        capture_rearm();
+    }
+}
+
+static size_t capture_fill(void *ctx, uint32_t index, uint8_t *buf, size_t len) {
+    return index <= UINT16_MAX ? capture_serialize((uint16_t)index, buf, len) : 0;
+}
+
+/* Leitura Modbus alterada em <rack>/modbus/<nome> (retida, QoS 1: só mudanças são enviadas,
+ * então a última cópia no broker precisa ser a vigente) */
+static void publish_modbus_change(const modbus_change_t *change) {
+    const modbus_reg_t *reg = change->reg;
+    char topic[OUTBOX_TOPIC_MAX];
+    snprintf(topic, sizeof(topic), "%s/modbus/%s", mqtt_rack_topic, reg->name);
+
+    char message[OUTBOX_PRODUCER_MAX];
+    int len = modbus_format_change(message, sizeof(message), change);
+    if (len < 0 || (size_t)len >= sizeof(message)) {
+        printf("[MODBUS] %s: leitura não cabe na mensagem (%d bytes), descartada\n", reg->name, len);
+        return;
+    }
+
+    printf("[MODBUS] Publicando: tópico='%s', mensagem='%s'\n", topic, message);
+    outbox_publish(TELEMETRY_CH_MODBUS, change->online ? TELEMETRY_PRIO_TELEMETRY : TELEMETRY_PRIO_STATE,
+                   topic, message, strlen(message), 1, 1);
+}
+
+// Contador de boots em flash: distingue as sequências de mensagens de cada boot
+static uint32_t next_boot_epoch(void) {
+    uint32_t boot_epoch = 0;
+    persist_load(PERSIST_SLOT_BOOT, &boot_epoch, sizeof(boot_epoch));
+    boot_epoch++;
+    persist_save(PERSIST_SLOT_BOOT, &boot_epoch, sizeof(boot_epoch));
+    printf("[BOOT] Época de boot %u\n", (unsigned)boot_epoch);
+    return boot_epoch;
+}
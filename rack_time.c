@@ -0,0 +1,41 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Hora sincronizada
+/ Descrição: Mantém o epoch UTC a partir do SNTP do lwIP, ancorado no contador de tempo desde o boot.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/cyw43_arch.h"
+#include "lwip/apps/sntp.h"
+#include "rack_time.h"
+
+// Epoch (ms) correspondente ao instante zero do boot; válido quando synced
+static volatile uint64_t boot_epoch_ms = 0;
+static volatile bool synced = false;
+
+void rack_time_init(void) {
+    cyw43_arch_lwip_begin();
+    sntp_setoperatingmode(SNTP_OPMODE_POLL);
+    sntp_setservername(0, RACK_NTP_SERVER);
+    sntp_init();
+    cyw43_arch_lwip_end();
+}
+
+bool rack_time_is_synced(void) {
+    return synced;
+}
+
+uint32_t rack_time_epoch(void) {
+    if (!synced) {
+        return 0;
+    }
+    return (uint32_t)((boot_epoch_ms + time_us_64() / 1000) / 1000);
+}
+
+void rack_time_set_epoch(uint32_t epoch_s) {
+    boot_epoch_ms = (uint64_t)epoch_s * 1000 - time_us_64() / 1000;
+    if (!synced) {
+        printf("[SNTP] Hora sincronizada: epoch %u\n", (unsigned)epoch_s);
+    }
+    synced = true;
+}
@@ -0,0 +1,24 @@
+#ifndef RACK_TIME_H
+#define RACK_TIME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Relógio de parede sincronizado por SNTP. Antes da primeira sincronização só o tempo
+ * desde o boot é conhecido; rack_time_is_synced() indica quando o epoch é válido. */
+
+#ifndef RACK_NTP_SERVER
+#define RACK_NTP_SERVER "pool.ntp.org"
+#endif
+
+void rack_time_init(void);
+
+bool rack_time_is_synced(void);
+
+// Segundos desde 1970-01-01 UTC (0 enquanto não sincronizado)
+uint32_t rack_time_epoch(void);
+
+// Chamado pelo SNTP do lwIP via SNTP_SET_SYSTEM_TIME (ver lwipopts.h)
+void rack_time_set_epoch(uint32_t epoch_s);
+
+#endif /* RACK_TIME_H */
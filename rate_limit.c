@@ -0,0 +1,108 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Limitação de taxa
+/ Descrição: Token buckets por canal e global para limitar a telemetria de saída sem nunca atrasar alarmes.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <string.h>
+#include "rate_limit.h"
+
+// Limites por canal: { mensagens por minuto, rajada }
+static const struct {
+    uint32_t rate_per_min;
+    uint32_t burst;
+} channel_limits[TELEMETRY_CH_COUNT] = {
+    [TELEMETRY_CH_DOOR]        = { 30, 10 },
+    [TELEMETRY_CH_TEMPERATURE] = { 30, 10 },
+    [TELEMETRY_CH_GPS]         = { 12, 2  },   // latitude + longitude a cada GPS_INTERVAL_MS (10 s)
+    [TELEMETRY_CH_METRICS]     = { 20, 20 },   // um lote de métricas por minuto
+    [TELEMETRY_CH_SUMMARY]     = { 4,  4  },   // resumos horário e diário
+    [TELEMETRY_CH_HISTORY]     = { 240, 64 },  // despejos de histórico sob demanda
+    [TELEMETRY_CH_CAPTURE]     = { 60,  16 },  // janelas de captura disparadas por alarme
+    [TELEMETRY_CH_MODBUS]      = { 60,  16 },  // mudanças nos registradores de PDUs/nobreaks
+    [TELEMETRY_CH_SENSOR]      = { 10,  6  },  // qualidade retida + evento de falha por mudança
+};
+
+#define RATE_LIMIT_GLOBAL_PER_MIN 120
+#define RATE_LIMIT_GLOBAL_BURST   40
+
+static token_bucket_t channel_buckets[TELEMETRY_CH_COUNT];
+static token_bucket_t global_bucket;
+static uint32_t throttled[TELEMETRY_CH_COUNT];
+static uint32_t deferred = 0;
+static bool drain_took_token = false;   // a última rate_limit_drain() consumiu um token do bucket global
+
+static void token_bucket_refill(token_bucket_t *bucket, uint32_t now_ms) {
+    uint32_t elapsed_ms = now_ms - bucket->last_ms;
+    uint32_t capacity_milli = bucket->burst * 1000u;
+
+    // elapsed_ms * rate_per_min / 60 = milésimos de token repostos; limitado para não estourar 32 bits
+    if (elapsed_ms > 60000u) {
+        elapsed_ms = 60000u;
+    }
+    uint32_t refill = elapsed_ms * bucket->rate_per_min / 60u;
+    bucket->tokens_milli = (bucket->tokens_milli + refill > capacity_milli) ? capacity_milli : bucket->tokens_milli + refill;
+    bucket->last_ms = now_ms;
+}
+
+void token_bucket_init(token_bucket_t *bucket, uint32_t rate_per_min, uint32_t burst, uint32_t now_ms) {
+    bucket->rate_per_min = rate_per_min;
+    bucket->burst = burst;
+    bucket->tokens_milli = burst * 1000u;
+    bucket->last_ms = now_ms;
+}
+
+bool token_bucket_take(token_bucket_t *bucket, uint32_t now_ms) {
+    token_bucket_refill(bucket, now_ms);
+    if (bucket->tokens_milli < 1000u) {
+        return false;
+    }
+    bucket->tokens_milli -= 1000u;
+    return true;
+}
+
+void rate_limit_init(uint32_t now_ms) {
+    for (int channel = 0; channel < TELEMETRY_CH_COUNT; channel++) {
+        token_bucket_init(&channel_buckets[channel], channel_limits[channel].rate_per_min, channel_limits[channel].burst, now_ms);
+    }
+    token_bucket_init(&global_bucket, RATE_LIMIT_GLOBAL_PER_MIN, RATE_LIMIT_GLOBAL_BURST, now_ms);
+    memset(throttled, 0, sizeof(throttled));
+    deferred = 0;
+    drain_took_token = false;
+}
+
+bool rate_limit_admit(telemetry_channel_t channel, telemetry_priority_t priority, uint32_t now_ms) {
+    if (priority == TELEMETRY_PRIO_ALARM) {
+        // Alarmes passam sempre, mas consomem o token disponível para que o restante do canal seja contido
+        token_bucket_take(&channel_buckets[channel], now_ms);
+        return true;
+    }
+    if (token_bucket_take(&channel_buckets[channel], now_ms)) {
+        return true;
+    }
+    throttled[channel]++;
+    return false;
+}
+
+bool rate_limit_drain(telemetry_priority_t priority, uint32_t now_ms) {
+    drain_took_token = token_bucket_take(&global_bucket, now_ms);
+    if (drain_took_token || priority == TELEMETRY_PRIO_ALARM) {
+        return true;
+    }
+    deferred++;
+    return false;
+}
+
+void rate_limit_drain_cancel(void) {
+    if (drain_took_token) {
+        drain_took_token = false;
+        global_bucket.tokens_milli += 1000u;   // devolvido no mesmo ciclo: não passa da capacidade
+    }
+}
+
+uint32_t rate_limit_throttled(telemetry_channel_t channel) {
+    return channel < TELEMETRY_CH_COUNT ? throttled[channel] : 0;
+}
+
+uint32_t rate_limit_deferred(void) {
+    return deferred;
+}
@@ -0,0 +1,38 @@
+#ifndef RATE_LIMIT_H
+#define RATE_LIMIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "telemetry.h"
+
+/* Limitação de taxa por token bucket. Cada canal tem seu bucket, aplicado na entrada da
+ * fila de saída (mensagens acima da taxa são descartadas); um bucket global molda a
+ * drenagem da fila (mensagens aguardam tokens). Alarmes sempre passam. */
+
+typedef struct {
+    uint32_t rate_per_min;    // reposição em mensagens por minuto
+    uint32_t burst;           // capacidade do bucket em mensagens
+    uint32_t tokens_milli;    // tokens disponíveis em milésimos
+    uint32_t last_ms;
+} token_bucket_t;
+
+void token_bucket_init(token_bucket_t *bucket, uint32_t rate_per_min, uint32_t burst, uint32_t now_ms);
+bool token_bucket_take(token_bucket_t *bucket, uint32_t now_ms);
+
+void rate_limit_init(uint32_t now_ms);
+
+// Policiamento por canal na entrada da fila; false = descartar (contabilizado)
+bool rate_limit_admit(telemetry_channel_t channel, telemetry_priority_t priority, uint32_t now_ms);
+
+// Moldagem global na drenagem; false = a mensagem deve aguardar na fila
+bool rate_limit_drain(telemetry_priority_t priority, uint32_t now_ms);
+
+// A mensagem liberada pela última rate_limit_drain() não saiu (anel cheio, sem conexão): devolve o token
+void rate_limit_drain_cancel(void);
+
+uint32_t rate_limit_throttled(telemetry_channel_t channel);
+
+// Vezes em que a drenagem foi adiada por falta de tokens no bucket global
+uint32_t rate_limit_deferred(void);
+
+#endif /* RATE_LIMIT_H */
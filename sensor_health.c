@@ -0,0 +1,101 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Saúde de sensores
+/ Descrição: Detecta leitura falha, fora da faixa, travada e ruidosa, gerando flags de qualidade por canal.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "sensor_health.h"
+
+// Peso da nova amostra na média de ruído (1/8)
+#define SENSOR_NOISE_ALPHA 0.125f
+
+void sensor_health_init(sensor_health_t *health, const char *name, float min_valid, float max_valid,
+                        uint16_t stuck_samples, float noise_limit) {
+    memset(health, 0, sizeof(*health));
+    health->name = name;
+    health->min_valid = min_valid;
+    health->max_valid = max_valid;
+    health->stuck_samples = stuck_samples;
+    health->noise_limit = noise_limit;
+}
+
+uint8_t sensor_health_update(sensor_health_t *health, float value) {
+    uint8_t flags = SENSOR_QUALITY_OK;
+
+    if (isnan(value)) {
+        // Sem valor não há como avaliar travamento/ruído: mantém o histórico como estava
+        health->flags = SENSOR_FAULT_READ;
+        return health->flags;
+    }
+
+    if (value < health->min_valid || value > health->max_valid) {
+        flags |= SENSOR_FAULT_RANGE;
+    }
+
+    if (health->has_last) {
+        float delta = fabsf(value - health->last_value);
+        health->noise_avg += SENSOR_NOISE_ALPHA * (delta - health->noise_avg);
+
+        if (value == health->last_value) {
+            if (health->same_count < UINT16_MAX) {
+                health->same_count++;
+            }
+        } else {
+            health->same_count = 0;
+        }
+    }
+    health->last_value = value;
+    health->has_last = true;
+
+    if (health->stuck_samples > 0 && health->same_count >= health->stuck_samples) {
+        flags |= SENSOR_FAULT_STUCK;
+    }
+    if (health->noise_avg > health->noise_limit) {
+        flags |= SENSOR_FAULT_NOISY;
+    }
+
+    health->flags = flags;
+    return flags;
+}
+
+bool sensor_health_take_change(sensor_health_t *health, uint8_t *new_faults, uint8_t *cleared) {
+    if (health->flags == health->reported_flags) {
+        return false;
+    }
+    *new_faults = health->flags & ~health->reported_flags;
+    *cleared = health->reported_flags & ~health->flags;
+    if (*new_faults) {
+        health->fault_events++;
+    }
+    health->reported_flags = health->flags;
+    return true;
+}
+
+void sensor_health_describe(uint8_t flags, char *buf, size_t len) {
+    static const struct {
+        uint8_t flag;
+        const char *name;
+    } names[] = {
+        { SENSOR_FAULT_READ,  "read" },
+        { SENSOR_FAULT_RANGE, "range" },
+        { SENSOR_FAULT_STUCK, "stuck" },
+        { SENSOR_FAULT_NOISY, "noisy" },
+    };
+
+    if (flags == SENSOR_QUALITY_OK) {
+        snprintf(buf, len, "ok");
+        return;
+    }
+    size_t used = 0;
+    buf[0] = '\0';
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if ((flags & names[i].flag) && used < len) {
+            int n = snprintf(buf + used, len - used, "%s%s", used ? "," : "", names[i].name);
+            if (n > 0) {
+                used += (size_t)n;
+            }
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef SENSOR_HEALTH_H
+#define SENSOR_HEALTH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Saúde de sensores analógicos: cada canal acompanha falha de leitura, valor fora da
+ * faixa física, valor travado e ruído excessivo, e produz flags de qualidade que
+ * acompanham as leituras publicadas. */
+
+typedef enum {
+    SENSOR_QUALITY_OK  = 0,
+    SENSOR_FAULT_READ  = 1 << 0,   // leitura falhou (NaN, unidade inválida, erro de barramento)
+    SENSOR_FAULT_RANGE = 1 << 1,   // valor fisicamente impossível
+    SENSOR_FAULT_STUCK = 1 << 2,   // valor idêntico por stuck_samples leituras seguidas
+    SENSOR_FAULT_NOISY = 1 << 3,   // média da variação entre leituras acima de noise_limit
+} sensor_fault_t;
+
+typedef struct {
+    const char *name;
+    float min_valid;
+    float max_valid;
+    uint16_t stuck_samples;
+    float noise_limit;
+
+    bool has_last;
+    float last_value;
+    uint16_t same_count;
+    float noise_avg;          // média móvel exponencial de |Δ| entre leituras
+    uint8_t flags;
+    uint8_t reported_flags;   // flags na última publicação de qualidade
+    uint32_t fault_events;
+} sensor_health_t;
+
+void sensor_health_init(sensor_health_t *health, const char *name, float min_valid, float max_valid,
+                        uint16_t stuck_samples, float noise_limit);
+
+// Avalia uma nova leitura e retorna as flags de qualidade correntes
+uint8_t sensor_health_update(sensor_health_t *health, float value);
+
+// Leitura inutilizável (falha ou fora da faixa): não deve ser publicada como valor
+static inline bool sensor_health_value_usable(const sensor_health_t *health) {
+    return (health->flags & (SENSOR_FAULT_READ | SENSOR_FAULT_RANGE)) == 0;
+}
+
+/* Leitura sem nenhuma falha: só estas entram no histórico e nos agregados e disparam ações
+ * (alarme, captura). Travada ou ruidosa ainda é publicada, com as flags, mas um pico de
+ * ruído não pode abrir um alarme nem distorcer mínimo e máximo. */
+static inline bool sensor_health_value_trusted(const sensor_health_t *health) {
+    return health->flags == SENSOR_QUALITY_OK;
+}
+
+/* Verdadeiro quando as flags mudaram desde a última publicação; *new_faults recebe as
+ * falhas que surgiram e *cleared as que desapareceram. Marca o estado como publicado. */
+bool sensor_health_take_change(sensor_health_t *health, uint8_t *new_faults, uint8_t *cleared);
+
+// Lista as falhas como texto ("ok" ou "stuck,noisy")
+void sensor_health_describe(uint8_t flags, char *buf, size_t len);
+
+#endif /* SENSOR_HEALTH_H */
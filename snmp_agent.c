@@ -0,0 +1,172 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Agente SNMP
+/ Descrição: MIB privada do rack (porta, temperatura, alarmes) no agente SNMP do lwIP e traps diretos para o NOC.
+/ Obs: As consultas chegam em contexto lwIP e só leem os valores copiados por snmp_agent_update(); os traps são enviados
+/      do loop principal sob cyw43_arch_lwip_begin().
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/cyw43_arch.h"
+#include "lwip/ip_addr.h"
+#include "lwip/apps/snmp.h"
+#include "lwip/apps/snmp_core.h"
+#include "lwip/apps/snmp_scalar.h"
+#include "snmp_agent.h"
+
+enum {
+    RACK_OID_NUMBER = 1,
+    RACK_OID_DOOR_OPEN,
+    RACK_OID_TEMPERATURE,
+    RACK_OID_TEMPERATURE_ALARM,
+    RACK_OID_ALARM_COUNT,
+};
+
+// Lidos pelas consultas em contexto lwIP; palavras de 32 bits, escritas atomicamente
+static volatile s32_t rack_number;
+static volatile s32_t door_open;
+static volatile s32_t temperature_centi;
+static volatile s32_t temperature_alarm;
+static volatile u32_t alarm_count;
+
+static snmp_agent_stats_t stats;
+
+static const struct snmp_obj_id enterprise_oid = {
+    7, { 1, 3, 6, 1, 4, 1, SNMP_AGENT_ENTERPRISE }
+};
+
+static s16_t rack_scalar_get(const struct snmp_scalar_array_node_def *node, void *value) {
+    switch (node->oid) {
+        case RACK_OID_NUMBER:
+            *(s32_t *)value = rack_number;
+            break;
+        case RACK_OID_DOOR_OPEN:
+            *(s32_t *)value = door_open;
+            break;
+        case RACK_OID_TEMPERATURE:
+            *(s32_t *)value = temperature_centi;
+            break;
+        case RACK_OID_TEMPERATURE_ALARM:
+            *(s32_t *)value = temperature_alarm;
+            break;
+        case RACK_OID_ALARM_COUNT:
+            *(u32_t *)value = alarm_count;
+            break;
+        default:
+            return 0;
+    }
+    return sizeof(s32_t);
+}
+
+static const struct snmp_scalar_array_node_def rack_scalars[] = {
+    { RACK_OID_NUMBER,            SNMP_ASN1_TYPE_INTEGER, SNMP_NODE_INSTANCE_READ_ONLY },
+    { RACK_OID_DOOR_OPEN,         SNMP_ASN1_TYPE_INTEGER, SNMP_NODE_INSTANCE_READ_ONLY },
+    { RACK_OID_TEMPERATURE,       SNMP_ASN1_TYPE_INTEGER, SNMP_NODE_INSTANCE_READ_ONLY },
+    { RACK_OID_TEMPERATURE_ALARM, SNMP_ASN1_TYPE_INTEGER, SNMP_NODE_INSTANCE_READ_ONLY },
+    { RACK_OID_ALARM_COUNT,       SNMP_ASN1_TYPE_COUNTER, SNMP_NODE_INSTANCE_READ_ONLY },
+};
+
+// <enterprise>.<arc>.1: objetos escalares do rack
+static const struct snmp_scalar_array_node rack_objects = SNMP_SCALAR_CREATE_ARRAY_NODE(1, rack_scalars, rack_scalar_get, NULL, NULL);
+static const struct snmp_node *const rack_nodes[] = { &rack_objects.node.node };
+static const struct snmp_tree_node rack_tree = SNMP_CREATE_TREE_NODE(SNMP_AGENT_ARC, rack_nodes);
+
+static const u32_t rack_mib_base[] = { 1, 3, 6, 1, 4, 1, SNMP_AGENT_ENTERPRISE };
+static const struct snmp_mib rack_mib = SNMP_MIB_CREATE(rack_mib_base, &rack_tree.node);
+static const struct snmp_mib *rack_mibs[] = { &rack_mib };
+
+void snmp_agent_init(uint32_t number) {
+    rack_number = (s32_t)number;
+
+    ip_addr_t trap_ip;
+    bool trap_ok = ipaddr_aton(RACK_SNMP_TRAP_HOST, &trap_ip);
+
+    cyw43_arch_lwip_begin();
+    snmp_set_mibs(rack_mibs, LWIP_ARRAYSIZE(rack_mibs));
+    snmp_set_community(RACK_SNMP_COMMUNITY);
+    snmp_set_community_trap(RACK_SNMP_COMMUNITY);
+    snmp_set_device_enterprise_oid(&enterprise_oid);
+    if (trap_ok) {
+        snmp_trap_dst_ip_set(0, &trap_ip);
+        snmp_trap_dst_enable(0, 1);
+    }
+    snmp_init();
+    cyw43_arch_lwip_end();
+
+    if (trap_ok) {
+        printf("[SNMP] Agente ativo, traps para %s\n", RACK_SNMP_TRAP_HOST);
+    } else {
+        printf("[SNMP] Agente ativo, sem destino de traps (RACK_SNMP_TRAP_HOST inválido)\n");
+    }
+}
+
+void snmp_agent_update(bool open, float temperature, bool alarm) {
+    door_open = open ? 1 : 0;
+    temperature_centi = (s32_t)lroundf(temperature * 100.0f);
+    temperature_alarm = alarm ? 1 : 0;
+}
+
+// Monta a lista de variáveis a partir dos escalares da MIB e envia o trap medindo o custo do envio
+static void send_trap(s32_t specific, const u32_t *objects, size_t count) {
+    struct snmp_varbind varbinds[2];
+    s32_t values[2];
+    if (count > LWIP_ARRAYSIZE(varbinds)) {
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const u32_t oid[] = { 1, 3, 6, 1, 4, 1, SNMP_AGENT_ENTERPRISE, SNMP_AGENT_ARC, 1, objects[i], 0 };
+        struct snmp_scalar_array_node_def node = { objects[i], SNMP_ASN1_TYPE_INTEGER, SNMP_NODE_INSTANCE_READ_ONLY };
+        rack_scalar_get(&node, &values[i]);
+
+        memset(&varbinds[i], 0, sizeof(varbinds[i]));
+        snmp_oid_assign(&varbinds[i].oid, oid, LWIP_ARRAYSIZE(oid));
+        varbinds[i].type = SNMP_ASN1_TYPE_INTEGER;
+        varbinds[i].value = &values[i];
+        varbinds[i].value_len = sizeof(values[i]);
+        varbinds[i].prev = i > 0 ? &varbinds[i - 1] : NULL;
+        varbinds[i].next = i + 1 < count ? &varbinds[i + 1] : NULL;
+    }
+
+    uint32_t start_us = time_us_32();
+    cyw43_arch_lwip_begin();
+    err_t err = snmp_send_trap_specific(specific, &varbinds[0]);
+    cyw43_arch_lwip_end();
+    uint32_t elapsed_us = time_us_32() - start_us;
+
+    if (err != ERR_OK) {
+        stats.errors++;
+        printf("[SNMP] Erro ao enviar trap %d: %d\n", (int)specific, err);
+        return;
+    }
+    stats.traps++;
+    stats.last_us = elapsed_us;
+    if (elapsed_us > stats.max_us) {
+        stats.max_us = elapsed_us;
+    }
+}
+
+void snmp_agent_trap_door(bool open) {
+    door_open = open ? 1 : 0;
+    if (open) {
+        alarm_count++;  // o fechamento sai como trap de estado, não como alarme
+    }
+    const u32_t objects[] = { RACK_OID_DOOR_OPEN };
+    send_trap(SNMP_AGENT_TRAP_DOOR, objects, LWIP_ARRAYSIZE(objects));
+}
+
+void snmp_agent_trap_temperature(bool alarm, float temperature) {
+    temperature_alarm = alarm ? 1 : 0;
+    temperature_centi = (s32_t)lroundf(temperature * 100.0f);
+    if (alarm) {
+        alarm_count++;
+    }
+    const u32_t objects[] = { RACK_OID_TEMPERATURE_ALARM, RACK_OID_TEMPERATURE };
+    send_trap(SNMP_AGENT_TRAP_TEMPERATURE, objects, LWIP_ARRAYSIZE(objects));
+}
+
+void snmp_agent_get_stats(snmp_agent_stats_t *stats_out) {
+    *stats_out = stats;
+}
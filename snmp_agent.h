@@ -0,0 +1,45 @@
+#ifndef SNMP_AGENT_H
+#define SNMP_AGENT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Agente SNMP do lwIP (opção RACK_SNMP do CMake) com uma MIB privada pequena, somente leitura:
+ *   <enterprise>.77.1.1  rackNumber             INTEGER
+ *   <enterprise>.77.1.2  rackDoorOpen           INTEGER (1 = aberta)
+ *   <enterprise>.77.1.3  rackTemperature        INTEGER (centésimos de grau, unidade do firmware)
+ *   <enterprise>.77.1.4  rackTemperatureAlarm   INTEGER (1 = acima do limite)
+ *   <enterprise>.77.1.5  rackAlarmCount         Counter32 (porta aberta e temperatura acima do limite)
+ * Traps "enterprise specific" vão para RACK_SNMP_TRAP_HOST (IP) na comunidade
+ * RACK_SNMP_COMMUNITY: 1 = porta, 2 = temperatura, com as variáveis do objeto. Os dois
+ * sentidos geram trap; só a abertura e a entrada em alarme contam em rackAlarmCount. */
+
+// PEN do projeto lwIP como padrão; defina com o PEN da organização para a MIB ficar sob ele
+#ifndef SNMP_AGENT_ENTERPRISE
+#define SNMP_AGENT_ENTERPRISE 26381
+#endif
+#define SNMP_AGENT_ARC        77     // ramo do rack sob o enterprise
+
+#define SNMP_AGENT_TRAP_DOOR        1
+#define SNMP_AGENT_TRAP_TEMPERATURE 2
+
+typedef struct {
+    uint32_t traps;
+    uint32_t errors;
+    uint32_t last_us;    // duração de snmp_send_trap_specific (montagem + envio UDP)
+    uint32_t max_us;
+} snmp_agent_stats_t;
+
+// Inicia o agente na porta 161 e configura o destino dos traps; chamar com a pilha lwIP já iniciada
+void snmp_agent_init(uint32_t rack_number);
+
+// Valores servidos nas consultas (lidos em contexto lwIP)
+void snmp_agent_update(bool door_open, float temperature, bool temperature_alarm);
+
+void snmp_agent_trap_door(bool open);
+
+void snmp_agent_trap_temperature(bool alarm, float temperature);
+
+void snmp_agent_get_stats(snmp_agent_stats_t *stats);
+
+#endif /* SNMP_AGENT_H */
@@ -0,0 +1,52 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Monitor de pilha
+/ Descrição: Pinta as pilhas no boot e mede o high-water mark de cada contexto (core 0 + IRQs, core 1).
+/ Obs: Os símbolos __Stack* são definidos pelo linker script padrão do pico-sdk (memmap_default.ld).
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include "stack_monitor.h"
+
+// Margem preservada abaixo do SP atual ao pintar a pilha ativa
+#define STACK_MONITOR_GUARD_BYTES 64
+
+extern uint32_t __StackBottom;
+extern uint32_t __StackTop;
+extern uint32_t __StackOneBottom;
+extern uint32_t __StackOneTop;
+
+static void paint_region(uint32_t *bottom, uint32_t *top) {
+    for (uint32_t *p = bottom; p < top; p++) {
+        *p = STACK_MONITOR_PAINT_WORD;
+    }
+}
+
+static stack_usage_t measure_region(const uint32_t *bottom, const uint32_t *top) {
+    const uint32_t *p = bottom;
+    while (p < top && *p == STACK_MONITOR_PAINT_WORD) {
+        p++;
+    }
+
+    stack_usage_t usage = {
+        .size = (size_t)((const uint8_t *)top - (const uint8_t *)bottom),
+        .peak_used = (size_t)((const uint8_t *)top - (const uint8_t *)p)
+    };
+    return usage;
+}
+
+void stack_monitor_init(void) {
+    // A pilha do core 0 está em uso: pinta apenas até um pouco abaixo do SP atual
+    uint8_t marker;
+    uint32_t *limit = (uint32_t *)(((uintptr_t)&marker - STACK_MONITOR_GUARD_BYTES) & ~(uintptr_t)3);
+    paint_region(&__StackBottom, limit);
+
+    // O core 1 ainda não foi lançado, então sua pilha pode ser pintada por inteiro
+    paint_region(&__StackOneBottom, &__StackOneTop);
+}
+
+stack_usage_t stack_monitor_core0(void) {
+    return measure_region(&__StackBottom, &__StackTop);
+}
+
+stack_usage_t stack_monitor_core1(void) {
+    return measure_region(&__StackOneBottom, &__StackOneTop);
+}
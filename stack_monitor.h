@@ -0,0 +1,26 @@
+#ifndef STACK_MONITOR_H
+#define STACK_MONITOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Padrão gravado na pilha livre durante o boot ("stack painting"). */
+#define STACK_MONITOR_PAINT_WORD 0xA5A5A5A5u
+
+// Medição de uso de uma região de pilha
+typedef struct {
+    size_t size;        // tamanho total da região em bytes
+    size_t peak_used;   // maior uso observado (high-water mark) em bytes
+} stack_usage_t;
+
+/* Pinta as pilhas do core 0 (abaixo do SP atual) e do core 1.
+ * Deve ser a primeira chamada de main(), antes de qualquer IRQ habilitada
+ * pelo firmware e antes de lançar o core 1. */
+void stack_monitor_init(void);
+
+/* No RP2040 as IRQs executam sobre a MSP, a mesma pilha do core 0 em
+ * modo thread; a medição do core 0 já inclui o aninhamento de IRQs. */
+stack_usage_t stack_monitor_core0(void);
+stack_usage_t stack_monitor_core1(void);
+
+#endif /* STACK_MONITOR_H */
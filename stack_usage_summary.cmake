@@ -0,0 +1,58 @@
+# Resume os arquivos .su gerados por -fstack-usage (executado como script: cmake -P)
+#
+# Variáveis esperadas:
+#   SU_DIR     - diretório onde procurar os arquivos .su (recursivo)
+#   OUTPUT     - arquivo de saída com o ranking completo
+#   TOP        - quantidade de funções exibidas no console (padrão 15)
+
+if(NOT DEFINED SU_DIR OR NOT DEFINED OUTPUT)
+    message(FATAL_ERROR "Uso: cmake -DSU_DIR=<dir> -DOUTPUT=<arquivo> -P stack_usage_summary.cmake")
+endif()
+if(NOT DEFINED TOP)
+    set(TOP 15)
+endif()
+
+file(GLOB_RECURSE su_files "${SU_DIR}/*.su")
+
+set(entries "")
+foreach(su_file ${su_files})
+    file(STRINGS "${su_file}" lines)
+    foreach(line ${lines})
+        # Formato: arquivo:linha:coluna:função<TAB>bytes<TAB>qualificador
+        if(line MATCHES "^(.*)\t([0-9]+)\t(.*)$")
+            set(location "${CMAKE_MATCH_1}")
+            set(bytes "${CMAKE_MATCH_2}")
+            set(qualifier "${CMAKE_MATCH_3}")
+            # Preenche com zeros para que a ordenação textual seja numérica
+            set(zeros "")
+            string(LENGTH "${bytes}" len)
+            while(len LESS 8)
+                string(APPEND zeros "0")
+                math(EXPR len "${len} + 1")
+            endwhile()
+            get_filename_component(location_name "${location}" NAME)
+            list(APPEND entries "${zeros}${bytes}|${qualifier}|${location_name}")
+        endif()
+    endforeach()
+endforeach()
+
+list(SORT entries ORDER DESCENDING)
+
+set(report "bytes\tqualifier\tfunction\n")
+set(index 0)
+foreach(entry ${entries})
+    string(REPLACE "|" ";" fields "${entry}")
+    list(GET fields 0 bytes)
+    list(GET fields 1 qualifier)
+    list(GET fields 2 location)
+    math(EXPR bytes "${bytes}")
+    string(APPEND report "${bytes}\t${qualifier}\t${location}\n")
+    if(index LESS TOP)
+        message(STATUS "[stack] ${bytes}\t${qualifier}\t${location}")
+    endif()
+    math(EXPR index "${index} + 1")
+endforeach()
+
+file(WRITE "${OUTPUT}" "${report}")
+list(LENGTH entries total)
+message(STATUS "[stack] ${total} funções analisadas, relatório completo em ${OUTPUT}")
@@ -0,0 +1,109 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Publicação em fluxo
+/ Descrição: Divide cargas grandes em trechos numerados com janela de PUBACKs, publicados pela fila de saída em prioridade bulk.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "crc.h"
+#include "stream_pub.h"
+
+static stream_stats_t stats;
+
+// Notificação da fila (pode vir do contexto lwIP)
+static void chunk_done(void *arg, bool ok) {
+    stream_t *stream = (stream_t *)arg;
+    if (ok) {
+        stream->completed++;
+    } else {
+        stream->failed++;
+    }
+}
+
+static bool pool_has_room(void) {
+    return msg_pool_available(outbox_pool()) > STREAM_POOL_RESERVE;
+}
+
+bool stream_begin(stream_t *stream, telemetry_channel_t channel, const char *topic_base,
+                  const char *meta_json, stream_fill_fn fill, void *ctx) {
+    if (stream->active || !pool_has_room() || strlen(topic_base) >= sizeof(stream->topic)) {
+        return false;
+    }
+
+    char topic[OUTBOX_TOPIC_MAX];
+    snprintf(topic, sizeof(topic), "%s/meta", topic_base);
+    if (!outbox_publish(channel, TELEMETRY_PRIO_BULK, topic, meta_json, strlen(meta_json), 1, 0)) {
+        return false;
+    }
+
+    memset(stream, 0, sizeof(*stream));
+    strcpy(stream->topic, topic_base);
+    stream->channel = channel;
+    stream->fill = fill;
+    stream->ctx = ctx;
+    stream->start_ms = to_ms_since_boot(get_absolute_time());
+    stream->active = true;
+    return true;
+}
+
+static bool publish_end(stream_t *stream, uint32_t now_ms) {
+    char topic[OUTBOX_TOPIC_MAX];
+    char message[OUTBOX_PRODUCER_MAX];
+    uint32_t duration_ms = now_ms - stream->start_ms;
+
+    snprintf(topic, sizeof(topic), "%s/end", stream->topic);
+    snprintf(message, sizeof(message), "{\"chunks\":%u,\"bytes\":%u,\"crc\":%u,\"failed\":%u,\"ms\":%u}",
+             (unsigned)stream->next_index, (unsigned)stream->bytes, (unsigned)stream->crc,
+             (unsigned)stream->failed, (unsigned)duration_ms);
+    if (!outbox_publish(stream->channel, TELEMETRY_PRIO_BULK, topic, message, strlen(message), 1, 0)) {
+        return false;
+    }
+
+    stats.streams++;
+    stats.last_chunks = stream->next_index;
+    stats.last_bytes = stream->bytes;
+    stats.last_ms = duration_ms;
+    stats.last_rate = duration_ms > 0 ? (uint32_t)((uint64_t)stream->bytes * 1000u / duration_ms) : stream->bytes;
+    stats.last_failed = stream->failed;
+    printf("[STREAM] %s concluído: %u trechos, %u bytes em %u ms (%u B/s)\n", stream->topic,
+           (unsigned)stream->next_index, (unsigned)stream->bytes, (unsigned)duration_ms, (unsigned)stats.last_rate);
+    return true;
+}
+
+stream_status_t stream_tick(stream_t *stream, uint32_t now_ms) {
+    if (!stream->active) {
+        return STREAM_IDLE;
+    }
+
+    char topic[OUTBOX_TOPIC_MAX];
+    uint8_t chunk[STREAM_CHUNK_MAX];
+
+    while (!stream->fill_done && stream->next_index - (stream->completed + stream->failed) < STREAM_WINDOW && pool_has_room()) {
+        size_t len = stream->fill(stream->ctx, stream->next_index, chunk, sizeof(chunk));
+        if (len == 0) {
+            stream->fill_done = true;
+            break;
+        }
+        snprintf(topic, sizeof(topic), "%s/%u", stream->topic, (unsigned)stream->next_index);
+        if (!outbox_publish_notify(stream->channel, TELEMETRY_PRIO_BULK, topic, chunk, (uint16_t)len, 1, 0, chunk_done, stream)) {
+            break;  // canal limitado ou fila sem espaço: o mesmo trecho é produzido de novo no próximo ciclo
+        }
+        stream->crc = crc32_update(stream->crc, chunk, len);
+        stream->bytes += len;
+        stream->next_index++;
+    }
+
+    // Fim só depois que todos os trechos foram confirmados (ou descartados)
+    if (stream->fill_done && stream->completed + stream->failed >= stream->next_index && pool_has_room()) {
+        if (publish_end(stream, now_ms)) {
+            stream->active = false;
+            return STREAM_DONE;
+        }
+    }
+    return STREAM_RUNNING;
+}
+
+void stream_get_stats(stream_stats_t *out) {
+    *out = stats;
+}
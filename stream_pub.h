@@ -0,0 +1,70 @@
+#ifndef STREAM_PUB_H
+#define STREAM_PUB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "outbox.h"
+#include "telemetry.h"
+
+/* Publicação em fluxo de cargas maiores que uma mensagem da fila (despejo de histórico,
+ * capturas, exportações). A carga lógica sai como:
+ *   <base>/meta    JSON do chamador (QoS 1)
+ *   <base>/<n>     trecho n (0, 1, 2...) com os bytes produzidos pelo callback `fill` (QoS 1)
+ *   <base>/end     {"chunks":n,"bytes":n,"crc":crc32,"failed":n,"ms":duração} (QoS 1)
+ * Controle de fluxo: no máximo STREAM_WINDOW trechos sem PUBACK e nunca abaixo de
+ * STREAM_POOL_RESERVE blocos livres no pool da fila, que ficam para os alarmes. O "end"
+ * só é publicado depois de todos os trechos confirmados, então sua chegada fecha a carga. */
+
+#define STREAM_WINDOW       4
+#define STREAM_POOL_RESERVE 8
+#define STREAM_CHUNK_MAX    (OUTBOX_PAYLOAD_MAX)
+
+// Produz o trecho `index` em `buf`; retorna o tamanho ou 0 quando a carga terminou
+typedef size_t (*stream_fill_fn)(void *ctx, uint32_t index, uint8_t *buf, size_t len);
+
+typedef enum {
+    STREAM_IDLE,
+    STREAM_RUNNING,
+    STREAM_DONE,         // retornado uma única vez, na iteração que publicou o "end"
+} stream_status_t;
+
+typedef struct {
+    bool active;
+    bool fill_done;
+    telemetry_channel_t channel;
+    char topic[OUTBOX_TOPIC_MAX - 8];   // base; sobra espaço para "/<n>"
+    stream_fill_fn fill;
+    void *ctx;
+    uint32_t next_index;
+    uint32_t bytes;
+    uint32_t crc;
+    uint32_t start_ms;
+    volatile uint32_t completed;        // atualizados pela notificação da fila (contexto lwIP)
+    volatile uint32_t failed;
+} stream_t;
+
+typedef struct {
+    uint32_t streams;
+    uint32_t last_chunks;
+    uint32_t last_bytes;
+    uint32_t last_ms;
+    uint32_t last_rate;      // bytes/s sustentados no último fluxo
+    uint32_t last_failed;
+} stream_stats_t;
+
+/* Inicia o fluxo publicando <base>/meta; false se já houver um fluxo ativo nesta estrutura
+ * ou se a fila recusar o meta (tente de novo no próximo ciclo). */
+bool stream_begin(stream_t *stream, telemetry_channel_t channel, const char *topic_base,
+                  const char *meta_json, stream_fill_fn fill, void *ctx);
+
+// Avança o fluxo dentro da janela; chamar a cada iteração do loop principal
+stream_status_t stream_tick(stream_t *stream, uint32_t now_ms);
+
+static inline bool stream_active(const stream_t *stream) {
+    return stream->active;
+}
+
+void stream_get_stats(stream_stats_t *stats);
+
+#endif /* STREAM_PUB_H */
@@ -0,0 +1,28 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+/* Canais e prioridades das mensagens de saída. O canal identifica a origem da
+ * mensagem (limites de taxa, contadores); a prioridade decide quem passa primeiro. */
+
+typedef enum {
+    TELEMETRY_CH_DOOR = 0,
+    TELEMETRY_CH_TEMPERATURE,
+    TELEMETRY_CH_GPS,
+    TELEMETRY_CH_METRICS,
+    TELEMETRY_CH_SUMMARY,
+    TELEMETRY_CH_HISTORY,
+    TELEMETRY_CH_CAPTURE,
+    TELEMETRY_CH_MODBUS,
+    TELEMETRY_CH_SENSOR,        // qualidade e falhas dos sensores, fora do volume das leituras
+    TELEMETRY_CH_COUNT
+} telemetry_channel_t;
+
+typedef enum {
+    TELEMETRY_PRIO_ALARM = 0,   // nunca limitada
+    TELEMETRY_PRIO_STATE,       // mudança de estado
+    TELEMETRY_PRIO_TELEMETRY,   // leituras periódicas
+    TELEMETRY_PRIO_BULK,        // métricas, histórico, despejos
+    TELEMETRY_PRIO_COUNT
+} telemetry_priority_t;
+
+#endif /* TELEMETRY_H */
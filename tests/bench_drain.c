@@ -0,0 +1,144 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Benchmark da drenagem do backlog
+/ Descrição: Vazão da ressincronização da fila de saída após uma queda do broker, com o perfil de buffers do cliente MQTT
+/            deste build (RACK_MQTT_PROFILE_SMALL, padrão ou RACK_MQTT_PROFILE_BURST em lwipopts.h), em vários enlaces.
+/ Obs: Uso: bench_drain. Compilado uma vez por perfil (bench_drain_small, bench_drain, bench_drain_burst). O tempo é o do
+/      relógio virtual: mede o efeito do anel de saída, das requisições em voo e do intervalo de drenagem do loop
+/      principal sobre o enlace simulado, não o processador.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include "test_harness.h"
+#include "outbox.h"
+#include "rate_limit.h"
+#include "lwip/apps/mqtt_priv.h"
+
+#if defined(RACK_MQTT_PROFILE_SMALL)
+#define PROFILE_NAME "small"
+#elif defined(RACK_MQTT_PROFILE_BURST)
+#define PROFILE_NAME "burst"
+#else
+#define PROFILE_NAME "balanced"
+#endif
+
+#define BROKER_IP       "10.0.0.1"
+#define OUTAGE_MS       (2 * OUTBOX_CAPACITY * 1000)   // uma mensagem a cada 2 s enche a fila
+#define RESYNC_LIMIT_MS 600000
+
+typedef struct {
+    const char *name;
+    uint32_t bytes_per_ms;
+    uint32_t rtt_ms;
+} link_profile_t;
+
+static const link_profile_t links[] = {
+    { "LAN",           1000, 2  },
+    { "Wi-Fi bom",     500,  20 },
+    { "Wi-Fi fraco",   20,   80 },
+};
+
+static mqtt_client_t client;
+
+static uint32_t now_ms(void) {
+    return (uint32_t)(host_clock_us() / 1000u);
+}
+
+/* Queda de OUTAGE_MS: temperatura e métricas alternadas a cada 2 s, dentro das taxas dos canais,
+ * até a fila encher. Os payloads têm o tamanho máximo do produtor, o pior caso do anel. */
+static void fill_backlog(uint8_t qos) {
+    char payload[OUTBOX_PRODUCER_MAX];
+    memset(payload, '1', sizeof(payload));
+    payload[0] = '{';
+    memcpy(&payload[1], "\"t\":\"", 5);
+    payload[sizeof(payload) - 2] = '"';
+    payload[sizeof(payload) - 1] = '}';
+    for (uint32_t i = 0; i < OUTBOX_CAPACITY; i++) {
+        bool metrics = i % 2 != 0;
+        CHECK(outbox_publish(metrics ? TELEMETRY_CH_METRICS : TELEMETRY_CH_TEMPERATURE,
+                             metrics ? TELEMETRY_PRIO_BULK : TELEMETRY_PRIO_TELEMETRY,
+                             metrics ? "rack_inteligente/00007/metricas" : "rack_inteligente/00007/temperatura",
+                             payload, sizeof(payload), qos, 0));
+        host_clock_advance_ms(OUTAGE_MS / OUTBOX_CAPACITY);
+    }
+}
+
+typedef struct {
+    uint32_t resync_ms;
+    uint32_t rate;
+    uint32_t stalls;
+    uint32_t deferred;
+    double kbytes_per_s;
+} drain_result_t;
+
+static drain_result_t run_drain(const link_profile_t *link, uint8_t qos, uint32_t interval_ms) {
+    host_reset();
+    memset(&client, 0, sizeof(client));
+    rate_limit_init(now_ms());
+    outbox_init(1);
+    fill_backlog(qos);
+
+    host_link_set(link->bytes_per_ms, link->rtt_ms);
+    ip_addr_t ip;
+    ipaddr_aton(BROKER_IP, &ip);
+    struct mqtt_connect_client_info_t info = { .client_id = "rack-00007", .keep_alive = 60 };
+    CHECK_EQ(mqtt_client_connect(&client, &ip, 1883, NULL, NULL, &info), ERR_OK);
+    while (!mqtt_client_is_connected(&client)) {
+        host_clock_advance_ms(1);
+    }
+    outbox_session_started(now_ms());
+
+    host_mqtt_stats_t before;
+    host_mqtt_get_stats(&before);
+    uint32_t start = now_ms();
+    outbox_stats_t stats;
+    do {
+        outbox_drain(&client, now_ms());
+        outbox_get_stats(&stats);
+        if (stats.last_resync_sent > 0) {
+            break;
+        }
+        host_clock_advance_ms(interval_ms);
+    } while (now_ms() - start < RESYNC_LIMIT_MS);
+    host_mqtt_stats_t after;
+    host_mqtt_get_stats(&after);
+
+    CHECK_EQ(stats.last_resync_sent, OUTBOX_CAPACITY);
+    CHECK_EQ(stats.dropped, 0);
+    CHECK_EQ(outbox_pool()->in_use, 0);
+    drain_result_t result = {
+        .resync_ms = stats.last_resync_ms,
+        .rate = stats.drain_rate,
+        .stalls = stats.ring_stalls,
+        .deferred = rate_limit_deferred(),
+        .kbytes_per_s = stats.last_resync_ms > 0 ? (double)(after.bytes - before.bytes) / stats.last_resync_ms : 0,
+    };
+    return result;
+}
+
+static void bench_drain(void) {
+    printf("perfil %s: anel de %u bytes, %u requisições em voo; backlog de %u mensagens de %u bytes\n", PROFILE_NAME,
+           MQTT_OUTPUT_RINGBUF_SIZE, MQTT_REQ_MAX_IN_FLIGHT, OUTBOX_CAPACITY, OUTBOX_PRODUCER_MAX);
+    printf("%-12s %4s %9s %14s %8s %10s %12s %9s\n", "enlace", "QoS", "drenagem", "ressinc. (ms)", "msg/s",
+           "kB/s", "anel cheio", "sem token");
+    for (size_t l = 0; l < sizeof(links) / sizeof(links[0]); l++) {
+        for (uint8_t qos = 0; qos <= 1; qos++) {
+            // 1000 ms: drenagem só no ciclo do loop principal (antes); 50 ms: entre ciclos com backlog (agora)
+            static const uint32_t intervals[] = { 1000, 50 };
+            uint32_t rates[2];
+            for (size_t i = 0; i < 2; i++) {
+                drain_result_t r = run_drain(&links[l], qos, intervals[i]);
+                rates[i] = r.rate;
+                CHECK_EQ(r.deferred, 0);   // anel cheio não pode gastar a rajada do bucket global
+                printf("%-12s %4u %6u ms %14u %8u %10.1f %12u %9u\n", links[l].name, qos, (unsigned)intervals[i],
+                       (unsigned)r.resync_ms, (unsigned)r.rate, r.kbytes_per_s, (unsigned)r.stalls,
+                       (unsigned)r.deferred);
+            }
+            CHECK(rates[1] >= rates[0]);
+        }
+    }
+    printf("(tempo virtual; a fila inteira cabe na rajada do bucket global: a vazão é do anel, das requisições e do intervalo)\n");
+}
+
+int main(void) {
+    RUN_TEST(bench_drain);
+    return test_report();
+}
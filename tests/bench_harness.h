@@ -0,0 +1,20 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+/* Apoio aos benchmarks no host. O tempo medido é o real do processador do host (o relógio
+ * virtual dos dublês não anda dentro do código medido): os números comparam alternativas
+ * entre si e mostram tendências, não o custo absoluto no RP2040. */
+
+#include <stdint.h>
+#include <time.h>
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Destino dos resultados medidos, para o compilador não eliminar o trabalho
+static volatile uintptr_t bench_sink;
+
+#endif /* BENCH_HARNESS_H */
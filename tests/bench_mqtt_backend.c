@@ -0,0 +1,213 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Benchmark dos clientes MQTT
+/ Descrição: RAM por cliente do app MQTT do lwIP e do mini_mqtt (RACK_MQTT_BACKEND) e custo por publicação do mini_mqtt sobre o
+/            TCP raw simulado, conferindo no fio cada PUBLISH gerado.
+/ Obs: Uso: bench_mqtt_backend. O app MQTT do lwIP não é compilado no host (o dublê host_mqtt.c só simula o broker), então a
+/      RAM dele vem do layout de mqtt_priv.h, que segue o lwIP 2.x, e o custo por publicação só é medido no mini_mqtt. A flash
+/      de cada cliente sai do link do firmware (-Wl,--print-memory-usage) compilado com um e com o outro. O host tem
+/      ponteiros de 64 bits: no RP2040 as estruturas são menores, mas os buffers, que dominam a conta, são os mesmos.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stddef.h>
+#include "test_harness.h"
+#include "bench_harness.h"
+#include "mini_mqtt.h"
+#include "lwip/apps/mqtt_priv.h"
+
+#define BROKER_IP   "10.0.0.1"
+#define TOPIC       "rack_inteligente/00007/temperatura"
+#define ITERATIONS  200000
+
+static mini_mqtt_t client;
+
+// ---- Fio ----
+
+static uint8_t wire[512];
+static size_t wire_len;
+static uint32_t wire_writes;
+
+static void capture_tx(struct tcp_pcb *pcb, const void *data, uint16_t len, void *arg) {
+    if (wire_len + len <= sizeof(wire)) {
+        memcpy(&wire[wire_len], data, len);
+    }
+    wire_len += len;
+    wire_writes++;
+}
+
+// Esvazia o buffer de envio do pcb, como um enlace instantâneo, sem passar pelo relógio virtual
+static void flush_tcp(void) {
+    client.pcb->snd_queued = 0;
+    client.pcb->snd_segments = 0;
+}
+
+static void connected(mini_mqtt_t *c, void *arg, mqtt_connection_status_t status) {
+}
+
+static void puback_done(void *arg, err_t err) {
+    bench_sink += (uintptr_t)err + 1;
+}
+
+static void connect_client(void) {
+    host_reset();
+    host_broker_set(BROKER_IP, HOST_BROKER_UP);
+    host_tcp_set_tx_hook(capture_tx, NULL);
+    mini_mqtt_init(&client);
+    ip_addr_t ip;
+    ipaddr_aton(BROKER_IP, &ip);
+    struct mqtt_connect_client_info_t info = { .client_id = "rack-00007", .keep_alive = 60 };
+    CHECK_EQ(mini_mqtt_connect(&client, &ip, 1883, connected, NULL, &info), ERR_OK);
+    while (client.pcb != NULL && !client.pcb->connected) {
+        host_clock_advance_ms(1);
+    }
+    static const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    host_tcp_receive(client.pcb, connack, sizeof(connack));
+    CHECK(mini_mqtt_is_connected(&client));
+    flush_tcp();
+}
+
+// Confere o PUBLISH capturado: cabeçalho fixo, tamanho restante, tópico, identificador e payload
+static bool publish_on_wire_ok(const uint8_t *payload, uint16_t len, uint8_t qos, uint16_t *pkt_id) {
+    if (wire_len > sizeof(wire) || wire[0] != (0x30 | (qos << 1))) {
+        return false;
+    }
+    size_t pos = 1;
+    uint32_t remaining = 0;
+    for (uint8_t shift = 0; pos < wire_len; shift += 7) {
+        uint8_t b = wire[pos++];
+        remaining |= (uint32_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            break;
+        }
+    }
+    if (pos + remaining != wire_len) {
+        return false;
+    }
+    size_t topic_len = (size_t)(wire[pos] << 8 | wire[pos + 1]);
+    pos += 2;
+    if (topic_len != strlen(TOPIC) || memcmp(&wire[pos], TOPIC, topic_len) != 0) {
+        return false;
+    }
+    pos += topic_len;
+    if (qos > 0) {
+        *pkt_id = (uint16_t)(wire[pos] << 8 | wire[pos + 1]);
+        pos += 2;
+    }
+    return wire_len - pos == len && memcmp(&wire[pos], payload, len) == 0;
+}
+
+static void feed_puback(uint16_t pkt_id) {
+    uint8_t puback[] = { 0x40, 0x02, (uint8_t)(pkt_id >> 8), (uint8_t)pkt_id };
+    host_tcp_receive(client.pcb, puback, sizeof(puback));
+}
+
+// ---- RAM ----
+
+// Linha da tabela com o rótulo alinhado por caractere (os acentos ocupam 2 bytes em UTF-8)
+static void print_ram_row(const char *label, size_t lwip, size_t mini) {
+    size_t chars = 0;
+    for (const char *c = label; *c != '\0'; c++) {
+        chars += ((uint8_t)*c & 0xC0) != 0x80;
+    }
+    printf("%s%*s %8zu %8zu\n", label, (int)(28 - chars), "", lwip, mini);
+}
+
+static void bench_ram(void) {
+    // O dublê acrescenta campos ao fim de mqtt_request_t e do cliente: fora da conta
+    size_t lwip_request = offsetof(struct mqtt_request_t, used);
+    lwip_request = (lwip_request + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *);
+    size_t lwip_requests = MQTT_REQ_MAX_IN_FLIGHT * lwip_request;
+    size_t lwip_ring = sizeof(struct mqtt_ringbuf_t);
+    size_t lwip_total = offsetof(mqtt_client_t, host) -
+                        MQTT_REQ_MAX_IN_FLIGHT * (sizeof(struct mqtt_request_t) - lwip_request);
+    size_t mini_requests = sizeof(client.requests);
+    size_t mini_total = sizeof(mini_mqtt_t);
+
+    printf("RAM por cliente (host, ponteiros de %zu bytes), %u requisições em voo\n", sizeof(void *),
+           MQTT_REQ_MAX_IN_FLIGHT);
+    printf("%-28s %8s %8s\n", "", "lwip", "mini");
+    print_ram_row("anel de saída", lwip_ring, 0);
+    print_ram_row("buffer de recepção", MQTT_VAR_HEADER_BUFFER_LEN, MINI_MQTT_RX_MAX);
+    print_ram_row("requisições em voo", lwip_requests, mini_requests);
+    print_ram_row("estado e callbacks", lwip_total - lwip_ring - MQTT_VAR_HEADER_BUFFER_LEN - lwip_requests,
+                  mini_total - MINI_MQTT_RX_MAX - mini_requests);
+    print_ram_row("total", lwip_total, mini_total);
+    printf("(os dois escrevem no mesmo buffer de envio do TCP, TCP_SND_BUF = %u bytes, fora da conta; o mini não tem\n"
+           " anel próprio e devolve ERR_MEM quando esse buffer enche)\n", TCP_SND_BUF);
+
+    CHECK(mini_total < lwip_total);
+    CHECK(lwip_total - mini_total >= lwip_ring - MINI_MQTT_RX_MAX);
+}
+
+// ---- Custo por publicação ----
+
+static void bench_publish(void) {
+    static const uint16_t sizes[] = { 16, 64, 160 };
+    uint8_t payload[160];
+    for (size_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = (uint8_t)('a' + i % 26);
+    }
+
+    printf("\nmini_mqtt_publish sobre o TCP simulado (tópico de %zu bytes, %u publicações)\n", strlen(TOPIC),
+           ITERATIONS);
+    printf("%4s %8s %10s %10s %12s %14s\n", "QoS", "payload", "no fio", "tcp_write", "ns/publ.", "ns/PUBACK");
+    for (uint8_t qos = 0; qos <= 1; qos++) {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            connect_client();
+
+            // Uma publicação conferida no fio antes da medida
+            wire_len = 0;
+            wire_writes = 0;
+            CHECK_EQ(mini_mqtt_publish(&client, TOPIC, payload, sizes[s], qos, 0, puback_done, NULL), ERR_OK);
+            uint16_t pkt_id = 0;
+            CHECK(publish_on_wire_ok(payload, sizes[s], qos, &pkt_id));
+            size_t on_wire = wire_len;
+            uint32_t writes = wire_writes;
+            if (qos > 0) {
+                feed_puback(pkt_id);
+            }
+            flush_tcp();
+            host_tcp_set_tx_hook(NULL, NULL);
+
+            uint64_t publish_ns = 0, puback_ns = 0;
+            for (uint32_t i = 0; i < ITERATIONS; i++) {
+                uint64_t t0 = bench_now_ns();
+                err_t err = mini_mqtt_publish(&client, TOPIC, payload, sizes[s], qos, 0, puback_done, NULL);
+                uint64_t t1 = bench_now_ns();
+                publish_ns += t1 - t0;
+                if (err != ERR_OK) {
+                    CHECK_EQ(err, ERR_OK);
+                    break;
+                }
+                if (qos > 0) {
+                    uint16_t id = 0;
+                    for (size_t r = 0; r < MQTT_REQ_MAX_IN_FLIGHT; r++) {
+                        id = client.requests[r].pkt_id != 0 ? client.requests[r].pkt_id : id;
+                    }
+                    t0 = bench_now_ns();
+                    feed_puback(id);
+                    puback_ns += bench_now_ns() - t0;
+                }
+                flush_tcp();
+            }
+            // Todas as vagas livres: nenhum PUBACK se perdeu
+            for (size_t r = 0; r < MQTT_REQ_MAX_IN_FLIGHT; r++) {
+                CHECK_EQ(client.requests[r].pkt_id, 0);
+            }
+            char puback[16] = "-";
+            if (qos > 0) {
+                snprintf(puback, sizeof(puback), "%.1f", (double)puback_ns / ITERATIONS);
+            }
+            printf("%4u %8u %10zu %10u %12.1f %14s\n", qos, sizes[s], on_wire, (unsigned)writes,
+                   (double)publish_ns / ITERATIONS, puback);
+            mini_mqtt_disconnect(&client);
+        }
+    }
+    printf("(tempo do host, inclui o tcp_write do dublê; no lwIP real cada tcp_write com cópia também aloca e copia\n"
+           " para os segmentos do TCP, o que o app MQTT do lwIP faz uma vez a partir do anel)\n");
+}
+
+int main(void) {
+    RUN_TEST(bench_ram);
+    RUN_TEST(bench_publish);
+    return test_report();
+}
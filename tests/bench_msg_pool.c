@@ -0,0 +1,306 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Benchmark do pool de mensagens
+/ Descrição: Custo de alloc/free do msg_pool contra malloc/free em três padrões de uso e soak de fragmentação com a carga
+/            da fila de saída (mensagens de tamanho variável, backlog em rajadas e objetos de vida longa intercalados).
+/ Obs: Uso: bench_msg_pool [operações]. malloc aqui é o da glibc do host, não o da newlib na placa: a comparação de
+/      tempo vale como ordem de grandeza, e a de fragmentação mostra o padrão (a newlib é first-fit, sem arenas).
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdlib.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#include "test_harness.h"
+#include "bench_harness.h"
+#include "msg_pool.h"
+#include "outbox.h"
+
+#define SLOTS 32   // OUTBOX_CAPACITY
+
+MSG_POOL_STORAGE(pool_storage, outbox_msg_t, SLOTS);
+static msg_pool_t pool;
+
+static uint32_t ops = 5000000;
+static uint32_t rng_state = 12345;
+
+static uint32_t rng(void) {
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rng_state = x;
+}
+
+// Tamanhos exatos de mensagens da fila se fossem alocadas no heap: cabeçalho + tópico + payload
+#define SIZE_TABLE 4096
+static size_t size_table[SIZE_TABLE];
+static uint32_t size_next = 0;
+
+static void sizes_init(void) {
+    rng_state = 12345;
+    for (size_t i = 0; i < SIZE_TABLE; i++) {
+        size_table[i] = offsetof(outbox_msg_t, topic) + 20 + rng() % 40 + 4 + rng() % OUTBOX_PAYLOAD_MAX;
+    }
+    size_next = 0;
+}
+
+static size_t message_size(void) {
+    return size_table[size_next++ % SIZE_TABLE];
+}
+
+// ---- Alocadores comparados ----
+
+typedef struct {
+    const char *name;
+    void *(*alloc)(size_t size);
+    void (*release)(void *block);
+} allocator_t;
+
+static void *pool_alloc(size_t size) {
+    return msg_pool_alloc(&pool);
+}
+
+static void pool_release(void *block) {
+    msg_pool_free(&pool, block);
+}
+
+static void *heap_alloc(size_t size) {
+    return malloc(size);
+}
+
+static void heap_release(void *block) {
+    free(block);
+}
+
+static const allocator_t allocators[] = {
+    { "msg_pool", pool_alloc, pool_release },
+    { "malloc",   heap_alloc, heap_release },
+};
+
+// ---- Padrões ----
+
+// Aloca e libera em seguida (mensagem montada e descartada no mesmo ciclo)
+static void pattern_lifo(const allocator_t *a) {
+    for (uint32_t i = 0; i < ops; i++) {
+        uint8_t *p = a->alloc(message_size());
+        p[0] = (uint8_t)i;
+        bench_sink += (uintptr_t)p;
+        a->release(p);
+    }
+}
+
+// Fila com 32 mensagens: cada nova entra no fim e a mais antiga sai (backlog em drenagem)
+static void pattern_fifo(const allocator_t *a) {
+    void *queue[SLOTS];
+    for (size_t i = 0; i < SLOTS; i++) {
+        queue[i] = a->alloc(message_size());
+    }
+    for (uint32_t i = 0; i < ops; i++) {
+        size_t head = i % SLOTS;
+        a->release(queue[head]);
+        uint8_t *p = a->alloc(message_size());
+        p[0] = (uint8_t)i;
+        queue[head] = p;
+    }
+    for (size_t i = 0; i < SLOTS; i++) {
+        a->release(queue[i]);
+    }
+}
+
+// Vagas sorteadas: libera se ocupada, aloca se livre (PUBACKs fora de ordem, descartes)
+static void pattern_random(const allocator_t *a) {
+    void *slots[SLOTS] = { 0 };
+    for (uint32_t i = 0; i < ops; i++) {
+        size_t slot = rng() % SLOTS;
+        if (slots[slot] != NULL) {
+            a->release(slots[slot]);
+            slots[slot] = NULL;
+        } else {
+            uint8_t *p = a->alloc(message_size());
+            p[0] = (uint8_t)i;
+            slots[slot] = p;
+        }
+    }
+    for (size_t i = 0; i < SLOTS; i++) {
+        if (slots[i] != NULL) {
+            a->release(slots[i]);
+        }
+    }
+}
+
+static const struct {
+    const char *name;
+    void (*run)(const allocator_t *a);
+} patterns[] = {
+    { "LIFO (alloc+free imediato)", pattern_lifo },
+    { "FIFO, fila de 32",           pattern_fifo },
+    { "vagas sorteadas (32)",       pattern_random },
+};
+
+static void bench_alloc_free(void) {
+    msg_pool_init(&pool, "bench", pool_storage, sizeof(outbox_msg_t), SLOTS);
+    printf("alloc+free, %u operações por padrão (ns por par)\n", (unsigned)ops);
+    printf("%-28s %10s %10s %8s\n", "padrão", "msg_pool", "malloc", "razão");
+    for (size_t p = 0; p < sizeof(patterns) / sizeof(patterns[0]); p++) {
+        double ns[2];
+        for (size_t a = 0; a < 2; a++) {
+            sizes_init();
+            uint64_t start = bench_now_ns();
+            patterns[p].run(&allocators[a]);
+            ns[a] = (double)(bench_now_ns() - start) / ops;
+        }
+        printf("%-28s %10.1f %10.1f %7.1fx\n", patterns[p].name, ns[0], ns[1], ns[1] / ns[0]);
+    }
+    CHECK_EQ(pool.in_use, 0);
+    CHECK_EQ(pool.alloc_failures, 0);
+}
+
+// ---- Soak de fragmentação ----
+
+typedef struct {
+    size_t reserved_max;   // maior extensão ocupada do heap (ou o armazenamento fixo do pool)
+    size_t live_peak;      // maior soma de bytes de mensagens vivas ao mesmo tempo
+    size_t holes_max;      // maior soma de buracos livres abaixo do topo do heap
+    uint32_t failures;
+} frag_result_t;
+
+// Extensão do heap até o último bloco em uso e buracos livres abaixo dela (sem o topo liberável)
+static void heap_usage(size_t *span, size_t *holes) {
+#if defined(__GLIBC__)
+    struct mallinfo2 info = mallinfo2();
+    *span = info.arena - info.keepcost;
+    *holes = info.fordblks - info.keepcost;
+#else
+    *span = 0;
+    *holes = 0;
+#endif
+}
+
+/* Carga da fila de saída ao longo de semanas: a profundidade oscila em rajadas (quedas do broker
+ * enchem a fila, a reconexão drena) e, de tempos em tempos, um objeto de vida longa de tamanho
+ * qualquer é alocado no meio (sessão, buffer de captura, ...), que é o que fragmenta um heap. */
+static frag_result_t fragmentation_soak(bool use_pool) {
+    void *queue[SLOTS] = { 0 };
+    size_t sizes[SLOTS] = { 0 };
+    void *long_lived[8] = { 0 };
+    size_t long_sizes[8] = { 0 };
+    size_t head = 0, count = 0, live = 0;
+    size_t target = 4;
+    frag_result_t result = { 0 };
+    size_t span_base = 0, holes_base = 0;
+    if (!use_pool) {
+#if defined(__GLIBC__)
+        malloc_trim(0);
+#endif
+        heap_usage(&span_base, &holes_base);
+    }
+
+    sizes_init();
+    rng_state = 777;
+    for (uint32_t i = 0; i < ops; i++) {
+        if (i % 20000 == 0) {
+            target = rng() % 4 == 0 ? SLOTS : 1 + rng() % 6;   // queda: fila cheia
+        }
+        // Com o pool esses objetos são estáticos: o sorteio é o mesmo, só não há alocação
+        if (i % 1000 == 0) {
+            size_t k = rng() % 8;
+            long_sizes[k] = 64 + rng() % 1024;
+            if (!use_pool) {
+                free(long_lived[k]);
+                long_lived[k] = malloc(long_sizes[k]);
+            }
+        }
+        if (count < target) {
+            size_t size = message_size();
+            void *p = use_pool ? msg_pool_alloc(&pool) : malloc(size);
+            if (p == NULL) {
+                result.failures++;
+                continue;
+            }
+            memset(p, 0x5A, size);
+            size_t tail = (head + count) % SLOTS;
+            queue[tail] = p;
+            sizes[tail] = size;
+            live += sizes[tail];
+            count++;
+        } else {
+            // Entrega: a mais antiga sai; às vezes uma do meio (PUBACK fora de ordem) troca de lugar antes
+            if (count > 1 && rng() % 8 == 0) {
+                size_t other = (head + 1 + rng() % (count - 1)) % SLOTS;
+                void *tmp = queue[head];
+                size_t tmp_size = sizes[head];
+                queue[head] = queue[other];
+                sizes[head] = sizes[other];
+                queue[other] = tmp;
+                sizes[other] = tmp_size;
+            }
+            if (use_pool) {
+                msg_pool_free(&pool, queue[head]);
+            } else {
+                free(queue[head]);
+            }
+            live -= sizes[head];
+            head = (head + 1) % SLOTS;
+            count--;
+        }
+        if (live > result.live_peak) {
+            result.live_peak = live;
+        }
+        if (!use_pool && i % 256 == 0) {
+            size_t span, holes;
+            heap_usage(&span, &holes);
+            span = span > span_base ? span - span_base : 0;
+            holes = holes > holes_base ? holes - holes_base : 0;
+            result.reserved_max = span > result.reserved_max ? span : result.reserved_max;
+            result.holes_max = holes > result.holes_max ? holes : result.holes_max;
+        }
+    }
+    if (use_pool) {
+        result.reserved_max = pool.block_size * pool.block_count;
+    }
+    while (count > 0) {
+        use_pool ? msg_pool_free(&pool, queue[head]) : free(queue[head]);
+        head = (head + 1) % SLOTS;
+        count--;
+    }
+    for (size_t k = 0; k < 8; k++) {
+        free(long_lived[k]);
+    }
+    return result;
+}
+
+static void bench_fragmentation(void) {
+    msg_pool_init(&pool, "bench", pool_storage, sizeof(outbox_msg_t), SLOTS);
+    frag_result_t pool_result = fragmentation_soak(true);
+    frag_result_t heap_result = fragmentation_soak(false);
+
+    printf("\nsoak de fragmentação, %u operações (bytes)\n", (unsigned)ops);
+    printf("%-10s %12s %12s %14s %8s\n", "alocador", "reservado", "pico vivo", "buracos (máx)", "falhas");
+    printf("%-10s %12zu %12zu %14s %8u\n", "msg_pool", pool_result.reserved_max, pool_result.live_peak,
+           "-", (unsigned)pool_result.failures);
+    printf("%-10s %12zu %12zu %14zu %8u\n", "malloc", heap_result.reserved_max, heap_result.live_peak,
+           heap_result.holes_max, (unsigned)heap_result.failures);
+    printf("(reservado do malloc inclui os objetos de vida longa; o pool paga save/restore de interrupções simulados)\n");
+
+    // O pool nunca falha com a fila dentro da capacidade e termina com todos os blocos alocáveis
+    CHECK_EQ(pool_result.failures, 0);
+    CHECK_EQ(pool.in_use, 0);
+    CHECK_EQ(pool.peak_in_use, SLOTS);
+    void *blocks[SLOTS];
+    for (size_t i = 0; i < SLOTS; i++) {
+        blocks[i] = msg_pool_alloc(&pool);
+        CHECK(blocks[i] != NULL);
+    }
+    for (size_t i = 0; i < SLOTS; i++) {
+        msg_pool_free(&pool, blocks[i]);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        ops = (uint32_t)strtoul(argv[1], NULL, 10);
+    }
+    RUN_TEST(bench_alloc_free);
+    RUN_TEST(bench_fragmentation);
+    return test_report();
+}
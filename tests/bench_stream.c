@@ -0,0 +1,297 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Benchmark da publicação em fluxo
+/ Descrição: Vazão do stream_pub sobre o enlace e o broker simulados, com o loop principal do firmware (stream_tick a cada
+/            ciclo de 1 s, drenagem a cada 50 ms com backlog), e remontagem no broker conferindo contagem, bytes e CRC32
+/            do "end", inclusive com queda de sessão e broker sem PUBACK no meio do fluxo.
+/ Obs: Uso: bench_stream. O tempo é o do relógio virtual; os limites de taxa (rate_limit.c) e a janela de PUBACKs são os do
+/      firmware, então a vazão medida é a que o dispositivo sustenta, não a do enlace.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdlib.h>
+#include "test_harness.h"
+#include "stream_pub.h"
+#include "outbox.h"
+#include "rate_limit.h"
+#include "crc.h"
+#include "lwip/apps/mqtt_priv.h"
+
+#define BROKER_IP       "10.0.0.1"
+#define STREAM_BASE     "rack_inteligente/00007/history/1"
+#define CYCLE_MS        1000   // período do loop principal
+#define DRAIN_MS        50     // OUTBOX_DRAIN_INTERVAL_MS
+#define MAX_CHUNKS      512
+#define STREAM_LIMIT_MS (30u * 60u * 1000u)
+
+typedef struct {
+    const char *name;
+    uint32_t bytes_per_ms;
+    uint32_t rtt_ms;
+} link_profile_t;
+
+static const link_profile_t links[] = {
+    { "Wi-Fi bom",   500, 20 },
+    { "Wi-Fi fraco", 20,  80 },
+};
+
+// ---- Carga ----
+
+static uint32_t payload_bytes;
+
+// Bytes determinísticos por posição: o mesmo trecho produzido de novo (canal limitado) sai idêntico
+static uint8_t payload_byte(uint32_t offset) {
+    uint32_t x = offset * 2654435761u;
+    return (uint8_t)(x >> 24);
+}
+
+static size_t fill_payload(void *ctx, uint32_t index, uint8_t *buf, size_t len) {
+    uint32_t offset = index * (uint32_t)len;
+    if (offset >= payload_bytes) {
+        return 0;
+    }
+    size_t n = payload_bytes - offset < len ? payload_bytes - offset : len;
+    for (size_t i = 0; i < n; i++) {
+        buf[i] = payload_byte(offset + (uint32_t)i);
+    }
+    return n;
+}
+
+// ---- Remontagem no broker ----
+
+typedef struct {
+    bool meta;
+    bool end;
+    uint32_t end_at_ms;
+    uint32_t end_chunks, end_bytes, end_crc, end_failed, end_ms;
+    uint8_t data[MAX_CHUNKS][STREAM_CHUNK_MAX];
+    uint16_t len[MAX_CHUNKS];
+    bool have[MAX_CHUNKS];
+    uint32_t duplicates;
+    uint32_t after_end;     // trechos que chegaram depois do "end"
+} reassembly_t;
+
+static reassembly_t rx;
+
+static uint32_t json_field(const char *json, const char *key) {
+    const char *p = strstr(json, key);
+    return p != NULL ? (uint32_t)strtoul(p + strlen(key), NULL, 10) : UINT32_MAX;
+}
+
+static void broker_receive(const host_mqtt_msg_t *msg, void *arg) {
+    size_t base_len = strlen(STREAM_BASE);
+    if (strncmp(msg->topic, STREAM_BASE "/", base_len + 1) != 0) {
+        return;
+    }
+    const char *suffix = msg->topic + base_len + 1;
+    if (strcmp(suffix, "meta") == 0) {
+        rx.meta = true;
+    } else if (strcmp(suffix, "end") == 0) {
+        char json[sizeof(msg->payload) + 1];
+        memcpy(json, msg->payload, msg->payload_len);
+        json[msg->payload_len] = '\0';
+        rx.end = true;
+        rx.end_at_ms = (uint32_t)(msg->at_us / 1000u);
+        rx.end_chunks = json_field(json, "\"chunks\":");
+        rx.end_bytes = json_field(json, "\"bytes\":");
+        rx.end_crc = json_field(json, "\"crc\":");
+        rx.end_failed = json_field(json, "\"failed\":");
+        rx.end_ms = json_field(json, "\"ms\":");
+    } else {
+        uint32_t index = (uint32_t)strtoul(suffix, NULL, 10);
+        if (index >= MAX_CHUNKS) {
+            host_fatal("trecho %u fora da remontagem", (unsigned)index);
+        }
+        rx.after_end += rx.end;
+        rx.duplicates += rx.have[index];
+        rx.have[index] = true;
+        rx.len[index] = msg->payload_len;
+        memcpy(rx.data[index], msg->payload, msg->payload_len);
+    }
+}
+
+// Confere a carga remontada contra o "end" e contra a carga original
+static bool reassembled_ok(void) {
+    uint32_t crc = 0, bytes = 0;
+    bool content = true;
+    for (uint32_t i = 0; i < rx.end_chunks && i < MAX_CHUNKS; i++) {
+        if (!rx.have[i]) {
+            return false;
+        }
+        for (uint16_t k = 0; k < rx.len[i]; k++) {
+            content &= rx.data[i][k] == payload_byte(bytes + k);
+        }
+        crc = crc32_update(crc, rx.data[i], rx.len[i]);
+        bytes += rx.len[i];
+    }
+    return rx.meta && rx.end && content && bytes == payload_bytes && rx.end_bytes == bytes && rx.end_crc == crc &&
+           rx.end_failed == 0 && rx.after_end == 0;
+}
+
+// ---- Loop principal ----
+
+static mqtt_client_t client;
+static bool drop_armed;   // derruba a sessão logo após a próxima drenagem, com trechos em voo
+
+static uint32_t now_ms(void) {
+    return (uint32_t)(host_clock_us() / 1000u);
+}
+
+static void connect_client(void) {
+    ip_addr_t ip;
+    ipaddr_aton(BROKER_IP, &ip);
+    struct mqtt_connect_client_info_t info = { .client_id = "rack-00007", .keep_alive = 60 };
+    CHECK_EQ(mqtt_client_connect(&client, &ip, 1883, NULL, NULL, &info), ERR_OK);
+    while (!mqtt_client_is_connected(&client)) {
+        host_clock_advance_ms(1);
+    }
+    outbox_session_started(now_ms());
+}
+
+// Um ciclo de rack_inteligente.c: stream_tick e drenagem a cada 50 ms enquanto houver backlog
+static void main_cycle(stream_t *stream) {
+    uint32_t deadline = now_ms() + CYCLE_MS;
+    stream_tick(stream, now_ms());
+    while (true) {
+        if (mqtt_client_is_connected(&client)) {
+            outbox_drain(&client, now_ms());
+            if (drop_armed) {
+                drop_armed = false;
+                host_mqtt_drop(&client);
+                outbox_session_lost();
+            }
+        }
+        outbox_stats_t outbox;
+        outbox_get_stats(&outbox);
+        if (!mqtt_client_is_connected(&client) || outbox.depth == 0 || deadline - now_ms() < DRAIN_MS) {
+            break;
+        }
+        host_clock_advance_ms(DRAIN_MS);
+    }
+    host_clock_advance_ms(deadline - now_ms());
+}
+
+typedef enum {
+    FAULT_NONE,
+    FAULT_SESSION_DROP,   // sessão cai no meio do fluxo e volta 5 s depois
+    FAULT_NO_ACK,         // broker para de confirmar por 40 s (os trechos em voo expiram e são reenviados)
+} fault_t;
+
+typedef struct {
+    uint32_t chunks;
+    uint32_t duration_ms;     // begin até o "end" chegar ao broker
+    uint32_t device_rate;     // stats.last_rate (campo "ms" do end)
+    uint32_t deferred;        // drenagens adiadas pelo bucket global
+    uint32_t throttled;       // trechos recusados pelo limite do canal (produzidos de novo)
+    uint32_t retransmits;
+    uint32_t duplicates;
+    bool ok;
+} stream_result_t;
+
+static stream_result_t run_stream(const link_profile_t *link, uint32_t bytes, fault_t fault) {
+    host_reset();
+    memset(&client, 0, sizeof(client));
+    memset(&rx, 0, sizeof(rx));
+    host_mqtt_set_publish_hook(broker_receive, NULL);
+    host_link_set(link->bytes_per_ms, link->rtt_ms);
+    rate_limit_init(now_ms());
+    outbox_init(1);
+    connect_client();
+
+    payload_bytes = bytes;
+    static stream_t stream;
+    memset(&stream, 0, sizeof(stream));
+    uint32_t start = now_ms();
+    CHECK(stream_begin(&stream, TELEMETRY_CH_HISTORY, STREAM_BASE, "{\"blocks\":0}", fill_payload, NULL));
+
+    bool faulted = false;
+    uint32_t fault_end_ms = 0;
+    while (!rx.end && now_ms() - start < STREAM_LIMIT_MS) {
+        if (fault != FAULT_NONE && !faulted && stream.next_index >= 8) {
+            faulted = true;
+            if (fault == FAULT_SESSION_DROP) {
+                drop_armed = true;
+                fault_end_ms = now_ms() + 5000;
+            } else {
+                host_broker_set(BROKER_IP, HOST_BROKER_NO_ACK);
+                fault_end_ms = now_ms() + 40000;
+            }
+        }
+        if (faulted && fault_end_ms != 0 && (int32_t)(now_ms() - fault_end_ms) >= 0) {
+            fault_end_ms = 0;
+            host_broker_set(BROKER_IP, HOST_BROKER_UP);
+            if (fault == FAULT_SESSION_DROP) {
+                connect_client();
+            }
+        }
+        main_cycle(&stream);
+    }
+    // Trechos atrasados (reenvios) ainda podem chegar depois do "end": roda mais alguns ciclos
+    for (int i = 0; i < 5; i++) {
+        main_cycle(&stream);
+    }
+
+    stream_stats_t stats;
+    stream_get_stats(&stats);
+    outbox_stats_t outbox;
+    outbox_get_stats(&outbox);
+    stream_result_t result = {
+        .chunks = rx.end_chunks,
+        .duration_ms = rx.end_at_ms - start,
+        .device_rate = stats.last_rate,
+        .deferred = rate_limit_deferred(),
+        .throttled = rate_limit_throttled(TELEMETRY_CH_HISTORY),
+        .retransmits = outbox.retransmits,
+        .duplicates = rx.duplicates,
+        .ok = reassembled_ok(),
+    };
+    CHECK(result.ok);
+    CHECK(!stream_active(&stream));
+    CHECK_EQ(outbox_pool()->in_use, 0);
+    return result;
+}
+
+static void print_result(const char *link, uint32_t bytes, const char *fault, const stream_result_t *r) {
+    printf("%-12s %7u %-14s %7u %9.1f %8u %8u %9u %8u %6u %9s\n", link, (unsigned)bytes, fault, (unsigned)r->chunks,
+           r->duration_ms / 1000.0, (unsigned)(r->duration_ms > 0 ? (uint64_t)bytes * 1000u / r->duration_ms : 0),
+           (unsigned)r->device_rate, (unsigned)r->deferred, (unsigned)r->throttled, (unsigned)r->retransmits,
+           r->ok ? "ok" : "FALHOU");
+}
+
+static void bench_throughput(void) {
+    // Uma hora de histórico são ~64 blocos de ~110 bytes; a captura, 400 amostras em ~8 trechos
+    static const uint32_t sizes[] = { 1024, 8 * 1024, 32 * 1024 };
+    printf("fluxo em trechos de %u bytes, janela de %u PUBACKs, loop de %u ms com drenagem a cada %u ms\n",
+           STREAM_CHUNK_MAX, STREAM_WINDOW, CYCLE_MS, DRAIN_MS);
+    printf("%-12s %7s %-14s %7s %9s %8s %8s %9s %8s %6s %9s\n", "enlace", "bytes", "falha", "trechos", "dur. (s)",
+           "B/s", "B/s disp", "sem token", "canal", "reenv", "CRC");
+    for (size_t l = 0; l < sizeof(links) / sizeof(links[0]); l++) {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            stream_result_t r = run_stream(&links[l], sizes[s], FAULT_NONE);
+            print_result(links[l].name, sizes[s], "-", &r);
+            CHECK_EQ(r.chunks, (sizes[s] + STREAM_CHUNK_MAX - 1) / STREAM_CHUNK_MAX);
+            CHECK_EQ(r.duplicates, 0);
+            // stream_tick roda uma vez por ciclo e produz no máximo uma janela: o teto independe do enlace
+            CHECK(r.device_rate <= STREAM_WINDOW * STREAM_CHUNK_MAX * 1000u / CYCLE_MS);
+        }
+    }
+}
+
+static void bench_faults(void) {
+    const link_profile_t *link = &links[0];
+    stream_result_t r = run_stream(link, 8 * 1024, FAULT_SESSION_DROP);
+    print_result(link->name, 8 * 1024, "queda sessão", &r);
+    CHECK(r.retransmits > 0);
+
+    r = run_stream(link, 8 * 1024, FAULT_NO_ACK);
+    print_result(link->name, 8 * 1024, "sem PUBACK 40s", &r);
+    CHECK(r.retransmits > 0);
+    CHECK(r.duplicates > 0);   // o broker recebeu os trechos sem confirmar; a remontagem absorve as cópias
+    printf("(B/s: carga / tempo até o end no broker; B/s disp: medido no dispositivo; sem token e canal: limites de\n"
+           " rate_limit.c. O teto é uma janela de %u trechos por ciclo do loop, e o bucket global depois da rajada)\n",
+           STREAM_WINDOW);
+}
+
+int main(void) {
+    RUN_TEST(bench_throughput);
+    RUN_TEST(bench_faults);
+    return test_report();
+}
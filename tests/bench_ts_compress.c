@@ -0,0 +1,321 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Benchmark da compressão de séries temporais
+/ Descrição: Taxa de compressão do ts_compress em séries de temperatura típicas do rack (bits por amostra, razão contra i16
+/            e contra o texto JSON, uso dos baldes, amostras por bloco do histórico) e custo de codificação/decodificação.
+/ Obs: Uso: bench_ts_compress [repetições]. O tempo é medido no processador do host. O orçamento no Cortex-M0+ é estimado
+/      por um modelo de ciclos declarado abaixo (não há como medir ciclos do RP2040 aqui), a partir das operações que o
+/      codificador realmente executa em cada série.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdlib.h>
+#include "test_harness.h"
+#include "bench_harness.h"
+#include "ts_compress.h"
+#include "history.h"
+#include "capture.h"
+
+#define SERIES_SAMPLES 3600   // 1 h a 1 Hz, como o histórico
+
+/* Modelo de ciclos no Cortex-M0+ (sem barrel shifter em instruções de carga, desvio tomado 2 ciclos, carga/armazenamento
+ * 2 ciclos): cada volta do laço de put_bits (um trecho de até 8 bits num byte) custa ~30 instruções, ~40 ciclos; o resto
+ * de ts_encode (subtrações, escolha do balde, teste de capacidade, chamada) ~60 ciclos por amostra. Pessimista de
+ * propósito: o resultado é um teto, não uma medida. */
+#define M0_CYCLES_PER_CHUNK  40
+#define M0_CYCLES_PER_SAMPLE 60
+#define M0_CLOCK_HZ          125000000u
+
+static uint32_t repetitions = 2000;
+static uint32_t rng_state = 2024;
+
+static uint32_t rng(void) {
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rng_state = x;
+}
+
+// Ruído aproximadamente gaussiano (soma de 12 uniformes), desvio padrão `sigma`
+static int32_t noise(int32_t sigma) {
+    int32_t sum = 0;
+    for (int i = 0; i < 12; i++) {
+        sum += (int32_t)(rng() % 1001);
+    }
+    return (sum - 6000) * sigma / 1000;   // cada uniforme tem variância 1000²/12: a soma tem desvio 1000
+}
+
+// ---- Séries (centésimos de grau) ----
+
+// Deriva lenta do ar-condicionado: ±0,4 °C em ciclos de ~20 min em torno de 25 °C
+static int32_t drift(size_t i) {
+    size_t phase = i % 1200;
+    int32_t tri = phase < 600 ? (int32_t)phase : (int32_t)(1200 - phase);
+    return 2500 + (tri - 300) * 40 / 300;
+}
+
+static void series_constant(int16_t *out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = 2512;
+    }
+}
+
+// Sensor externo digital (resolução de 1/16 °C, ruído de ~0,03 °C)
+static void series_external(int16_t *out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        int32_t sixteenths = (drift(i) + noise(3)) * 16 / 100;
+        out[i] = (int16_t)(sixteenths * 100 / 16);
+    }
+}
+
+// Leitura já suavizada pela média do firmware: ruído residual de ~0,1 °C
+static void series_smoothed(int16_t *out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = (int16_t)(drift(i) + noise(10));
+    }
+}
+
+/* Sensor interno do RP2040 lido direto do ADC: um LSB de 12 bits vale ~0,47 °C e o ruído
+ * é de um a dois LSB, então a série salta entre níveis quantizados */
+static void series_internal(int16_t *out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        int32_t lsb = (drift(i) * 100 + noise(100) * 47) / 4700;
+        out[i] = (int16_t)(lsb * 47);
+    }
+}
+
+// Porta aberta: queda de 3 °C em 30 s a cada 10 min e volta em 5 min, sobre o ruído suavizado
+static void series_door(int16_t *out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        size_t t = i % 600;
+        int32_t drop = t < 30 ? (int32_t)t * 10 : t < 330 ? 300 - ((int32_t)t - 30) : 0;
+        out[i] = (int16_t)(drift(i) - drop + noise(10));
+    }
+}
+
+// Captura a 10 Hz no disparo de um alarme de calor: subida de 8 °C em 20 s com ruído do ADC
+static void series_capture(int16_t *out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        size_t t = i % (CAPTURE_PRE_SAMPLES + CAPTURE_POST_SAMPLES);
+        int32_t rise = t < CAPTURE_PRE_SAMPLES ? 0 : (int32_t)(t - CAPTURE_PRE_SAMPLES) * 4;
+        out[i] = (int16_t)(2600 + rise + noise(15));
+    }
+}
+
+typedef struct {
+    const char *name;
+    void (*fill)(int16_t *out, size_t count);
+    size_t block;            // amostras por bloco (histórico ou trecho de captura)
+} series_t;
+
+static const series_t series[] = {
+    { "constante",             series_constant, HISTORY_BLOCK_SAMPLES },
+    { "sensor externo 1/16",   series_external, HISTORY_BLOCK_SAMPLES },
+    { "média do firmware",     series_smoothed, HISTORY_BLOCK_SAMPLES },
+    { "ADC interno cru",       series_internal, HISTORY_BLOCK_SAMPLES },
+    { "porta aberta",          series_door,     HISTORY_BLOCK_SAMPLES },
+    { "captura 10 Hz",         series_capture,  CAPTURE_CHUNK_SAMPLES },
+};
+
+// ---- Medidas ----
+
+// Balde de cada dod, espelhando a tabela de ts_compress.h
+static size_t bucket_of(int32_t dod) {
+    if (dod == 0) {
+        return 0;
+    }
+    if (dod >= -63 && dod <= 64) {
+        return 1;
+    }
+    if (dod >= -255 && dod <= 256) {
+        return 2;
+    }
+    if (dod >= -2047 && dod <= 2048) {
+        return 3;
+    }
+    return 4;
+}
+
+// Voltas do laço de put_bits para escrever `nbits` a partir da posição `bit` (um trecho por byte tocado)
+static uint32_t chunks_for(size_t bit, uint32_t nbits) {
+    return nbits == 0 ? 0 : (uint32_t)((bit + nbits - 1) / 8 - bit / 8 + 1);
+}
+
+typedef struct {
+    size_t bits;
+    size_t bytes;            // soma dos blocos arredondados a byte
+    size_t blocks;
+    size_t max_block_bytes;
+    uint32_t buckets[5];
+    uint64_t chunks;         // voltas de put_bits (prefixo e campo escritos separadamente)
+    bool round_trip;
+} ratio_t;
+
+static ratio_t measure_ratio(const int16_t *values, size_t count, size_t block) {
+    ratio_t r = { 0 };
+    r.round_trip = true;
+    uint8_t buf[512];
+    for (size_t start = 0; start < count; start += block) {
+        size_t n = count - start < block ? count - start : block;
+        ts_encoder_t enc;
+        ts_encoder_init(&enc, buf, sizeof(buf));
+        for (size_t i = 0; i < n; i++) {
+            size_t before = enc.bits;
+            if (!ts_encode(&enc, values[start + i])) {
+                r.round_trip = false;
+                return r;
+            }
+            if (i == 0) {
+                r.chunks += chunks_for(before, 16);
+                continue;
+            }
+            int32_t delta = values[start + i] - values[start + i - 1];
+            int32_t prev_delta = i >= 2 ? values[start + i - 1] - values[start + i - 2] : 0;
+            size_t b = bucket_of(delta - prev_delta);
+            static const uint8_t prefix_bits[] = { 1, 2, 3, 4, 4 };
+            r.buckets[b]++;
+            r.chunks += chunks_for(before, prefix_bits[b]);
+            r.chunks += chunks_for(before + prefix_bits[b], (uint32_t)(enc.bits - before - prefix_bits[b]));
+        }
+        r.bits += enc.bits;
+        r.bytes += ts_encoder_bytes(&enc);
+        r.blocks++;
+        if (ts_encoder_bytes(&enc) > r.max_block_bytes) {
+            r.max_block_bytes = ts_encoder_bytes(&enc);
+        }
+
+        ts_decoder_t dec;
+        ts_decoder_init(&dec, buf, ts_encoder_bytes(&enc));
+        for (size_t i = 0; i < n; i++) {
+            int16_t value;
+            if (!ts_decode(&dec, &value) || value != values[start + i]) {
+                r.round_trip = false;
+            }
+        }
+    }
+    return r;
+}
+
+// Blocos que o histórico fecha numa hora: ao atingir HISTORY_BLOCK_SAMPLES ou quando o fluxo enche os HISTORY_BLOCK_BYTES
+static size_t history_blocks(const int16_t *values, size_t count) {
+    uint8_t buf[HISTORY_BLOCK_BYTES];
+    ts_encoder_t enc;
+    ts_encoder_init(&enc, buf, sizeof(buf));
+    size_t blocks = 1;
+    for (size_t i = 0; i < count; i++) {
+        if (enc.count == HISTORY_BLOCK_SAMPLES || !ts_encode(&enc, values[i])) {
+            ts_encoder_init(&enc, buf, sizeof(buf));
+            ts_encode(&enc, values[i]);
+            blocks++;
+        }
+    }
+    return blocks;
+}
+
+// Tamanho do mesmo trecho publicado como texto ("25.12,": o formato dos campos de temperatura do JSON)
+static size_t text_bytes(const int16_t *values, size_t count) {
+    size_t total = 0;
+    char field[16];
+    for (size_t i = 0; i < count; i++) {
+        total += (size_t)snprintf(field, sizeof(field), "%d.%02d,", values[i] / 100, abs(values[i] % 100));
+    }
+    return total;
+}
+
+static void bench_ratio(void) {
+    static int16_t values[SERIES_SAMPLES];
+    printf("compressão de %u amostras por série (blocos de %u; captura em trechos de %u)\n",
+           SERIES_SAMPLES, HISTORY_BLOCK_SAMPLES, CAPTURE_CHUNK_SAMPLES);
+    printf("%-22s %9s %8s %8s %11s %10s  %s\n", "série", "bits/amo", "vs i16", "vs texto", "maior bloco",
+           "blocos/h", "baldes 0/7/9/12/18 bits (%)");
+    for (size_t s = 0; s < sizeof(series) / sizeof(series[0]); s++) {
+        rng_state = 2024 + (uint32_t)s;
+        series[s].fill(values, SERIES_SAMPLES);
+        ratio_t r = measure_ratio(values, SERIES_SAMPLES, series[s].block);
+        size_t coded = SERIES_SAMPLES - r.blocks;
+        size_t per_hour = series[s].block == HISTORY_BLOCK_SAMPLES ? history_blocks(values, SERIES_SAMPLES) : 0;
+        char blocks[24] = "-";
+        if (per_hour > 0) {
+            snprintf(blocks, sizeof(blocks), "%zu", per_hour);
+        }
+        printf("%-22s %9.2f %7.1fx %7.1fx %9zu B %10s  %5.1f %5.1f %5.1f %5.1f %5.1f\n", series[s].name,
+               (double)r.bits / SERIES_SAMPLES, (double)(SERIES_SAMPLES * 2) / r.bytes,
+               (double)text_bytes(values, SERIES_SAMPLES) / r.bytes, r.max_block_bytes, blocks,
+               100.0 * r.buckets[0] / coded, 100.0 * r.buckets[1] / coded, 100.0 * r.buckets[2] / coded,
+               100.0 * r.buckets[3] / coded, 100.0 * r.buckets[4] / coded);
+
+        CHECK(r.round_trip);
+        if (per_hour > 0) {
+            // Blocos fechados antes de HISTORY_BLOCK_SAMPLES não podem encurtar a última hora guardada
+            CHECK(per_hour <= HISTORY_BLOCKS);
+        } else {
+            // Trecho comprimido menor que o RAW que capture_serialize usaria no lugar
+            CHECK(r.max_block_bytes < CAPTURE_CHUNK_SAMPLES * 2);
+        }
+    }
+    printf("(maior bloco: %u amostras sem limite de bytes; no histórico o bloco fecha ao encher %u B, e a hora precisa caber em %u blocos)\n",
+           HISTORY_BLOCK_SAMPLES, HISTORY_BLOCK_BYTES, HISTORY_BLOCKS);
+}
+
+static void bench_cost(void) {
+    static int16_t values[SERIES_SAMPLES];
+    uint8_t buf[512];
+    printf("\ncusto por amostra, %u repetições por série\n", (unsigned)repetitions);
+    printf("%-22s %12s %12s %14s %12s\n", "série", "codif. (ns)", "decod. (ns)", "M0+ (ciclos)", "CPU a 11 Hz");
+    for (size_t s = 0; s < sizeof(series) / sizeof(series[0]); s++) {
+        rng_state = 2024 + (uint32_t)s;
+        series[s].fill(values, SERIES_SAMPLES);
+        size_t block = series[s].block;
+
+        uint64_t start = bench_now_ns();
+        for (uint32_t rep = 0; rep < repetitions; rep++) {
+            for (size_t first = 0; first < SERIES_SAMPLES; first += block) {
+                ts_encoder_t enc;
+                ts_encoder_init(&enc, buf, sizeof(buf));
+                for (size_t i = first; i < first + block && i < SERIES_SAMPLES; i++) {
+                    ts_encode(&enc, values[i]);
+                }
+                bench_sink += enc.bits;
+            }
+        }
+        double encode_ns = (double)(bench_now_ns() - start) / ((double)repetitions * SERIES_SAMPLES);
+
+        ts_encoder_t enc;
+        ts_encoder_init(&enc, buf, sizeof(buf));
+        for (size_t i = 0; i < block; i++) {
+            ts_encode(&enc, values[i]);
+        }
+        start = bench_now_ns();
+        for (uint32_t rep = 0; rep < repetitions * (SERIES_SAMPLES / block); rep++) {
+            ts_decoder_t dec;
+            ts_decoder_init(&dec, buf, ts_encoder_bytes(&enc));
+            int16_t value = 0;
+            for (size_t i = 0; i < block; i++) {
+                ts_decode(&dec, &value);
+            }
+            bench_sink += (uintptr_t)value;
+        }
+        double decode_ns = (double)(bench_now_ns() - start) /
+                           ((double)repetitions * (SERIES_SAMPLES / block) * block);
+
+        /* Teto no M0+: o histórico (1 Hz) e a captura (10 Hz) codificando ao mesmo tempo. A captura
+         * na verdade codifica no envio, em rajada, mas a soma por segundo é a mesma. */
+        ratio_t r = measure_ratio(values, SERIES_SAMPLES, block);
+        double cycles = M0_CYCLES_PER_SAMPLE + (double)r.chunks * M0_CYCLES_PER_CHUNK / SERIES_SAMPLES;
+        double cpu = cycles * (1 + CAPTURE_RATE_HZ) / M0_CLOCK_HZ;
+        printf("%-22s %12.1f %12.1f %14.0f %11.4f%%\n", series[s].name, encode_ns, decode_ns, cycles, cpu * 100);
+
+        // Mesmo com o modelo pessimista, a codificação não pode passar de 0,01% da CPU
+        CHECK(cpu < 0.0001);
+    }
+    printf("(ns: processador do host, -O2; ciclos: modelo de %u por trecho de byte + %u por amostra a %u MHz)\n",
+           M0_CYCLES_PER_CHUNK, M0_CYCLES_PER_SAMPLE, M0_CLOCK_HZ / 1000000u);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        repetitions = (uint32_t)strtoul(argv[1], NULL, 10);
+    }
+    RUN_TEST(bench_ratio);
+    RUN_TEST(bench_cost);
+    return test_report();
+}
@@ -0,0 +1,316 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Dublês do host - núcleo
+/ Descrição: Relógio virtual com fila de eventos, sorteio determinístico, trava do lwIP, panic() e logs do firmware.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <setjmp.h>
+#include "host_internal.h"
+
+#define HOST_EVENTS_MAX  512
+#define HOST_BROKERS_MAX 8
+
+typedef struct {
+    ip_addr_t ip;
+    host_broker_mode_t mode;
+} host_broker_t;
+
+static uint64_t clock_us = 0;
+static bool advancing = false;
+static uint32_t rand_state = 1;
+static int lock_depth = 0;
+static int irq_depth = 0;
+
+static host_event_t events[HOST_EVENTS_MAX];
+static bool event_used[HOST_EVENTS_MAX];
+static uint64_t event_order = 0;
+
+static host_broker_t brokers[HOST_BROKERS_MAX];
+static size_t broker_count = 0;
+static uint32_t link_rate = 1000;      // bytes/ms (~8 Mbit/s)
+static uint64_t link_rtt_us = 20000;
+
+static jmp_buf *panic_jmp = NULL;
+static char panic_message[256];
+
+// ---- Logs do firmware ----
+
+int host_printf(const char *format, ...) {
+    static int verbose = -1;
+    if (verbose < 0) {
+        const char *env = getenv("RACK_HOST_VERBOSE");
+        verbose = env != NULL && strcmp(env, "1") == 0;
+    }
+    if (!verbose) {
+        return 0;
+    }
+    va_list args;
+    va_start(args, format);
+    int len = vprintf(format, args);
+    va_end(args);
+    return len;
+}
+
+// ---- panic() e falhas do dublê ----
+
+void host_panic(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(panic_message, sizeof(panic_message), format, args);
+    va_end(args);
+    if (panic_jmp != NULL) {
+        longjmp(*panic_jmp, 1);
+    }
+    fprintf(stderr, "panic: %s\n", panic_message);
+    abort();
+}
+
+bool host_panic_caught(void (*fn)(void *arg), void *arg) {
+    jmp_buf env;
+    jmp_buf *saved = panic_jmp;
+    panic_message[0] = '\0';
+    panic_jmp = &env;
+    if (setjmp(env) != 0) {
+        panic_jmp = saved;
+        irq_depth = 0;  // panic() pode ter saído com as interrupções desabilitadas
+        return true;
+    }
+    fn(arg);
+    panic_jmp = saved;
+    return false;
+}
+
+const char *host_panic_message(void) {
+    return panic_message;
+}
+
+void host_fatal(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "host: ");
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+    abort();
+}
+
+// ---- Trava do lwIP e interrupções ----
+
+void host_lwip_lock(bool take) {
+    if (take) {
+        lock_depth++;
+    } else if (--lock_depth < 0) {
+        host_fatal("cyw43_arch_lwip_end() sem cyw43_arch_lwip_begin()");
+    }
+}
+
+int host_lwip_lock_depth(void) {
+    return lock_depth;
+}
+
+uint32_t host_irq_disable(void) {
+    return (uint32_t)irq_depth++;
+}
+
+void host_irq_restore(uint32_t state) {
+    if (irq_depth == 0 || (uint32_t)(irq_depth - 1) != state) {
+        host_fatal("restore_interrupts() fora de ordem (profundidade %d, estado %u)", irq_depth, (unsigned)state);
+    }
+    irq_depth--;
+}
+
+// ---- Sorteio (xorshift32) ----
+
+void host_rand_seed(uint32_t seed) {
+    rand_state = seed != 0 ? seed : 1;
+}
+
+uint32_t host_rand_32(void) {
+    uint32_t x = rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rand_state = x;
+    return x;
+}
+
+// ---- Brokers e enlace ----
+
+void host_broker_set(const char *ip, host_broker_mode_t mode) {
+    ip_addr_t addr;
+    if (!ipaddr_aton(ip, &addr)) {
+        host_fatal("IP de broker inválido: %s", ip);
+    }
+    for (size_t i = 0; i < broker_count; i++) {
+        if (brokers[i].ip.addr == addr.addr) {
+            brokers[i].mode = mode;
+            return;
+        }
+    }
+    if (broker_count == HOST_BROKERS_MAX) {
+        host_fatal("brokers demais");
+    }
+    brokers[broker_count].ip = addr;
+    brokers[broker_count].mode = mode;
+    broker_count++;
+}
+
+host_broker_mode_t host_broker_mode(const ip_addr_t *ip) {
+    for (size_t i = 0; i < broker_count; i++) {
+        if (brokers[i].ip.addr == ip->addr) {
+            return brokers[i].mode;
+        }
+    }
+    return HOST_BROKER_UP;
+}
+
+void host_link_set(uint32_t bytes_per_ms, uint32_t rtt_ms) {
+    link_rate = bytes_per_ms;
+    link_rtt_us = (uint64_t)rtt_ms * 1000u;
+}
+
+uint32_t host_link_rate(void) {
+    return link_rate;
+}
+
+uint64_t host_link_rtt_us(void) {
+    return link_rtt_us;
+}
+
+uint64_t host_link_tx_us(uint64_t bytes) {
+    return link_rate == 0 ? 0 : (bytes * 1000u + link_rate - 1) / link_rate;
+}
+
+// ---- Fila de eventos ----
+
+host_event_t *host_event_add(uint64_t delay_us, host_event_type_t type, void *target, uint32_t gen) {
+    for (size_t i = 0; i < HOST_EVENTS_MAX; i++) {
+        if (!event_used[i]) {
+            event_used[i] = true;
+            memset(&events[i], 0, sizeof(events[i]));
+            events[i].due_us = clock_us + delay_us;
+            events[i].order = event_order++;
+            events[i].type = type;
+            events[i].target = target;
+            events[i].gen = gen;
+            return &events[i];
+        }
+    }
+    host_fatal("fila de eventos cheia");
+}
+
+static int event_earliest(void) {
+    int best = -1;
+    for (int i = 0; i < HOST_EVENTS_MAX; i++) {
+        if (event_used[i] && (best < 0 || events[i].due_us < events[best].due_us ||
+                              (events[i].due_us == events[best].due_us && events[i].order < events[best].order))) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+static void event_dispatch(const host_event_t *ev) {
+    switch (ev->type) {
+        case HOST_EV_DNS:
+            host_dns_event(ev);
+            break;
+        case HOST_EV_MQTT_TCP_CONNECTED:
+        case HOST_EV_MQTT_TCP_FAILED:
+        case HOST_EV_MQTT_CONNACK:
+        case HOST_EV_MQTT_ACK:
+            // Respostas do broker chegam pela netif; o aborto local do TCP, não
+            if (ev->local) {
+                host_mqtt_event(ev);
+            } else {
+                host_netif_receive(ev);
+            }
+            break;
+        case HOST_EV_MQTT_RETRANSMIT:
+            host_mqtt_event(ev);
+            break;
+        case HOST_EV_SYS_TIMEOUT:
+            host_netif_event(ev);
+            break;
+        case HOST_EV_TCP_CONNECTED:
+        case HOST_EV_TCP_FAILED:
+            host_tcp_event(ev);
+            break;
+    }
+}
+
+// ---- Relógio ----
+
+uint64_t host_clock_us(void) {
+    return clock_us;
+}
+
+void host_clock_advance_us(uint64_t us) {
+    if (lock_depth != 0) {
+        host_fatal("relógio avançado com a trava do lwIP tomada");
+    }
+    if (advancing) {
+        host_fatal("relógio avançado dentro de um callback");
+    }
+    advancing = true;
+
+    uint64_t target = clock_us + us;
+    while (true) {
+        uint64_t next = target;
+        int ev = event_earliest();
+        if (ev >= 0 && events[ev].due_us < next) {
+            next = events[ev].due_us > clock_us ? events[ev].due_us : clock_us;
+        }
+        uint64_t deadline = host_mqtt_next_deadline();
+        if (deadline < next) {
+            next = deadline > clock_us ? deadline : clock_us;
+        }
+        deadline = host_tcp_next_deadline();
+        if (deadline < next) {
+            next = deadline > clock_us ? deadline : clock_us;
+        }
+
+        host_mqtt_transmit(clock_us, next);
+        host_tcp_transmit(clock_us, next);
+        clock_us = next;
+
+        while ((ev = event_earliest()) >= 0 && events[ev].due_us <= clock_us) {
+            host_event_t copy = events[ev];
+            event_used[ev] = false;
+            event_dispatch(&copy);
+        }
+        host_mqtt_expire(clock_us);
+        host_tcp_poll(clock_us);
+        if (lock_depth != 0) {
+            host_fatal("callback de rede retornou com a trava do lwIP tomada");
+        }
+        if (clock_us >= target) {
+            break;
+        }
+    }
+    advancing = false;
+}
+
+void host_clock_advance_ms(uint32_t ms) {
+    host_clock_advance_us((uint64_t)ms * 1000u);
+}
+
+void host_reset(void) {
+    host_mqtt_clear();
+    host_tcp_clear();
+    host_dns_clear();
+    host_netif_clear();
+    clock_us = 0;
+    advancing = false;
+    rand_state = 1;
+    lock_depth = 0;
+    irq_depth = 0;
+    memset(event_used, 0, sizeof(event_used));
+    event_order = 0;
+    broker_count = 0;
+    link_rate = 1000;
+    link_rtt_us = 20000;
+}
@@ -0,0 +1,94 @@
+#ifndef HOST_INTERNAL_H
+#define HOST_INTERNAL_H
+
+/* Interno aos dublês: fila de eventos do relógio virtual e estado compartilhado entre
+ * host_core.c, host_lwip.c e host_mqtt.c. Os testes usam apenas host_mock.h. */
+
+#include "host_mock.h"
+#include "lwip/ip_addr.h"
+#include "lwip/dns.h"
+
+typedef enum {
+    HOST_EV_DNS,
+    HOST_EV_MQTT_TCP_CONNECTED,
+    HOST_EV_MQTT_TCP_FAILED,
+    HOST_EV_MQTT_CONNACK,
+    HOST_EV_MQTT_ACK,
+    HOST_EV_TCP_CONNECTED,
+    HOST_EV_TCP_FAILED,
+    HOST_EV_MQTT_RETRANSMIT,  // RTO do quadro MQTT retido ou perdido na netif
+    HOST_EV_SYS_TIMEOUT,
+} host_event_type_t;
+
+typedef struct {
+    uint64_t due_us;
+    uint64_t order;           // desempate: eventos no mesmo instante saem na ordem de criação
+    host_event_type_t type;
+    void *target;             // mqtt_client_t ou tcp_pcb
+    uint32_t gen;             // geração da conexão no agendamento; eventos de conexões antigas são ignorados
+    uint16_t pkt_id;
+    int status;
+    // Netif: quadros do cliente MQTT simulado
+    uint32_t seq;             // HOST_EV_MQTT_RETRANSMIT: quadro aguardando entrega
+    uint8_t attempt;          // retransmissões já feitas
+    bool local;               // gerado no próprio dispositivo (aborto do TCP): não passa pela netif
+    void (*timeout)(void *arg);
+    // DNS
+    dns_found_callback dns_found;
+    void *dns_arg;
+    char dns_name[64];
+    bool dns_ok;
+    ip_addr_t dns_ip;
+} host_event_t;
+
+// Agenda um evento `delay_us` após o instante atual; retorna o evento para preencher os campos
+host_event_t *host_event_add(uint64_t delay_us, host_event_type_t type, void *target, uint32_t gen);
+
+host_broker_mode_t host_broker_mode(const ip_addr_t *ip);
+uint32_t host_link_rate(void);
+uint64_t host_link_rtt_us(void);
+
+// Tradução de bytes de crédito do enlace: tempo em µs para transmitir `bytes`
+uint64_t host_link_tx_us(uint64_t bytes);
+
+// Chamados pelo laço do relógio
+void host_mqtt_transmit(uint64_t from_us, uint64_t to_us);
+uint64_t host_mqtt_next_deadline(void);
+void host_mqtt_expire(uint64_t now_us);
+void host_mqtt_event(const host_event_t *ev);
+void host_mqtt_clear(void);
+
+void host_tcp_transmit(uint64_t from_us, uint64_t to_us);
+uint64_t host_tcp_next_deadline(void);
+void host_tcp_poll(uint64_t now_us);
+void host_tcp_event(const host_event_t *ev);
+void host_tcp_clear(void);
+
+void host_dns_event(const host_event_t *ev);
+void host_dns_clear(void);
+
+/* Netif do Wi-Fi: os quadros do cliente MQTT simulado passam pelos ganchos input/linkoutput,
+ * que a injeção de falhas pode interceptar. Quadro perdido ou retido é retransmitido como no
+ * TCP do lwIP: RTO inicial de HOST_NETIF_RTO_MS com o backoff do lwIP e aborto da conexão
+ * depois de HOST_NETIF_MAXRTX tentativas. */
+#define HOST_NETIF_RTO_MS  1000
+#define HOST_NETIF_MAXRTX  12
+
+uint64_t host_netif_rto_us(uint8_t attempt);
+
+// Transmite um pacote do cliente ao broker; a entrega chega por host_mqtt_frame_delivered()
+void host_netif_send(mqtt_client_t *client, uint32_t gen, uint32_t seq, const uint8_t *data, size_t len,
+                     uint64_t received_us);
+
+// Resposta do broker (conexão TCP, CONNACK, PUBACK): entregue a host_mqtt_event() pela netif
+void host_netif_receive(const host_event_t *ev);
+
+void host_netif_event(const host_event_t *ev);
+void host_netif_clear(void);
+
+void host_mqtt_frame_delivered(mqtt_client_t *client, uint32_t gen, uint32_t seq, const uint8_t *data, size_t len,
+                               uint64_t received_us);
+
+extern host_mqtt_stats_t host_mqtt_stats_data;
+
+#endif /* HOST_INTERNAL_H */
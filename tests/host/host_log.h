@@ -0,0 +1,14 @@
+#ifndef HOST_LOG_H
+#define HOST_LOG_H
+
+/* Incluído à força (-include) nos fontes do firmware compilados no host: os logs do
+ * firmware só aparecem com RACK_HOST_VERBOSE=1 no ambiente, para não afogar a saída
+ * dos testes e não pesar nos benchmarks. */
+
+#include <stdio.h>
+
+int host_printf(const char *format, ...) __attribute__((format(__printf__, 1, 2)));
+
+#define printf host_printf
+
+#endif /* HOST_LOG_H */
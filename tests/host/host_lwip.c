@@ -0,0 +1,373 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Dublês do host - lwIP
+/ Descrição: Endereços IP, DNS por tabela, TCP raw com enlace virtual e pbufs alocados na libc (um segmento cada).
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_internal.h"
+#include "lwip/tcp.h"
+#include "lwip/pbuf.h"
+
+#define HOST_DNS_MAX  16
+#define HOST_TCP_PCBS 8
+
+typedef struct {
+    char name[64];
+    ip_addr_t ip;
+} host_dns_entry_t;
+
+static host_dns_entry_t dns_table[HOST_DNS_MAX];
+static size_t dns_count = 0;
+static uint32_t dns_delay_ms = 20;
+static uint32_t dns_queries = 0;
+
+static struct tcp_pcb pcbs[HOST_TCP_PCBS];
+static uint32_t pcb_gen = 0;
+static host_tcp_tx_hook_t tx_hook = NULL;
+static void *tx_hook_arg = NULL;
+
+// ---- Endereços ----
+
+char *ipaddr_ntoa(const ip_addr_t *addr) {
+    static char text[16];
+    u32_t a = addr->addr;
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", (unsigned)(a & 0xFF), (unsigned)((a >> 8) & 0xFF),
+             (unsigned)((a >> 16) & 0xFF), (unsigned)(a >> 24));
+    return text;
+}
+
+int ipaddr_aton(const char *text, ip_addr_t *addr) {
+    unsigned b[4];
+    char tail;
+    if (sscanf(text, "%u.%u.%u.%u%c", &b[0], &b[1], &b[2], &b[3], &tail) != 4 ||
+        b[0] > 255 || b[1] > 255 || b[2] > 255 || b[3] > 255) {
+        return 0;
+    }
+    addr->addr = (u32_t)(b[0] | (b[1] << 8) | (b[2] << 16) | (b[3] << 24));
+    return 1;
+}
+
+// ---- DNS ----
+
+void host_dns_set_delay_ms(uint32_t delay_ms) {
+    dns_delay_ms = delay_ms;
+}
+
+void host_dns_add(const char *name, const char *ip) {
+    if (dns_count == HOST_DNS_MAX || strlen(name) >= sizeof(dns_table[0].name)) {
+        host_fatal("tabela de DNS cheia ou nome longo demais: %s", name);
+    }
+    if (!ipaddr_aton(ip, &dns_table[dns_count].ip)) {
+        host_fatal("IP inválido para %s: %s", name, ip);
+    }
+    strcpy(dns_table[dns_count].name, name);
+    dns_count++;
+}
+
+uint32_t host_dns_queries(void) {
+    return dns_queries;
+}
+
+err_t dns_gethostbyname(const char *hostname, ip_addr_t *addr, dns_found_callback found, void *callback_arg) {
+    dns_queries++;
+    if (ipaddr_aton(hostname, addr)) {
+        return ERR_OK;
+    }
+
+    const host_dns_entry_t *entry = NULL;
+    for (size_t i = 0; i < dns_count; i++) {
+        if (strcmp(dns_table[i].name, hostname) == 0) {
+            entry = &dns_table[i];
+        }
+    }
+    if (entry != NULL && dns_delay_ms == 0) {
+        *addr = entry->ip;
+        return ERR_OK;
+    }
+
+    // Nomes desconhecidos falham de forma assíncrona, como um NXDOMAIN
+    host_event_t *ev = host_event_add((uint64_t)dns_delay_ms * 1000u, HOST_EV_DNS, NULL, 0);
+    ev->dns_found = found;
+    ev->dns_arg = callback_arg;
+    snprintf(ev->dns_name, sizeof(ev->dns_name), "%s", hostname);
+    ev->dns_ok = entry != NULL;
+    if (entry != NULL) {
+        ev->dns_ip = entry->ip;
+    }
+    return ERR_INPROGRESS;
+}
+
+void host_dns_event(const host_event_t *ev) {
+    if (ev->dns_found != NULL) {
+        ev->dns_found(ev->dns_name, ev->dns_ok ? &ev->dns_ip : NULL, ev->dns_arg);
+    }
+}
+
+void host_dns_clear(void) {
+    dns_count = 0;
+    dns_delay_ms = 20;
+    dns_queries = 0;
+}
+
+// ---- pbuf ----
+
+struct pbuf *pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type) {
+    struct pbuf *p = malloc(sizeof(struct pbuf) + length);
+    if (p == NULL) {
+        host_fatal("sem memória para pbuf");
+    }
+    p->next = NULL;
+    p->payload = (uint8_t *)(p + 1);
+    p->tot_len = length;
+    p->len = length;
+    p->host_lost = NULL;
+    return p;
+}
+
+static struct pbuf *pbuf_from(const void *data, u16_t len) {
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, len, PBUF_RAM);
+    memcpy(p->payload, data, len);
+    return p;
+}
+
+err_t pbuf_copy(struct pbuf *p_to, const struct pbuf *p_from) {
+    if (p_to->len < p_from->tot_len) {
+        return ERR_ARG;
+    }
+    u16_t offset = 0;
+    for (const struct pbuf *q = p_from; q != NULL; q = q->next) {
+        memcpy((uint8_t *)p_to->payload + offset, q->payload, q->len);
+        offset += q->len;
+    }
+    return ERR_OK;
+}
+
+u8_t pbuf_free(struct pbuf *p) {
+    u8_t count = 0;
+    while (p != NULL) {
+        struct pbuf *next = p->next;
+        if (p->host_lost != NULL) {
+            p->host_lost(p);
+        }
+        free(p);
+        p = next;
+        count++;
+    }
+    return count;
+}
+
+// ---- TCP ----
+
+static void pcb_release(struct tcp_pcb *pcb) {
+    pcb->used = false;
+    pcb->connected = false;
+    pcb->connecting = false;
+    pcb->gen = ++pcb_gen;
+}
+
+struct tcp_pcb *tcp_new(void) {
+    for (size_t i = 0; i < HOST_TCP_PCBS; i++) {
+        if (!pcbs[i].used) {
+            uint32_t gen = ++pcb_gen;
+            memset(&pcbs[i], 0, sizeof(pcbs[i]));
+            pcbs[i].used = true;
+            pcbs[i].gen = gen;
+            return &pcbs[i];
+        }
+    }
+    return NULL;
+}
+
+void tcp_arg(struct tcp_pcb *pcb, void *arg) {
+    pcb->arg = arg;
+}
+
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn err) {
+    pcb->err_fn = err;
+}
+
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn recv) {
+    pcb->recv_fn = recv;
+}
+
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn sent) {
+    pcb->sent_fn = sent;
+}
+
+void tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn poll, u8_t interval) {
+    pcb->poll_fn = poll;
+    pcb->poll_interval = interval;
+    pcb->next_poll_us = host_clock_us() + (uint64_t)interval * 500000u;  // timer lento do TCP: 500 ms
+}
+
+err_t tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port, tcp_connected_fn connected) {
+    pcb->remote_ip = *ipaddr;
+    pcb->connected_fn = connected;
+    pcb->connecting = true;
+    switch (host_broker_mode(ipaddr)) {
+        case HOST_BROKER_DOWN:
+            host_event_add(host_link_rtt_us(), HOST_EV_TCP_FAILED, pcb, pcb->gen);
+            break;
+        case HOST_BROKER_SILENT:
+            break;
+        default:
+            host_event_add(host_link_rtt_us(), HOST_EV_TCP_CONNECTED, pcb, pcb->gen);
+            break;
+    }
+    return ERR_OK;
+}
+
+err_t tcp_write(struct tcp_pcb *pcb, const void *data, u16_t len, u8_t apiflags) {
+    if (!pcb->connected && !pcb->connecting) {
+        return ERR_CONN;
+    }
+    u16_t segments = (u16_t)((len + TCP_MSS - 1) / TCP_MSS);
+    if (len > tcp_sndbuf(pcb) || pcb->snd_segments + segments > TCP_SND_QUEUELEN) {
+        return ERR_MEM;
+    }
+    pcb->snd_queued += len;
+    pcb->snd_segments += segments;
+    pcb->bytes_written += len;
+    if (tx_hook != NULL) {
+        tx_hook(pcb, data, len, tx_hook_arg);
+    }
+    return ERR_OK;
+}
+
+err_t tcp_output(struct tcp_pcb *pcb) {
+    return pcb->connected || pcb->connecting ? ERR_OK : ERR_CONN;
+}
+
+void tcp_recved(struct tcp_pcb *pcb, u16_t len) {
+}
+
+err_t tcp_close(struct tcp_pcb *pcb) {
+    pcb_release(pcb);
+    return ERR_OK;
+}
+
+// Como no lwIP, o pcb já está liberado quando o callback de erro é chamado
+static void pcb_fail(struct tcp_pcb *pcb, err_t err) {
+    tcp_err_fn err_fn = pcb->err_fn;
+    void *arg = pcb->arg;
+    pcb_release(pcb);
+    if (err_fn != NULL) {
+        err_fn(arg, err);
+    }
+}
+
+void tcp_abort(struct tcp_pcb *pcb) {
+    pcb_fail(pcb, ERR_ABRT);
+}
+
+void host_tcp_set_tx_hook(host_tcp_tx_hook_t hook, void *arg) {
+    tx_hook = hook;
+    tx_hook_arg = arg;
+}
+
+void host_tcp_receive(struct tcp_pcb *pcb, const void *data, uint16_t len) {
+    if (!pcb->used || !pcb->connected) {
+        host_fatal("recepção em pcb não conectado");
+    }
+    struct pbuf *p = data != NULL ? pbuf_from(data, len) : NULL;
+    if (pcb->recv_fn == NULL) {
+        pbuf_free(p);
+        return;
+    }
+    if (pcb->recv_fn(pcb->arg, pcb, p, ERR_OK) != ERR_OK) {
+        pbuf_free(p);  // recusado: no lwIP ficaria para nova entrega; aqui é descartado
+    }
+}
+
+void host_tcp_reset(struct tcp_pcb *pcb) {
+    if (pcb->used) {
+        pcb_fail(pcb, ERR_RST);
+    }
+}
+
+size_t host_tcp_pcbs_used(void) {
+    size_t used = 0;
+    for (size_t i = 0; i < HOST_TCP_PCBS; i++) {
+        used += pcbs[i].used;
+    }
+    return used;
+}
+
+void host_tcp_event(const host_event_t *ev) {
+    struct tcp_pcb *pcb = (struct tcp_pcb *)ev->target;
+    if (!pcb->used || pcb->gen != ev->gen) {
+        return;  // pcb fechado antes do evento
+    }
+    if (ev->type == HOST_EV_TCP_FAILED) {
+        pcb_fail(pcb, ERR_RST);
+        return;
+    }
+    pcb->connecting = false;
+    pcb->connected = true;
+    if (pcb->connected_fn != NULL) {
+        pcb->connected_fn(pcb->arg, pcb, ERR_OK);
+    }
+}
+
+void host_tcp_transmit(uint64_t from_us, uint64_t to_us) {
+    uint32_t rate = host_link_rate();
+    for (size_t i = 0; i < HOST_TCP_PCBS; i++) {
+        struct tcp_pcb *pcb = &pcbs[i];
+        if (!pcb->used || !pcb->connected || pcb->snd_queued == 0) {
+            pcb->tx_credit = 0;
+            continue;
+        }
+        u16_t sent;
+        if (rate == 0) {
+            sent = pcb->snd_queued;
+        } else {
+            pcb->tx_credit += (to_us - from_us) * rate;
+            uint64_t whole = pcb->tx_credit / 1000u;
+            sent = whole >= pcb->snd_queued ? pcb->snd_queued : (u16_t)whole;
+            pcb->tx_credit -= (uint64_t)sent * 1000u;
+        }
+        if (sent == 0) {
+            continue;
+        }
+        pcb->snd_queued -= sent;
+        if (pcb->snd_queued == 0) {
+            pcb->snd_segments = 0;
+            pcb->tx_credit = 0;
+        }
+        host_mqtt_stats_data.bytes += sent;
+        if (pcb->sent_fn != NULL) {
+            pcb->sent_fn(pcb->arg, pcb, sent);
+        }
+    }
+}
+
+uint64_t host_tcp_next_deadline(void) {
+    uint64_t next = UINT64_MAX;
+    for (size_t i = 0; i < HOST_TCP_PCBS; i++) {
+        if (pcbs[i].used && pcbs[i].poll_fn != NULL && pcbs[i].poll_interval > 0 && pcbs[i].next_poll_us < next) {
+            next = pcbs[i].next_poll_us;
+        }
+    }
+    return next;
+}
+
+void host_tcp_poll(uint64_t now_us) {
+    for (size_t i = 0; i < HOST_TCP_PCBS; i++) {
+        struct tcp_pcb *pcb = &pcbs[i];
+        if (pcb->used && pcb->poll_fn != NULL && pcb->poll_interval > 0 && pcb->next_poll_us <= now_us) {
+            pcb->next_poll_us = now_us + (uint64_t)pcb->poll_interval * 500000u;
+            pcb->poll_fn(pcb->arg, pcb);
+        }
+    }
+}
+
+void host_tcp_clear(void) {
+    for (size_t i = 0; i < HOST_TCP_PCBS; i++) {
+        pcbs[i].used = false;
+        pcbs[i].gen = ++pcb_gen;
+    }
+    tx_hook = NULL;
+    tx_hook_arg = NULL;
+}
@@ -0,0 +1,138 @@
+#ifndef HOST_MOCK_H
+#define HOST_MOCK_H
+
+/* Controle dos dublês do SDK e do lwIP usados pelos testes no host.
+ *
+ * Relógio virtual: o tempo só anda em host_clock_advance_ms()/host_clock_advance_us()
+ * (ou sleep_ms() no código do firmware). Cada avanço processa, em ordem de horário, os
+ * eventos de rede vencidos (DNS, TCP, CONNACK, PUBACK, SUBACK, timeouts) e esvazia os
+ * buffers de saída pelo enlace virtual, chamando os callbacks como o lwIP faria em
+ * contexto de IRQ. Avançar o relógio com a trava do lwIP tomada é um erro do teste.
+ *
+ * Brokers: cada IP tem um comportamento (host_broker_set); IPs não cadastrados aceitam
+ * conexões automaticamente. Nomes são resolvidos pela tabela de host_dns_add(). */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// ---- Relógio e sorteio ----
+uint64_t host_clock_us(void);
+void host_clock_advance_us(uint64_t us);
+void host_clock_advance_ms(uint32_t ms);
+
+void host_rand_seed(uint32_t seed);
+uint32_t host_rand_32(void);
+
+/* Volta todos os dublês ao estado inicial (relógio em 0, sem brokers, sem eventos). Clientes
+ * de mqtt_client_new() são liberados: os módulos do firmware precisam ser reinicializados. */
+void host_reset(void);
+
+// ---- Trava do lwIP e interrupções ----
+void host_lwip_lock(bool take);
+int host_lwip_lock_depth(void);
+uint32_t host_irq_disable(void);
+void host_irq_restore(uint32_t state);
+
+// ---- panic() ----
+void host_panic(const char *format, ...) __attribute__((noreturn, format(__printf__, 1, 2)));
+
+// Executa fn(arg); retorna true se ele terminou em panic() (mensagem em host_panic_message())
+bool host_panic_caught(void (*fn)(void *arg), void *arg);
+const char *host_panic_message(void);
+
+// Falha fatal do próprio dublê (uso incorreto pelo teste)
+void host_fatal(const char *format, ...) __attribute__((noreturn, format(__printf__, 1, 2)));
+
+// ---- DNS ----
+// Atraso das respostas; 0 resolve na própria chamada (como um nome em cache)
+void host_dns_set_delay_ms(uint32_t delay_ms);
+void host_dns_add(const char *name, const char *ip);
+uint32_t host_dns_queries(void);
+
+// ---- Brokers e enlace ----
+typedef enum {
+    HOST_BROKER_UP,        // aceita CONNECT e confirma PUBLISH/SUBSCRIBE após o RTT
+    HOST_BROKER_MANUAL,    // TCP conecta, CONNACK só com host_mqtt_accept()/host_mqtt_refuse()
+    HOST_BROKER_DOWN,      // conexão recusada (RST) após o RTT
+    HOST_BROKER_SILENT,    // nunca responde (SYN perdido)
+    HOST_BROKER_NO_ACK,    // conecta, mas não envia PUBACK/SUBACK
+} host_broker_mode_t;
+
+void host_broker_set(const char *ip, host_broker_mode_t mode);
+
+// Vazão do enlace (bytes/ms, 0 = infinita) e RTT até o broker
+void host_link_set(uint32_t bytes_per_ms, uint32_t rtt_ms);
+
+// ---- Cliente MQTT do lwIP simulado ----
+typedef struct mqtt_client_s mqtt_client_t;
+
+typedef struct {
+    uint64_t at_us;           // instante em que o broker terminou de receber a mensagem
+    char topic[128];
+    uint8_t payload[512];
+    uint16_t payload_len;
+    uint8_t qos;
+    uint8_t retain;
+    uint8_t dup;
+    uint16_t pkt_id;
+} host_mqtt_msg_t;
+
+typedef struct {
+    uint32_t connects;        // CONNECT recebidos pelo broker
+    uint32_t connacks;
+    uint32_t publishes;       // PUBLISH recebidos pelo broker
+    uint32_t acks;            // PUBACK/SUBACK/UNSUBACK entregues ao cliente
+    uint32_t subscribes;
+    uint32_t timeouts;        // requisições expiradas no cliente (MQTT_REQ_TIMEOUT)
+    uint64_t bytes;           // bytes transmitidos pelo enlace
+} host_mqtt_stats_t;
+
+// Chamado para cada PUBLISH recebido pelo broker
+typedef void (*host_mqtt_publish_hook_t)(const host_mqtt_msg_t *msg, void *arg);
+
+void host_mqtt_set_publish_hook(host_mqtt_publish_hook_t hook, void *arg);
+const host_mqtt_msg_t *host_mqtt_last(void);
+void host_mqtt_get_stats(host_mqtt_stats_t *stats);
+
+// CONNACK manual para um cliente esperando em um broker HOST_BROKER_MANUAL
+void host_mqtt_accept(mqtt_client_t *client);
+void host_mqtt_refuse(mqtt_client_t *client, int status);
+
+// O broker derruba a conexão (o cliente recebe MQTT_CONNECT_DISCONNECTED)
+void host_mqtt_drop(mqtt_client_t *client);
+
+// Entrega uma publicação do broker ao cliente, em um único fragmento
+void host_mqtt_deliver(mqtt_client_t *client, const char *topic, const void *payload, uint16_t len);
+
+const char *host_mqtt_client_id(const mqtt_client_t *client);
+const char *host_mqtt_subscription(const mqtt_client_t *client);
+bool host_mqtt_clean_session(const mqtt_client_t *client);
+size_t host_mqtt_ring_used(const mqtt_client_t *client);
+size_t host_mqtt_requests_used(const mqtt_client_t *client);
+
+// ---- TCP raw simulado ----
+struct tcp_pcb;
+
+// Chamado em cada tcp_write(), com os bytes escritos
+typedef void (*host_tcp_tx_hook_t)(struct tcp_pcb *pcb, const void *data, uint16_t len, void *arg);
+
+void host_tcp_set_tx_hook(host_tcp_tx_hook_t hook, void *arg);
+
+// Entrega bytes recebidos ao callback de recepção do pcb (NULL = FIN do outro lado)
+void host_tcp_receive(struct tcp_pcb *pcb, const void *data, uint16_t len);
+
+// Derruba a conexão pelo outro lado (o pcb recebe ERR_RST e é liberado)
+void host_tcp_reset(struct tcp_pcb *pcb);
+
+size_t host_tcp_pcbs_used(void);
+
+// ---- Netif do Wi-Fi ----
+struct netif;
+
+/* Interface por onde passa o tráfego do cliente MQTT simulado (não o do TCP raw), com os
+ * ganchos input/linkoutput do lwIP: a injeção de falhas (fault_inject.c) é instalada nela
+ * como na netif do CYW43. host_reset() restaura os ganchos originais. */
+struct netif *host_netif(void);
+
+#endif /* HOST_MOCK_H */
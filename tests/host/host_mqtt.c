@@ -0,0 +1,710 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Dublês do host - cliente MQTT do lwIP
+/ Descrição: Mesma API e mesmos limites do app MQTT do lwIP 2.x (anel de saída, requisições em voo, timeout de 30 s),
+/            com os pacotes reais no anel e um broker simulado que os interpreta na outra ponta do enlace virtual.
+/ Obs: Semântica reproduzida do lwIP: mqtt_client_connect() zera o cliente; mqtt_disconnect() descarta as requisições
+/      pendentes sem chamar callbacks nem o callback de conexão; falta de requisição livre ou de espaço no anel
+/      retorna ERR_MEM; cliente desconectado retorna ERR_CONN; PUBLISH QoS 0 conclui a cada pacote transmitido.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_internal.h"
+#include "lwip/apps/mqtt_priv.h"
+
+#define HOST_MQTT_CLIENTS 16
+
+// Estados de conexão, como em mqtt.c do lwIP
+enum {
+    TCP_DISCONNECTED,
+    TCP_CONNECTING,
+    MQTT_CONNECTING,
+    MQTT_CONNECTED,
+};
+
+enum {
+    MQTT_MSG_TYPE_CONNECT     = 1,
+    MQTT_MSG_TYPE_CONNACK     = 2,
+    MQTT_MSG_TYPE_PUBLISH     = 3,
+    MQTT_MSG_TYPE_PUBACK      = 4,
+    MQTT_MSG_TYPE_SUBSCRIBE   = 8,
+    MQTT_MSG_TYPE_UNSUBSCRIBE = 10,
+};
+
+typedef struct {
+    mqtt_client_t *client;
+    bool heap;
+} host_mqtt_slot_t;
+
+host_mqtt_stats_t host_mqtt_stats_data;
+
+static host_mqtt_slot_t clients[HOST_MQTT_CLIENTS];
+static u32_t client_gen = 0;
+static host_mqtt_publish_hook_t publish_hook = NULL;
+static void *publish_hook_arg = NULL;
+static host_mqtt_msg_t last_msg;
+
+// ---- Registro dos clientes ----
+
+static void client_register(mqtt_client_t *client, bool heap) {
+    for (size_t i = 0; i < HOST_MQTT_CLIENTS; i++) {
+        if (clients[i].client == client) {
+            return;
+        }
+    }
+    for (size_t i = 0; i < HOST_MQTT_CLIENTS; i++) {
+        if (clients[i].client == NULL) {
+            clients[i].client = client;
+            clients[i].heap = heap;
+            return;
+        }
+    }
+    host_fatal("clientes MQTT demais");
+}
+
+mqtt_client_t *mqtt_client_new(void) {
+    mqtt_client_t *client = calloc(1, sizeof(mqtt_client_t));
+    if (client != NULL) {
+        client_register(client, true);
+    }
+    return client;
+}
+
+static bool client_registered(const mqtt_client_t *client) {
+    for (size_t i = 0; i < HOST_MQTT_CLIENTS; i++) {
+        if (clients[i].client == client) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void mqtt_client_free(mqtt_client_t *client) {
+    for (size_t i = 0; i < HOST_MQTT_CLIENTS; i++) {
+        if (clients[i].client == client) {
+            clients[i].client = NULL;
+        }
+    }
+    free(client);
+}
+
+// ---- Anel de saída ----
+
+static u16_t ring_free(const mqtt_client_t *client) {
+    return (u16_t)(MQTT_OUTPUT_RINGBUF_SIZE - client->host.ring_len);
+}
+
+static void ring_put(mqtt_client_t *client, u8_t byte) {
+    client->output.buf[client->output.put] = byte;
+    client->output.put = (u16_t)((client->output.put + 1) % MQTT_OUTPUT_RINGBUF_SIZE);
+    client->host.ring_len++;
+}
+
+static void ring_put_u16(mqtt_client_t *client, u16_t value) {
+    ring_put(client, (u8_t)(value >> 8));
+    ring_put(client, (u8_t)value);
+}
+
+static void ring_put_bytes(mqtt_client_t *client, const void *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        ring_put(client, ((const u8_t *)data)[i]);
+    }
+}
+
+static void ring_put_string(mqtt_client_t *client, const char *text) {
+    ring_put_u16(client, (u16_t)strlen(text));
+    ring_put_bytes(client, text, strlen(text));
+}
+
+static u8_t ring_peek(const mqtt_client_t *client, size_t offset) {
+    return client->output.buf[(client->output.get + offset) % MQTT_OUTPUT_RINGBUF_SIZE];
+}
+
+static size_t remaining_length_bytes(size_t remaining) {
+    size_t bytes = 1;
+    while (remaining >= 128) {
+        remaining /= 128;
+        bytes++;
+    }
+    return bytes;
+}
+
+// Cabeçalho fixo; false (nada escrito) se o pacote inteiro não couber no anel
+static bool output_header(mqtt_client_t *client, u8_t first, size_t remaining) {
+    if (1 + remaining_length_bytes(remaining) + remaining > ring_free(client)) {
+        return false;
+    }
+    ring_put(client, first);
+    do {
+        u8_t byte = remaining % 128;
+        remaining /= 128;
+        ring_put(client, remaining > 0 ? byte | 0x80 : byte);
+    } while (remaining > 0);
+    return true;
+}
+
+// Tamanho total do pacote na frente do anel
+static size_t front_packet_len(const mqtt_client_t *client) {
+    size_t remaining = 0;
+    size_t multiplier = 1;
+    size_t pos = 1;
+    u8_t byte;
+    do {
+        byte = ring_peek(client, pos++);
+        remaining += (byte & 0x7F) * multiplier;
+        multiplier *= 128;
+    } while (byte & 0x80);
+    return pos + remaining;
+}
+
+// ---- Requisições ----
+
+static struct mqtt_request_t *request_create(mqtt_client_t *client, u16_t pkt_id, mqtt_request_cb_t cb, void *arg) {
+    for (size_t i = 0; i < MQTT_REQ_MAX_IN_FLIGHT; i++) {
+        struct mqtt_request_t *r = &client->req_list[i];
+        if (!r->used) {
+            r->used = true;
+            r->pkt_id = pkt_id;
+            r->cb = cb;
+            r->arg = arg;
+            r->deadline_us = host_clock_us() + (uint64_t)MQTT_REQ_TIMEOUT * 1000000u;
+            return r;
+        }
+    }
+    return NULL;
+}
+
+static struct mqtt_request_t *request_take(mqtt_client_t *client, u16_t pkt_id) {
+    for (size_t i = 0; i < MQTT_REQ_MAX_IN_FLIGHT; i++) {
+        struct mqtt_request_t *r = &client->req_list[i];
+        if (r->used && r->pkt_id == pkt_id) {
+            r->used = false;
+            return r;
+        }
+    }
+    return NULL;
+}
+
+static u16_t packet_id_next(mqtt_client_t *client) {
+    if (++client->pkt_id_seq == 0) {
+        client->pkt_id_seq = 1;
+    }
+    return client->pkt_id_seq;
+}
+
+// ---- Conexão ----
+
+static void client_close(mqtt_client_t *client, mqtt_connection_status_t reason) {
+    client->host.gen = ++client_gen;
+    client->host.awaiting_connack = false;
+    for (size_t i = 0; i < MQTT_REQ_MAX_IN_FLIGHT; i++) {
+        client->req_list[i].used = false;  // descartadas sem callback, como mqtt_clear_requests()
+    }
+    if (client->conn_state != TCP_DISCONNECTED) {
+        client->conn_state = TCP_DISCONNECTED;
+        if (client->connect_cb != NULL) {
+            client->connect_cb(client, client->connect_arg, reason);
+        }
+    }
+}
+
+static void client_connack(mqtt_client_t *client, int status) {
+    if (client->conn_state != MQTT_CONNECTING) {
+        return;
+    }
+    host_mqtt_stats_data.connacks++;
+    if (status == MQTT_CONNECT_ACCEPTED) {
+        client->conn_state = MQTT_CONNECTED;
+        if (client->connect_cb != NULL) {
+            client->connect_cb(client, client->connect_arg, MQTT_CONNECT_ACCEPTED);
+        }
+        return;
+    }
+    // Recusado: o lwIP repassa o código e o broker fecha a conexão em seguida
+    if (client->connect_cb != NULL) {
+        client->connect_cb(client, client->connect_arg, (mqtt_connection_status_t)status);
+    }
+    client_close(client, MQTT_CONNECT_DISCONNECTED);
+}
+
+err_t mqtt_client_connect(mqtt_client_t *client, const ip_addr_t *ipaddr, u16_t port, mqtt_connection_cb_t cb,
+                          void *arg, const struct mqtt_connect_client_info_t *client_info) {
+    if (client->conn_state != TCP_DISCONNECTED) {
+        return ERR_ISCONN;
+    }
+    memset(client, 0, sizeof(*client));
+    client_register(client, false);
+    client->connect_cb = cb;
+    client->connect_arg = arg;
+    client->keep_alive = client_info->keep_alive;
+    client->host.broker = *ipaddr;
+    client->host.gen = ++client_gen;
+
+    // CONNECT MQTT 3.1.1, sempre com clean session (o lwIP não oferece outra opção)
+    u8_t flags = 0x02;
+    size_t remaining = 10 + 2 + strlen(client_info->client_id);
+    if (client_info->will_topic != NULL) {
+        flags |= 0x04 | (u8_t)((client_info->will_qos & 3) << 3) | (client_info->will_retain ? 0x20 : 0);
+        remaining += 2 + strlen(client_info->will_topic) + 2 + strlen(client_info->will_msg);
+    }
+    if (client_info->client_user != NULL) {
+        flags |= 0x80;
+        remaining += 2 + strlen(client_info->client_user);
+    }
+    if (client_info->client_pass != NULL) {
+        flags |= 0x40;
+        remaining += 2 + strlen(client_info->client_pass);
+    }
+    if (!output_header(client, MQTT_MSG_TYPE_CONNECT << 4, remaining)) {
+        return ERR_MEM;
+    }
+    ring_put_string(client, "MQTT");
+    ring_put(client, 4);
+    ring_put(client, flags);
+    ring_put_u16(client, client_info->keep_alive);
+    ring_put_string(client, client_info->client_id);
+    if (client_info->will_topic != NULL) {
+        ring_put_string(client, client_info->will_topic);
+        ring_put_string(client, client_info->will_msg);
+    }
+    if (client_info->client_user != NULL) {
+        ring_put_string(client, client_info->client_user);
+    }
+    if (client_info->client_pass != NULL) {
+        ring_put_string(client, client_info->client_pass);
+    }
+
+    client->conn_state = TCP_CONNECTING;
+    switch (host_broker_mode(ipaddr)) {
+        case HOST_BROKER_DOWN:
+            host_event_add(host_link_rtt_us(), HOST_EV_MQTT_TCP_FAILED, client, client->host.gen);
+            break;
+        case HOST_BROKER_SILENT:
+            break;
+        default:
+            host_event_add(host_link_rtt_us(), HOST_EV_MQTT_TCP_CONNECTED, client, client->host.gen);
+            break;
+    }
+    return ERR_OK;
+}
+
+void mqtt_disconnect(mqtt_client_t *client) {
+    if (client->conn_state != TCP_DISCONNECTED) {
+        // Estado alterado antes de fechar: o callback de conexão não é chamado
+        client->conn_state = TCP_DISCONNECTED;
+        client_close(client, (mqtt_connection_status_t)0);
+    }
+}
+
+u8_t mqtt_client_is_connected(mqtt_client_t *client) {
+    return client->conn_state == MQTT_CONNECTED;
+}
+
+void mqtt_set_inpub_callback(mqtt_client_t *client, mqtt_incoming_publish_cb_t pub_cb,
+                             mqtt_incoming_data_cb_t data_cb, void *arg) {
+    client->pub_cb = pub_cb;
+    client->data_cb = data_cb;
+    client->inpub_arg = arg;
+}
+
+// ---- Publicação e assinatura ----
+
+err_t mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_t payload_length,
+                   u8_t qos, u8_t retain, mqtt_request_cb_t cb, void *arg) {
+    if (client->conn_state == TCP_DISCONNECTED) {
+        return ERR_CONN;
+    }
+    size_t topic_len = strlen(topic);
+    size_t remaining = 2 + topic_len + payload_length + (qos > 0 ? 2 : 0);
+    if (remaining > 0xFFFF) {
+        return ERR_ARG;
+    }
+    u16_t pkt_id = qos > 0 ? packet_id_next(client) : 0;
+
+    struct mqtt_request_t *r = request_create(client, pkt_id, cb, arg);
+    if (r == NULL) {
+        return ERR_MEM;
+    }
+    if (!output_header(client, (u8_t)((MQTT_MSG_TYPE_PUBLISH << 4) | ((qos & 3) << 1) | (retain ? 1 : 0)), remaining)) {
+        r->used = false;
+        return ERR_MEM;
+    }
+    ring_put_string(client, topic);
+    if (qos > 0) {
+        ring_put_u16(client, pkt_id);
+    }
+    ring_put_bytes(client, payload, payload_length);
+    return ERR_OK;
+}
+
+err_t mqtt_sub_unsub(mqtt_client_t *client, const char *topic, u8_t qos, mqtt_request_cb_t cb, void *arg, u8_t sub) {
+    if (client->conn_state == TCP_DISCONNECTED) {
+        return ERR_CONN;
+    }
+    size_t remaining = 2 + 2 + strlen(topic) + (sub ? 1 : 0);
+    if (remaining > 0xFFFF) {
+        return ERR_ARG;
+    }
+    u16_t pkt_id = packet_id_next(client);
+
+    struct mqtt_request_t *r = request_create(client, pkt_id, cb, arg);
+    if (r == NULL) {
+        return ERR_MEM;
+    }
+    u8_t type = sub ? MQTT_MSG_TYPE_SUBSCRIBE : MQTT_MSG_TYPE_UNSUBSCRIBE;
+    if (!output_header(client, (u8_t)((type << 4) | 0x02), remaining)) {
+        r->used = false;
+        return ERR_MEM;
+    }
+    ring_put_u16(client, pkt_id);
+    ring_put_string(client, topic);
+    if (sub) {
+        ring_put(client, qos);
+    }
+    return ERR_OK;
+}
+
+// ---- Broker simulado ----
+
+static u16_t read_u16(const u8_t *p) {
+    return (u16_t)((p[0] << 8) | p[1]);
+}
+
+// Resposta do broker (CONNACK/PUBACK/SUBACK) um RTT após o pacote chegar
+static void broker_reply(mqtt_client_t *client, host_event_type_t type, u16_t pkt_id, uint64_t received_us) {
+    uint64_t due = received_us + host_link_rtt_us();
+    uint64_t now = host_clock_us();
+    host_event_t *ev = host_event_add(due > now ? due - now : 0, type, client, client->host.gen);
+    ev->pkt_id = pkt_id;
+}
+
+static void broker_receive(mqtt_client_t *client, const u8_t *pkt, size_t len, uint64_t received_us) {
+    size_t pos = 1;
+    while (pkt[pos++] & 0x80) {
+    }
+    host_broker_mode_t mode = host_broker_mode(&client->host.broker);
+
+    switch (pkt[0] >> 4) {
+        case MQTT_MSG_TYPE_CONNECT: {
+            // Nome do protocolo (6) + nível (1) + flags (1) + keep alive (2) + client id
+            u8_t flags = pkt[pos + 7];
+            u16_t id_len = read_u16(&pkt[pos + 10]);
+            snprintf(client->host.client_id, sizeof(client->host.client_id), "%.*s", (int)id_len, (const char *)&pkt[pos + 12]);
+            client->host.clean_session = (flags & 0x02) != 0;
+            host_mqtt_stats_data.connects++;
+            if (mode == HOST_BROKER_MANUAL) {
+                client->host.awaiting_connack = true;
+            } else {
+                broker_reply(client, HOST_EV_MQTT_CONNACK, 0, received_us);
+            }
+            break;
+        }
+        case MQTT_MSG_TYPE_PUBLISH: {
+            host_mqtt_msg_t *msg = &last_msg;
+            memset(msg, 0, sizeof(*msg));
+            msg->at_us = received_us;
+            msg->dup = (pkt[0] >> 3) & 1;
+            msg->qos = (pkt[0] >> 1) & 3;
+            msg->retain = pkt[0] & 1;
+            u16_t topic_len = read_u16(&pkt[pos]);
+            pos += 2;
+            snprintf(msg->topic, sizeof(msg->topic), "%.*s", (int)topic_len, (const char *)&pkt[pos]);
+            pos += topic_len;
+            if (msg->qos > 0) {
+                msg->pkt_id = read_u16(&pkt[pos]);
+                pos += 2;
+            }
+            size_t payload_len = len - pos;
+            msg->payload_len = (uint16_t)payload_len;
+            memcpy(msg->payload, &pkt[pos], payload_len < sizeof(msg->payload) ? payload_len : sizeof(msg->payload));
+            host_mqtt_stats_data.publishes++;
+            if (publish_hook != NULL) {
+                publish_hook(msg, publish_hook_arg);
+            }
+            if (msg->qos > 0 && mode != HOST_BROKER_NO_ACK) {
+                broker_reply(client, HOST_EV_MQTT_ACK, msg->pkt_id, received_us);
+            }
+            break;
+        }
+        case MQTT_MSG_TYPE_SUBSCRIBE:
+        case MQTT_MSG_TYPE_UNSUBSCRIBE: {
+            u16_t pkt_id = read_u16(&pkt[pos]);
+            u16_t topic_len = read_u16(&pkt[pos + 2]);
+            if ((pkt[0] >> 4) == MQTT_MSG_TYPE_SUBSCRIBE) {
+                snprintf(client->host.subscription, sizeof(client->host.subscription), "%.*s",
+                         (int)topic_len, (const char *)&pkt[pos + 4]);
+                host_mqtt_stats_data.subscribes++;
+            } else {
+                client->host.subscription[0] = '\0';
+            }
+            if (mode != HOST_BROKER_NO_ACK) {
+                broker_reply(client, HOST_EV_MQTT_ACK, pkt_id, received_us);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Como mqtt_tcp_sent_cb(): a cada envio confirmado, os PUBLISH QoS 0 são concluídos
+static void complete_qos0(mqtt_client_t *client) {
+    struct mqtt_request_t *r;
+    while (client->conn_state == MQTT_CONNECTED && (r = request_take(client, 0)) != NULL) {
+        if (r->cb != NULL) {
+            r->cb(r->arg, ERR_OK);
+        }
+    }
+}
+
+// Pacote entregue pela netif (na hora ou depois de retido pela injeção de falhas)
+void host_mqtt_frame_delivered(mqtt_client_t *client, uint32_t gen, uint32_t seq, const uint8_t *data, size_t len,
+                               uint64_t received_us) {
+    if (!client_registered(client) || client->host.gen != gen || !client->host.tx_stalled || client->host.tx_seq != seq) {
+        return;  // cópia de um pacote já entregue ou de uma conexão encerrada
+    }
+    client->host.tx_stalled = false;
+    client->host.tx_seq++;
+    broker_receive(client, data, len, received_us);
+    if (client->host.gen == gen) {
+        complete_qos0(client);
+    }
+}
+
+// Pacote da frente do anel pela netif; false se ele ainda não foi entregue ou a conexão caiu
+static bool send_frame(mqtt_client_t *client, uint64_t received_us) {
+    u32_t gen = client->host.gen;
+    client->host.tx_stalled = true;
+    host_netif_send(client, gen, client->host.tx_seq, client->host.tx_frame, client->host.tx_len, received_us);
+    if (client->host.gen == gen && client->host.tx_stalled) {
+        host_event_t *ev = host_event_add(host_netif_rto_us(client->host.tx_attempts), HOST_EV_MQTT_RETRANSMIT,
+                                          client, gen);
+        ev->seq = client->host.tx_seq;
+        return false;
+    }
+    return client->host.gen == gen;
+}
+
+// Transmite pacotes inteiros do anel; retorna false quando o crédito acabou
+static bool transmit_packet(mqtt_client_t *client, uint64_t to_us, uint32_t rate) {
+    size_t len = front_packet_len(client);
+    size_t remaining = len - client->host.tx_partial;
+    uint64_t received_us = to_us;
+
+    if (rate != 0) {
+        if (client->host.tx_credit < (uint64_t)remaining * 1000u) {
+            size_t partial = (size_t)(client->host.tx_credit / 1000u);
+            client->host.tx_partial += (u16_t)partial;
+            client->host.tx_credit -= (uint64_t)partial * 1000u;
+            host_mqtt_stats_data.bytes += partial;
+            return false;
+        }
+        client->host.tx_credit -= (uint64_t)remaining * 1000u;
+        received_us = to_us - client->host.tx_credit / rate;  // crédito que sobrou não tinha sido gasto ainda
+    }
+    host_mqtt_stats_data.bytes += remaining;
+
+    for (size_t i = 0; i < len; i++) {
+        client->host.tx_frame[i] = ring_peek(client, i);
+    }
+    client->output.get = (u16_t)((client->output.get + len) % MQTT_OUTPUT_RINGBUF_SIZE);
+    client->host.ring_len -= (u16_t)len;
+    client->host.tx_partial = 0;
+    client->host.tx_len = (u16_t)len;
+    client->host.tx_attempts = 0;
+    return send_frame(client, received_us);
+}
+
+void host_mqtt_transmit(uint64_t from_us, uint64_t to_us) {
+    uint32_t rate = host_link_rate();
+    for (size_t i = 0; i < HOST_MQTT_CLIENTS; i++) {
+        mqtt_client_t *client = clients[i].client;
+        if (client == NULL) {
+            continue;
+        }
+        if (client->conn_state < MQTT_CONNECTING || client->host.ring_len == 0 || client->host.tx_stalled) {
+            client->host.tx_credit = 0;  // enlace ocioso (ou esperando a entrega) não acumula crédito
+            continue;
+        }
+        client->host.tx_credit += (to_us - from_us) * rate;
+        while (client->host.ring_len > 0 && client->conn_state >= MQTT_CONNECTING) {
+            if (!transmit_packet(client, to_us, rate)) {
+                break;
+            }
+        }
+        if (client->host.ring_len == 0) {
+            client->host.tx_credit = 0;
+        }
+    }
+}
+
+uint64_t host_mqtt_next_deadline(void) {
+    uint64_t next = UINT64_MAX;
+    for (size_t i = 0; i < HOST_MQTT_CLIENTS; i++) {
+        mqtt_client_t *client = clients[i].client;
+        if (client == NULL || client->conn_state != MQTT_CONNECTED) {
+            continue;
+        }
+        for (size_t j = 0; j < MQTT_REQ_MAX_IN_FLIGHT; j++) {
+            if (client->req_list[j].used && client->req_list[j].deadline_us < next) {
+                next = client->req_list[j].deadline_us;
+            }
+        }
+    }
+    return next;
+}
+
+// Requisições sem resposta em MQTT_REQ_TIMEOUT s são concluídas com ERR_TIMEOUT (só com a sessão ativa)
+void host_mqtt_expire(uint64_t now_us) {
+    for (size_t i = 0; i < HOST_MQTT_CLIENTS; i++) {
+        mqtt_client_t *client = clients[i].client;
+        for (size_t j = 0; client != NULL && j < MQTT_REQ_MAX_IN_FLIGHT; j++) {
+            struct mqtt_request_t *r = &client->req_list[j];
+            if (client->conn_state == MQTT_CONNECTED && r->used && r->deadline_us <= now_us) {
+                r->used = false;
+                host_mqtt_stats_data.timeouts++;
+                if (r->cb != NULL) {
+                    r->cb(r->arg, ERR_TIMEOUT);
+                }
+            }
+        }
+    }
+}
+
+void host_mqtt_event(const host_event_t *ev) {
+    mqtt_client_t *client = (mqtt_client_t *)ev->target;
+    if (client->host.gen != ev->gen) {
+        return;  // conexão encerrada depois do agendamento
+    }
+    switch (ev->type) {
+        case HOST_EV_MQTT_TCP_CONNECTED:
+            if (client->conn_state == TCP_CONNECTING) {
+                client->conn_state = MQTT_CONNECTING;
+            }
+            break;
+        case HOST_EV_MQTT_TCP_FAILED:
+            client_close(client, MQTT_CONNECT_DISCONNECTED);
+            break;
+        case HOST_EV_MQTT_CONNACK:
+            client_connack(client, MQTT_CONNECT_ACCEPTED);
+            break;
+        case HOST_EV_MQTT_ACK: {
+            struct mqtt_request_t *r = request_take(client, ev->pkt_id);
+            if (r != NULL) {
+                host_mqtt_stats_data.acks++;
+                if (r->cb != NULL) {
+                    r->cb(r->arg, ERR_OK);
+                }
+            }
+            break;
+        }
+        case HOST_EV_MQTT_RETRANSMIT:
+            if (!client->host.tx_stalled || client->host.tx_seq != ev->seq) {
+                break;  // entregue antes do RTO
+            }
+            if (++client->host.tx_attempts > HOST_NETIF_MAXRTX) {
+                client_close(client, MQTT_CONNECT_DISCONNECTED);  // tcp_abort() por retransmissões esgotadas
+                break;
+            }
+            send_frame(client, host_clock_us());
+            break;
+        default:
+            break;
+    }
+}
+
+// ---- Controle pelos testes ----
+
+void host_mqtt_set_publish_hook(host_mqtt_publish_hook_t hook, void *arg) {
+    publish_hook = hook;
+    publish_hook_arg = arg;
+}
+
+const host_mqtt_msg_t *host_mqtt_last(void) {
+    return &last_msg;
+}
+
+void host_mqtt_get_stats(host_mqtt_stats_t *stats) {
+    *stats = host_mqtt_stats_data;
+}
+
+void host_mqtt_accept(mqtt_client_t *client) {
+    host_mqtt_refuse(client, MQTT_CONNECT_ACCEPTED);
+}
+
+void host_mqtt_refuse(mqtt_client_t *client, int status) {
+    if (!client->host.awaiting_connack) {
+        host_fatal("CONNACK manual sem CONNECT pendente");
+    }
+    if (host_lwip_lock_depth() != 0) {
+        host_fatal("CONNACK entregue com a trava do lwIP tomada");
+    }
+    client->host.awaiting_connack = false;
+    client_connack(client, status);
+}
+
+void host_mqtt_drop(mqtt_client_t *client) {
+    if (host_lwip_lock_depth() != 0) {
+        host_fatal("queda entregue com a trava do lwIP tomada");
+    }
+    client_close(client, MQTT_CONNECT_DISCONNECTED);
+}
+
+void host_mqtt_deliver(mqtt_client_t *client, const char *topic, const void *payload, uint16_t len) {
+    if (client->conn_state != MQTT_CONNECTED) {
+        host_fatal("publicação entregue a cliente sem sessão");
+    }
+    if (host_lwip_lock_depth() != 0) {
+        host_fatal("publicação entregue com a trava do lwIP tomada");
+    }
+    // Sem callbacks instalados o lwIP descarta a publicação em silêncio
+    if (client->pub_cb != NULL) {
+        client->pub_cb(client->inpub_arg, topic, len);
+    }
+    if (client->data_cb != NULL) {
+        client->data_cb(client->inpub_arg, (const u8_t *)payload, len, MQTT_DATA_FLAG_LAST);
+    }
+}
+
+const char *host_mqtt_client_id(const mqtt_client_t *client) {
+    return client->host.client_id;
+}
+
+const char *host_mqtt_subscription(const mqtt_client_t *client) {
+    return client->host.subscription;
+}
+
+bool host_mqtt_clean_session(const mqtt_client_t *client) {
+    return client->host.clean_session;
+}
+
+size_t host_mqtt_ring_used(const mqtt_client_t *client) {
+    return client->host.ring_len;
+}
+
+size_t host_mqtt_requests_used(const mqtt_client_t *client) {
+    size_t used = 0;
+    for (size_t i = 0; i < MQTT_REQ_MAX_IN_FLIGHT; i++) {
+        used += client->req_list[i].used;
+    }
+    return used;
+}
+
+void host_mqtt_clear(void) {
+    for (size_t i = 0; i < HOST_MQTT_CLIENTS; i++) {
+        mqtt_client_t *client = clients[i].client;
+        if (client != NULL && clients[i].heap) {
+            free(client);
+        } else if (client != NULL) {
+            // Cliente estático do firmware: volta a desconectado, sem callbacks
+            client->conn_state = TCP_DISCONNECTED;
+            client->host.gen = ++client_gen;
+        }
+        clients[i].client = NULL;
+    }
+    memset(&host_mqtt_stats_data, 0, sizeof(host_mqtt_stats_data));
+    memset(&last_msg, 0, sizeof(last_msg));
+    publish_hook = NULL;
+    publish_hook_arg = NULL;
+}
@@ -0,0 +1,121 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Dublês do host - netif do Wi-Fi
+/ Descrição: Quadros do cliente MQTT simulado passando pelos ganchos input/linkoutput de uma netif, para que a injeção de falhas
+/            do firmware (fault_inject.c) rode no host, e sys_timeout() sobre o relógio virtual.
+/ Obs: Cada quadro leva um pacote MQTT inteiro (saída) ou uma resposta do broker (entrada), não segmentos TCP de verdade. O
+/      cliente manda um pacote por vez enquanto o anterior não é entregue, e o quadro perdido é retransmitido após o RTO; a
+/      entrada perdida é reenviada pelo "broker" do mesmo jeito. Sem falhas instaladas a entrega é síncrona, como antes.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <string.h>
+#include "host_internal.h"
+#include "lwip/netif.h"
+#include "lwip/timeouts.h"
+
+// Cabeçalho no início do payload de cada quadro (sobrevive a pbuf_copy())
+typedef struct {
+    mqtt_client_t *client;    // saída: pacote do cliente ao broker
+    uint32_t gen;
+    uint32_t seq;
+    uint64_t received_us;
+    host_event_t event;       // entrada: resposta do broker
+} frame_header_t;
+
+static err_t base_input(struct pbuf *p, struct netif *inp);
+static err_t base_linkoutput(struct netif *netif, struct pbuf *p);
+
+static struct netif wifi_netif = { base_input, base_linkoutput, NULL };
+
+// Multiplicadores do RTO a cada retransmissão, como tcp_backoff[] do lwIP
+static const uint8_t rto_backoff[] = { 1, 2, 3, 4, 5, 6, 7, 7, 7, 7, 7, 7, 7 };
+
+struct netif *host_netif(void) {
+    return &wifi_netif;
+}
+
+uint64_t host_netif_rto_us(uint8_t attempt) {
+    uint8_t index = attempt < sizeof(rto_backoff) ? attempt : sizeof(rto_backoff) - 1;
+    return (uint64_t)HOST_NETIF_RTO_MS * 1000u * rto_backoff[index];
+}
+
+static struct pbuf *frame_alloc(const frame_header_t *header, const uint8_t *data, size_t len) {
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, (u16_t)(sizeof(*header) + len), PBUF_RAM);
+    memcpy(p->payload, header, sizeof(*header));
+    if (len > 0) {
+        memcpy((uint8_t *)p->payload + sizeof(*header), data, len);
+    }
+    return p;
+}
+
+// ---- Saída ----
+
+static err_t base_linkoutput(struct netif *netif, struct pbuf *p) {
+    frame_header_t header;
+    memcpy(&header, p->payload, sizeof(header));
+    uint64_t now = host_clock_us();
+    host_mqtt_frame_delivered(header.client, header.gen, header.seq, (const uint8_t *)p->payload + sizeof(header),
+                              p->tot_len - sizeof(header), header.received_us > now ? header.received_us : now);
+    return ERR_OK;
+}
+
+void host_netif_send(mqtt_client_t *client, uint32_t gen, uint32_t seq, const uint8_t *data, size_t len,
+                     uint64_t received_us) {
+    frame_header_t header = { .client = client, .gen = gen, .seq = seq, .received_us = received_us };
+    struct pbuf *p = frame_alloc(&header, data, len);
+    wifi_netif.linkoutput(&wifi_netif, p);
+    pbuf_free(p);   // como no lwIP, linkoutput não fica com o quadro
+}
+
+// ---- Entrada ----
+
+// Resposta perdida: o broker a reenvia após o RTO; esgotadas as tentativas, o TCP do dispositivo aborta
+static void rx_lost(struct pbuf *p) {
+    frame_header_t header;
+    memcpy(&header, p->payload, sizeof(header));
+    const host_event_t *lost = &header.event;
+    host_event_t *ev;
+    if (lost->attempt >= HOST_NETIF_MAXRTX) {
+        ev = host_event_add(0, HOST_EV_MQTT_TCP_FAILED, lost->target, lost->gen);
+        ev->local = true;
+        return;
+    }
+    ev = host_event_add(host_netif_rto_us(lost->attempt), lost->type, lost->target, lost->gen);
+    ev->pkt_id = lost->pkt_id;
+    ev->status = lost->status;
+    ev->attempt = (uint8_t)(lost->attempt + 1);
+}
+
+static err_t base_input(struct pbuf *p, struct netif *inp) {
+    frame_header_t header;
+    memcpy(&header, p->payload, sizeof(header));
+    p->host_lost = NULL;
+    pbuf_free(p);   // ERR_OK: a pilha fica com o quadro
+    host_mqtt_event(&header.event);
+    return ERR_OK;
+}
+
+void host_netif_receive(const host_event_t *ev) {
+    frame_header_t header = { .event = *ev };
+    struct pbuf *p = frame_alloc(&header, NULL, 0);
+    p->host_lost = rx_lost;
+    if (wifi_netif.input(p, &wifi_netif) != ERR_OK) {
+        pbuf_free(p);
+    }
+}
+
+// ---- sys_timeout ----
+
+void sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg) {
+    host_event_t *ev = host_event_add((uint64_t)msecs * 1000u, HOST_EV_SYS_TIMEOUT, arg, 0);
+    ev->timeout = handler;
+}
+
+void host_netif_event(const host_event_t *ev) {
+    ev->timeout(ev->target);
+}
+
+void host_netif_clear(void) {
+    wifi_netif.input = base_input;
+    wifi_netif.linkoutput = base_linkoutput;
+    wifi_netif.state = NULL;
+}
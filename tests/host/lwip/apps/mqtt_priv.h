@@ -0,0 +1,69 @@
+#ifndef HOST_LWIP_APPS_MQTT_PRIV_H
+#define HOST_LWIP_APPS_MQTT_PRIV_H
+
+/* Estrutura do cliente com os mesmos campos do lwIP 2.x que o firmware acessa (anel de
+ * saída em RACK_MQTT_PERSISTENT_SESSION, armazenamento estático em RACK_HEAP_FREE), mais
+ * o estado do dublê no fim. */
+
+#include <stdbool.h>
+#include "lwip/apps/mqtt.h"
+
+struct tcp_pcb;
+
+struct mqtt_ringbuf_t {
+    u16_t put;
+    u16_t get;
+    u8_t buf[MQTT_OUTPUT_RINGBUF_SIZE];
+};
+
+struct mqtt_request_t {
+    struct mqtt_request_t *next;
+    mqtt_request_cb_t cb;
+    void *arg;
+    u16_t pkt_id;
+    u16_t timeout;
+    // Estado do dublê
+    bool used;
+    uint64_t deadline_us;
+};
+
+// Estado do dublê: zerado junto com o cliente em mqtt_client_connect()
+struct host_mqtt_client {
+    ip_addr_t broker;
+    u32_t gen;
+    u16_t ring_len;
+    u16_t tx_partial;        // bytes do pacote da frente já transmitidos
+    uint64_t tx_credit;      // crédito do enlace em milésimos de byte
+    bool awaiting_connack;   // CONNECT recebido por um broker HOST_BROKER_MANUAL
+    bool tx_stalled;         // pacote da frente perdido ou retido na netif: transmissão parada até a entrega
+    u8_t tx_attempts;
+    u32_t tx_seq;            // número do pacote aguardando entrega
+    u16_t tx_len;
+    u8_t tx_frame[MQTT_OUTPUT_RINGBUF_SIZE];   // cópia para retransmissão
+    bool clean_session;
+    char client_id[32];
+    char subscription[64];
+};
+
+struct mqtt_client_s {
+    u16_t cyclic_tick;
+    u16_t keep_alive;
+    u16_t server_watchdog;
+    u16_t pkt_id_seq;
+    u16_t inpub_pkt_id;
+    u8_t conn_state;
+    struct tcp_pcb *conn;
+    void *connect_arg;
+    mqtt_connection_cb_t connect_cb;
+    struct mqtt_request_t *pend_req_queue;
+    struct mqtt_request_t req_list[MQTT_REQ_MAX_IN_FLIGHT];
+    void *inpub_arg;
+    mqtt_incoming_data_cb_t data_cb;
+    mqtt_incoming_publish_cb_t pub_cb;
+    u32_t msg_idx;
+    u8_t rx_buffer[MQTT_VAR_HEADER_BUFFER_LEN];
+    struct mqtt_ringbuf_t output;
+    struct host_mqtt_client host;
+};
+
+#endif /* HOST_LWIP_APPS_MQTT_PRIV_H */
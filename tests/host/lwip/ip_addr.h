@@ -0,0 +1,14 @@
+#ifndef HOST_LWIP_IP_ADDR_H
+#define HOST_LWIP_IP_ADDR_H
+
+#include "lwip/arch.h"
+
+typedef struct {
+    u32_t addr;
+} ip_addr_t;
+
+// Endereço em ordem de rede, como no lwIP: "10.0.0.1" -> bytes 10,0,0,1
+char *ipaddr_ntoa(const ip_addr_t *addr);
+int ipaddr_aton(const char *text, ip_addr_t *addr);
+
+#endif /* HOST_LWIP_IP_ADDR_H */
@@ -0,0 +1,22 @@
+#ifndef HOST_LWIP_NETIF_H
+#define HOST_LWIP_NETIF_H
+
+#include "lwip/arch.h"
+#include "lwip/err.h"
+#include "lwip/pbuf.h"
+
+/* Só os ganchos de entrada e saída do enlace: o dublê da netif do Wi-Fi (host_netif.c) leva
+ * por eles o tráfego do cliente MQTT simulado, e a injeção de falhas os intercepta. */
+
+struct netif;
+
+typedef err_t (*netif_input_fn)(struct pbuf *p, struct netif *inp);
+typedef err_t (*netif_linkoutput_fn)(struct netif *netif, struct pbuf *p);
+
+struct netif {
+    netif_input_fn input;
+    netif_linkoutput_fn linkoutput;
+    void *state;
+};
+
+#endif /* HOST_LWIP_NETIF_H */
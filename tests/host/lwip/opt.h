@@ -0,0 +1,18 @@
+#ifndef HOST_LWIP_OPT_H
+#define HOST_LWIP_OPT_H
+
+// As opções vêm do lwipopts.h do firmware, como no build real
+#include "lwipopts.h"
+#include "lwip/arch.h"
+
+#ifndef TCP_MSS
+#define TCP_MSS 536
+#endif
+#ifndef TCP_SND_BUF
+#define TCP_SND_BUF (2 * TCP_MSS)
+#endif
+#ifndef TCP_SND_QUEUELEN
+#define TCP_SND_QUEUELEN ((4 * (TCP_SND_BUF) + (TCP_MSS - 1)) / (TCP_MSS))
+#endif
+
+#endif /* HOST_LWIP_OPT_H */
@@ -0,0 +1,35 @@
+#ifndef HOST_LWIP_PBUF_H
+#define HOST_LWIP_PBUF_H
+
+#include "lwip/arch.h"
+#include "lwip/err.h"
+
+typedef enum {
+    PBUF_TRANSPORT,
+    PBUF_IP,
+    PBUF_LINK,
+    PBUF_RAW,
+} pbuf_layer;
+
+typedef enum {
+    PBUF_RAM,
+    PBUF_ROM,
+    PBUF_REF,
+    PBUF_POOL,
+} pbuf_type;
+
+struct pbuf {
+    struct pbuf *next;
+    void *payload;
+    u16_t tot_len;
+    u16_t len;
+    // Estado do dublê: chamado se o quadro for liberado sem ter sido entregue (host_netif.c)
+    void (*host_lost)(struct pbuf *p);
+};
+
+// Sempre um único segmento, alocado na libc
+struct pbuf *pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type);
+err_t pbuf_copy(struct pbuf *p_to, const struct pbuf *p_from);
+u8_t pbuf_free(struct pbuf *p);
+
+#endif /* HOST_LWIP_PBUF_H */
@@ -0,0 +1,11 @@
+#ifndef HOST_LWIP_SYS_H
+#define HOST_LWIP_SYS_H
+
+#include "lwip/arch.h"
+#include "host_mock.h"
+
+static inline u32_t sys_now(void) {
+    return (u32_t)(host_clock_us() / 1000u);
+}
+
+#endif /* HOST_LWIP_SYS_H */
@@ -0,0 +1,61 @@
+#ifndef HOST_LWIP_TCP_H
+#define HOST_LWIP_TCP_H
+
+/* TCP raw simulado: cada pcb tem um buffer de envio de TCP_SND_BUF bytes esvaziado pelo
+ * enlace virtual (host_mock.h); a conexão só se completa quando o teste a aceita. */
+
+#include <stdbool.h>
+#include "lwip/opt.h"
+#include "lwip/err.h"
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+
+struct tcp_pcb;
+
+typedef err_t (*tcp_connected_fn)(void *arg, struct tcp_pcb *tpcb, err_t err);
+typedef err_t (*tcp_recv_fn)(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err);
+typedef err_t (*tcp_sent_fn)(void *arg, struct tcp_pcb *tpcb, u16_t len);
+typedef err_t (*tcp_poll_fn)(void *arg, struct tcp_pcb *tpcb);
+typedef void (*tcp_err_fn)(void *arg, err_t err);
+
+#define TCP_WRITE_FLAG_COPY 0x01
+#define TCP_WRITE_FLAG_MORE 0x02
+
+struct tcp_pcb {
+    bool used;
+    bool connected;
+    void *arg;
+    tcp_connected_fn connected_fn;
+    tcp_recv_fn recv_fn;
+    tcp_poll_fn poll_fn;
+    u8_t poll_interval;
+    tcp_err_fn err_fn;
+    u16_t snd_queued;       // bytes escritos e ainda não transmitidos pelo enlace
+    u16_t snd_segments;
+    u32_t bytes_written;
+    // Estado do dublê
+    bool connecting;        // SYN_SENT: aceita tcp_write, que só sai depois de conectar
+    tcp_sent_fn sent_fn;
+    ip_addr_t remote_ip;
+    u32_t gen;
+    uint64_t next_poll_us;
+    uint64_t tx_credit;     // crédito do enlace em milésimos de byte
+};
+
+struct tcp_pcb *tcp_new(void);
+void tcp_arg(struct tcp_pcb *pcb, void *arg);
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn err);
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn recv);
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn sent);
+void tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn poll, u8_t interval);
+err_t tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port, tcp_connected_fn connected);
+err_t tcp_write(struct tcp_pcb *pcb, const void *data, u16_t len, u8_t apiflags);
+err_t tcp_output(struct tcp_pcb *pcb);
+void tcp_recved(struct tcp_pcb *pcb, u16_t len);
+err_t tcp_close(struct tcp_pcb *pcb);
+void tcp_abort(struct tcp_pcb *pcb);
+
+#define tcp_sndbuf(pcb)      ((u16_t)(TCP_SND_BUF - (pcb)->snd_queued))
+#define tcp_sndqueuelen(pcb) ((pcb)->snd_segments)
+
+#endif /* HOST_LWIP_TCP_H */
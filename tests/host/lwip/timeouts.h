@@ -0,0 +1,11 @@
+#ifndef HOST_LWIP_TIMEOUTS_H
+#define HOST_LWIP_TIMEOUTS_H
+
+#include "lwip/arch.h"
+
+// Temporizador de disparo único no relógio virtual (contexto lwIP, como os eventos de rede)
+typedef void (*sys_timeout_handler)(void *arg);
+
+void sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg);
+
+#endif /* HOST_LWIP_TIMEOUTS_H */
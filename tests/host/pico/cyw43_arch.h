@@ -0,0 +1,17 @@
+#ifndef HOST_PICO_CYW43_ARCH_H
+#define HOST_PICO_CYW43_ARCH_H
+
+/* Trava do lwIP no host: sem contexto de IRQ real, apenas conta a profundidade para
+ * os testes verificarem que toda entrada tem saída (host_lwip_lock_depth()). */
+
+#include "host_mock.h"
+
+static inline void cyw43_arch_lwip_begin(void) {
+    host_lwip_lock(true);
+}
+
+static inline void cyw43_arch_lwip_end(void) {
+    host_lwip_lock(false);
+}
+
+#endif /* HOST_PICO_CYW43_ARCH_H */
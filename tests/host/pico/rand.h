@@ -0,0 +1,12 @@
+#ifndef HOST_PICO_RAND_H
+#define HOST_PICO_RAND_H
+
+#include <stdint.h>
+#include "host_mock.h"
+
+// Sequência determinística por semente (host_rand_seed) para simulações reproduzíveis
+static inline uint32_t get_rand_32(void) {
+    return host_rand_32();
+}
+
+#endif /* HOST_PICO_RAND_H */
@@ -0,0 +1,54 @@
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+/* Subconjunto do pico/stdlib.h usado pelo firmware, sobre o relógio virtual do host
+ * (host_mock.h): o tempo só anda quando o teste avança o relógio ou chama sleep_ms(). */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "host_mock.h"
+
+typedef uint64_t absolute_time_t;
+
+static inline absolute_time_t get_absolute_time(void) {
+    return host_clock_us();
+}
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000u);
+}
+
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) {
+    return host_clock_us() + (uint64_t)ms * 1000u;
+}
+
+static inline bool time_reached(absolute_time_t t) {
+    return host_clock_us() >= t;
+}
+
+static inline uint32_t time_us_32(void) {
+    return (uint32_t)host_clock_us();
+}
+
+static inline uint64_t time_us_64(void) {
+    return host_clock_us();
+}
+
+static inline void sleep_ms(uint32_t ms) {
+    host_clock_advance_ms(ms);
+}
+
+// Sem interrupções no host: só confere o pareamento
+static inline uint32_t save_and_disable_interrupts(void) {
+    return host_irq_disable();
+}
+
+static inline void restore_interrupts(uint32_t state) {
+    host_irq_restore(state);
+}
+
+#define panic host_panic
+
+#endif /* HOST_PICO_STDLIB_H */
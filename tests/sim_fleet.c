@@ -0,0 +1,205 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Simulador de frota
+/ Descrição: Curva de CONNECT por segundo no broker quando a energia de um site volta e todos os racks iniciam juntos,
+/            comparando o boot antigo (só o sleep fixo de 2 s) com o atual (fatia do rack + jitter, fleet_slot).
+/ Obs: Uso: sim_fleet [racks] [capacidade do broker em CONNECT/s] [semente]. Cada rack roda o mqtt_link real sobre os
+/      dublês, um por vez, no mesmo relógio virtual a partir do instante da volta da energia; o broker compartilhado
+/      aceita até `capacidade` CONNECT por segundo e recusa o resto (servidor indisponível), e o rack recusado segue o
+/      próprio backoff. Rodar em sequência não muda a curva: a contagem de aceitos e recusados em cada segundo só
+/      depende de quantos CONNECT chegaram nele, e os racks recusados seguem todos a mesma política.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdlib.h>
+#include "test_harness.h"
+#include "mqtt_link.h"
+#include "broker_list.h"
+#include "fleet_slot.h"
+#include "lwip/apps/mqtt_priv.h"
+
+#define BROKER_IP     "10.0.0.1"
+#define HORIZON_S     300
+#define BOOT_SLEEP_MS 2000   // sleep_ms() fixo do início de main()
+
+// Associação ao Wi-Fi + DHCP depois do boot: de 1 a 3 s, conforme o AP e o sinal
+#define WIFI_MIN_MS    1000
+#define WIFI_SPREAD_MS 2000
+
+typedef enum {
+    BOOT_FIXED,    // antes: todos saem do sleep de 2 s juntos
+    BOOT_SLOTTED,  // agora: + fatia do rack na janela de boot + jitter
+} boot_policy_t;
+
+typedef struct {
+    const char *name;
+    uint32_t attempts[HORIZON_S];   // CONNECT recebidos pelo broker em cada segundo
+    uint32_t first[HORIZON_S];      // dos quais primeira tentativa do rack (sem as repetições após recusa)
+    uint32_t accepted[HORIZON_S];
+    uint32_t connected_ms[4096];    // instante do CONNACK aceito de cada rack
+    uint32_t racks;
+    uint32_t refused;
+    uint32_t never;                 // racks sem sessão ao fim do horizonte
+} fleet_run_t;
+
+static uint32_t racks = 200;
+static uint32_t capacity = 20;
+static uint32_t seed = 1;
+
+static uint32_t now_ms(void) {
+    return (uint32_t)(host_clock_us() / 1000u);
+}
+
+static void session_up(uint32_t at_ms) {
+}
+
+static void session_down(void) {
+}
+
+static void boot_rack(fleet_run_t *run, boot_policy_t policy, int rack) {
+    host_reset();
+    host_rand_seed(seed * 7919u + (uint32_t)rack);
+    host_dns_add("broker.test", BROKER_IP);
+    host_broker_set(BROKER_IP, HOST_BROKER_MANUAL);
+
+    // Mesma sequência de main(): sleep fixo, atraso da frota, Wi-Fi e só então o MQTT
+    fleet_slot_init(rack);
+    uint32_t boot_ms = BOOT_SLEEP_MS;
+    if (policy == BOOT_SLOTTED) {
+        boot_ms += fleet_slot_offset_ms(FLEET_BOOT_WINDOW_MS) + fleet_jitter_ms(FLEET_BOOT_JITTER_MS);
+    }
+    boot_ms += WIFI_MIN_MS + host_rand_32() % WIFI_SPREAD_MS;
+    host_clock_advance_ms(boot_ms);
+
+    mqtt_link_init();
+    mqtt_link_set_session_callbacks(session_up, session_down);
+
+    bool first = true;
+    while (!mqtt_link_is_connected() && now_ms() < HORIZON_S * 1000u) {
+        mqtt_link_tick(now_ms());
+        mqtt_client_t *client = mqtt_link_client();
+        if (client->host.awaiting_connack) {
+            uint32_t second = now_ms() / 1000u;
+            run->attempts[second]++;
+            run->first[second] += first;
+            first = false;
+            if (run->accepted[second] < capacity) {
+                run->accepted[second]++;
+                host_mqtt_accept(client);
+                run->connected_ms[run->racks] = now_ms();
+            } else {
+                run->refused++;
+                host_mqtt_refuse(client, MQTT_CONNECT_REFUSED_SERVER);
+            }
+        }
+        host_clock_advance_ms(10);
+    }
+    if (!mqtt_link_is_connected()) {
+        run->never++;
+        run->connected_ms[run->racks] = HORIZON_S * 1000u;
+    }
+    run->racks++;
+}
+
+static void run_fleet(fleet_run_t *run, boot_policy_t policy) {
+    for (uint32_t rack = 1; rack <= racks; rack++) {
+        boot_rack(run, policy, (int)rack);
+    }
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint32_t peak(const uint32_t *per_second) {
+    uint32_t max = 0;
+    for (size_t s = 0; s < HORIZON_S; s++) {
+        max = per_second[s] > max ? per_second[s] : max;
+    }
+    return max;
+}
+
+static size_t last_second(const fleet_run_t *run) {
+    size_t last = 0;
+    for (size_t s = 0; s < HORIZON_S; s++) {
+        if (run->attempts[s] > 0) {
+            last = s;
+        }
+    }
+    return last;
+}
+
+static void print_bar(uint32_t count, uint32_t scale) {
+    char bar[41];
+    size_t len = scale > 0 ? (count * 40u + scale - 1) / scale : 0;
+    memset(bar, '#', len);
+    bar[len] = '\0';
+    printf(" %-40s", bar);
+}
+
+static void report(const fleet_run_t *old_run, const fleet_run_t *new_run) {
+    size_t last = last_second(old_run) > last_second(new_run) ? last_second(old_run) : last_second(new_run);
+    uint32_t scale = peak(old_run->attempts) > peak(new_run->attempts) ? peak(old_run->attempts) : peak(new_run->attempts);
+
+    printf("%u racks religados juntos, broker aceita %u CONNECT/s, semente %u\n", (unsigned)racks,
+           (unsigned)capacity, (unsigned)seed);
+    printf("CONNECT recebidos por segundo desde a volta da energia (aceitos); o que passa de %u/s é recusado e\n"
+           "volta pelo backoff do rack\n", (unsigned)capacity);
+    printf("%4s %11s %-40s %11s %-40s\n", "s", old_run->name, "", new_run->name, "");
+    for (size_t s = 0; s <= last; s++) {
+        if (old_run->attempts[s] == 0 && new_run->attempts[s] == 0) {
+            continue;
+        }
+        printf("%4zu %5u (%3u)", s, (unsigned)old_run->attempts[s], (unsigned)old_run->accepted[s]);
+        print_bar(old_run->attempts[s], scale);
+        printf(" %5u (%3u)", (unsigned)new_run->attempts[s], (unsigned)new_run->accepted[s]);
+        print_bar(new_run->attempts[s], scale);
+        printf("\n");
+    }
+
+    printf("\n%-12s %10s %12s %10s %10s %10s %10s %8s\n", "boot", "pico/s", "1ª tent./s", "recusas", "p50 (s)",
+           "p95 (s)", "todos (s)", "sem sessão");
+    const fleet_run_t *runs[] = { old_run, new_run };
+    for (size_t i = 0; i < 2; i++) {
+        static uint32_t sorted[4096];
+        memcpy(sorted, runs[i]->connected_ms, runs[i]->racks * sizeof(uint32_t));
+        qsort(sorted, runs[i]->racks, sizeof(uint32_t), compare_u32);
+        printf("%-12s %10u %12u %10u %10.1f %10.1f %10.1f %8u\n", runs[i]->name, (unsigned)peak(runs[i]->attempts),
+               (unsigned)peak(runs[i]->first), (unsigned)runs[i]->refused, sorted[runs[i]->racks / 2] / 1000.0,
+               sorted[runs[i]->racks * 95 / 100] / 1000.0, sorted[runs[i]->racks - 1] / 1000.0,
+               (unsigned)runs[i]->never);
+    }
+}
+
+static void sim_boot_storm(void) {
+    static fleet_run_t old_run = { .name = "sleep 2 s" };
+    static fleet_run_t new_run = { .name = "fatia+jitter" };
+    run_fleet(&old_run, BOOT_FIXED);
+    run_fleet(&new_run, BOOT_SLOTTED);
+    report(&old_run, &new_run);
+
+    CHECK_EQ(old_run.never, 0);
+    CHECK_EQ(new_run.never, 0);
+    // Com a frota espalhada pela janela de boot o pico cai e o broker recusa menos
+    CHECK(peak(new_run.attempts) < peak(old_run.attempts));
+    CHECK(old_run.refused == 0 ? new_run.refused == 0 : new_run.refused < old_run.refused);
+    // As primeiras tentativas se espalham pela janela de boot mais o espalhamento do Wi-Fi
+    CHECK(peak(new_run.first) <= 2 * racks * 1000u / (FLEET_BOOT_WINDOW_MS + WIFI_SPREAD_MS) + 5);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        racks = (uint32_t)strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        capacity = (uint32_t)strtoul(argv[2], NULL, 10);
+    }
+    if (argc > 3) {
+        seed = (uint32_t)strtoul(argv[3], NULL, 10);
+    }
+    if (racks == 0 || racks > 4096 || capacity == 0) {
+        fprintf(stderr, "uso: sim_fleet [racks (1..4096)] [CONNECT/s] [semente]\n");
+        return 2;
+    }
+    RUN_TEST(sim_boot_storm);
+    return test_report();
+}
@@ -0,0 +1,622 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Soak no host
+/ Descrição: Semanas de operação do rack em relógio virtual: o loop principal do firmware (porta, temperatura, agregados,
+/            GPS, métricas, fila de saída e conexão MQTT com failover) roda sobre os dublês do lwIP com quedas de broker
+/            e ruído de sensor sorteados, e falha se memória, filas ou contagens crescerem sem limite.
+/ Obs: Uso: soak_rack [dias] [semente]. Acima de 49,7 dias o relógio de 32 bits em ms do firmware dá a volta.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdlib.h>
+#include <math.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#include "test_harness.h"
+#include "outbox.h"
+#include "rate_limit.h"
+#include "mqtt_link.h"
+#include "broker_list.h"
+#include "fleet_slot.h"
+#include "sensor_health.h"
+#include "flap_detector.h"
+#include "aggregator.h"
+#include "history.h"
+#include "drift_monitor.h"
+
+#define PRIMARY_IP   "10.0.0.1"
+#define SECONDARY_IP "10.0.0.2"
+#define SOAK_EPOCH   1767225600u   // 2026-01-01 00:00 UTC
+
+// Mesmos períodos e limites do loop principal (rack_inteligente.c)
+#define MAIN_LOOP_PERIOD_MS      1000
+#define OUTBOX_DRAIN_INTERVAL_MS 50
+#define METRICS_INTERVAL_MS      60000
+#define GPS_INTERVAL_MS          10000
+#define TEMPERATURE_ALARM            45.0f
+#define TEMPERATURE_ALARM_HYSTERESIS 2.0f
+
+// Perfil das falhas sorteadas
+#define OUTAGE_GAP_MIN_MS       (30u * 60u * 1000u)
+#define OUTAGE_GAP_MAX_MS       (24u * 60u * 60u * 1000u)
+#define OUTAGE_DURATION_MIN_MS  (30u * 1000u)
+#define OUTAGE_DURATION_MAX_MS  (3u * 60u * 60u * 1000u)
+#define DOOR_OPEN_MEAN_S        (3u * 60u * 60u)
+#define DOOR_FLAP_MEAN_S        (2u * 24u * 60u * 60u)
+#define NOISE_EPISODE_MEAN_S    (3u * 24u * 60u * 60u)
+#define HEAT_EPISODE_MEAN_S     (5u * 24u * 60u * 60u)
+
+// Critérios de aprovação
+#define RECOVERY_MAX_MS       (10u * 60u * 1000u)   // fim da queda até fila e mensagens em voo vazias
+#define STEADY_DEPTH_MAX      4
+#define STEADY_POOL_MAX       8
+#define DAILY_GROWTH_PERCENT  150                    // mensagens por dia na 2ª metade x máximo da 1ª metade
+
+typedef enum {
+    OUTAGE_PRIMARY_DOWN,   // primário recusa conexões: failover para o secundário
+    OUTAGE_ALL_DOWN,       // os dois brokers fora: backlog e descartes
+    OUTAGE_SILENT,         // primário some da rede (SYN perdido): tempo esgotado na tentativa
+    OUTAGE_NO_ACK,         // sessão ativa, mas sem PUBACK: QoS 1 expira e é retransmitida
+    OUTAGE_RESTART,        // reinício do broker: queda instantânea da sessão
+    OUTAGE_KIND_COUNT
+} outage_kind_t;
+
+static const char *const outage_names[OUTAGE_KIND_COUNT] = {
+    "primário fora", "todos fora", "primário mudo", "sem PUBACK", "reinício",
+};
+
+// Medidores amostrados a cada hora
+typedef enum {
+    GAUGE_DEPTH,
+    GAUGE_INFLIGHT,
+    GAUGE_POOL,
+    GAUGE_REQUESTS,
+    GAUGE_RING,
+    GAUGE_PCBS,
+    GAUGE_HEAP,
+    GAUGE_COUNT
+} gauge_t;
+
+static const char *const gauge_names[GAUGE_COUNT] = {
+    "fila", "em voo", "pool", "requisições MQTT", "anel MQTT", "pcbs TCP", "heap (bytes)",
+};
+
+typedef struct {
+    uint32_t enqueued;
+    uint32_t sent;
+    uint32_t dropped;
+    uint32_t outages;
+    uint32_t connected_s;
+    uint32_t depth_max;
+    uint32_t pool_max;
+} day_stats_t;
+
+static uint32_t soak_days = 21;
+static uint32_t soak_seed = 1;
+
+static bool door_open = false;
+static uint64_t door_toggle_us = 0;
+static uint64_t flap_until_us = 0;
+static uint64_t noise_until_us = 0;
+static uint64_t heat_until_us = 0;
+static bool temperature_alarm = false;
+static float last_temperature = NAN;
+
+static sensor_health_t temperature_health;
+static flap_detector_t door_flap;
+static aggregator_t hourly_agg;
+static aggregator_t daily_agg;
+
+static bool outage_active = false;
+static outage_kind_t outage_kind;
+static uint64_t outage_next_us = 0;
+static uint64_t outage_end_us = 0;
+static uint64_t recovery_start_us = 0;
+static bool recovering = false;
+static uint32_t recovery_max_ms = 0;
+static uint32_t outage_counts[OUTAGE_KIND_COUNT];
+
+static uint64_t connected_since_us = 0;
+static uint64_t last_disturbance_us = 0;
+
+static uint32_t steady_first[GAUGE_COUNT];
+static uint32_t steady_second[GAUGE_COUNT];
+static uint32_t steady_samples = 0;
+static uint32_t accounting_errors = 0;
+static day_stats_t *days;
+
+// ---- Sorteios ----
+
+static uint32_t rand_range(uint32_t min, uint32_t max) {
+    return min + host_rand_32() % (max - min + 1);
+}
+
+// Evento de Poisson com média de mean_s segundos, avaliado uma vez por ciclo de 1 s
+static bool rand_chance(uint32_t mean_s) {
+    return host_rand_32() % mean_s == 0;
+}
+
+// Aproximação de normal (soma de 4 uniformes) com desvio `sigma`
+static float rand_noise(float sigma) {
+    float sum = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        sum += (float)(host_rand_32() & 0xFFFF) / 65535.0f;
+    }
+    return (sum - 2.0f) * sigma * 1.732f;
+}
+
+static uint32_t now_ms(void) {
+    return (uint32_t)(host_clock_us() / 1000u);
+}
+
+static uint32_t heap_in_use(void) {
+#if defined(__GLIBC__)
+    return (uint32_t)mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+// ---- Produtores (mesmos canais, prioridades e QoS do firmware) ----
+
+static void publish_door_state(bool open) {
+    const char *message = open ? "ON" : "OFF";
+    outbox_publish(TELEMETRY_CH_DOOR, TELEMETRY_PRIO_ALARM, "rack_inteligente/00007/door", message, strlen(message), 1, 0);
+}
+
+static void publish_door_flapping(bool entered, bool flapping, uint32_t transitions) {
+    char message[64];
+    snprintf(message, sizeof(message), "{\"flapping\":%s,\"transitions\":%u,\"state\":\"%s\"}",
+             flapping ? "true" : "false", (unsigned)transitions, door_open ? "ON" : "OFF");
+    outbox_publish(TELEMETRY_CH_DOOR, TELEMETRY_PRIO_STATE, "rack_inteligente/00007/door/flapping", message, strlen(message), 1, 0);
+    if (entered) {
+        outbox_publish(TELEMETRY_CH_DOOR, TELEMETRY_PRIO_ALARM, "rack_inteligente/00007/door", "FLAPPING", 8, 1, 0);
+    }
+}
+
+static void publish_sensor_health(void) {
+    uint8_t new_faults, cleared;
+    if (!sensor_health_take_change(&temperature_health, &new_faults, &cleared)) {
+        return;
+    }
+    char quality[32];
+    sensor_health_describe(temperature_health.flags, quality, sizeof(quality));
+    outbox_publish(TELEMETRY_CH_SENSOR, TELEMETRY_PRIO_STATE, "rack_inteligente/00007/temperature/quality",
+                   quality, strlen(quality), 1, 1);
+
+    char message[96];
+    snprintf(message, sizeof(message), "{\"sensor\":\"temperature\",\"faults\":%u,\"cleared\":%u,\"quality\":\"%s\"}",
+             new_faults, cleared, quality);
+    outbox_publish(TELEMETRY_CH_SENSOR, new_faults ? TELEMETRY_PRIO_ALARM : TELEMETRY_PRIO_STATE,
+                   "rack_inteligente/00007/sensor_fault", message, strlen(message), 1, 0);
+}
+
+static void publish_temperature(float temperature, uint8_t quality) {
+    char quality_text[32];
+    sensor_health_describe(quality, quality_text, sizeof(quality_text));
+    char message[64];
+    snprintf(message, sizeof(message), "{\"value\":%.2f,\"quality\":\"%s\"}", temperature, quality_text);
+    outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_TELEMETRY, "rack_inteligente/00007/temperature",
+                   message, strlen(message), 0, 0);
+}
+
+static void publish_temperature_alarm(bool active, float temperature) {
+    char message[48];
+    snprintf(message, sizeof(message), "{\"alarm\":%s,\"temperature\":%.2f}", active ? "true" : "false", temperature);
+    outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_ALARM, "rack_inteligente/00007/temperature/alarm",
+                   message, strlen(message), 1, 1);
+}
+
+static void publish_summary(const char *name, const agg_summary_t *summary) {
+    char topic[50];
+    snprintf(topic, sizeof(topic), "rack_inteligente/00007/summary/%s", name);
+    char message[OUTBOX_PRODUCER_MAX];
+    snprintf(message, sizeof(message), "{\"ts\":%u,\"p\":%u,\"min\":%.2f,\"max\":%.2f,\"avg\":%.2f,\"n\":%u,\"door_min\":%.1f,\"opens\":%u%s}",
+             (unsigned)summary->start, (unsigned)summary->period_s, summary->temp_min, summary->temp_max, summary->temp_avg,
+             (unsigned)summary->temp_count, summary->door_open_ms / 60000.0f, (unsigned)summary->door_openings,
+             summary->partial ? ",\"partial\":true" : "");
+    outbox_publish(TELEMETRY_CH_SUMMARY, TELEMETRY_PRIO_STATE, topic, message, strlen(message), 1, 0);
+}
+
+static void publish_gps(void) {
+    outbox_publish(TELEMETRY_CH_GPS, TELEMETRY_PRIO_TELEMETRY, "rack_inteligente/00007/gps/latitude", "-3.7319", 7, 0, 0);
+    outbox_publish(TELEMETRY_CH_GPS, TELEMETRY_PRIO_TELEMETRY, "rack_inteligente/00007/gps/longitude", "-38.5267", 8, 0, 0);
+}
+
+static void publish_metrics(void) {
+    if (!mqtt_link_is_connected()) {
+        return;
+    }
+    outbox_stats_t stats;
+    outbox_get_stats(&stats);
+    char message[OUTBOX_PRODUCER_MAX];
+    snprintf(message, sizeof(message), "{\"depth\":%u,\"peak\":%u,\"sent\":%u,\"dropped\":%u,\"retx\":%u,\"reconnects\":%u}",
+             (unsigned)stats.depth, (unsigned)stats.peak_depth, (unsigned)stats.sent, (unsigned)stats.dropped,
+             (unsigned)stats.retransmits, (unsigned)mqtt_link_reconnects());
+    outbox_publish(TELEMETRY_CH_METRICS, TELEMETRY_PRIO_BULK, "rack_inteligente/00007/metrics/outbox", message, strlen(message), 0, 0);
+}
+
+// ---- Ambiente simulado ----
+
+static float read_temperature(uint64_t now_us) {
+    double day_fraction = (double)(now_us % (86400ull * 1000000ull)) / (86400.0 * 1000000.0);
+    float value = 24.0f + 3.0f * (float)sin(2.0 * M_PI * day_fraction) + rand_noise(0.05f);
+
+    if (now_us < heat_until_us) {
+        value += 24.0f;   // falha de refrigeração: passa do limite de alarme
+    } else if (rand_chance(HEAT_EPISODE_MEAN_S)) {
+        heat_until_us = now_us + rand_range(10, 40) * 60000000ull;
+    }
+    if (now_us < noise_until_us) {
+        // Mau contato no sensor: leituras perdidas e picos
+        if (host_rand_32() % 20 == 0) {
+            return NAN;
+        }
+        value += rand_noise(6.0f);
+    } else if (rand_chance(NOISE_EPISODE_MEAN_S)) {
+        noise_until_us = now_us + rand_range(10, 30) * 60000000ull;
+    }
+    return roundf(value * 100.0f) / 100.0f;
+}
+
+static bool read_door(uint64_t now_us) {
+    if (now_us < flap_until_us) {
+        if (now_us >= door_toggle_us) {
+            door_toggle_us = now_us + rand_range(1, 3) * 1000000ull;
+            return !door_open;
+        }
+        return door_open;
+    }
+    if (rand_chance(DOOR_FLAP_MEAN_S)) {
+        flap_until_us = now_us + rand_range(1, 5) * 60000000ull;
+        door_toggle_us = now_us;
+        return door_open;
+    }
+    if (door_open) {
+        return now_us < door_toggle_us;
+    }
+    if (rand_chance(DOOR_OPEN_MEAN_S)) {
+        door_toggle_us = now_us + rand_range(60, 20 * 60) * 1000000ull;
+        return true;
+    }
+    return false;
+}
+
+static void outage_start(uint64_t now_us) {
+    outage_kind = (outage_kind_t)(host_rand_32() % OUTAGE_KIND_COUNT);
+    outage_active = true;
+    outage_end_us = now_us + (outage_kind == OUTAGE_RESTART ? 0 : rand_range(OUTAGE_DURATION_MIN_MS, OUTAGE_DURATION_MAX_MS) * 1000ull);
+    outage_counts[outage_kind]++;
+    days[now_us / 86400000000ull].outages++;
+
+    bool on_primary = broker_list_current_index() == 0;
+    bool drop = mqtt_link_is_connected();
+    switch (outage_kind) {
+        case OUTAGE_PRIMARY_DOWN:
+            host_broker_set(PRIMARY_IP, HOST_BROKER_DOWN);
+            drop = drop && on_primary;
+            break;
+        case OUTAGE_ALL_DOWN:
+            host_broker_set(PRIMARY_IP, HOST_BROKER_DOWN);
+            host_broker_set(SECONDARY_IP, HOST_BROKER_DOWN);
+            break;
+        case OUTAGE_SILENT:
+            host_broker_set(PRIMARY_IP, HOST_BROKER_SILENT);
+            drop = drop && on_primary;
+            break;
+        case OUTAGE_NO_ACK:
+            host_broker_set(PRIMARY_IP, HOST_BROKER_NO_ACK);
+            host_broker_set(SECONDARY_IP, HOST_BROKER_NO_ACK);
+            drop = false;
+            break;
+        default:
+            break;
+    }
+    if (drop) {
+        host_mqtt_drop(mqtt_link_client());
+    }
+}
+
+static void outage_end(uint64_t now_us) {
+    host_broker_set(PRIMARY_IP, HOST_BROKER_UP);
+    host_broker_set(SECONDARY_IP, HOST_BROKER_UP);
+    outage_active = false;
+    outage_next_us = now_us + rand_range(OUTAGE_GAP_MIN_MS, OUTAGE_GAP_MAX_MS) * 1000ull;
+    recovering = true;
+    recovery_start_us = now_us;
+}
+
+static void outage_tick(uint64_t now_us) {
+    if (!outage_active && now_us >= outage_next_us) {
+        outage_start(now_us);
+    }
+    if (outage_active && now_us >= outage_end_us) {
+        outage_end(now_us);
+    }
+    if (outage_active || recovering) {
+        last_disturbance_us = now_us;
+    }
+}
+
+// ---- Amostragem ----
+
+static void check_recovery(uint64_t now_us) {
+    if (!recovering) {
+        return;
+    }
+    outbox_stats_t stats;
+    outbox_get_stats(&stats);
+    if (mqtt_link_is_connected() && stats.depth == 0 && stats.inflight == 0) {
+        uint32_t elapsed_ms = (uint32_t)((now_us - recovery_start_us) / 1000u);
+        if (elapsed_ms > recovery_max_ms) {
+            recovery_max_ms = elapsed_ms;
+        }
+        recovering = false;
+    }
+}
+
+static void sample_gauges(uint64_t now_us, uint32_t values[GAUGE_COUNT]) {
+    outbox_stats_t stats;
+    outbox_get_stats(&stats);
+    mqtt_client_t *client = mqtt_link_client();
+    values[GAUGE_DEPTH] = stats.depth;
+    values[GAUGE_INFLIGHT] = stats.inflight;
+    values[GAUGE_POOL] = outbox_pool()->in_use;
+    values[GAUGE_REQUESTS] = host_mqtt_requests_used(client);
+    values[GAUGE_RING] = host_mqtt_ring_used(client);
+    values[GAUGE_PCBS] = host_tcp_pcbs_used();
+    values[GAUGE_HEAP] = heap_in_use();
+
+    // Todo bloco ocupado do pool está na fila ou em voo
+    if (values[GAUGE_POOL] != stats.depth + stats.inflight) {
+        accounting_errors++;
+    }
+
+    uint32_t drift[DRIFT_GAUGE_COUNT] = {
+        [DRIFT_OUTBOX_DEPTH] = stats.depth,
+        [DRIFT_POOL_IN_USE]  = values[GAUGE_POOL],
+        [DRIFT_LATE_ALLOCS]  = values[GAUGE_HEAP],
+    };
+    drift_monitor_sample(now_ms(), drift);
+
+    /* Regime: conectado e sem perturbação há uma hora. Só essas amostras entram na comparação
+     * entre as metades do soak; o primeiro dia é aquecimento (buffers da libc, primeiras sessões) */
+    bool steady = mqtt_link_is_connected() && now_us - connected_since_us >= 3600000000ull &&
+                  now_us - last_disturbance_us >= 3600000000ull;
+    uint64_t day = now_us / 86400000000ull;
+    if (steady && day >= 1) {
+        uint32_t *max = day < (soak_days + 1) / 2 ? steady_first : steady_second;
+        for (int gauge = 0; gauge < GAUGE_COUNT; gauge++) {
+            if (values[gauge] > max[gauge]) {
+                max[gauge] = values[gauge];
+            }
+        }
+        steady_samples++;
+    }
+}
+
+static void report_day(uint32_t day, uint32_t *last_enqueued, uint32_t *last_sent, uint32_t *last_dropped) {
+    outbox_stats_t stats;
+    outbox_get_stats(&stats);
+    day_stats_t *d = &days[day];
+    d->enqueued = stats.enqueued - *last_enqueued;
+    d->sent = stats.sent - *last_sent;
+    d->dropped = stats.dropped - *last_dropped;
+    *last_enqueued = stats.enqueued;
+    *last_sent = stats.sent;
+    *last_dropped = stats.dropped;
+    printf("dia %3u: quedas %u, conectado %5.1f%%, enfileiradas %6u, enviadas %6u, descartadas %5u, fila máx %2u, pool máx %2u, heap %u B\n",
+           (unsigned)day + 1, (unsigned)d->outages, d->connected_s / 864.0, (unsigned)d->enqueued, (unsigned)d->sent,
+           (unsigned)d->dropped, (unsigned)d->depth_max, (unsigned)d->pool_max, (unsigned)heap_in_use());
+}
+
+// ---- Loop principal ----
+
+static void main_cycle(uint64_t *next_gps_us, uint64_t *next_metrics_us) {
+    uint64_t cycle_deadline = host_clock_us() + MAIN_LOOP_PERIOD_MS * 1000u;
+    uint64_t now_us = host_clock_us();
+    uint32_t now = now_ms();
+
+    outage_tick(now_us);
+    mqtt_link_tick(now);
+    if (!mqtt_link_is_connected()) {
+        connected_since_us = now_us;
+    }
+
+    bool door = read_door(now_us);
+    if (door != door_open) {
+        switch (flap_detector_transition(&door_flap, now)) {
+            case FLAP_PASS:
+                publish_door_state(door);
+                break;
+            case FLAP_ENTERED:
+                publish_door_flapping(true, true, door_flap.threshold);
+                break;
+            case FLAP_SUPPRESSED:
+                break;
+        }
+        aggregator_set_door(&hourly_agg, door, now);
+        aggregator_set_door(&daily_agg, door, now);
+        door_open = door;
+    }
+    uint32_t door_transitions;
+    switch (flap_detector_tick(&door_flap, now, &door_transitions)) {
+        case FLAP_TICK_SUMMARY:
+            publish_door_flapping(false, true, door_transitions);
+            break;
+        case FLAP_TICK_EXITED:
+            publish_door_flapping(false, false, door_transitions);
+            publish_door_state(door_open);
+            break;
+        default:
+            break;
+    }
+
+    float temperature = read_temperature(now_us);
+    sensor_health_update(&temperature_health, temperature);
+    publish_sensor_health();
+    if (sensor_health_value_trusted(&temperature_health)) {
+        history_add(now, temperature);
+        if (!temperature_alarm && temperature >= TEMPERATURE_ALARM) {
+            temperature_alarm = true;
+            publish_temperature_alarm(true, temperature);
+        } else if (temperature_alarm && temperature < TEMPERATURE_ALARM - TEMPERATURE_ALARM_HYSTERESIS) {
+            temperature_alarm = false;
+            publish_temperature_alarm(false, temperature);
+        }
+        aggregator_add_temperature(&hourly_agg, temperature);
+        aggregator_add_temperature(&daily_agg, temperature);
+    } else {
+        history_gap();
+    }
+    if (sensor_health_value_usable(&temperature_health) && temperature != last_temperature) {
+        publish_temperature(temperature, temperature_health.flags);
+        last_temperature = temperature;
+    }
+
+    agg_summary_t summary;
+    uint32_t epoch_s = SOAK_EPOCH + (uint32_t)(now_us / 1000000u);
+    if (aggregator_tick(&hourly_agg, epoch_s, now, &summary)) {
+        publish_summary("hourly", &summary);
+    }
+    if (aggregator_tick(&daily_agg, epoch_s, now, &summary)) {
+        publish_summary("daily", &summary);
+    }
+
+    if (now_us >= *next_gps_us) {
+        publish_gps();
+        *next_gps_us = now_us + GPS_INTERVAL_MS * 1000ull;
+    }
+    if (now_us >= *next_metrics_us) {
+        publish_metrics();
+        *next_metrics_us = now_us + (METRICS_INTERVAL_MS + fleet_jitter_ms(FLEET_PUBLISH_JITTER_MS)) * 1000ull;
+    }
+
+    // Drenagem como no firmware: a cada 50 ms enquanto houver backlog, até o fim do ciclo
+    while (true) {
+        if (mqtt_link_is_connected()) {
+            outbox_drain(mqtt_link_client(), now_ms());
+        }
+        outbox_stats_t stats;
+        outbox_get_stats(&stats);
+        if (!mqtt_link_is_connected() || stats.depth == 0 ||
+            cycle_deadline - host_clock_us() < OUTBOX_DRAIN_INTERVAL_MS * 1000u) {
+            break;
+        }
+        host_clock_advance_ms(OUTBOX_DRAIN_INTERVAL_MS);
+    }
+    check_recovery(host_clock_us());
+    if (cycle_deadline > host_clock_us()) {
+        host_clock_advance_us(cycle_deadline - host_clock_us());
+    }
+}
+
+static void test_soak(void) {
+    days = calloc(soak_days, sizeof(day_stats_t));
+    host_rand_seed(soak_seed);
+    host_dns_add("broker.test", PRIMARY_IP);
+    host_dns_add("backup.test", SECONDARY_IP);
+
+    fleet_slot_init(7);
+    rate_limit_init(0);
+    outbox_init(SOAK_EPOCH);
+    mqtt_link_init();
+    broker_list_init("broker.test,backup.test", MQTT_BROKER_PORT);
+    mqtt_link_set_session_callbacks(outbox_session_started, outbox_session_lost);
+    mqtt_link_set_command_topic("rack_inteligente/00007/cmd");
+    sensor_health_init(&temperature_health, "temperature", -40.0f, 125.0f, 600, 4.0f);
+    flap_detector_init(&door_flap, 6, 30000, 60000, 60000);
+    aggregator_init(&hourly_agg, 3600);
+    aggregator_init(&daily_agg, 86400);
+    history_init();
+    drift_monitor_init(0);
+    outage_next_us = rand_range(OUTAGE_GAP_MIN_MS, OUTAGE_GAP_MAX_MS) * 1000ull;
+
+    uint64_t next_gps_us = GPS_INTERVAL_MS * 1000ull;
+    uint64_t next_metrics_us = (METRICS_INTERVAL_MS + fleet_slot_offset_ms(METRICS_INTERVAL_MS)) * 1000ull;
+    uint64_t next_sample_us = 3600000000ull;
+    uint32_t last_enqueued = 0, last_sent = 0, last_dropped = 0;
+    uint32_t drift_alerts = 0;
+    uint64_t end_us = soak_days * 86400000000ull;
+
+    while (host_clock_us() < end_us) {
+        main_cycle(&next_gps_us, &next_metrics_us);
+
+        uint64_t now_us = host_clock_us();
+        day_stats_t *d = &days[now_us / 86400000000ull < soak_days ? now_us / 86400000000ull : soak_days - 1];
+        outbox_stats_t stats;
+        outbox_get_stats(&stats);
+        d->connected_s += mqtt_link_is_connected();
+        d->depth_max = stats.depth > d->depth_max ? stats.depth : d->depth_max;
+        d->pool_max = outbox_pool()->in_use > d->pool_max ? outbox_pool()->in_use : d->pool_max;
+
+        if (now_us >= next_sample_us) {
+            uint32_t values[GAUGE_COUNT];
+            sample_gauges(now_us, values);
+            drift_alerts += drift_monitor_flags() != 0 && now_us - last_disturbance_us >= 6 * 3600000000ull;
+            uint64_t hour = next_sample_us / 3600000000ull;
+            next_sample_us += 3600000000ull;
+            if (hour % 24 == 0) {
+                report_day((uint32_t)(hour / 24) - 1, &last_enqueued, &last_sent, &last_dropped);
+            }
+        }
+    }
+
+    outbox_stats_t stats;
+    outbox_get_stats(&stats);
+    printf("\n%u dias (semente %u): %u mensagens enfileiradas, %u enviadas, %u descartadas, %u retransmitidas\n",
+           (unsigned)soak_days, (unsigned)soak_seed, (unsigned)stats.enqueued, (unsigned)stats.sent,
+           (unsigned)stats.dropped, (unsigned)stats.retransmits);
+    printf("quedas:");
+    for (int kind = 0; kind < OUTAGE_KIND_COUNT; kind++) {
+        printf(" %s %u%s", outage_names[kind], (unsigned)outage_counts[kind], kind + 1 < OUTAGE_KIND_COUNT ? "," : "\n");
+    }
+    printf("reconexões %u, failovers %u, recuperação máx %u ms, pico da fila %u, amostras em regime %u\n",
+           (unsigned)mqtt_link_reconnects(), (unsigned)broker_list_failovers(), (unsigned)recovery_max_ms,
+           (unsigned)stats.peak_depth, (unsigned)steady_samples);
+    printf("%-18s %12s %12s\n", "regime (máximo)", "1ª metade", "2ª metade");
+    for (int gauge = 0; gauge < GAUGE_COUNT; gauge++) {
+        printf("%-18s %12u %12u\n", gauge_names[gauge], (unsigned)steady_first[gauge], (unsigned)steady_second[gauge]);
+    }
+
+    // Nada cresce entre as metades: heap exato, filas e recursos do lwIP dentro do regime
+    CHECK(steady_samples > soak_days * 4);
+    for (int gauge = 0; gauge < GAUGE_COUNT; gauge++) {
+        if (gauge == GAUGE_HEAP) {
+            CHECK_EQ(steady_second[gauge], steady_first[gauge]);
+        } else {
+            CHECK(steady_second[gauge] <= steady_first[gauge] + 1);
+        }
+    }
+    CHECK(steady_second[GAUGE_DEPTH] <= STEADY_DEPTH_MAX);
+    CHECK(steady_second[GAUGE_POOL] <= STEADY_POOL_MAX);
+    CHECK(steady_second[GAUGE_PCBS] <= 1);
+    CHECK_EQ(accounting_errors, 0);
+    CHECK(recovery_max_ms <= RECOVERY_MAX_MS);
+    CHECK(!recovering || outage_active || host_clock_us() - recovery_start_us <= RECOVERY_MAX_MS * 1000ull);
+    CHECK_EQ(drift_alerts, 0);
+
+    // Volume diário estável: a segunda metade não passa da maior da primeira com folga
+    uint32_t first_max = 0;
+    for (uint32_t day = 1; day < (soak_days + 1) / 2; day++) {
+        first_max = days[day].enqueued > first_max ? days[day].enqueued : first_max;
+    }
+    for (uint32_t day = (soak_days + 1) / 2; day < soak_days; day++) {
+        CHECK(days[day].enqueued * 100u <= first_max * DAILY_GROWTH_PERCENT);
+    }
+    free(days);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        soak_days = (uint32_t)strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        soak_seed = (uint32_t)strtoul(argv[2], NULL, 10);
+    }
+    if (soak_days < 4) {
+        fprintf(stderr, "soak precisa de pelo menos 4 dias\n");
+        return 2;
+    }
+    RUN_TEST(test_soak);
+    return test_report();
+}
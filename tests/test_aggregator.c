@@ -0,0 +1,117 @@
+/* Testes do agregador: alinhamento ao relógio, estatísticas de temperatura e tempo de porta aberta. */
+#include "test_harness.h"
+#include "aggregator.h"
+
+#define HOUR_EPOCH 1700002800u   // múltiplo de 3600
+
+static void test_waits_for_synchronized_clock(void) {
+    aggregator_t agg;
+    agg_summary_t summary;
+    aggregator_init(&agg, 3600);
+    aggregator_add_temperature(&agg, 30.0f);
+    CHECK(!aggregator_tick(&agg, 0, 1000, &summary));
+    CHECK(!agg.open);
+    CHECK_EQ(agg.temp_count, 0);
+
+    // O primeiro tick sincronizado abre o balde da hora corrente sem publicar nada
+    CHECK(!aggregator_tick(&agg, HOUR_EPOCH + 1234, 2000, &summary));
+    CHECK(agg.open);
+    CHECK_EQ(agg.start, HOUR_EPOCH);
+    CHECK(agg.partial);
+}
+
+static void test_first_bucket_is_partial(void) {
+    aggregator_t agg;
+    agg_summary_t summary;
+    aggregator_init(&agg, 3600);
+    aggregator_tick(&agg, HOUR_EPOCH + 1234, 0, &summary);
+    aggregator_add_temperature(&agg, 25.0f);
+    CHECK(aggregator_tick(&agg, HOUR_EPOCH + 3600, 2366000, &summary));
+    CHECK_EQ(summary.start, HOUR_EPOCH);
+    CHECK(summary.partial);
+    CHECK_EQ(summary.temp_count, 1);
+
+    // O balde seguinte cobre a hora inteira
+    CHECK(aggregator_tick(&agg, HOUR_EPOCH + 7201, 5967000, &summary));
+    CHECK(!summary.partial);
+}
+
+static void test_clock_step_marks_partial(void) {
+    aggregator_t agg;
+    agg_summary_t summary;
+    aggregator_init(&agg, 3600);
+    aggregator_tick(&agg, HOUR_EPOCH, 0, &summary);
+
+    // O SNTP adianta o relógio duas horas e meia: o balde fechado e o novo ficam incompletos
+    CHECK(aggregator_tick(&agg, HOUR_EPOCH + 1000 + 9000, 1000000, &summary));
+    CHECK_EQ(summary.start, HOUR_EPOCH);
+    CHECK(summary.partial);
+    CHECK_EQ(agg.start, HOUR_EPOCH + 7200);
+    CHECK(aggregator_tick(&agg, HOUR_EPOCH + 10800, 1800000, &summary));
+    CHECK(summary.partial);
+    CHECK(aggregator_tick(&agg, HOUR_EPOCH + 14400, 5400000, &summary));
+    CHECK(!summary.partial);
+}
+
+static void test_hourly_summary(void) {
+    aggregator_t agg;
+    agg_summary_t summary;
+    aggregator_init(&agg, 3600);
+    aggregator_tick(&agg, HOUR_EPOCH, 0, &summary);
+    aggregator_add_temperature(&agg, 22.0f);
+    aggregator_add_temperature(&agg, 26.0f);
+    aggregator_add_temperature(&agg, 24.5f);
+    CHECK(!aggregator_tick(&agg, HOUR_EPOCH + 3599, 3599000, &summary));
+
+    CHECK(aggregator_tick(&agg, HOUR_EPOCH + 3600, 3600000, &summary));
+    CHECK_EQ(summary.start, HOUR_EPOCH);
+    CHECK_EQ(summary.period_s, 3600);
+    CHECK_EQ(summary.temp_count, 3);
+    CHECK_NEAR(summary.temp_min, 22.0, 1e-6);
+    CHECK_NEAR(summary.temp_max, 26.0, 1e-6);
+    CHECK_NEAR(summary.temp_avg, 24.1667, 1e-3);
+    CHECK_EQ(agg.start, HOUR_EPOCH + 3600);
+    CHECK_EQ(agg.temp_count, 0);
+    CHECK(!summary.partial);
+}
+
+static void test_door_time_crosses_bucket(void) {
+    aggregator_t agg;
+    agg_summary_t summary;
+    aggregator_init(&agg, 3600);
+    aggregator_tick(&agg, HOUR_EPOCH, 0, &summary);
+
+    aggregator_set_door(&agg, true, 1000000);
+    aggregator_set_door(&agg, false, 1060000);
+    aggregator_set_door(&agg, true, 3500000);
+    CHECK(aggregator_tick(&agg, HOUR_EPOCH + 3600, 3600000, &summary));
+    CHECK_EQ(summary.door_openings, 2);
+    CHECK_EQ(summary.door_open_ms, 60000 + 100000);
+
+    // A porta continua aberta no novo balde: tempo conta, abertura não
+    aggregator_set_door(&agg, false, 3630000);
+    CHECK(aggregator_tick(&agg, HOUR_EPOCH + 7200, 7200000, &summary));
+    CHECK_EQ(summary.door_openings, 0);
+    CHECK_EQ(summary.door_open_ms, 30000);
+}
+
+static void test_empty_bucket_and_daily_alignment(void) {
+    aggregator_t agg;
+    agg_summary_t summary;
+    aggregator_init(&agg, 86400);
+    aggregator_tick(&agg, 1700000000u, 0, &summary);
+    CHECK_EQ(agg.start, 1700000000u - 1700000000u % 86400u);
+    CHECK(aggregator_tick(&agg, agg.start + 86400, 1000, &summary));
+    CHECK_EQ(summary.temp_count, 0);
+    CHECK_NEAR(summary.temp_avg, 0.0, 1e-9);
+}
+
+int main(void) {
+    RUN_TEST(test_waits_for_synchronized_clock);
+    RUN_TEST(test_first_bucket_is_partial);
+    RUN_TEST(test_clock_step_marks_partial);
+    RUN_TEST(test_hourly_summary);
+    RUN_TEST(test_door_time_crosses_bucket);
+    RUN_TEST(test_empty_bucket_and_daily_alignment);
+    return test_report();
+}
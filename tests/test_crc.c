@@ -0,0 +1,36 @@
+/* Testes dos CRCs contra os valores de verificação padrão ("123456789") e do encadeamento. */
+#include "test_harness.h"
+#include "crc.h"
+
+static const uint8_t check_input[] = "123456789";
+
+static void test_crc32_check_value(void) {
+    CHECK_EQ(crc32_update(0, check_input, 9), 0xCBF43926u);
+    CHECK_EQ(crc32_update(0, check_input, 0), 0);
+}
+
+static void test_crc32_chains(void) {
+    uint32_t crc = crc32_update(0, check_input, 4);
+    crc = crc32_update(crc, check_input + 4, 5);
+    CHECK_EQ(crc, 0xCBF43926u);
+}
+
+static void test_crc16_modbus_check_value(void) {
+    CHECK_EQ(crc16_modbus(check_input, 9), 0x4B37);
+}
+
+static void test_crc16_modbus_frame(void) {
+    // Leitura de 2 registradores a partir de 0 no escravo 1: 01 03 00 00 00 02 C4 0B
+    static const uint8_t request[] = { 0x01, 0x03, 0x00, 0x00, 0x00, 0x02 };
+    uint16_t crc = crc16_modbus(request, sizeof(request));
+    CHECK_EQ(crc & 0xFF, 0xC4);
+    CHECK_EQ(crc >> 8, 0x0B);
+}
+
+int main(void) {
+    RUN_TEST(test_crc32_check_value);
+    RUN_TEST(test_crc32_chains);
+    RUN_TEST(test_crc16_modbus_check_value);
+    RUN_TEST(test_crc16_modbus_frame);
+    return test_report();
+}
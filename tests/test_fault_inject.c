@@ -0,0 +1,175 @@
+/* Roteiro de falhas do firmware (fault_inject.c, RACK_FAULT_INJECTION) sobre a netif simulada: a
+ * conexão MQTT e a fila de saída passam por perda, latência, blackhole, reset e falha de DNS, e cada
+ * passo precisa se recuperar sem perder mensagens QoS 1. A latência vale nos dois sentidos. */
+#include <stdlib.h>
+#include "test_harness.h"
+#include "fault_inject.h"
+#include "outbox.h"
+#include "rate_limit.h"
+#include "mqtt_link.h"
+#include "broker_list.h"
+#include "fleet_slot.h"
+
+#define PRIMARY_IP          "10.0.0.1"
+#define TOPIC               "rack_inteligente/00007/temperature/alarm"
+#define TICK_MS             50        // drenagem da fila, como no loop principal com backlog
+#define PUBLISH_INTERVAL_MS 5000
+#define SCRIPT_MAX_MS       (2u * 60u * 60u * 1000u)
+#define RECOVERY_MAX_MS     (5u * 60u * 1000u)
+#define LATENCY_MS          500       // passo FAULT_LATENCY do roteiro
+#define MESSAGES_MAX        2048
+
+static const fault_type_t expected_steps[] = {
+    FAULT_LOSS, FAULT_LOSS, FAULT_LATENCY, FAULT_BLACKHOLE, FAULT_RESET, FAULT_DNS_FAIL,
+};
+#define STEPS (sizeof(expected_steps) / sizeof(expected_steps[0]))
+
+typedef struct {
+    uint32_t published_ms;
+    uint32_t acked_ms;
+    fault_type_t fault;       // falha em curso na publicação
+    fault_type_t fault_acked; // e no PUBACK
+    uint32_t copies;          // PUBLISH recebidos pelo broker
+} message_t;
+
+static message_t messages[MESSAGES_MAX];
+static uint32_t published = 0;
+
+static uint32_t now_ms(void) {
+    return (uint32_t)(host_clock_us() / 1000u);
+}
+
+static void broker_received(const host_mqtt_msg_t *msg, void *arg) {
+    // O carimbo de sequência vem antes: {"c":..,"b":..,"q":..,"n":<número>}
+    const char *n = strstr((const char *)msg->payload, "\"n\":");
+    if (n != NULL) {
+        uint32_t index = (uint32_t)strtoul(n + 4, NULL, 10);
+        if (index < published) {
+            messages[index].copies++;
+        }
+    }
+}
+
+static void acked(void *arg, bool ok) {
+    message_t *message = (message_t *)arg;
+    if (ok && message->acked_ms == 0) {
+        message->acked_ms = now_ms();
+        message->fault_acked = fault_inject_active();
+    }
+}
+
+static void publish_next(void) {
+    if (published == MESSAGES_MAX) {
+        return;
+    }
+    message_t *message = &messages[published];
+    message->published_ms = now_ms();
+    message->fault = fault_inject_active();
+    char payload[32];
+    snprintf(payload, sizeof(payload), "{\"n\":%u}", (unsigned)published);
+    published++;
+    CHECK(outbox_publish_notify(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_STATE, TOPIC, payload, strlen(payload), 1, 0,
+                                acked, message));
+}
+
+static bool healthy(void) {
+    outbox_stats_t stats;
+    outbox_get_stats(&stats);
+    return mqtt_link_is_connected() && stats.depth == 0;
+}
+
+static void tick(void) {
+    host_clock_advance_ms(TICK_MS);
+    uint32_t now = now_ms();
+    mqtt_link_tick(now);
+    if (mqtt_link_is_connected()) {
+        outbox_drain(mqtt_link_client(), now);
+    }
+    outbox_stats_t stats;
+    outbox_get_stats(&stats);
+    fault_inject_tick(now, healthy(), stats.dropped + stats.publish_errors);
+}
+
+static void test_fault_script(void) {
+    host_dns_add("broker.test", PRIMARY_IP);
+    host_mqtt_set_publish_hook(broker_received, NULL);
+    fleet_slot_init(7);
+    rate_limit_init(0);
+    outbox_init(1);
+    mqtt_link_init();
+    broker_list_init("broker.test", MQTT_BROKER_PORT);
+    mqtt_link_set_session_callbacks(outbox_session_started, outbox_session_lost);
+    fault_inject_init(host_netif(), mqtt_link_drop);
+
+    fault_result_t results[STEPS];
+    uint32_t steps_done = 0;
+    uint32_t next_publish_ms = PUBLISH_INTERVAL_MS;
+    while (steps_done < STEPS && now_ms() < SCRIPT_MAX_MS) {
+        tick();
+        if (now_ms() >= next_publish_ms) {
+            publish_next();
+            next_publish_ms += PUBLISH_INTERVAL_MS;
+        }
+        fault_result_t result;
+        if (fault_inject_last_result(&result) && result.step == steps_done) {
+            results[steps_done++] = result;
+        }
+    }
+    CHECK_EQ(steps_done, STEPS);
+
+    // Mensagens do último passo terminam de sair
+    for (uint32_t waited = 0; waited < RECOVERY_MAX_MS && !healthy(); waited += TICK_MS) {
+        tick();
+    }
+    for (uint32_t waited = 0; waited < 60000; waited += TICK_MS) {
+        tick();
+    }
+
+    for (uint32_t i = 0; i < steps_done; i++) {
+        const fault_result_t *r = &results[i];
+        printf("passo %u %-9s recuperação %6u ms, perdidas %u, descartados tx %3u rx %3u, sem slot %u\n", (unsigned)i,
+               fault_inject_type_name(r->type), (unsigned)r->recovery_ms, (unsigned)r->lost_messages,
+               (unsigned)r->dropped_tx, (unsigned)r->dropped_rx, (unsigned)r->delay_overflow);
+        CHECK_EQ(r->type, expected_steps[i]);
+        CHECK(r->recovery_ms <= RECOVERY_MAX_MS);
+        CHECK_EQ(r->lost_messages, 0);
+        if (r->type == FAULT_LOSS || r->type == FAULT_BLACKHOLE) {
+            CHECK(r->dropped_tx > 0);
+            CHECK(r->dropped_rx > 0);
+        } else {
+            CHECK_EQ(r->dropped_tx, 0);
+            CHECK_EQ(r->dropped_rx, 0);
+        }
+        CHECK_EQ(r->delay_overflow, 0);
+    }
+
+    // QoS 1: tudo chega ao broker pelo menos uma vez; na latência, o PUBACK leva o atraso dos dois sentidos
+    uint32_t missing = 0, duplicates = 0, latency_messages = 0;
+    uint32_t latency_rtt_min = UINT32_MAX;
+    for (uint32_t i = 0; i < published; i++) {
+        const message_t *message = &messages[i];
+        missing += message->copies == 0 || message->acked_ms == 0;
+        duplicates += message->copies > 1 ? message->copies - 1 : 0;
+        if (message->fault == FAULT_LATENCY && message->fault_acked == FAULT_LATENCY && message->acked_ms != 0) {
+            uint32_t rtt = message->acked_ms - message->published_ms;
+            latency_messages++;
+            latency_rtt_min = rtt < latency_rtt_min ? rtt : latency_rtt_min;
+        }
+    }
+    outbox_stats_t stats;
+    outbox_get_stats(&stats);
+    printf("%u publicadas, %u sem PUBACK, %u cópias a mais, reconexões %u; PUBACK na latência >= %u ms\n",
+           (unsigned)published, (unsigned)missing, (unsigned)duplicates, (unsigned)mqtt_link_reconnects(),
+           (unsigned)latency_rtt_min);
+    CHECK(published > 50);
+    CHECK_EQ(missing, 0);
+    CHECK_EQ(stats.dropped, 0);
+    CHECK(latency_messages > 10);
+    CHECK(latency_rtt_min >= 2 * LATENCY_MS);
+    CHECK(mqtt_link_reconnects() >= 1);   // reset (e blackhole) derrubam a sessão
+}
+
+int main(void) {
+    RUN_TEST(test_fault_script);
+    return test_report();
+}
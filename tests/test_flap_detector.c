@@ -0,0 +1,94 @@
+/* Testes do detector de oscilação: entrada na janela, supressão, resumos e saída. */
+#include "test_harness.h"
+#include "flap_detector.h"
+
+static void test_slow_transitions_pass(void) {
+    flap_detector_t detector;
+    flap_detector_init(&detector, 4, 10000, 60000, 30000);
+    for (uint32_t i = 0; i < 20; i++) {
+        CHECK_EQ(flap_detector_transition(&detector, i * 4000), FLAP_PASS);
+    }
+    uint32_t transitions = 0;
+    CHECK_EQ(flap_detector_tick(&detector, 100000, &transitions), FLAP_TICK_NONE);
+    CHECK_EQ(detector.episodes, 0);
+}
+
+static void test_enter_suppress_summary_exit(void) {
+    flap_detector_t detector;
+    flap_detector_init(&detector, 4, 10000, 60000, 30000);
+    CHECK_EQ(flap_detector_transition(&detector, 0), FLAP_PASS);
+    CHECK_EQ(flap_detector_transition(&detector, 1000), FLAP_PASS);
+    CHECK_EQ(flap_detector_transition(&detector, 2000), FLAP_PASS);
+    CHECK_EQ(flap_detector_transition(&detector, 3000), FLAP_ENTERED);
+    CHECK_EQ(detector.episodes, 1);
+
+    for (uint32_t t = 4000; t < 60000; t += 1000) {
+        CHECK_EQ(flap_detector_transition(&detector, t), FLAP_SUPPRESSED);
+    }
+    uint32_t transitions = 0;
+    CHECK_EQ(flap_detector_tick(&detector, 59500, &transitions), FLAP_TICK_NONE);
+    CHECK_EQ(flap_detector_tick(&detector, 63000, &transitions), FLAP_TICK_SUMMARY);
+    CHECK_EQ(transitions, 56);   // só as suprimidas: as 4 da detecção foram no evento de entrada
+
+    CHECK_EQ(flap_detector_transition(&detector, 70000), FLAP_SUPPRESSED);
+    CHECK_EQ(flap_detector_tick(&detector, 99999, &transitions), FLAP_TICK_NONE);
+    CHECK_EQ(flap_detector_tick(&detector, 100000, &transitions), FLAP_TICK_EXITED);
+    CHECK_EQ(transitions, 1);
+
+    // Depois de sair o histórico recomeça: uma transição isolada volta a passar
+    CHECK_EQ(flap_detector_transition(&detector, 200000), FLAP_PASS);
+}
+
+// Evento de entrada + resumos + saída contam cada transição real exatamente uma vez
+static void test_enter_and_summaries_add_up(void) {
+    flap_detector_t detector;
+    flap_detector_init(&detector, 6, 10000, 60000, 30000);
+    uint32_t real = 0, reported = 0, transitions = 0;
+    for (uint32_t t = 0; t < 200000; t += 700) {
+        real++;
+        switch (flap_detector_transition(&detector, t)) {
+            case FLAP_ENTERED:
+                reported += detector.threshold;
+                break;
+            case FLAP_PASS:
+                CHECK_EQ(detector.episodes, 0);   // eventos individuais, antes da detecção
+                break;
+            default:
+                break;
+        }
+        if (flap_detector_tick(&detector, t, &transitions) != FLAP_TICK_NONE) {
+            reported += transitions;
+        }
+    }
+    CHECK_EQ(detector.episodes, 1);
+    CHECK_EQ(flap_detector_tick(&detector, 300000, &transitions), FLAP_TICK_EXITED);
+    reported += transitions;
+    // A entrada conta as `threshold` da detecção, os resumos só as suprimidas: a soma é o total real
+    CHECK_EQ(reported, real);
+}
+
+static void test_window_boundary(void) {
+    flap_detector_t detector;
+    flap_detector_init(&detector, 3, 10000, 60000, 30000);
+    CHECK_EQ(flap_detector_transition(&detector, 0), FLAP_PASS);
+    CHECK_EQ(flap_detector_transition(&detector, 5000), FLAP_PASS);
+    CHECK_EQ(flap_detector_transition(&detector, 10001), FLAP_PASS);     // 0..10001: 1 ms além da janela
+    CHECK_EQ(flap_detector_transition(&detector, 15000), FLAP_ENTERED);  // 5000..15000: exatamente a janela
+}
+
+static void test_threshold_clamped(void) {
+    flap_detector_t detector;
+    flap_detector_init(&detector, 1, 1000, 1000, 1000);
+    CHECK_EQ(detector.threshold, 2);
+    flap_detector_init(&detector, 200, 1000, 1000, 1000);
+    CHECK_EQ(detector.threshold, FLAP_MAX_THRESHOLD);
+}
+
+int main(void) {
+    RUN_TEST(test_slow_transitions_pass);
+    RUN_TEST(test_enter_suppress_summary_exit);
+    RUN_TEST(test_enter_and_summaries_add_up);
+    RUN_TEST(test_window_boundary);
+    RUN_TEST(test_threshold_clamped);
+    return test_report();
+}
@@ -0,0 +1,76 @@
+#ifndef TEST_HARNESS_H
+#define TEST_HARNESS_H
+
+/* Verificações mínimas para os testes no host (sem dependências externas). Cada teste é
+ * uma função void sem argumentos executada por RUN_TEST() com os dublês zerados; as
+ * falhas são contadas e listadas, e test_report() devolve o código de saída do ctest. */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "host_mock.h"
+
+static int test_checks = 0;
+static int test_failures = 0;
+static const char *test_current = "";
+
+static inline void test_fail(const char *file, int line, const char *what) {
+    test_failures++;
+    fprintf(stderr, "%s:%d: [%s] %s\n", file, line, test_current, what);
+}
+
+#define CHECK(cond) do { \
+    test_checks++; \
+    if (!(cond)) { \
+        test_fail(__FILE__, __LINE__, "CHECK(" #cond ")"); \
+    } \
+} while (0)
+
+#define CHECK_EQ(actual, expected) do { \
+    long long actual_ = (long long)(actual); \
+    long long expected_ = (long long)(expected); \
+    test_checks++; \
+    if (actual_ != expected_) { \
+        char what_[256]; \
+        snprintf(what_, sizeof(what_), "%s == %lld, esperado %lld", #actual, actual_, expected_); \
+        test_fail(__FILE__, __LINE__, what_); \
+    } \
+} while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) do { \
+    double actual_ = (double)(actual); \
+    double expected_ = (double)(expected); \
+    test_checks++; \
+    if (!(fabs(actual_ - expected_) <= (tolerance))) { \
+        char what_[256]; \
+        snprintf(what_, sizeof(what_), "%s == %g, esperado %g (±%g)", #actual, actual_, expected_, (double)(tolerance)); \
+        test_fail(__FILE__, __LINE__, what_); \
+    } \
+} while (0)
+
+#define CHECK_STR(actual, expected) do { \
+    const char *actual_ = (actual); \
+    const char *expected_ = (expected); \
+    test_checks++; \
+    if (strcmp(actual_, expected_) != 0) { \
+        char what_[256]; \
+        snprintf(what_, sizeof(what_), "%s == \"%s\", esperado \"%s\"", #actual, actual_, expected_); \
+        test_fail(__FILE__, __LINE__, what_); \
+    } \
+} while (0)
+
+#define RUN_TEST(fn) do { \
+    test_current = #fn; \
+    host_reset(); \
+    fn(); \
+    if (host_lwip_lock_depth() != 0) { \
+        test_fail(__FILE__, __LINE__, "trava do lwIP tomada ao fim do teste"); \
+    } \
+} while (0)
+
+static inline int test_report(void) {
+    printf("%d verificações, %d falhas\n", test_checks, test_failures);
+    return test_failures == 0 ? 0 : 1;
+}
+
+#endif /* TEST_HARNESS_H */
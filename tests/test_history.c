@@ -0,0 +1,119 @@
+/* Testes do histórico circular: fechamento de blocos, serialização decodificável,
+ * lacunas, sobrescrita e busca por instante. */
+#include "test_harness.h"
+#include "history.h"
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static float sample_value(uint32_t i) {
+    return 24.0f + (float)(i % 17) * 0.05f - (float)(i % 5) * 0.02f;
+}
+
+static void test_block_serializes_and_decodes(void) {
+    history_init();
+    for (uint32_t i = 0; i < HISTORY_BLOCK_SAMPLES; i++) {
+        history_add(1000 + i * 1000, sample_value(i));
+    }
+    CHECK_EQ(history_next_seq(), 1);
+
+    uint8_t buf[15 + HISTORY_BLOCK_BYTES];
+    size_t len = history_serialize(0, buf, sizeof(buf));
+    CHECK(len > 15);
+    CHECK_EQ(get_u32(&buf[0]), 0);
+    CHECK_EQ(get_u32(&buf[4]), 1000);
+    CHECK_EQ(get_u32(&buf[8]), 1000 + (HISTORY_BLOCK_SAMPLES - 1) * 1000);
+    CHECK_EQ(buf[12], HISTORY_BLOCK_SAMPLES);
+    uint16_t bits = (uint16_t)(buf[13] | (buf[14] << 8));
+    CHECK_EQ(len, 15 + (bits + 7u) / 8u);
+
+    ts_decoder_t dec;
+    ts_decoder_init(&dec, &buf[15], len - 15);
+    bool all_match = true;
+    for (uint32_t i = 0; i < HISTORY_BLOCK_SAMPLES; i++) {
+        int16_t centi;
+        if (!ts_decode(&dec, &centi) || centi != (int16_t)roundf(sample_value(i) * 100.0f)) {
+            all_match = false;
+        }
+    }
+    CHECK(all_match);
+
+    // A amostra seguinte abre o bloco 1
+    history_add(200000, 25.0f);
+    CHECK_EQ(history_next_seq(), 2);
+}
+
+static void test_gap_closes_block(void) {
+    history_init();
+    history_add(1000, 20.0f);
+    history_add(2000, 20.1f);
+    history_gap();
+    history_add(10000, 20.2f);
+    CHECK_EQ(history_next_seq(), 2);
+
+    uint8_t buf[15 + HISTORY_BLOCK_BYTES];
+    CHECK(history_serialize(0, buf, sizeof(buf)) > 0);
+    CHECK_EQ(buf[12], 2);
+    CHECK(history_serialize(1, buf, sizeof(buf)) > 0);
+    CHECK_EQ(buf[12], 1);
+    CHECK_EQ(get_u32(&buf[4]), 10000);
+}
+
+static void test_ring_overwrites_oldest(void) {
+    history_init();
+    for (uint32_t seq = 0; seq < HISTORY_BLOCKS + 5; seq++) {
+        history_add(seq * 1000, 21.0f);
+        history_gap();
+    }
+    CHECK_EQ(history_next_seq(), HISTORY_BLOCKS + 5);
+    CHECK_EQ(history_oldest_seq(), 5);
+
+    uint8_t buf[15 + HISTORY_BLOCK_BYTES];
+    CHECK_EQ(history_serialize(4, buf, sizeof(buf)), 0);
+    CHECK(history_serialize(5, buf, sizeof(buf)) > 0);
+    CHECK_EQ(get_u32(&buf[0]), 5);
+    CHECK_EQ(history_serialize(HISTORY_BLOCKS + 5, buf, sizeof(buf)), 0);
+}
+
+static void test_seq_since(void) {
+    history_init();
+    for (uint32_t seq = 0; seq < 4; seq++) {
+        history_add(seq * 10000, 21.0f);
+        history_add(seq * 10000 + 5000, 21.0f);
+        history_gap();
+    }
+    CHECK_EQ(history_seq_since(0), 0);
+    CHECK_EQ(history_seq_since(5000), 0);
+    CHECK_EQ(history_seq_since(5001), 1);
+    CHECK_EQ(history_seq_since(35000), 3);
+    CHECK_EQ(history_seq_since(35001), 4);
+}
+
+static void test_values_clamped_and_small_buffer_rejected(void) {
+    history_init();
+    history_add(0, 400.0f);
+    history_add(1000, -400.0f);
+
+    uint8_t buf[15 + HISTORY_BLOCK_BYTES];
+    size_t len = history_serialize(0, buf, sizeof(buf));
+    CHECK(len > 0);
+    ts_decoder_t dec;
+    ts_decoder_init(&dec, &buf[15], len - 15);
+    int16_t value;
+    CHECK(ts_decode(&dec, &value));
+    CHECK_EQ(value, INT16_MAX);
+    CHECK(ts_decode(&dec, &value));
+    CHECK_EQ(value, INT16_MIN);
+
+    CHECK_EQ(history_serialize(0, buf, len - 1), 0);
+}
+
+int main(void) {
+    RUN_TEST(test_block_serializes_and_decodes);
+    RUN_TEST(test_gap_closes_block);
+    RUN_TEST(test_ring_overwrites_oldest);
+    RUN_TEST(test_seq_since);
+    RUN_TEST(test_values_clamped_and_small_buffer_rejected);
+    return test_report();
+}
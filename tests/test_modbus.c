@@ -0,0 +1,260 @@
+/* Testes do mestre Modbus RTU: quadros de requisição e resposta, exceções, queda/volta do escravo,
+ * reporte por deadband e o JSON publicado. */
+#include "test_harness.h"
+#include "modbus_rtu.h"
+#include "crc.h"
+
+static const modbus_reg_t pdu_watts = { "pdu_watts", 1, 4, 0x0002, 2, 0, 50, 5 };
+
+// Resposta do escravo com os valores e o CRC; retorna o comprimento
+static uint32_t make_response(const modbus_reg_t *reg, const uint16_t *values, uint8_t *frame) {
+    frame[0] = reg->unit;
+    frame[1] = reg->function;
+    frame[2] = (uint8_t)(2 * reg->count);
+    for (uint32_t i = 0; i < reg->count; i++) {
+        frame[3 + 2 * i] = (uint8_t)(values[i] >> 8);
+        frame[4 + 2 * i] = (uint8_t)values[i];
+    }
+    uint32_t len = 3 + 2u * reg->count;
+    uint16_t crc = crc16_modbus(frame, len);
+    frame[len] = (uint8_t)crc;
+    frame[len + 1] = (uint8_t)(crc >> 8);
+    return len + 2;
+}
+
+static uint32_t make_exception(const modbus_reg_t *reg, uint8_t code, uint8_t *frame) {
+    frame[0] = reg->unit;
+    frame[1] = (uint8_t)(reg->function | 0x80);
+    frame[2] = code;
+    uint16_t crc = crc16_modbus(frame, 3);
+    frame[3] = (uint8_t)crc;
+    frame[4] = (uint8_t)(crc >> 8);
+    return MODBUS_RTU_EXCEPTION_LEN;
+}
+
+static void test_request_frame(void) {
+    // Exemplo clássico: escravo 1, função 4, endereço 2, 2 registradores -> CRC 0x0BD0 (D0 0B no fio)
+    uint8_t frame[MODBUS_RTU_REQUEST_LEN];
+    modbus_rtu_build_request(&pdu_watts, frame);
+    static const uint8_t expected[] = { 0x01, 0x04, 0x00, 0x02, 0x00, 0x02, 0xD0, 0x0B };
+    CHECK(memcmp(frame, expected, sizeof(expected)) == 0);
+
+    modbus_reg_t high = { "ups", 247, 3, 0xABCD, 8, 0, 0, 1 };
+    modbus_rtu_build_request(&high, frame);
+    CHECK_EQ(frame[0], 247);
+    CHECK_EQ(frame[2], 0xAB);
+    CHECK_EQ(frame[3], 0xCD);
+    CHECK_EQ(frame[5], 8);
+    CHECK_EQ(crc16_modbus(frame, sizeof(frame)), 0);   // CRC sobre o quadro inteiro zera
+}
+
+static void test_response_checks(void) {
+    uint8_t frame[MODBUS_RTU_RESPONSE_LEN(MODBUS_REGS_MAX)];
+    uint16_t values[] = { 0x0012, 0x3456 };
+    uint8_t exception = 0;
+    uint32_t len = make_response(&pdu_watts, values, frame);
+    CHECK_EQ(len, MODBUS_RTU_RESPONSE_LEN(2));
+    CHECK_EQ(modbus_rtu_check_response(&pdu_watts, frame, len, &exception), MODBUS_RTU_OK);
+
+    // Curta: prazo esgotado
+    CHECK_EQ(modbus_rtu_check_response(&pdu_watts, frame, len - 1, &exception), MODBUS_RTU_TIMEOUT);
+    CHECK_EQ(modbus_rtu_check_response(&pdu_watts, frame, 0, &exception), MODBUS_RTU_TIMEOUT);
+
+    // CRC, escravo, função e contagem de bytes
+    frame[len - 1] ^= 0x01;
+    CHECK_EQ(modbus_rtu_check_response(&pdu_watts, frame, len, &exception), MODBUS_RTU_BAD_FRAME);
+    modbus_reg_t other = pdu_watts;
+    other.unit = 2;
+    len = make_response(&other, values, frame);
+    CHECK_EQ(modbus_rtu_check_response(&pdu_watts, frame, len, &exception), MODBUS_RTU_BAD_FRAME);
+    other = pdu_watts;
+    other.function = 3;
+    len = make_response(&other, values, frame);
+    CHECK_EQ(modbus_rtu_check_response(&pdu_watts, frame, len, &exception), MODBUS_RTU_BAD_FRAME);
+    len = make_response(&pdu_watts, values, frame);
+    frame[2] = 6;
+    uint16_t crc = crc16_modbus(frame, len - 2);
+    frame[len - 2] = (uint8_t)crc;
+    frame[len - 1] = (uint8_t)(crc >> 8);
+    CHECK_EQ(modbus_rtu_check_response(&pdu_watts, frame, len, &exception), MODBUS_RTU_BAD_FRAME);
+}
+
+static void test_exception_response(void) {
+    uint8_t frame[MODBUS_RTU_RESPONSE_LEN(MODBUS_REGS_MAX)];
+    uint8_t exception = 0;
+    uint32_t len = make_exception(&pdu_watts, 2, frame);
+    CHECK_EQ(frame[1], 0x84);
+    CHECK_EQ(modbus_rtu_check_response(&pdu_watts, frame, len, &exception), MODBUS_RTU_EXCEPTION);
+    CHECK_EQ(exception, 2);
+
+    // A exceção encerra a transação sem esperar o prazo; a resposta normal incompleta, não
+    CHECK(modbus_rtu_response_done(&pdu_watts, frame, len, 0));
+    uint16_t values[] = { 1, 2 };
+    len = make_response(&pdu_watts, values, frame);
+    CHECK(!modbus_rtu_response_done(&pdu_watts, frame, MODBUS_RTU_EXCEPTION_LEN, 0));
+    CHECK(!modbus_rtu_response_done(&pdu_watts, frame, len - 1, MODBUS_TIMEOUT_MS - 1));
+    CHECK(modbus_rtu_response_done(&pdu_watts, frame, len - 1, MODBUS_TIMEOUT_MS));
+    CHECK(modbus_rtu_response_done(&pdu_watts, frame, len, 0));
+
+    // Exceção com CRC errado ou de outro escravo não é exceção
+    len = make_exception(&pdu_watts, 2, frame);
+    frame[4] ^= 0x80;
+    CHECK_EQ(modbus_rtu_check_response(&pdu_watts, frame, len, &exception), MODBUS_RTU_TIMEOUT);
+    modbus_reg_t other = pdu_watts;
+    other.unit = 9;
+    len = make_exception(&other, 2, frame);
+    CHECK_EQ(modbus_rtu_check_response(&pdu_watts, frame, len, &exception), MODBUS_RTU_TIMEOUT);
+}
+
+static void test_offline_after_threshold_and_back(void) {
+    modbus_entry_t entry;
+    modbus_change_t change;
+    uint8_t frame[MODBUS_RTU_RESPONSE_LEN(MODBUS_REGS_MAX)];
+    uint16_t values[] = { 100, 200 };
+    modbus_entry_reset(&entry, 0);
+
+    // Primeira leitura sempre reportada
+    make_response(&pdu_watts, values, frame);
+    modbus_entry_update(&entry, &pdu_watts, MODBUS_RTU_OK, frame);
+    CHECK(modbus_entry_take(&entry, &pdu_watts, &change));
+    CHECK(change.online);
+    CHECK_EQ(change.values[1], 200);
+    CHECK(!modbus_entry_take(&entry, &pdu_watts, &change));
+
+    // Falhas abaixo do limiar não reportam; uma resposta válida zera a contagem
+    for (int i = 0; i < MODBUS_FAIL_THRESHOLD - 1; i++) {
+        modbus_entry_update(&entry, &pdu_watts, MODBUS_RTU_TIMEOUT, NULL);
+    }
+    CHECK(!modbus_entry_take(&entry, &pdu_watts, &change));
+    modbus_entry_update(&entry, &pdu_watts, MODBUS_RTU_OK, frame);
+    CHECK(!modbus_entry_take(&entry, &pdu_watts, &change));
+    for (int i = 0; i < MODBUS_FAIL_THRESHOLD - 1; i++) {
+        modbus_entry_update(&entry, &pdu_watts, MODBUS_RTU_BAD_FRAME, NULL);
+    }
+    CHECK(entry.online);
+
+    // Limiar: uma queda reportada, com os últimos valores; falhas seguintes não repetem
+    modbus_entry_update(&entry, &pdu_watts, MODBUS_RTU_EXCEPTION, NULL);
+    CHECK(modbus_entry_take(&entry, &pdu_watts, &change));
+    CHECK(!change.online);
+    CHECK_EQ(change.values[0], 100);
+    for (int i = 0; i < 10; i++) {
+        modbus_entry_update(&entry, &pdu_watts, MODBUS_RTU_TIMEOUT, NULL);
+    }
+    CHECK(!modbus_entry_take(&entry, &pdu_watts, &change));
+
+    // Volta reportada mesmo sem variação
+    modbus_entry_update(&entry, &pdu_watts, MODBUS_RTU_OK, frame);
+    CHECK(modbus_entry_take(&entry, &pdu_watts, &change));
+    CHECK(change.online);
+    CHECK_EQ(entry.failures, 0);
+}
+
+static void test_deadband_report_by_exception(void) {
+    modbus_entry_t entry;
+    modbus_change_t change;
+    uint8_t frame[MODBUS_RTU_RESPONSE_LEN(MODBUS_REGS_MAX)];
+    uint16_t values[] = { 1000, 5 };
+    modbus_entry_reset(&entry, 0);
+    make_response(&pdu_watts, values, frame);
+    modbus_entry_update(&entry, &pdu_watts, MODBUS_RTU_OK, frame);
+    CHECK(modbus_entry_take(&entry, &pdu_watts, &change));
+
+    // Dentro do deadband (50) nos dois sentidos: nada
+    values[0] = 1050;
+    make_response(&pdu_watts, values, frame);
+    modbus_entry_update(&entry, &pdu_watts, MODBUS_RTU_OK, frame);
+    CHECK(!modbus_entry_take(&entry, &pdu_watts, &change));
+    values[0] = 950;
+    make_response(&pdu_watts, values, frame);
+    modbus_entry_update(&entry, &pdu_watts, MODBUS_RTU_OK, frame);
+    CHECK(!modbus_entry_take(&entry, &pdu_watts, &change));
+
+    // Deriva lenta é medida contra o último valor reportado, não contra a última leitura
+    values[0] = 1051;
+    make_response(&pdu_watts, values, frame);
+    modbus_entry_update(&entry, &pdu_watts, MODBUS_RTU_OK, frame);
+    CHECK(modbus_entry_take(&entry, &pdu_watts, &change));
+    CHECK_EQ(change.values[0], 1051);
+
+    // Qualquer registrador da leitura dispara, e o reporte leva todos os valores atuais
+    values[1] = 0;
+    values[0] = 1060;
+    make_response(&pdu_watts, values, frame);
+    modbus_entry_update(&entry, &pdu_watts, MODBUS_RTU_OK, frame);
+    CHECK(!modbus_entry_take(&entry, &pdu_watts, &change));
+    values[1] = 60;
+    make_response(&pdu_watts, values, frame);
+    modbus_entry_update(&entry, &pdu_watts, MODBUS_RTU_OK, frame);
+    CHECK(modbus_entry_take(&entry, &pdu_watts, &change));
+    CHECK_EQ(change.values[0], 1060);
+    CHECK_EQ(change.values[1], 60);
+}
+
+static void test_reg_validation(void) {
+    CHECK(modbus_reg_valid(&pdu_watts));
+    modbus_reg_t reg = pdu_watts;
+    strcpy(reg.name, "PDU");
+    CHECK(!modbus_reg_valid(&reg));
+    strcpy(reg.name, "a/b");
+    CHECK(!modbus_reg_valid(&reg));
+    reg = pdu_watts;
+    memset(reg.name, 'a', sizeof(reg.name));   // sem terminador
+    CHECK(!modbus_reg_valid(&reg));
+    reg = pdu_watts;
+    reg.unit = 0;
+    CHECK(!modbus_reg_valid(&reg));
+    reg.unit = 248;
+    CHECK(!modbus_reg_valid(&reg));
+    reg = pdu_watts;
+    reg.function = 6;
+    CHECK(!modbus_reg_valid(&reg));
+    reg = pdu_watts;
+    reg.count = MODBUS_REGS_MAX + 1;
+    CHECK(!modbus_reg_valid(&reg));
+    reg = pdu_watts;
+    reg.period_s = 0;
+    CHECK(!modbus_reg_valid(&reg));
+}
+
+static void test_format_change_clamps(void) {
+    modbus_change_t change = { .reg = &pdu_watts, .online = true, .values = { 12, 3456 } };
+    char buf[128];
+    int len = modbus_format_change(buf, sizeof(buf), &change);
+    CHECK_STR(buf, "{\"unit\":1,\"fc\":4,\"addr\":2,\"online\":true,\"v\":[12,3456]}");
+    CHECK_EQ(len, (int)strlen(buf));
+
+    change.online = false;
+    modbus_format_change(buf, sizeof(buf), &change);
+    CHECK_STR(buf, "{\"unit\":1,\"fc\":4,\"addr\":2,\"online\":false}");
+
+    // Maior leitura possível cabe no payload do produtor (OUTBOX_PRODUCER_MAX = 128)
+    modbus_reg_t widest = { "ups", 247, 4, 65535, MODBUS_REGS_MAX, 0, 0, 1 };
+    change.reg = &widest;
+    change.online = true;
+    for (int i = 0; i < MODBUS_REGS_MAX; i++) {
+        change.values[i] = 65535;
+    }
+    len = modbus_format_change(buf, sizeof(buf), &change);
+    CHECK(len > 0 && (size_t)len < sizeof(buf));
+
+    // Buffer curto: não escreve além dele e retorna o comprimento completo
+    char small[24];
+    memset(small, 'x', sizeof(small));
+    char guard = small[sizeof(small) - 1] = 'G';
+    int full = modbus_format_change(small, sizeof(small) - 1, &change);
+    CHECK_EQ(full, len);
+    CHECK_EQ(small[sizeof(small) - 1], guard);
+    CHECK_EQ(strlen(small), sizeof(small) - 2);
+}
+
+int main(void) {
+    RUN_TEST(test_request_frame);
+    RUN_TEST(test_response_checks);
+    RUN_TEST(test_exception_response);
+    RUN_TEST(test_offline_after_threshold_and_back);
+    RUN_TEST(test_deadband_report_by_exception);
+    RUN_TEST(test_reg_validation);
+    RUN_TEST(test_format_change_clamps);
+    return test_report();
+}
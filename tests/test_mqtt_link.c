@@ -0,0 +1,224 @@
+/* Testes da conexão MQTT sobre o DNS, o TCP e o broker simulados: sessão persistente, comando
+ * entregue logo após o CONNACK, backoff, tempo esgotado, failover e retorno ao primário. */
+#include "test_harness.h"
+#include "mqtt_link.h"
+#include "broker_list.h"
+#include "fleet_slot.h"
+#include "lwip/apps/mqtt_priv.h"
+
+#define PRIMARY_IP   "10.0.0.1"
+#define SECONDARY_IP "10.0.0.2"
+#define COMMAND_TOPIC "rack_inteligente/00007/cmd"
+
+static int sessions_up;
+static int sessions_down;
+
+static void session_up(uint32_t now_ms) {
+    sessions_up++;
+}
+
+static void session_down(void) {
+    sessions_down++;
+}
+
+static uint32_t now_ms(void) {
+    return (uint32_t)(host_clock_us() / 1000u);
+}
+
+// Loop principal: um tick a cada 10 ms
+static void run_for(uint32_t ms) {
+    for (uint32_t elapsed = 0; elapsed < ms; elapsed += 10) {
+        host_clock_advance_ms(10);
+        mqtt_link_tick(now_ms());
+    }
+}
+
+static bool run_until_connected(uint32_t max_ms) {
+    for (uint32_t elapsed = 0; elapsed < max_ms && !mqtt_link_is_connected(); elapsed += 10) {
+        run_for(10);
+    }
+    return mqtt_link_is_connected();
+}
+
+static bool connected_to(const char *ip) {
+    ip_addr_t expected;
+    ipaddr_aton(ip, &expected);
+    return mqtt_link_client()->host.broker.addr == expected.addr;
+}
+
+static void setup(const char *brokers) {
+    sessions_up = 0;
+    sessions_down = 0;
+    host_dns_add("broker.test", PRIMARY_IP);
+    host_dns_add("backup.test", SECONDARY_IP);
+    fleet_slot_init(7);
+    mqtt_link_init();
+    if (brokers != NULL) {
+        broker_list_init(brokers, MQTT_BROKER_PORT);
+    }
+    mqtt_link_set_session_callbacks(session_up, session_down);
+    mqtt_link_set_command_topic(COMMAND_TOPIC);
+}
+
+static void test_connect_with_persistent_session(void) {
+    setup(NULL);
+    CHECK(run_until_connected(1000));
+    mqtt_client_t *client = mqtt_link_client();
+    CHECK_STR(host_mqtt_client_id(client), "rack-00007");
+    CHECK(!host_mqtt_clean_session(client));
+    CHECK_EQ(sessions_up, 1);
+
+    run_for(100);
+    CHECK_STR(host_mqtt_subscription(client), COMMAND_TOPIC);
+    CHECK_EQ(host_mqtt_requests_used(client), 0);   // SUBACK recebido
+    CHECK_EQ(broker_list_entry(0)->connects, 1);
+}
+
+static void test_command_delivered_right_after_connack(void) {
+    setup(NULL);
+    host_broker_set(PRIMARY_IP, HOST_BROKER_MANUAL);
+    run_for(200);
+    CHECK(!mqtt_link_is_connected());
+
+    /* Com sessão persistente o broker despeja os comandos QoS 1 guardados junto com o
+     * CONNACK, antes de o loop principal rodar de novo */
+    mqtt_client_t *client = mqtt_link_client();
+    host_mqtt_accept(client);
+    host_mqtt_deliver(client, COMMAND_TOPIC, "reboot", 6);
+
+    char command[64];
+    CHECK(mqtt_link_take_command(command, sizeof(command)));
+    CHECK_STR(command, "reboot");
+    CHECK(!mqtt_link_take_command(command, sizeof(command)));
+}
+
+static void test_command_filtering(void) {
+    setup(NULL);
+    CHECK(run_until_connected(1000));
+    mqtt_client_t *client = mqtt_link_client();
+    char command[64];
+
+    host_mqtt_deliver(client, "outro/topico", "reboot", 6);
+    CHECK(!mqtt_link_take_command(command, sizeof(command)));
+
+    char too_long[80];
+    memset(too_long, 'x', sizeof(too_long));
+    host_mqtt_deliver(client, COMMAND_TOPIC, too_long, sizeof(too_long));
+    CHECK(!mqtt_link_take_command(command, sizeof(command)));
+
+    // Um comando pendente não é sobrescrito pelo seguinte
+    host_mqtt_deliver(client, COMMAND_TOPIC, "dump", 4);
+    host_mqtt_deliver(client, COMMAND_TOPIC, "reboot", 6);
+    CHECK(mqtt_link_take_command(command, sizeof(command)));
+    CHECK_STR(command, "dump");
+    CHECK(!mqtt_link_take_command(command, sizeof(command)));
+}
+
+static void test_backoff_with_jitter(void) {
+    setup(NULL);
+    host_broker_set(PRIMARY_IP, HOST_BROKER_DOWN);
+    host_rand_seed(1234);
+
+    // Instantes das tentativas (consultas DNS)
+    uint32_t attempts[12];
+    size_t count = 0;
+    uint32_t queries = 0;
+    while (count < 12 && now_ms() < 600000) {
+        mqtt_link_tick(now_ms());
+        if (host_dns_queries() != queries) {
+            queries = host_dns_queries();
+            attempts[count++] = now_ms();
+        }
+        host_clock_advance_ms(10);
+    }
+    CHECK_EQ(count, 12);
+
+    // A falha chega após DNS (20 ms) + RTT (20 ms); o atraso fica em [backoff/2, backoff)
+    uint32_t backoff = MQTT_LINK_BACKOFF_MIN_MS;
+    for (size_t i = 1; i < count; i++) {
+        uint32_t gap = attempts[i] - attempts[i - 1];
+        CHECK(gap >= 40 + backoff / 2);
+        CHECK(gap <= 60 + backoff);
+        backoff = backoff * 2 > MQTT_LINK_BACKOFF_MAX_MS ? MQTT_LINK_BACKOFF_MAX_MS : backoff * 2;
+    }
+    CHECK(!mqtt_link_is_connected());
+    CHECK_EQ(broker_list_entry(0)->total_failures, 11);
+}
+
+static void test_attempt_timeout_on_silent_broker(void) {
+    setup(NULL);
+    host_broker_set(PRIMARY_IP, HOST_BROKER_SILENT);
+    run_for(MQTT_LINK_ATTEMPT_TIMEOUT_MS - 100);
+    CHECK_EQ(broker_list_entry(0)->total_failures, 0);
+    run_for(200);
+    CHECK_EQ(broker_list_entry(0)->total_failures, 1);
+
+    // O broker volta: a tentativa seguinte conecta
+    host_broker_set(PRIMARY_IP, HOST_BROKER_UP);
+    CHECK(run_until_connected(5000));
+    CHECK_EQ(broker_list_entry(0)->consecutive_failures, 0);
+}
+
+static void test_failover_and_return_to_primary(void) {
+    setup("broker.test,backup.test");
+    host_broker_set(PRIMARY_IP, HOST_BROKER_DOWN);
+    CHECK(run_until_connected(20000));
+    CHECK(connected_to(SECONDARY_IP));
+    CHECK_EQ(broker_list_current_index(), 1);
+    CHECK_EQ(broker_list_failovers(), 1);
+    CHECK_EQ(broker_list_entry(0)->total_failures, BROKER_FAILOVER_THRESHOLD);
+    CHECK(broker_list_last_failover_ms() > 0);
+
+    // Primário ainda fora na primeira sondagem: continua no secundário
+    run_for(BROKER_PRIMARY_PROBE_MS + 1000);
+    CHECK(mqtt_link_is_connected());
+    CHECK_EQ(broker_list_current_index(), 1);
+
+    // Primário de volta: a sondagem seguinte derruba a sessão e reconecta nele
+    host_broker_set(PRIMARY_IP, HOST_BROKER_UP);
+    run_for(BROKER_PRIMARY_PROBE_MS);
+    CHECK_EQ(broker_list_current_index(), 0);
+    CHECK(run_until_connected(10000));
+    CHECK(connected_to(PRIMARY_IP));
+    CHECK_EQ(sessions_down, 1);
+    CHECK_EQ(mqtt_link_reconnects(), 1);
+    CHECK_EQ(host_tcp_pcbs_used(), 0);
+}
+
+static void test_lost_session_reconnects_in_fleet_slot(void) {
+    setup(NULL);
+    CHECK(run_until_connected(1000));
+    host_mqtt_drop(mqtt_link_client());
+    run_for(10);
+    CHECK(!mqtt_link_is_connected());
+    CHECK_EQ(sessions_down, 1);
+
+    // Rack 7: fatia de 7/16 da janela de reconexão, antes de qualquer nova tentativa
+    uint32_t dropped_ms = now_ms();
+    uint32_t queries = host_dns_queries();
+    while (host_dns_queries() == queries) {
+        run_for(10);
+    }
+    uint32_t delay = now_ms() - dropped_ms;
+    CHECK(delay >= fleet_slot_offset_ms(FLEET_RECONNECT_WINDOW_MS) + MQTT_LINK_BACKOFF_MIN_MS / 2);
+    CHECK(delay <= fleet_slot_offset_ms(FLEET_RECONNECT_WINDOW_MS) + MQTT_LINK_BACKOFF_MIN_MS + 20);
+
+    CHECK(run_until_connected(1000));
+    CHECK_EQ(sessions_up, 2);
+    CHECK_EQ(mqtt_link_reconnects(), 1);
+    host_mqtt_stats_t stats;
+    host_mqtt_get_stats(&stats);
+    CHECK_EQ(stats.connects, 2);
+    CHECK_EQ(broker_list_entry(0)->total_failures, 0);
+}
+
+int main(void) {
+    RUN_TEST(test_connect_with_persistent_session);
+    RUN_TEST(test_command_delivered_right_after_connack);
+    RUN_TEST(test_command_filtering);
+    RUN_TEST(test_backoff_with_jitter);
+    RUN_TEST(test_attempt_timeout_on_silent_broker);
+    RUN_TEST(test_failover_and_return_to_primary);
+    RUN_TEST(test_lost_session_reconnects_in_fleet_slot);
+    return test_report();
+}
@@ -0,0 +1,120 @@
+/* Testes do pool de blocos fixos: ordem de alocação, esgotamento, contadores e as
+ * verificações de debug (free duplo, ponteiro inválido, escrita após free). */
+#include "test_harness.h"
+#include "msg_pool.h"
+
+typedef struct {
+    uint32_t id;
+    char text[20];
+} record_t;
+
+#define POOL_BLOCKS 4
+
+MSG_POOL_STORAGE(pool_storage, record_t, POOL_BLOCKS);
+static msg_pool_t pool;
+
+static void test_alloc_order_and_exhaustion(void) {
+    msg_pool_init(&pool, "teste", pool_storage, sizeof(record_t), POOL_BLOCKS);
+    CHECK_EQ(pool.block_size % sizeof(void *), 0);
+    CHECK(pool.block_size >= sizeof(record_t));
+
+    record_t *blocks[POOL_BLOCKS];
+    for (int i = 0; i < POOL_BLOCKS; i++) {
+        blocks[i] = msg_pool_alloc(&pool);
+        CHECK(blocks[i] != NULL);
+        CHECK((uint8_t *)blocks[i] == (uint8_t *)pool_storage + i * pool.block_size);
+    }
+    CHECK(msg_pool_alloc(&pool) == NULL);
+    CHECK_EQ(pool.alloc_failures, 1);
+    CHECK_EQ(msg_pool_available(&pool), 0);
+
+    msg_pool_free(&pool, blocks[2]);
+    CHECK_EQ(msg_pool_available(&pool), 1);
+    CHECK(msg_pool_alloc(&pool) == blocks[2]);  // LIFO: o último liberado volta primeiro
+    CHECK_EQ(pool.peak_in_use, POOL_BLOCKS);
+    CHECK_EQ(pool.alloc_count, POOL_BLOCKS + 1);
+
+    msg_pool_free(&pool, NULL);
+    CHECK_EQ(pool.in_use, POOL_BLOCKS);
+}
+
+static void double_free(void *arg) {
+    record_t *block = msg_pool_alloc(&pool);
+    block->id = 1;
+    msg_pool_free(&pool, block);
+    msg_pool_free(&pool, block);
+}
+
+static void invalid_free(void *arg) {
+    static record_t outside;
+    msg_pool_free(&pool, &outside);
+}
+
+static void misaligned_free(void *arg) {
+    uint8_t *block = msg_pool_alloc(&pool);
+    msg_pool_free(&pool, block + 4);
+}
+
+static void write_after_free(void *arg) {
+    record_t *block = msg_pool_alloc(&pool);
+    msg_pool_free(&pool, block);
+    block->text[5] = 'x';
+    // O bloco modificado é o próximo da lista livre
+    msg_pool_alloc(&pool);
+}
+
+static void test_debug_checks_panic(void) {
+#ifndef NDEBUG
+    msg_pool_init(&pool, "teste", pool_storage, sizeof(record_t), POOL_BLOCKS);
+    CHECK(host_panic_caught(double_free, NULL));
+    CHECK(strstr(host_panic_message(), "free duplo") != NULL);
+
+    msg_pool_init(&pool, "teste", pool_storage, sizeof(record_t), POOL_BLOCKS);
+    CHECK(host_panic_caught(invalid_free, NULL));
+    CHECK(strstr(host_panic_message(), "inválido") != NULL);
+
+    msg_pool_init(&pool, "teste", pool_storage, sizeof(record_t), POOL_BLOCKS);
+    CHECK(host_panic_caught(misaligned_free, NULL));
+
+    msg_pool_init(&pool, "teste", pool_storage, sizeof(record_t), POOL_BLOCKS);
+    CHECK(host_panic_caught(write_after_free, NULL));
+    CHECK(strstr(host_panic_message(), "modificado após free") != NULL);
+#endif
+}
+
+/* Soak em build de debug: ordem de liberação sorteada, blocos preenchidos até o fim a cada uso.
+ * Qualquer escrita fora do bloco ou lista livre corrompida dispara o envenenamento (panic). */
+static void test_random_order_soak(void) {
+    msg_pool_init(&pool, "teste", pool_storage, sizeof(record_t), POOL_BLOCKS);
+    record_t *slots[POOL_BLOCKS] = { 0 };
+    uint32_t allocs = 0;
+    host_rand_seed(99);
+    for (int i = 0; i < 200000; i++) {
+        size_t slot = host_rand_32() % POOL_BLOCKS;
+        if (slots[slot] != NULL) {
+            CHECK(slots[slot]->id == (uint32_t)slot);
+            msg_pool_free(&pool, slots[slot]);
+            slots[slot] = NULL;
+        } else {
+            slots[slot] = msg_pool_alloc(&pool);
+            memset(slots[slot], 0x11, sizeof(record_t));
+            slots[slot]->id = (uint32_t)slot;
+            allocs++;
+        }
+    }
+    for (size_t i = 0; i < POOL_BLOCKS; i++) {
+        msg_pool_free(&pool, slots[i]);
+    }
+    CHECK_EQ(pool.in_use, 0);
+    CHECK_EQ(pool.alloc_count, allocs);
+    CHECK_EQ(pool.alloc_failures, 0);
+    CHECK_EQ(pool.peak_in_use, POOL_BLOCKS);
+    CHECK_EQ(msg_pool_available(&pool), POOL_BLOCKS);
+}
+
+int main(void) {
+    RUN_TEST(test_alloc_order_and_exhaustion);
+    RUN_TEST(test_debug_checks_panic);
+    RUN_TEST(test_random_order_soak);
+    return test_report();
+}
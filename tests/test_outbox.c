@@ -0,0 +1,390 @@
+/* Testes da fila de saída sobre o cliente MQTT simulado: ordem por prioridade, envelhecimento,
+ * política de descarte, QoS 1 (PUBACK, timeout, queda de sessão), carimbo de sequência,
+ * anel de saída cheio e latência dos alarmes (inclusive o teto durante a drenagem de um backlog). */
+#include <stdlib.h>
+#include "test_harness.h"
+#include "outbox.h"
+#include "rate_limit.h"
+#include "lwip/apps/mqtt_priv.h"
+
+#define BROKER_IP   "10.0.0.1"
+#define BOOT_EPOCH  42
+
+static mqtt_client_t client;
+static host_mqtt_msg_t received[64];
+static size_t received_count;
+static int done_ok;
+static int done_failed;
+
+static void record_publish(const host_mqtt_msg_t *msg, void *arg) {
+    if (received_count < sizeof(received) / sizeof(received[0])) {
+        received[received_count] = *msg;
+    }
+    received_count++;
+}
+
+static void count_done(void *arg, bool ok) {
+    if (ok) {
+        done_ok++;
+    } else {
+        done_failed++;
+    }
+}
+
+static const char *received_payload(size_t i) {
+    static char text[sizeof(received[0].payload) + 1];
+    memcpy(text, received[i].payload, received[i].payload_len);
+    text[received[i].payload_len] = '\0';
+    return text;
+}
+
+static void connect_client(void) {
+    ip_addr_t ip;
+    ipaddr_aton(BROKER_IP, &ip);
+    struct mqtt_connect_client_info_t info = { .client_id = "teste", .keep_alive = 60 };
+    CHECK_EQ(mqtt_client_connect(&client, &ip, 1883, NULL, NULL, &info), ERR_OK);
+    host_clock_advance_ms(200);
+    CHECK(mqtt_client_is_connected(&client));
+}
+
+static uint32_t now_ms(void) {
+    return (uint32_t)(host_clock_us() / 1000u);
+}
+
+static void setup(void) {
+    memset(&client, 0, sizeof(client));
+    received_count = 0;
+    done_ok = 0;
+    done_failed = 0;
+    host_mqtt_set_publish_hook(record_publish, NULL);
+    rate_limit_init(0);
+    outbox_init(BOOT_EPOCH);
+}
+
+static outbox_stats_t get_stats(void) {
+    outbox_stats_t stats;
+    outbox_get_stats(&stats);
+    return stats;
+}
+
+static void test_priority_order(void) {
+    setup();
+    connect_client();
+    CHECK(outbox_publish(TELEMETRY_CH_METRICS, TELEMETRY_PRIO_BULK, "m", "1", 1, 0, 0));
+    CHECK(outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_TELEMETRY, "t", "2", 1, 0, 0));
+    CHECK(outbox_publish(TELEMETRY_CH_DOOR, TELEMETRY_PRIO_STATE, "s", "3", 1, 0, 0));
+    CHECK(outbox_publish(TELEMETRY_CH_DOOR, TELEMETRY_PRIO_ALARM, "a", "4", 1, 0, 0));
+    CHECK_EQ(get_stats().depth, 4);
+
+    CHECK_EQ(outbox_drain(&client, now_ms()), 4);
+    host_clock_advance_ms(50);
+    CHECK_EQ(received_count, 4);
+    CHECK_STR(received[0].topic, "a");
+    CHECK_STR(received[1].topic, "s");
+    CHECK_STR(received[2].topic, "t");
+    CHECK_STR(received[3].topic, "m");
+    CHECK_EQ(get_stats().depth, 0);
+    CHECK_EQ(outbox_pool()->in_use, 0);
+}
+
+static void test_aging_promotes_old_bulk(void) {
+    setup();
+    connect_client();
+    CHECK(outbox_publish(TELEMETRY_CH_METRICS, TELEMETRY_PRIO_BULK, "m", "1", 1, 0, 0));
+    host_clock_advance_ms(2 * OUTBOX_AGING_MS + 1000);
+    CHECK(outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_TELEMETRY, "t", "2", 1, 0, 0));
+
+    // Duas esperas de envelhecimento levam o bulk ao nível de estado, à frente da telemetria
+    CHECK_EQ(outbox_drain(&client, now_ms()), 2);
+    host_clock_advance_ms(50);
+    CHECK_EQ(received_count, 2);
+    CHECK_STR(received[0].topic, "m");
+    CHECK_STR(received[1].topic, "t");
+    CHECK_EQ(get_stats().aged, 1);
+}
+
+static void test_drop_policy(void) {
+    setup();
+    for (int i = 0; i < OUTBOX_CAPACITY; i++) {
+        CHECK(outbox_publish_notify(TELEMETRY_CH_HISTORY, TELEMETRY_PRIO_BULK, "h", "x", 1, 0, 0, count_done, NULL));
+    }
+    CHECK_EQ(msg_pool_available(outbox_pool()), 0);
+
+    // Pool esgotado: o bulk mais antigo dá lugar à telemetria
+    CHECK(outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_TELEMETRY, "t", "1", 1, 0, 0));
+    outbox_stats_t stats = get_stats();
+    CHECK_EQ(stats.dropped, 1);
+    CHECK_EQ(done_failed, 1);
+    CHECK_EQ(stats.depth, OUTBOX_CAPACITY);
+    CHECK_EQ(stats.depth_by_priority[TELEMETRY_PRIO_BULK], OUTBOX_CAPACITY - 1);
+
+    // Fila só com alarmes: uma mensagem comum é recusada, nunca um alarme é descartado
+    outbox_init(BOOT_EPOCH);
+    for (int i = 0; i < OUTBOX_CAPACITY; i++) {
+        CHECK(outbox_publish(TELEMETRY_CH_DOOR, TELEMETRY_PRIO_ALARM, "a", "x", 1, 0, 0));
+    }
+    CHECK(!outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_TELEMETRY, "t", "1", 1, 0, 0));
+    stats = get_stats();
+    CHECK_EQ(stats.dropped, 1);
+    CHECK_EQ(stats.depth_by_priority[TELEMETRY_PRIO_ALARM], OUTBOX_CAPACITY);
+}
+
+static void test_limits_rejected(void) {
+    setup();
+    char topic[OUTBOX_TOPIC_MAX + 1];
+    memset(topic, 't', OUTBOX_TOPIC_MAX);
+    topic[OUTBOX_TOPIC_MAX] = '\0';
+    CHECK(!outbox_publish(TELEMETRY_CH_METRICS, TELEMETRY_PRIO_BULK, topic, "1", 1, 0, 0));
+    uint8_t payload[OUTBOX_PAYLOAD_MAX + 1] = { 0 };
+    CHECK(!outbox_publish(TELEMETRY_CH_HISTORY, TELEMETRY_PRIO_BULK, "h", payload, sizeof(payload), 0, 0));
+    CHECK_EQ(get_stats().enqueued, 0);
+}
+
+static void test_qos1_ack_and_resync(void) {
+    setup();
+    connect_client();
+    outbox_session_started(now_ms());
+    for (int i = 0; i < 3; i++) {
+        CHECK(outbox_publish_notify(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_TELEMETRY, "t", "1", 1, 1, 0, count_done, NULL));
+    }
+    CHECK_EQ(outbox_drain(&client, now_ms()), 3);
+    outbox_stats_t stats = get_stats();
+    CHECK_EQ(stats.inflight, 3);
+    CHECK_EQ(outbox_pool()->in_use, 3);
+
+    host_clock_advance_ms(100);
+    stats = get_stats();
+    CHECK_EQ(stats.acked, 3);
+    CHECK_EQ(stats.inflight, 0);
+    CHECK_EQ(done_ok, 3);
+    CHECK_EQ(outbox_pool()->in_use, 0);
+
+    // A ressincronização fecha na primeira drenagem com fila e mensagens em voo vazias
+    outbox_drain(&client, now_ms());
+    stats = get_stats();
+    CHECK_EQ(stats.last_resync_sent, 3);
+    CHECK_EQ(stats.last_resync_ms, 100);
+    CHECK_EQ(stats.drain_rate, 30);
+}
+
+static void test_qos1_timeout_requeues(void) {
+    setup();
+    host_broker_set(BROKER_IP, HOST_BROKER_NO_ACK);
+    connect_client();
+    CHECK(outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_TELEMETRY, "t", "1", 1, 1, 0));
+    CHECK_EQ(outbox_drain(&client, now_ms()), 1);
+
+    host_clock_advance_ms(MQTT_REQ_TIMEOUT * 1000 + 100);
+    outbox_stats_t stats = get_stats();
+    CHECK_EQ(stats.retransmits, 1);
+    CHECK_EQ(stats.inflight, 0);
+    CHECK_EQ(stats.depth, 1);
+
+    CHECK_EQ(outbox_drain(&client, now_ms()), 1);
+    host_clock_advance_ms(50);
+    CHECK_EQ(received_count, 2);
+    CHECK_STR(received_payload(0), received_payload(1));   // mesmo carimbo: é a mesma mensagem
+}
+
+static void test_session_lost_requeues_in_order(void) {
+    setup();
+    host_broker_set(BROKER_IP, HOST_BROKER_NO_ACK);
+    connect_client();
+    CHECK(outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_TELEMETRY, "t", "1", 1, 1, 0));
+    CHECK(outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_TELEMETRY, "t", "2", 1, 1, 0));
+    CHECK(outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_TELEMETRY, "t", "3", 1, 1, 0));
+    CHECK_EQ(outbox_drain(&client, now_ms()), 3);
+    host_clock_advance_ms(100);
+    CHECK_EQ(get_stats().inflight, 3);
+
+    host_mqtt_drop(&client);
+    outbox_session_lost();
+    outbox_stats_t stats = get_stats();
+    CHECK_EQ(stats.inflight, 0);
+    CHECK_EQ(stats.depth, 3);
+    CHECK_EQ(stats.retransmits, 3);
+
+    host_broker_set(BROKER_IP, HOST_BROKER_UP);
+    connect_client();
+    received_count = 0;
+    CHECK_EQ(outbox_drain(&client, now_ms()), 3);
+    host_clock_advance_ms(100);
+    CHECK_EQ(received_count, 3);
+    CHECK_STR(received_payload(0), "{\"c\":1,\"b\":42,\"q\":0,\"v\":1}");
+    CHECK_STR(received_payload(1), "{\"c\":1,\"b\":42,\"q\":1,\"v\":2}");
+    CHECK_STR(received_payload(2), "{\"c\":1,\"b\":42,\"q\":2,\"v\":3}");
+    CHECK_EQ(get_stats().acked, 3);
+    CHECK_EQ(outbox_pool()->in_use, 0);
+}
+
+static void test_sequence_stamping(void) {
+    setup();
+    connect_client();
+    char long_text[OUTBOX_PRODUCER_MAX + 20];
+    memset(long_text, 'x', sizeof(long_text));
+
+    CHECK(outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_TELEMETRY, "t", "{\"t\":1}", 7, 0, 0));
+    CHECK(outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_TELEMETRY, "t", "{}", 2, 0, 0));
+    CHECK(outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_TELEMETRY, "t", "25.5", 4, 0, 0));
+    CHECK(outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_TELEMETRY, "t", "nan", 3, 0, 0));
+    CHECK(outbox_publish(TELEMETRY_CH_DOOR, TELEMETRY_PRIO_STATE, "d", "aberta", 6, 0, 0));
+    CHECK(outbox_publish(TELEMETRY_CH_HISTORY, TELEMETRY_PRIO_BULK, "h", "\x01\x02", 2, 0, 0));
+    CHECK(outbox_publish(TELEMETRY_CH_METRICS, TELEMETRY_PRIO_BULK, "m", long_text, sizeof(long_text), 0, 0));
+    CHECK_EQ(outbox_drain(&client, now_ms()), 7);
+    host_clock_advance_ms(100);
+    CHECK_EQ(received_count, 7);
+
+    // Ordem de entrega: estado, telemetria, bulk
+    CHECK_STR(received_payload(0), "{\"c\":0,\"b\":42,\"q\":0,\"v\":\"aberta\"}");
+    CHECK_STR(received_payload(1), "{\"c\":1,\"b\":42,\"q\":0,\"t\":1}");
+    CHECK_STR(received_payload(2), "{\"c\":1,\"b\":42,\"q\":1}");
+    CHECK_STR(received_payload(3), "{\"c\":1,\"b\":42,\"q\":2,\"v\":25.5}");
+    CHECK_STR(received_payload(4), "{\"c\":1,\"b\":42,\"q\":3,\"v\":\"nan\"}");
+    // Binário passa intacto; texto maior que o limite do produtor segue sem carimbo
+    CHECK_EQ(received[5].payload_len, 2);
+    CHECK_EQ(received[6].payload_len, sizeof(long_text));
+
+    outbox_stats_t stats = get_stats();
+    CHECK_EQ(stats.seq[TELEMETRY_CH_TEMPERATURE], 4);
+    CHECK_EQ(stats.seq[TELEMETRY_CH_DOOR], 1);
+    CHECK_EQ(stats.seq[TELEMETRY_CH_HISTORY], 0);
+    CHECK_EQ(stats.seq[TELEMETRY_CH_METRICS], 0);
+}
+
+static void test_ring_stall_and_alarm_latency(void) {
+    setup();
+    host_link_set(1, 20);   // 1 byte/ms: o anel enche antes de esvaziar
+    connect_client();
+    char payload[100];
+    memset(payload, '7', sizeof(payload));
+
+    for (int i = 0; i < 10; i++) {
+        CHECK(outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_TELEMETRY, "t", payload, sizeof(payload), 0, 0));
+    }
+    size_t first = outbox_drain(&client, now_ms());
+    outbox_stats_t stats = get_stats();
+    CHECK(first > 0 && first < 10);
+    CHECK_EQ(stats.ring_stalls, 1);
+    CHECK_EQ(stats.depth, 10 - first);
+
+    // Alarme preso atrás do anel cheio: sai na primeira drenagem com espaço, à frente da telemetria
+    CHECK(outbox_publish(TELEMETRY_CH_DOOR, TELEMETRY_PRIO_ALARM, "a", "1", 1, 0, 0));
+    host_clock_advance_ms(500);
+    CHECK(outbox_drain(&client, now_ms()) >= 1);
+    stats = get_stats();
+    CHECK_EQ(stats.alarm_latency_last_ms, 500);
+    CHECK_EQ(stats.alarm_latency_max_ms, 500);
+
+    for (int i = 0; i < 20 && get_stats().depth > 0; i++) {
+        host_clock_advance_ms(500);
+        outbox_drain(&client, now_ms());
+    }
+    host_clock_advance_ms(2000);
+    CHECK_EQ(get_stats().depth, 0);
+    CHECK_EQ(received_count, 11);
+    CHECK_STR(received[first].topic, "a");
+    CHECK_EQ(host_mqtt_ring_used(&client), 0);
+}
+
+// Chegada ao broker de cada alarme do teste de latência, pelo campo "n" do payload
+#define LATENCY_ALARMS 32
+static uint32_t alarm_sent_ms[LATENCY_ALARMS];
+static uint32_t alarm_arrived_ms[LATENCY_ALARMS];
+
+static void record_alarm_arrival(const host_mqtt_msg_t *msg, void *arg) {
+    char text[sizeof(msg->payload) + 1];
+    memcpy(text, msg->payload, msg->payload_len);
+    text[msg->payload_len] = '\0';
+    const char *n = strstr(text, "\"n\":");
+    if (strcmp(msg->topic, "a") == 0 && n != NULL) {
+        unsigned long index = strtoul(n + 4, NULL, 10);
+        if (index < LATENCY_ALARMS && alarm_arrived_ms[index] == 0) {
+            alarm_arrived_ms[index] = (uint32_t)(msg->at_us / 1000u);
+        }
+    }
+}
+
+static void test_alarm_latency_bound_during_backlog(void) {
+    setup();
+    memset(alarm_arrived_ms, 0, sizeof(alarm_arrived_ms));
+    host_mqtt_set_publish_hook(record_alarm_arrival, NULL);
+    /* Enlace fraco (1 byte/ms): cada mensagem de bulk leva ~155 ms no ar e o backlog, dentro da
+     * rajada do bucket global, mantém anel e requisições ocupados por alguns segundos */
+    const uint32_t rate = 1, rtt = 20, drain_interval = 50;
+    host_link_set(rate, rtt);
+    char bulk[150];
+    memset(bulk, 'h', sizeof(bulk));
+    for (int i = 0; i < OUTBOX_CAPACITY - 2; i++) {
+        CHECK(outbox_publish(TELEMETRY_CH_HISTORY, TELEMETRY_PRIO_BULK, "h", bulk, sizeof(bulk), 1, 0));
+    }
+    connect_client();
+    outbox_session_started(now_ms());
+
+    // Loop principal enquanto houver bulk na fila: drenagem a cada 50 ms, telemetria contínua e um alarme a cada 370 ms
+    size_t alarms = 0;
+    for (uint32_t t = 0; t < 20000 && get_stats().depth_by_priority[TELEMETRY_PRIO_BULK] > 0; t += 10) {
+        if (t % 500 == 0) {
+            outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_TELEMETRY, "t", bulk, 60, 0, 0);
+        }
+        if (t % 370 == 0 && alarms < LATENCY_ALARMS) {
+            char payload[16];
+            int len = snprintf(payload, sizeof(payload), "{\"n\":%u}", (unsigned)alarms);
+            alarm_sent_ms[alarms] = now_ms();
+            CHECK(outbox_publish(TELEMETRY_CH_DOOR, TELEMETRY_PRIO_ALARM, "a", payload, (uint16_t)len, 1, 0));
+            alarms++;
+        }
+        if (t % drain_interval == 0) {
+            outbox_drain(&client, now_ms());
+        }
+        host_clock_advance_ms(10);
+    }
+    for (int i = 0; i < 40; i++) {
+        outbox_drain(&client, now_ms());
+        host_clock_advance_ms(drain_interval);
+    }
+
+    /* Pior caso de um alarme até o broker: espera a drenagem, uma requisição livre (a mensagem em voo
+     * mais antiga sai do anel e volta o PUBACK), a drenagem seguinte e o anel à frente dele */
+    uint32_t ring_ms = MQTT_OUTPUT_RINGBUF_SIZE / rate;
+    uint32_t bound = 2 * drain_interval + 2 * ring_ms + rtt;
+    uint32_t worst = 0;
+    for (size_t i = 0; i < alarms; i++) {
+        CHECK(alarm_arrived_ms[i] != 0);
+        uint32_t latency = alarm_arrived_ms[i] - alarm_sent_ms[i];
+        worst = latency > worst ? latency : worst;
+    }
+    CHECK(worst <= bound);
+
+    // O cenário exercita o pior caso: vários alarmes atrás do backlog, anel cheio e tudo entregue
+    outbox_stats_t stats = get_stats();
+    CHECK(alarms >= 10);
+    CHECK(stats.ring_stalls > 0);
+    CHECK_EQ(stats.depth, 0);
+    CHECK(stats.alarm_latency_max_ms <= worst);
+    CHECK_EQ(stats.dropped, 0);
+}
+
+static void test_disconnected_drain_keeps_messages(void) {
+    setup();
+    CHECK(outbox_publish(TELEMETRY_CH_TEMPERATURE, TELEMETRY_PRIO_TELEMETRY, "t", "1", 1, 0, 0));
+    CHECK_EQ(outbox_drain(&client, now_ms()), 0);
+    outbox_stats_t stats = get_stats();
+    CHECK_EQ(stats.depth, 1);
+    CHECK_EQ(stats.ring_stalls, 0);
+    CHECK_EQ(stats.publish_errors, 0);
+}
+
+int main(void) {
+    RUN_TEST(test_priority_order);
+    RUN_TEST(test_aging_promotes_old_bulk);
+    RUN_TEST(test_drop_policy);
+    RUN_TEST(test_limits_rejected);
+    RUN_TEST(test_qos1_ack_and_resync);
+    RUN_TEST(test_qos1_timeout_requeues);
+    RUN_TEST(test_session_lost_requeues_in_order);
+    RUN_TEST(test_sequence_stamping);
+    RUN_TEST(test_ring_stall_and_alarm_latency);
+    RUN_TEST(test_alarm_latency_bound_during_backlog);
+    RUN_TEST(test_disconnected_drain_keeps_messages);
+    return test_report();
+}
@@ -0,0 +1,46 @@
+/* Testes da conversão do ADC e da formatação de tópicos e client ID. */
+#include "test_harness.h"
+#include "rack_format.h"
+
+static void test_temperature_conversion(void) {
+    // 0,706 V no sensor interno correspondem a 27 °C
+    CHECK_NEAR(convert_rack_temperature(876, 'C'), 27.14, 0.01);
+    float celsius = convert_rack_temperature(800, 'C');
+    CHECK_NEAR(convert_rack_temperature(800, 'F'), celsius * 9.0 / 5.0 + 32.0, 0.001);
+    CHECK(convert_rack_temperature(900, 'C') < convert_rack_temperature(800, 'C'));
+}
+
+static void test_invalid_unit_is_nan(void) {
+    CHECK(isnan(convert_rack_temperature(876, 'K')));
+    CHECK(isnan(convert_rack_temperature(876, '\0')));
+}
+
+static void test_rack_number_parse(void) {
+    CHECK_EQ(rack_number_parse("7"), 7);
+    CHECK_EQ(rack_number_parse("00042"), 42);
+    CHECK_EQ(rack_number_parse("99999"), 99999);
+    CHECK_EQ(rack_number_parse("100000"), 0);
+    CHECK_EQ(rack_number_parse("-3"), 0);
+    CHECK_EQ(rack_number_parse("abc"), 0);
+}
+
+static void test_topic_and_client_id(void) {
+    char buf[64];
+    CHECK_EQ(format_rack_topic(buf, sizeof(buf), "rack_inteligente", 7), 22);
+    CHECK_STR(buf, "rack_inteligente/00007");
+    CHECK_EQ(format_rack_client_id(buf, sizeof(buf), 12345), 10);
+    CHECK_STR(buf, "rack-12345");
+
+    // Truncado como snprintf: o retorno indica o tamanho necessário
+    char small[8];
+    CHECK_EQ(format_rack_client_id(small, sizeof(small), 7), 10);
+    CHECK_STR(small, "rack-00");
+}
+
+int main(void) {
+    RUN_TEST(test_temperature_conversion);
+    RUN_TEST(test_invalid_unit_is_nan);
+    RUN_TEST(test_rack_number_parse);
+    RUN_TEST(test_topic_and_client_id);
+    return test_report();
+}
@@ -0,0 +1,103 @@
+/* Testes dos token buckets por canal e global: rajada, reposição, alarmes e contadores. */
+#include "test_harness.h"
+#include "rate_limit.h"
+
+static void test_bucket_burst_and_refill(void) {
+    token_bucket_t bucket;
+    token_bucket_init(&bucket, 60, 3, 0);
+    CHECK(token_bucket_take(&bucket, 0));
+    CHECK(token_bucket_take(&bucket, 0));
+    CHECK(token_bucket_take(&bucket, 0));
+    CHECK(!token_bucket_take(&bucket, 0));
+    CHECK(!token_bucket_take(&bucket, 999));
+    CHECK(token_bucket_take(&bucket, 1000));  // 60/min = 1 token/s
+    CHECK(!token_bucket_take(&bucket, 1000));
+}
+
+static void test_bucket_caps_at_burst_and_survives_wrap(void) {
+    token_bucket_t bucket;
+    token_bucket_init(&bucket, 60, 2, UINT32_MAX - 500);
+    CHECK(token_bucket_take(&bucket, UINT32_MAX - 500));
+    CHECK(token_bucket_take(&bucket, UINT32_MAX - 500));
+    CHECK(!token_bucket_take(&bucket, UINT32_MAX - 500));
+    // Passa pelo estouro de 32 bits do relógio: 1 s depois há um token de novo
+    CHECK(token_bucket_take(&bucket, 499));
+    // Uma hora parado não passa da rajada
+    int taken = 0;
+    while (token_bucket_take(&bucket, 3600u * 1000u)) {
+        taken++;
+    }
+    CHECK_EQ(taken, 2);
+}
+
+static void test_channel_admission_and_throttled_counter(void) {
+    rate_limit_init(0);
+    // GPS: rajada de 2
+    CHECK(rate_limit_admit(TELEMETRY_CH_GPS, TELEMETRY_PRIO_TELEMETRY, 0));
+    CHECK(rate_limit_admit(TELEMETRY_CH_GPS, TELEMETRY_PRIO_TELEMETRY, 0));
+    CHECK(!rate_limit_admit(TELEMETRY_CH_GPS, TELEMETRY_PRIO_TELEMETRY, 0));
+    CHECK_EQ(rate_limit_throttled(TELEMETRY_CH_GPS), 1);
+    CHECK_EQ(rate_limit_throttled(TELEMETRY_CH_DOOR), 0);
+    CHECK_EQ(rate_limit_throttled(TELEMETRY_CH_COUNT), 0);
+
+    // 12/min: um token a cada 5 s
+    CHECK(!rate_limit_admit(TELEMETRY_CH_GPS, TELEMETRY_PRIO_TELEMETRY, 4999));
+    CHECK(rate_limit_admit(TELEMETRY_CH_GPS, TELEMETRY_PRIO_TELEMETRY, 10000));
+    CHECK_EQ(rate_limit_throttled(TELEMETRY_CH_GPS), 2);
+}
+
+static void test_alarms_always_pass_but_consume(void) {
+    rate_limit_init(0);
+    for (int i = 0; i < 50; i++) {
+        CHECK(rate_limit_admit(TELEMETRY_CH_DOOR, TELEMETRY_PRIO_ALARM, 0));
+    }
+    // O alarme gastou a rajada do canal: um evento comum da porta é contido
+    CHECK(!rate_limit_admit(TELEMETRY_CH_DOOR, TELEMETRY_PRIO_STATE, 0));
+    CHECK_EQ(rate_limit_throttled(TELEMETRY_CH_DOOR), 1);
+}
+
+static void test_global_drain_defers(void) {
+    rate_limit_init(0);
+    int passed = 0;
+    while (rate_limit_drain(TELEMETRY_PRIO_BULK, 0)) {
+        passed++;
+    }
+    CHECK_EQ(passed, 40);
+    CHECK_EQ(rate_limit_deferred(), 1);
+    CHECK(rate_limit_drain(TELEMETRY_PRIO_ALARM, 0));
+    CHECK_EQ(rate_limit_deferred(), 1);
+    // 120/min: meio segundo por token
+    CHECK(rate_limit_drain(TELEMETRY_PRIO_BULK, 500));
+
+    rate_limit_init(1000);
+    CHECK_EQ(rate_limit_deferred(), 0);
+}
+
+static void test_drain_cancel_returns_token(void) {
+    rate_limit_init(0);
+    // Anel cheio a cada tentativa: a mensagem volta à fila sem gastar a rajada
+    for (int i = 0; i < 100; i++) {
+        CHECK(rate_limit_drain(TELEMETRY_PRIO_BULK, 0));
+        rate_limit_drain_cancel();
+    }
+    int passed = 0;
+    while (rate_limit_drain(TELEMETRY_PRIO_BULK, 0)) {
+        passed++;
+    }
+    CHECK_EQ(passed, 40);
+
+    // Alarme liberado sem token: cancelar não cria um token para o bulk
+    CHECK(rate_limit_drain(TELEMETRY_PRIO_ALARM, 0));
+    rate_limit_drain_cancel();
+    CHECK(!rate_limit_drain(TELEMETRY_PRIO_BULK, 0));
+}
+
+int main(void) {
+    RUN_TEST(test_bucket_burst_and_refill);
+    RUN_TEST(test_bucket_caps_at_burst_and_survives_wrap);
+    RUN_TEST(test_channel_admission_and_throttled_counter);
+    RUN_TEST(test_alarms_always_pass_but_consume);
+    RUN_TEST(test_global_drain_defers);
+    RUN_TEST(test_drain_cancel_returns_token);
+    return test_report();
+}
@@ -0,0 +1,88 @@
+/* Testes da saúde de sensores: falha de leitura, faixa, travamento, ruído e mudanças reportadas. */
+#include "test_harness.h"
+#include "sensor_health.h"
+
+static void test_read_and_range_faults(void) {
+    sensor_health_t health;
+    sensor_health_init(&health, "temp", -20.0f, 80.0f, 0, 5.0f);
+    CHECK_EQ(sensor_health_update(&health, 25.0f), SENSOR_QUALITY_OK);
+    CHECK(sensor_health_value_usable(&health));
+    CHECK_EQ(sensor_health_update(&health, NAN), SENSOR_FAULT_READ);
+    CHECK(!sensor_health_value_usable(&health));
+    CHECK_EQ(sensor_health_update(&health, 25.0f), SENSOR_QUALITY_OK);
+    CHECK_EQ(sensor_health_update(&health, 120.0f) & SENSOR_FAULT_RANGE, SENSOR_FAULT_RANGE);
+    CHECK(!sensor_health_value_usable(&health));
+}
+
+static void test_stuck_after_identical_samples(void) {
+    sensor_health_t health;
+    sensor_health_init(&health, "temp", -20.0f, 80.0f, 5, 5.0f);
+    for (int i = 0; i < 5; i++) {
+        CHECK_EQ(sensor_health_update(&health, 30.0f), SENSOR_QUALITY_OK);
+    }
+    CHECK_EQ(sensor_health_update(&health, 30.0f), SENSOR_FAULT_STUCK);
+    CHECK(sensor_health_value_usable(&health));
+    CHECK(!sensor_health_value_trusted(&health));
+    CHECK_EQ(sensor_health_update(&health, 30.1f), SENSOR_QUALITY_OK);
+    CHECK(sensor_health_value_trusted(&health));
+}
+
+static void test_noise_average(void) {
+    sensor_health_t health;
+    sensor_health_init(&health, "temp", -20.0f, 80.0f, 0, 1.0f);
+    // Alternância de 4 °C: a média exponencial (1/8) passa de 1 °C na terceira variação
+    CHECK_EQ(sensor_health_update(&health, 20.0f), SENSOR_QUALITY_OK);
+    CHECK_EQ(sensor_health_update(&health, 24.0f), SENSOR_QUALITY_OK);   // 0,5
+    CHECK_EQ(sensor_health_update(&health, 20.0f), SENSOR_QUALITY_OK);   // 0,9375
+    CHECK_EQ(sensor_health_update(&health, 24.0f), SENSOR_FAULT_NOISY);  // 1,32
+    CHECK_NEAR(health.noise_avg, 1.3203, 0.001);
+    // Ruidosa: ainda publicável, mas não dispara alarme nem entra nos agregados
+    CHECK(sensor_health_value_usable(&health));
+    CHECK(!sensor_health_value_trusted(&health));
+
+    // Leituras estáveis fazem a média decair até sair do limite
+    int samples = 0;
+    while (sensor_health_update(&health, 24.0f) & SENSOR_FAULT_NOISY) {
+        samples++;
+    }
+    CHECK_EQ(samples, 2);
+}
+
+static void test_take_change_and_describe(void) {
+    sensor_health_t health;
+    sensor_health_init(&health, "temp", -20.0f, 80.0f, 2, 0.5f);
+    uint8_t new_faults = 0;
+    uint8_t cleared = 0;
+    sensor_health_update(&health, 25.0f);
+    CHECK(!sensor_health_take_change(&health, &new_faults, &cleared));
+
+    sensor_health_update(&health, 25.0f);
+    sensor_health_update(&health, 25.0f);
+    CHECK(sensor_health_take_change(&health, &new_faults, &cleared));
+    CHECK_EQ(new_faults, SENSOR_FAULT_STUCK);
+    CHECK_EQ(cleared, 0);
+    CHECK_EQ(health.fault_events, 1);
+    CHECK(!sensor_health_take_change(&health, &new_faults, &cleared));
+
+    sensor_health_update(&health, 25.2f);
+    CHECK(sensor_health_take_change(&health, &new_faults, &cleared));
+    CHECK_EQ(new_faults, 0);
+    CHECK_EQ(cleared, SENSOR_FAULT_STUCK);
+    CHECK_EQ(health.fault_events, 1);
+
+    char text[32];
+    sensor_health_describe(SENSOR_QUALITY_OK, text, sizeof(text));
+    CHECK_STR(text, "ok");
+    sensor_health_describe(SENSOR_FAULT_STUCK | SENSOR_FAULT_NOISY, text, sizeof(text));
+    CHECK_STR(text, "stuck,noisy");
+    sensor_health_describe(SENSOR_FAULT_READ | SENSOR_FAULT_RANGE | SENSOR_FAULT_STUCK | SENSOR_FAULT_NOISY, text, 10);
+    CHECK_STR(text, "read,rang");
+}
+
+int main(void) {
+    RUN_TEST(test_read_and_range_faults);
+    RUN_TEST(test_stuck_after_identical_samples);
+    RUN_TEST(test_noise_average);
+    RUN_TEST(test_take_change_and_describe);
+    return test_report();
+}
@@ -0,0 +1,129 @@
+/* Testes da compressão delta-de-delta: ida e volta em todos os baldes, limite de capacidade
+ * e extremos de 16 bits. */
+#include "test_harness.h"
+#include "ts_compress.h"
+
+static bool round_trip(const int16_t *values, size_t count, size_t *bits) {
+    uint8_t buf[4096];
+    ts_encoder_t enc;
+    ts_encoder_init(&enc, buf, sizeof(buf));
+    for (size_t i = 0; i < count; i++) {
+        if (!ts_encode(&enc, values[i])) {
+            return false;
+        }
+    }
+    if (bits != NULL) {
+        *bits = enc.bits;
+    }
+
+    ts_decoder_t dec;
+    ts_decoder_init(&dec, buf, ts_encoder_bytes(&enc));
+    for (size_t i = 0; i < count; i++) {
+        int16_t value;
+        if (!ts_decode(&dec, &value) || value != values[i]) {
+            return false;
+        }
+    }
+    return ts_decoder_bytes(&dec) == ts_encoder_bytes(&enc);
+}
+
+static void test_constant_series_costs_one_bit_per_sample(void) {
+    int16_t values[120];
+    for (size_t i = 0; i < 120; i++) {
+        values[i] = 2512;
+    }
+    size_t bits = 0;
+    CHECK(round_trip(values, 120, &bits));
+    CHECK_EQ(bits, 16 + 119);
+}
+
+static void test_bucket_sizes_at_range_edges(void) {
+    static const struct {
+        int32_t dod;
+        size_t bits;
+    } cases[] = {
+        { 0, 1 },
+        { 1, 9 }, { -63, 9 }, { 64, 9 },
+        { -64, 12 }, { 65, 12 }, { -255, 12 }, { 256, 12 },
+        { -256, 16 }, { 257, 16 }, { -2047, 16 }, { 2048, 16 },
+        { -2048, 22 }, { 2049, 22 }, { 30000, 22 }, { -30000, 22 },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        // Duas amostras iguais zeram o delta anterior: a terceira codifica exatamente o dod
+        int16_t values[3] = { 100, 100, (int16_t)(100 + cases[i].dod) };
+        size_t bits = 0;
+        CHECK(round_trip(values, 3, &bits));
+        CHECK_EQ(bits, 16 + 1 + cases[i].bits);
+    }
+}
+
+static void test_extremes_round_trip(void) {
+    int16_t values[64];
+    for (size_t i = 0; i < 64; i++) {
+        values[i] = (i % 2) ? INT16_MAX : INT16_MIN;
+    }
+    CHECK(round_trip(values, 64, NULL));
+}
+
+static void test_random_walks_round_trip(void) {
+    host_rand_seed(89);
+    for (int trial = 0; trial < 500; trial++) {
+        int16_t values[200];
+        int32_t value = (int32_t)(host_rand_32() % 6000) - 1000;
+        for (size_t i = 0; i < 200; i++) {
+            uint32_t r = host_rand_32();
+            int32_t step = (r % 16 == 0) ? (int32_t)(r % 20001) - 10000 : (int32_t)(r % 9) - 4;
+            value += step;
+            value = value > INT16_MAX ? INT16_MAX : (value < INT16_MIN ? INT16_MIN : value);
+            values[i] = (int16_t)value;
+        }
+        if (!round_trip(values, 200, NULL)) {
+            CHECK(false);
+            return;
+        }
+    }
+    CHECK(true);
+}
+
+static void test_full_buffer_rejects_without_changing_stream(void) {
+    uint8_t buf[3];
+    ts_encoder_t enc;
+    ts_encoder_init(&enc, buf, sizeof(buf));
+    CHECK(ts_encode(&enc, 500));
+    for (int i = 0; i < 8; i++) {
+        CHECK(ts_encode(&enc, 500));
+    }
+    CHECK_EQ(enc.bits, 24);
+    CHECK(!ts_encode(&enc, 500));
+    CHECK_EQ(enc.bits, 24);
+    CHECK_EQ(enc.count, 9);
+
+    uint8_t tiny[1];
+    ts_encoder_init(&enc, tiny, sizeof(tiny));
+    CHECK(!ts_encode(&enc, 1));
+}
+
+static void test_truncated_stream_fails(void) {
+    uint8_t buf[8];
+    ts_encoder_t enc;
+    ts_encoder_init(&enc, buf, sizeof(buf));
+    CHECK(ts_encode(&enc, 0));
+    CHECK(ts_encode(&enc, 20000));
+
+    ts_decoder_t dec;
+    ts_decoder_init(&dec, buf, 3);  // corta o campo de 18 bits do segundo valor
+    int16_t value;
+    CHECK(ts_decode(&dec, &value));
+    CHECK_EQ(value, 0);
+    CHECK(!ts_decode(&dec, &value));
+}
+
+int main(void) {
+    RUN_TEST(test_constant_series_costs_one_bit_per_sample);
+    RUN_TEST(test_bucket_sizes_at_range_edges);
+    RUN_TEST(test_extremes_round_trip);
+    RUN_TEST(test_random_walks_round_trip);
+    RUN_TEST(test_full_buffer_rejects_without_changing_stream);
+    RUN_TEST(test_truncated_stream_fails);
+    return test_report();
+}
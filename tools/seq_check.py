@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Verificador de perdas a partir das sequências carimbadas pelo firmware (RACK_MSG_SEQ).
+
+Lê a saída de `mosquitto_sub -v` (linhas "<tópico> <payload>") da entrada padrão ou de
+arquivos e reporta, por rack e por canal, mensagens recebidas, perdidas e duplicadas.
+
+    mosquitto_sub -h broker -v -R -t 'racks/#' | tools/seq_check.py
+    tools/seq_check.py captura.log --base racks
+
+Cada payload JSON traz "c" (canal), "b" (época de boot) e "q" (sequência por canal). Um
+boot novo reinicia a sequência; mensagens de um boot anterior que chegam atrasadas
+(QoS 1 reenviada após reconexão) não contam como perda. Use -R no mosquitto_sub para
+não receber as cópias retidas antigas na assinatura.
+"""
+
+import argparse
+import json
+import sys
+from collections import defaultdict
+
+CHANNELS = ["door", "temperature", "gps", "metrics", "summary", "history", "capture", "modbus", "sensor"]
+
+
+class Stream:
+    """Sequência de um (rack, canal) dentro de um boot."""
+
+    def __init__(self):
+        self.boot = None
+        self.expected = None
+        self.seen = set()
+        self.received = 0
+        self.missing = 0
+        self.duplicates = 0
+        self.boots = 0
+
+    def add(self, boot, seq):
+        if self.boot is None or boot > self.boot:
+            # Captura iniciada no meio de um boot: a origem é o primeiro valor visto;
+            # nos boots seguintes a sequência recomeça do zero
+            self.expected = seq if self.boot is None else 0
+            self.boot = boot
+            self.seen = set()
+            self.boots += 1
+        elif boot < self.boot:
+            self.received += 1  # atraso de um boot anterior
+            return
+
+        if seq in self.seen:
+            self.duplicates += 1
+            return
+        self.seen.add(seq)
+        self.received += 1
+
+        if seq >= self.expected:
+            self.missing += seq - self.expected
+            self.expected = seq + 1
+        else:
+            # Chegou fora de ordem: preenche uma lacuna contada antes
+            self.missing -= 1
+
+
+def rack_of(topic, base):
+    parts = topic.split("/")
+    if base:
+        base_parts = base.strip("/").split("/")
+        if parts[: len(base_parts)] != base_parts or len(parts) <= len(base_parts):
+            return None
+        return parts[len(base_parts)]
+    return parts[1] if len(parts) > 1 else None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("files", nargs="*", help="capturas de mosquitto_sub -v (padrão: entrada padrão)")
+    parser.add_argument("--base", default="", help="MQTT_BASE_TOPIC; o segmento seguinte é o rack")
+    args = parser.parse_args()
+
+    streams = defaultdict(Stream)
+    unstamped = 0
+
+    inputs = [open(name, encoding="utf-8", errors="replace") for name in args.files] or [sys.stdin]
+    for handle in inputs:
+        for line in handle:
+            topic, _, payload = line.rstrip("\n").partition(" ")
+            rack = rack_of(topic, args.base)
+            if rack is None:
+                continue
+            try:
+                message = json.loads(payload)
+            except ValueError:
+                unstamped += 1
+                continue
+            if not isinstance(message, dict) or not {"c", "b", "q"} <= message.keys():
+                unstamped += 1
+                continue
+            streams[(rack, message["c"])].add(message["b"], message["q"])
+
+    print(f"{'rack':>8} {'canal':<12} {'boots':>5} {'recebidas':>9} {'perdidas':>8} {'dup':>5} {'perda':>7}")
+    totals = defaultdict(lambda: [0, 0])
+    for (rack, channel), stream in sorted(streams.items()):
+        name = CHANNELS[channel] if 0 <= channel < len(CHANNELS) else str(channel)
+        expected = stream.received + stream.missing
+        loss = stream.missing / expected if expected else 0.0
+        totals[rack][0] += stream.received
+        totals[rack][1] += stream.missing
+        print(f"{rack:>8} {name:<12} {stream.boots:>5} {stream.received:>9} {stream.missing:>8} "
+              f"{stream.duplicates:>5} {loss:>7.2%}")
+
+    print()
+    for rack, (received, missing) in sorted(totals.items()):
+        expected = received + missing
+        print(f"rack {rack}: taxa de entrega {received / expected if expected else 1.0:.2%} "
+              f"({missing} perdidas de {expected})")
+    if unstamped:
+        print(f"{unstamped} mensagens sem carimbo de sequência ignoradas", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,259 @@
+#!/usr/bin/env python3
+"""Receptor dos traps SNMP do firmware (RACK_SNMP, snmp_agent.h) com medida de latência.
+
+Escuta traps SNMPv1/v2c em UDP, decodifica as variáveis da MIB do rack e, com a saída de
+`mosquitto_sub -v` na entrada padrão, pareia cada trap com o alarme MQTT do mesmo tipo
+(<rack>/door e <rack>/temperature/alarm) e mede quanto o trap chegou antes do MQTT. Os dois
+chegam à mesma máquina, então a diferença não depende de relógio sincronizado:
+
+    mosquitto_sub -h broker -v -t 'racks/+/door' -t 'racks/+/temperature/alarm' \\
+        | sudo tools/snmp_trap_latency.py
+
+(configure RACK_SNMP_TRAP_HOST com o IP desta máquina; a porta 162 exige root ou
+CAP_NET_BIND_SERVICE). Sem MQTT na entrada, só os traps são listados.
+
+Para cada trap imprime também a variação de atraso na rede: o intervalo entre dois traps
+medido pelo receptor menos o medido pelo dispositivo (time-stamp/sysUpTime, em centésimos).
+O custo de montar e enviar o trap no dispositivo está no metrics "snmp" (last_us/max_us).
+Ctrl-C (ou --count) encerra e imprime o resumo.
+"""
+
+import argparse
+import os
+import selectors
+import socket
+import sys
+import time
+from collections import deque
+
+ENTERPRISE = "1.3.6.1.4.1.26381"
+RACK_ARC = "77.1"
+RACK_OBJECTS = {1: "rackNumber", 2: "rackDoorOpen", 3: "rackTemperature", 4: "rackTemperatureAlarm",
+                5: "rackAlarmCount"}
+TRAP_KINDS = {1: "door", 2: "temperature"}
+SYS_UPTIME = "1.3.6.1.2.1.1.3.0"
+SNMP_TRAP_OID = "1.3.6.1.6.3.1.1.4.1.0"
+
+
+# ---- BER ----
+
+def read_tlv(data, pos):
+    tag = data[pos]
+    length = data[pos + 1]
+    pos += 2
+    if length & 0x80:
+        count = length & 0x7F
+        length = int.from_bytes(data[pos:pos + count], "big")
+        pos += count
+    return tag, data[pos:pos + length], pos + length
+
+
+def read_children(data):
+    pos = 0
+    while pos < len(data):
+        tag, value, pos = read_tlv(data, pos)
+        yield tag, value
+
+
+def decode_oid(value):
+    arcs = [value[0] // 40, value[0] % 40]
+    arc = 0
+    for b in value[1:]:
+        arc = (arc << 7) | (b & 0x7F)
+        if not b & 0x80:
+            arcs.append(arc)
+            arc = 0
+    return ".".join(map(str, arcs))
+
+
+def decode_value(tag, value):
+    if tag == 0x02:                                 # INTEGER
+        return int.from_bytes(value, "big", signed=True)
+    if tag in (0x41, 0x42, 0x43, 0x46):             # Counter32, Gauge32, TimeTicks, Counter64
+        return int.from_bytes(value, "big")
+    if tag == 0x06:
+        return decode_oid(value)
+    if tag == 0x40 and len(value) == 4:             # IpAddress
+        return ".".join(map(str, value))
+    if tag == 0x04:
+        return value.decode("ascii", "replace")
+    return value.hex()
+
+
+def parse_trap(packet):
+    """Retorna (versão, comunidade, específico, time-stamp, {oid: valor}) ou None."""
+    tag, message, _ = read_tlv(packet, 0)
+    if tag != 0x30:
+        return None
+    fields = list(read_children(message))
+    if len(fields) != 3:
+        return None
+    version = decode_value(*fields[0])
+    community = decode_value(*fields[1])
+    pdu_tag, pdu = fields[2]
+    pdu_fields = list(read_children(pdu))
+
+    if pdu_tag == 0xA4:                             # SNMPv1 Trap-PDU
+        _, _, generic, specific, stamp, varbinds = pdu_fields
+        specific = decode_value(*specific) if decode_value(*generic) == 6 else None
+        stamp = decode_value(*stamp)
+    elif pdu_tag == 0xA7:                           # SNMPv2-Trap-PDU
+        varbinds = pdu_fields[3]
+        specific = stamp = None
+    else:
+        return None
+
+    values = {}
+    for _, varbind in read_children(varbinds[1]):
+        (_, oid), (value_tag, value) = list(read_children(varbind))
+        values[decode_oid(oid)] = decode_value(value_tag, value)
+    if pdu_tag == 0xA7:
+        stamp = values.pop(SYS_UPTIME, None)
+        trap_oid = str(values.pop(SNMP_TRAP_OID, ""))
+        # v2c: o lwIP mapeia o trap específico para <enterprise>.0.<específico>
+        if trap_oid.startswith(ENTERPRISE + ".0."):
+            specific = int(trap_oid.rsplit(".", 1)[1])
+    return version, community, specific, stamp, values
+
+
+def describe(values):
+    names = []
+    for oid, value in sorted(values.items()):
+        prefix = "%s.%s." % (ENTERPRISE, RACK_ARC)
+        if oid.startswith(prefix):
+            number = int(oid[len(prefix):].split(".")[0])
+            name = RACK_OBJECTS.get(number, oid)
+            if number == 3:
+                value = "%.2f" % (value / 100.0)
+            names.append("%s=%s" % (name, value))
+        else:
+            names.append("%s=%s" % (oid, value))
+    return " ".join(names)
+
+
+def mqtt_kind(topic):
+    if topic.endswith("/door"):
+        return "door"
+    if topic.endswith("/temperature/alarm"):
+        return "temperature"
+    return None
+
+
+def percentile(values, fraction):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(len(ordered) * fraction))]
+
+
+class Matcher:
+    """Pareia trap e alarme MQTT do mesmo tipo que chegam dentro da janela, em ordem de chegada."""
+
+    def __init__(self, window):
+        self.window = window
+        self.pending = {"trap": {}, "mqtt": {}}
+        self.leads_ms = []
+
+    def add(self, source, kind, at):
+        other = "mqtt" if source == "trap" else "trap"
+        queue = self.pending[other].setdefault(kind, deque())
+        while queue and at - queue[0] > self.window:
+            queue.popleft()
+        if not queue:
+            self.pending[source].setdefault(kind, deque()).append(at)
+            return None
+        match = queue.popleft()
+        trap_at, mqtt_at = (at, match) if source == "trap" else (match, at)
+        lead_ms = (mqtt_at - trap_at) * 1000.0
+        self.leads_ms.append(lead_ms)
+        return lead_ms
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--bind", default="0.0.0.0", help="endereço de escuta")
+    parser.add_argument("--port", type=int, default=162, help="porta UDP dos traps")
+    parser.add_argument("--window", type=float, default=10.0, help="janela de pareamento trap/MQTT em segundos")
+    parser.add_argument("--count", type=int, default=0, help="encerra depois de N traps")
+    parser.add_argument("--no-mqtt", action="store_true", help="não lê o mosquitto_sub da entrada padrão")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind((args.bind, args.port))
+    selector = selectors.DefaultSelector()
+    selector.register(sock, selectors.EVENT_READ, "trap")
+    read_mqtt = not args.no_mqtt and not sys.stdin.isatty()
+    if read_mqtt:
+        selector.register(sys.stdin, selectors.EVENT_READ, "mqtt")
+    print("escutando traps em %s:%d%s" % (args.bind, args.port, ", alarmes MQTT da entrada padrão" if read_mqtt else ""),
+          file=sys.stderr)
+
+    matcher = Matcher(args.window)
+    jitters_ms = []
+    last = {}          # agente -> (chegada, time-stamp) do trap anterior
+    traps = 0
+    mqtt_buffer = b""
+    try:
+        while not args.count or traps < args.count:
+            for key, _ in selector.select():
+                now = time.monotonic()
+                if key.data == "mqtt":
+                    # Leitura sem buffer do Python: linhas já lidas não podem ficar esperando o próximo select
+                    chunk = os.read(sys.stdin.fileno(), 4096)
+                    if not chunk:
+                        selector.unregister(sys.stdin)
+                        continue
+                    mqtt_buffer += chunk
+                    *lines, mqtt_buffer = mqtt_buffer.split(b"\n")
+                    for line in lines:
+                        kind = mqtt_kind(line.split(None, 1)[0].decode("utf-8", "replace")) if line.strip() else None
+                        if kind is not None:
+                            lead = matcher.add("mqtt", kind, now)
+                            if lead is not None:
+                                print("  mqtt %-11s trap chegou %.1f ms antes" % (kind, lead))
+                    continue
+
+                packet, (agent, _) = sock.recvfrom(4096)
+                try:
+                    trap = parse_trap(packet)
+                except (IndexError, ValueError):
+                    trap = None
+                if trap is None:
+                    print("%s: pacote não reconhecido (%d bytes)" % (agent, len(packet)), file=sys.stderr)
+                    continue
+                version, community, specific, stamp, values = trap
+                traps += 1
+                kind = TRAP_KINDS.get(specific, "específico %s" % specific)
+
+                jitter = ""
+                if stamp is not None and agent in last:
+                    prev_at, prev_stamp = last[agent]
+                    # time-stamp em centésimos: a diferença dos intervalos é a variação do atraso na rede
+                    delta_ms = (now - prev_at) * 1000.0 - (stamp - prev_stamp) * 10.0
+                    jitters_ms.append(delta_ms)
+                    jitter = " variação %+.0f ms" % delta_ms
+                if stamp is not None:
+                    last[agent] = (now, stamp)
+
+                print("%s v%s %s %-11s uptime %s %s%s" % (agent, "1" if version == 0 else "2c", community, kind,
+                                                          "%.2fs" % (stamp / 100.0) if stamp is not None else "?",
+                                                          describe(values), jitter))
+                if kind in TRAP_KINDS.values():
+                    lead = matcher.add("trap", kind, now)
+                    if lead is not None:
+                        print("  trap %-11s chegou %.1f ms antes do MQTT" % (kind, lead))
+    except KeyboardInterrupt:
+        pass
+
+    print("\n%d traps" % traps)
+    if matcher.leads_ms:
+        leads = matcher.leads_ms
+        print("trap antes do MQTT: %d pares, mediana %.1f ms, mín %.1f ms, máx %.1f ms"
+              % (len(leads), percentile(leads, 0.5), min(leads), max(leads)))
+    if jitters_ms:
+        spread = [abs(j) for j in jitters_ms]
+        print("variação do atraso entre traps: p50 %.0f ms, p95 %.0f ms (resolução de 10 ms do time-stamp)"
+              % (percentile(spread, 0.5), percentile(spread, 0.95)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
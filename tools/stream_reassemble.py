@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Remontagem dos fluxos publicados pelo firmware (stream_pub.h).
+
+Lê a saída de `mosquitto_sub -v -F '%t %x'` (linhas "<tópico> <payload em hex>") da
+entrada padrão ou de arquivos, junta os trechos <base>/<n> de cada fluxo entre o
+<base>/meta e o <base>/end, confere a contagem de trechos e o CRC32 anunciados no "end"
+e grava a carga remontada em <saída>/<base com '_' no lugar de '/'>.bin.
+
+    mosquitto_sub -h broker -F '%t %x' -t 'racks/+/history/#' -t 'racks/+/capture/#' | tools/stream_reassemble.py -o dumps
+
+Para cada fluxo fechado imprime bytes, trechos, falhas, duração e vazão medidas no
+dispositivo (campo "ms" do end). As amostras de histórico e captura saem em CSV com
+tools/ts_decode.py.
+"""
+
+import argparse
+import json
+import os
+import sys
+import zlib
+
+
+class Stream:
+    def __init__(self):
+        self.meta = None
+        self.chunks = {}
+
+
+def finish(base, stream, end, out_dir):
+    expected = end.get("chunks", 0)
+    missing = [n for n in range(expected) if n not in stream.chunks]
+    data = b"".join(stream.chunks[n] for n in sorted(stream.chunks) if n < expected)
+    crc = zlib.crc32(data) & 0xFFFFFFFF
+
+    problems = []
+    if missing:
+        problems.append("faltam %d trechos (%s)" % (len(missing), ",".join(map(str, missing[:8]))))
+    if end.get("failed", 0):
+        problems.append("%d trechos recusados pelo broker" % end["failed"])
+    if len(data) != end.get("bytes", -1):
+        problems.append("bytes %d != %d anunciados" % (len(data), end.get("bytes", -1)))
+    if crc != end.get("crc", -1):
+        problems.append("crc %08x != %08x anunciado" % (crc, end.get("crc", 0) & 0xFFFFFFFF))
+
+    ms = end.get("ms", 0)
+    rate = (len(data) * 1000 // ms) if ms else 0
+    status = "OK" if not problems else "; ".join(problems)
+    print("%s: %d bytes em %d trechos, %d ms no dispositivo (%d B/s): %s"
+          % (base, len(data), expected, ms, rate, status))
+
+    if out_dir is not None:
+        os.makedirs(out_dir, exist_ok=True)
+        path = os.path.join(out_dir, base.replace("/", "_") + ".bin")
+        with open(path, "wb") as f:
+            f.write(data)
+        if stream.meta is not None:
+            with open(path[:-4] + ".json", "w") as f:
+                json.dump(stream.meta, f)
+    return not problems
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("files", nargs="*", help="capturas do mosquitto_sub (padrão: entrada padrão)")
+    parser.add_argument("-o", "--output", help="diretório para os .bin remontados")
+    args = parser.parse_args()
+
+    streams = {}
+    ok = True
+    sources = [open(name) for name in args.files] if args.files else [sys.stdin]
+    for source in sources:
+        for line in source:
+            parts = line.split(None, 1)
+            if len(parts) != 2:
+                continue
+            topic, payload_hex = parts
+            base, _, leaf = topic.rpartition("/")
+            try:
+                payload = bytes.fromhex(payload_hex.strip())
+            except ValueError:
+                continue
+
+            if leaf == "meta":
+                stream = streams[base] = Stream()
+                try:
+                    stream.meta = json.loads(payload)
+                except ValueError:
+                    pass
+            elif leaf == "end":
+                stream = streams.pop(base, None)
+                if stream is None:
+                    print("%s: end sem meta, ignorado" % base, file=sys.stderr)
+                    continue
+                try:
+                    end = json.loads(payload)
+                except ValueError:
+                    print("%s: end inválido" % base, file=sys.stderr)
+                    ok = False
+                    continue
+                ok = finish(base, stream, end, args.output) and ok
+            elif leaf.isdigit() and base in streams:
+                # Reenvio QoS 1 após reconexão chega duplicado com o mesmo conteúdo
+                streams[base].chunks[int(leaf)] = payload
+
+    for base in streams:
+        print("%s: fluxo sem end (%d trechos recebidos)" % (base, len(streams[base].chunks)), file=sys.stderr)
+        ok = False
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
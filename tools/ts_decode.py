@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""Decodificação do histórico e das capturas comprimidos pelo firmware (ts_compress.h).
+
+Lê os .bin gravados por stream_reassemble.py (com o .json do meta ao lado) e imprime as
+amostras em CSV. O tipo do fluxo vem do meta: o histórico traz "from"/"to", a captura
+traz "reason"; use --kind quando o meta não estiver disponível.
+
+    tools/stream_reassemble.py -o dumps < captura.txt
+    tools/ts_decode.py dumps/racks_00007_history_3.bin > historico.csv
+
+Colunas do histórico: bloco, ms desde o boot, epoch (vazio sem hora sincronizada), valor.
+Colunas da captura: amostra, ms relativos ao gatilho, epoch, valor.
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+
+# Largura e deslocamento do campo de cada balde, indexados pelo número de '1' do prefixo
+PAYLOAD_BITS = (0, 7, 9, 12, 18)
+PAYLOAD_BIAS = (0, 63, 255, 2047, 0)
+
+CAPTURE_ENC_RAW = 0
+CAPTURE_ENC_DOD = 1
+
+
+class BitReader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def get(self, nbits):
+        if self.pos + nbits > len(self.data) * 8:
+            raise ValueError("fluxo truncado")
+        value = 0
+        for _ in range(nbits):
+            byte = self.data[self.pos // 8]
+            value = (value << 1) | ((byte >> (7 - self.pos % 8)) & 1)
+            self.pos += 1
+        return value
+
+    def consumed(self):
+        return (self.pos + 7) // 8
+
+
+def ts_decode(data, count):
+    """Decodifica `count` amostras de um fluxo ts_compress; retorna (amostras, bytes lidos)."""
+    reader = BitReader(data)
+    samples = []
+    if count == 0:
+        return samples, 0
+    prev = struct.unpack(">h", reader.get(16).to_bytes(2, "big"))[0]
+    prev_delta = 0
+    samples.append(prev)
+    while len(samples) < count:
+        ones = 0
+        while ones < 4 and reader.get(1):
+            ones += 1
+        dod = 0
+        if ones == 4:
+            bits = reader.get(PAYLOAD_BITS[4])
+            dod = bits - (1 << 18) if bits & (1 << 17) else bits
+        elif ones > 0:
+            dod = reader.get(PAYLOAD_BITS[ones]) - PAYLOAD_BIAS[ones]
+        prev_delta += dod
+        prev += prev_delta
+        samples.append(prev)
+    return samples, reader.consumed()
+
+
+def epoch_of(meta, t_ms):
+    epoch = meta.get("epoch", 0)
+    if not epoch or "now_ms" not in meta:
+        return ""
+    return "%.3f" % (epoch - (meta["now_ms"] - t_ms) / 1000.0)
+
+
+def decode_history(data, meta, out):
+    scale = meta.get("scale", 100)
+    out.write("block,ms,epoch,value\n")
+    pos = 0
+    while pos + 15 <= len(data):
+        seq, start_ms, end_ms, count, bits = struct.unpack_from("<IIIBH", data, pos)
+        pos += 15
+        length = (bits + 7) // 8
+        samples, _ = ts_decode(data[pos:pos + length], count)
+        pos += length
+        step = (end_ms - start_ms) / (count - 1) if count > 1 else 0
+        for i, value in enumerate(samples):
+            t_ms = start_ms + round(i * step)
+            out.write("%d,%d,%s,%.2f\n" % (seq, t_ms, epoch_of(meta, t_ms), value / scale))
+    if pos != len(data):
+        raise ValueError("%d bytes sobrando após o último bloco" % (len(data) - pos))
+
+
+def decode_capture(data, meta, out):
+    scale = meta.get("scale", 100)
+    rate_hz = meta.get("rate_hz", 10)
+    pre = meta.get("pre", 0)
+    trigger_ms = meta.get("trigger_ms", 0)
+    capture_meta = dict(meta, now_ms=trigger_ms)
+
+    out.write("sample,rel_ms,epoch,value\n")
+    pos = 0
+    total = 0
+    while pos + 4 <= len(data):
+        first, count, enc = struct.unpack_from("<HBB", data, pos)
+        pos += 4
+        if enc == CAPTURE_ENC_DOD:
+            samples, used = ts_decode(data[pos:], count)
+        elif enc == CAPTURE_ENC_RAW:
+            used = 2 * count
+            samples = list(struct.unpack_from("<%dh" % count, data, pos))
+        else:
+            raise ValueError("codificação %d desconhecida no trecho da amostra %d" % (enc, first))
+        pos += used
+        for i, value in enumerate(samples):
+            rel_ms = (first + i - pre) * 1000 // rate_hz
+            out.write("%d,%d,%s,%.2f\n" % (first + i, rel_ms, epoch_of(capture_meta, trigger_ms + rel_ms), value / scale))
+        total += count
+    if pos != len(data):
+        raise ValueError("%d bytes sobrando após o último trecho" % (len(data) - pos))
+    if "n" in meta and total != meta["n"]:
+        raise ValueError("%d amostras decodificadas, meta anuncia %d" % (total, meta["n"]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("files", nargs="+", help=".bin remontados por stream_reassemble.py")
+    parser.add_argument("--kind", choices=("history", "capture"), help="tipo do fluxo quando não há meta")
+    args = parser.parse_args()
+
+    ok = True
+    for path in args.files:
+        meta = {}
+        meta_path = os.path.splitext(path)[0] + ".json"
+        if os.path.exists(meta_path):
+            with open(meta_path) as f:
+                meta = json.load(f)
+        kind = args.kind or ("capture" if "reason" in meta else "history" if "from" in meta else None)
+        if kind is None:
+            print("%s: sem meta; informe --kind" % path, file=sys.stderr)
+            ok = False
+            continue
+        with open(path, "rb") as f:
+            data = f.read()
+        try:
+            (decode_capture if kind == "capture" else decode_history)(data, meta, sys.stdout)
+        except (ValueError, struct.error) as e:
+            print("%s: %s" % (path, e), file=sys.stderr)
+            ok = False
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,145 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Compressão de séries temporais
+/ Descrição: Codificação delta-de-delta com empacotamento de bits em baldes (estilo Gorilla) para histórico e capturas.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <string.h>
+#include "ts_compress.h"
+
+static void put_bits(ts_encoder_t *enc, uint32_t value, uint8_t nbits) {
+    while (nbits > 0) {
+        size_t byte = enc->bits / 8;
+        uint8_t offset = enc->bits % 8;
+        uint8_t room = 8 - offset;
+        uint8_t take = nbits < room ? nbits : room;
+
+        uint8_t chunk = (uint8_t)((value >> (nbits - take)) & ((1u << take) - 1));
+        if (offset == 0) {
+            enc->buf[byte] = 0;
+        }
+        enc->buf[byte] |= (uint8_t)(chunk << (room - take));
+
+        enc->bits += take;
+        nbits -= take;
+    }
+}
+
+void ts_encoder_init(ts_encoder_t *enc, uint8_t *buf, size_t len) {
+    enc->buf = buf;
+    enc->capacity_bits = len * 8;
+    enc->bits = 0;
+    enc->count = 0;
+    enc->prev = 0;
+    enc->prev_delta = 0;
+}
+
+bool ts_encode(ts_encoder_t *enc, int16_t value) {
+    if (enc->count == 0) {
+        if (enc->capacity_bits < 16) {
+            return false;
+        }
+        put_bits(enc, (uint16_t)value, 16);
+        enc->prev = value;
+        enc->count = 1;
+        return true;
+    }
+
+    int32_t delta = (int32_t)value - enc->prev;
+    int32_t dod = delta - enc->prev_delta;
+
+    uint32_t prefix, prefix_bits, payload, payload_bits;
+    if (dod == 0) {
+        prefix = 0x0; prefix_bits = 1; payload = 0; payload_bits = 0;
+    } else if (dod >= -63 && dod <= 64) {
+        prefix = 0x2; prefix_bits = 2; payload = (uint32_t)(dod + 63); payload_bits = 7;
+    } else if (dod >= -255 && dod <= 256) {
+        prefix = 0x6; prefix_bits = 3; payload = (uint32_t)(dod + 255); payload_bits = 9;
+    } else if (dod >= -2047 && dod <= 2048) {
+        prefix = 0xE; prefix_bits = 4; payload = (uint32_t)(dod + 2047); payload_bits = 12;
+    } else {
+        prefix = 0xF; prefix_bits = 4; payload = (uint32_t)dod & 0x3FFFFu; payload_bits = 18;
+    }
+
+    if (enc->bits + prefix_bits + payload_bits > enc->capacity_bits) {
+        return false;
+    }
+    put_bits(enc, prefix, (uint8_t)prefix_bits);
+    if (payload_bits > 0) {
+        put_bits(enc, payload, (uint8_t)payload_bits);
+    }
+
+    enc->prev = value;
+    enc->prev_delta = delta;
+    enc->count++;
+    return true;
+}
+
+static bool get_bits(ts_decoder_t *dec, uint8_t nbits, uint32_t *value) {
+    if (dec->pos + nbits > dec->len_bits) {
+        return false;
+    }
+    uint32_t result = 0;
+    for (uint8_t i = 0; i < nbits; i++) {
+        size_t bit = dec->pos++;
+        result = (result << 1) | ((dec->buf[bit / 8] >> (7 - bit % 8)) & 1u);
+    }
+    *value = result;
+    return true;
+}
+
+void ts_decoder_init(ts_decoder_t *dec, const uint8_t *buf, size_t len) {
+    dec->buf = buf;
+    dec->len_bits = len * 8;
+    dec->pos = 0;
+    dec->count = 0;
+    dec->prev = 0;
+    dec->prev_delta = 0;
+}
+
+bool ts_decode(ts_decoder_t *dec, int16_t *value) {
+    uint32_t bits;
+    if (dec->count == 0) {
+        if (!get_bits(dec, 16, &bits)) {
+            return false;
+        }
+        dec->prev = (int16_t)bits;
+        dec->count = 1;
+        *value = (int16_t)dec->prev;
+        return true;
+    }
+
+    // Prefixo: até quatro '1' seguidos de '0' (o quarto '1' dispensa o zero)
+    uint8_t ones = 0;
+    while (ones < 4) {
+        if (!get_bits(dec, 1, &bits)) {
+            return false;
+        }
+        if (bits == 0) {
+            break;
+        }
+        ones++;
+    }
+
+    // Largura e deslocamento do campo de cada balde (ver ts_compress.h)
+    static const uint8_t payload_bits[] = { 0, 7, 9, 12, 18 };
+    static const int32_t payload_bias[] = { 0, 63, 255, 2047, 0 };
+
+    int32_t dod = 0;
+    if (ones > 0) {
+        if (!get_bits(dec, payload_bits[ones], &bits)) {
+            return false;
+        }
+        if (ones == 4) {
+            dod = (bits & 0x20000u) ? (int32_t)bits - 0x40000 : (int32_t)bits;  // 18 bits com sinal
+        } else {
+            dod = (int32_t)bits - payload_bias[ones];
+        }
+    }
+
+    int32_t delta = dec->prev_delta + dod;
+    dec->prev += delta;
+    dec->prev_delta = delta;
+    dec->count++;
+    *value = (int16_t)dec->prev;
+    return true;
+}
@@ -0,0 +1,58 @@
+#ifndef TS_COMPRESS_H
+#define TS_COMPRESS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Compressão de séries temporais estilo Gorilla (variante inteira, delta-de-delta) para amostras
+ * em intervalo regular. Fluxo de bits MSB primeiro: a primeira amostra ocupa 16 bits; as seguintes
+ * codificam dod = (v[i] - v[i-1]) - (v[i-1] - v[i-2]) em baldes:
+ *   '0'                 dod == 0
+ *   '10'   + 7 bits     -63   .. 64
+ *   '110'  + 9 bits     -255  .. 256
+ *   '1110' + 12 bits    -2047 .. 2048
+ *   '1111' + 18 bits    complemento de dois (qualquer dod entre amostras de 16 bits)
+ * Os campos de 7/9/12 bits guardam dod + 63/255/2047, como no Gorilla. */
+
+typedef struct {
+    uint8_t *buf;
+    size_t capacity_bits;
+    size_t bits;
+    uint16_t count;
+    int32_t prev;
+    int32_t prev_delta;
+} ts_encoder_t;
+
+void ts_encoder_init(ts_encoder_t *enc, uint8_t *buf, size_t len);
+
+// Acrescenta uma amostra; retorna false (sem alterar o fluxo) se ela não couber no buffer
+bool ts_encode(ts_encoder_t *enc, int16_t value);
+
+static inline size_t ts_encoder_bytes(const ts_encoder_t *enc) {
+    return (enc->bits + 7) / 8;
+}
+
+// Leitura de um fluxo produzido por ts_encode(), para as ferramentas e testes no host
+typedef struct {
+    const uint8_t *buf;
+    size_t len_bits;
+    size_t pos;
+    uint16_t count;
+    int32_t prev;
+    int32_t prev_delta;
+} ts_decoder_t;
+
+void ts_decoder_init(ts_decoder_t *dec, const uint8_t *buf, size_t len);
+
+/* Próxima amostra; false se o fluxo estiver truncado. O fluxo não marca o fim: os bits de
+ * enchimento do último byte decodificam como dod 0, então o chamador para na quantidade de
+ * amostras do bloco (campo count do histórico e da captura). */
+bool ts_decode(ts_decoder_t *dec, int16_t *value);
+
+// Bytes consumidos até aqui (o fluxo de cada bloco começa alinhado em byte)
+static inline size_t ts_decoder_bytes(const ts_decoder_t *dec) {
+    return (dec->pos + 7) / 8;
+}
+
+#endif /* TS_COMPRESS_H */
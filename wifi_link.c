@@ -0,0 +1,362 @@
+/* -------------------------------------------------------------------------------------------------------------------------------------
+/ Módulo: Conexão Wi-Fi
+/ Descrição: Associação e reassociação com caminho rápido (BSSID/canal/IP em cache na flash), recaída para varredura + DHCP
+/            e roaming para um AP mais forte do mesmo SSID.
+/----------------------------------------------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <string.h>
+#include "pico/cyw43_arch.h"
+#include "lwip/netif.h"
+#include "lwip/dhcp.h"
+#include "lwip/etharp.h"
+#include "persist.h"
+#include "wifi_link.h"
+
+#define WIFI_CACHE_VERSION 1
+
+// Registro gravado em PERSIST_SLOT_WIFI
+typedef struct {
+    uint32_t version;
+    uint8_t bssid[6];
+    uint8_t valid;
+    uint8_t channel;
+    uint32_t ip;
+    uint32_t netmask;
+    uint32_t gw;
+} wifi_cache_t;
+
+typedef enum {
+    WIFI_DOWN,
+    WIFI_JOINING,
+    WIFI_VERIFYING,    // IP em cache aplicado, aguardando resposta ARP do gateway
+    WIFI_WAIT_DHCP,
+    WIFI_UP,
+    WIFI_SCANNING,     // conectado, procurando um AP melhor para roaming
+} wifi_state_t;
+
+static const char *wifi_ssid;
+static const char *wifi_password;
+static uint32_t wifi_auth;
+
+static wifi_cache_t cache;
+static wifi_state_t state = WIFI_DOWN;
+static bool fast_attempt = false;
+static bool lease_from_cache = false;
+static uint32_t join_start_ms = 0;
+static uint32_t assoc_ms = 0;          // instante da associação
+static uint32_t next_attempt_ms = 0;
+static wifi_link_stats_t stats;
+
+static uint32_t next_rssi_ms = 0;
+static uint32_t low_rssi_samples = 0;
+static int32_t rssi_avg_x16 = 0;       // média móvel em 1/16 dB: a divisão inteira em dB travaria até 3 dB longe do sinal
+static uint32_t last_roam_scan_ms = 0;
+static bool roaming = false;
+static uint32_t roam_start_ms = 0;
+
+// Melhor candidato da varredura, preenchido no callback do driver
+static struct {
+    volatile bool found;
+    uint8_t bssid[6];
+    int16_t rssi;
+    uint8_t channel;
+} roam_candidate;
+static uint8_t current_bssid[6];
+
+static struct netif *sta_netif(void) {
+    return &cyw43_state.netif[CYW43_ITF_STA];
+}
+
+static void start_join(uint32_t now_ms) {
+    fast_attempt = cache.valid && !fast_attempt;   // alterna: rápido, depois completo
+    join_start_ms = now_ms;
+    lease_from_cache = false;
+
+    printf("[Wi-Fi] Conectando%s...\n", fast_attempt ? " (BSSID/canal em cache)" : "");
+    cyw43_arch_lwip_begin();
+    cyw43_wifi_join(&cyw43_state, strlen(wifi_ssid), (const uint8_t *)wifi_ssid,
+                    strlen(wifi_password), (const uint8_t *)wifi_password, wifi_auth,
+                    fast_attempt ? cache.bssid : NULL, fast_attempt ? cache.channel : CYW43_CHANNEL_NONE);
+    cyw43_arch_lwip_end();
+    state = WIFI_JOINING;
+}
+
+static void retry_later(uint32_t now_ms, bool immediately) {
+    cyw43_arch_lwip_begin();
+    cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA);
+    cyw43_arch_lwip_end();
+    state = WIFI_DOWN;
+    next_attempt_ms = immediately ? now_ms : now_ms + WIFI_LINK_RETRY_MS;
+}
+
+// Reaplica a última concessão e pergunta pelo gateway; o DHCP segue revalidando em paralelo
+static void apply_cached_lease(void) {
+    ip4_addr_t ip, netmask, gw;
+    ip4_addr_set_u32(&ip, cache.ip);
+    ip4_addr_set_u32(&netmask, cache.netmask);
+    ip4_addr_set_u32(&gw, cache.gw);
+
+    cyw43_arch_lwip_begin();
+    netif_set_addr(sta_netif(), &ip, &netmask, &gw);
+    etharp_request(sta_netif(), &gw);
+    cyw43_arch_lwip_end();
+}
+
+static bool gateway_resolved(void) {
+    ip4_addr_t gw;
+    ip4_addr_set_u32(&gw, cache.gw);
+    struct eth_addr *eth_ret;
+    const ip4_addr_t *ip_ret;
+
+    cyw43_arch_lwip_begin();
+    bool found = etharp_find_addr(sta_netif(), &gw, &eth_ret, &ip_ret) >= 0;
+    cyw43_arch_lwip_end();
+    return found;
+}
+
+static void drop_cached_lease(void) {
+    ip4_addr_t any;
+    ip4_addr_set_u32(&any, 0);
+    cyw43_arch_lwip_begin();
+    netif_set_addr(sta_netif(), &any, &any, &any);
+    cyw43_arch_lwip_end();
+}
+
+// Atualiza o cache com o AP e a concessão atuais; a flash só é regravada se algo mudou
+static void save_cache(void) {
+    wifi_cache_t fresh = { .version = WIFI_CACHE_VERSION, .valid = 1 };
+    uint8_t channel_info[12] = { 0 };
+
+    cyw43_arch_lwip_begin();
+    cyw43_wifi_get_bssid(&cyw43_state, fresh.bssid);
+    cyw43_ioctl(&cyw43_state, CYW43_IOCTL_GET_CHANNEL, sizeof(channel_info), channel_info, CYW43_ITF_STA);
+    fresh.ip = ip4_addr_get_u32(netif_ip4_addr(sta_netif()));
+    fresh.netmask = ip4_addr_get_u32(netif_ip4_netmask(sta_netif()));
+    fresh.gw = ip4_addr_get_u32(netif_ip4_gw(sta_netif()));
+    cyw43_arch_lwip_end();
+
+    fresh.channel = channel_info[0];   // channel_info_t.hw_channel (little-endian)
+    if (memcmp(&fresh, &cache, sizeof(cache)) != 0) {
+        cache = fresh;
+        persist_save(PERSIST_SLOT_WIFI, &cache, sizeof(cache));
+    }
+}
+
+static void link_up(uint32_t now_ms) {
+    state = WIFI_UP;
+    stats.connects++;
+    stats.last_ip_ms = now_ms - assoc_ms;
+    printf("[Wi-Fi] IP utilizável em %u ms após associação (%s)\n", (unsigned)stats.last_ip_ms,
+           lease_from_cache ? "concessão em cache" : "DHCP");
+
+    if (roaming) {
+        roaming = false;
+        stats.roams++;
+        stats.last_roam_ms = now_ms - roam_start_ms;
+        printf("[Wi-Fi] Roaming concluído em %u ms\n", (unsigned)stats.last_roam_ms);
+    }
+    low_rssi_samples = 0;
+    next_rssi_ms = now_ms;
+}
+
+static int roam_scan_callback(void *env, const cyw43_ev_scan_result_t *result) {
+    size_t ssid_len = strlen(wifi_ssid);
+    if (result->ssid_len != ssid_len || memcmp(result->ssid, wifi_ssid, ssid_len) != 0) {
+        return 0;
+    }
+    if (memcmp(result->bssid, current_bssid, sizeof(current_bssid)) == 0) {
+        return 0;
+    }
+    if (!roam_candidate.found || result->rssi > roam_candidate.rssi) {
+        memcpy(roam_candidate.bssid, result->bssid, sizeof(roam_candidate.bssid));
+        roam_candidate.rssi = result->rssi;
+        roam_candidate.channel = (uint8_t)result->channel;
+        roam_candidate.found = true;
+    }
+    return 0;
+}
+
+// Amostra o RSSI; retorna true quando o sinal ficou fraco tempo suficiente para procurar outro AP
+static bool sample_rssi(uint32_t now_ms) {
+    if ((int32_t)(now_ms - next_rssi_ms) < 0) {
+        return false;
+    }
+    next_rssi_ms = now_ms + WIFI_LINK_RSSI_PERIOD_MS;
+
+    int32_t rssi;
+    cyw43_arch_lwip_begin();
+    int err = cyw43_wifi_get_rssi(&cyw43_state, &rssi);
+    cyw43_arch_lwip_end();
+    if (err != 0) {
+        return false;
+    }
+
+    // Média móvel exponencial (alfa = 1/4) em ponto fixo; a primeira leitura inicializa a média
+    rssi_avg_x16 = (stats.rssi == 0) ? rssi * 16 : rssi_avg_x16 + (rssi * 16 - rssi_avg_x16) / 4;
+    stats.rssi_avg = (rssi_avg_x16 >= 0 ? rssi_avg_x16 + 8 : rssi_avg_x16 - 8) / 16;
+    stats.rssi_min = (stats.rssi == 0 || rssi < stats.rssi_min) ? rssi : stats.rssi_min;
+    stats.rssi = rssi;
+
+    low_rssi_samples = stats.rssi_avg < WIFI_LINK_ROAM_THRESHOLD_DBM ? low_rssi_samples + 1 : 0;
+    return low_rssi_samples >= WIFI_LINK_ROAM_LOW_SAMPLES &&
+           (stats.roam_scans == 0 || now_ms - last_roam_scan_ms >= WIFI_LINK_ROAM_COOLDOWN_MS);
+}
+
+static void start_roam_scan(uint32_t now_ms) {
+    cyw43_wifi_scan_options_t options = { 0 };
+    roam_candidate.found = false;
+
+    cyw43_arch_lwip_begin();
+    cyw43_wifi_get_bssid(&cyw43_state, current_bssid);
+    int err = cyw43_wifi_scan(&cyw43_state, &options, NULL, roam_scan_callback);
+    cyw43_arch_lwip_end();
+
+    last_roam_scan_ms = now_ms;
+    stats.roam_scans++;
+    if (err == 0) {
+        printf("[Wi-Fi] RSSI médio %d dBm, procurando AP melhor\n", (int)stats.rssi_avg);
+        state = WIFI_SCANNING;
+    }
+}
+
+// Fim da varredura: troca de AP só com margem sobre o sinal atual, reaproveitando o IP em cache
+static void finish_roam_scan(uint32_t now_ms) {
+    state = WIFI_UP;
+    if (!roam_candidate.found || roam_candidate.rssi < stats.rssi_avg + WIFI_LINK_ROAM_MARGIN_DB) {
+        printf("[Wi-Fi] Nenhum AP melhor encontrado\n");
+        return;
+    }
+
+    printf("[Wi-Fi] Roaming para %02x:%02x:%02x:%02x:%02x:%02x (canal %u, %d dBm)\n",
+           roam_candidate.bssid[0], roam_candidate.bssid[1], roam_candidate.bssid[2],
+           roam_candidate.bssid[3], roam_candidate.bssid[4], roam_candidate.bssid[5],
+           roam_candidate.channel, roam_candidate.rssi);
+
+    memcpy(cache.bssid, roam_candidate.bssid, sizeof(cache.bssid));
+    cache.channel = roam_candidate.channel;
+    cache.valid = 1;
+    roaming = true;
+    roam_start_ms = now_ms;
+
+    cyw43_arch_lwip_begin();
+    cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA);
+    cyw43_arch_lwip_end();
+    fast_attempt = false;   // start_join alterna para o caminho rápido com o novo BSSID
+    start_join(now_ms);
+}
+
+void wifi_link_init(const char *ssid, const char *password, uint32_t auth) {
+    wifi_ssid = ssid;
+    wifi_password = password;
+    wifi_auth = auth;
+
+    if (!persist_load(PERSIST_SLOT_WIFI, &cache, sizeof(cache)) || cache.version != WIFI_CACHE_VERSION) {
+        memset(&cache, 0, sizeof(cache));
+    }
+}
+
+void wifi_link_tick(uint32_t now_ms) {
+    switch (state) {
+        case WIFI_DOWN:
+            if ((int32_t)(now_ms - next_attempt_ms) >= 0) {
+                start_join(now_ms);
+            }
+            break;
+
+        case WIFI_JOINING: {
+            int status = cyw43_wifi_link_status(&cyw43_state, CYW43_ITF_STA);
+            uint32_t timeout = fast_attempt ? WIFI_LINK_FAST_JOIN_TIMEOUT_MS : WIFI_LINK_JOIN_TIMEOUT_MS;
+            if (status == CYW43_LINK_JOIN) {
+                assoc_ms = now_ms;
+                stats.last_assoc_ms = now_ms - join_start_ms;
+                stats.last_dhcp_ms = 0;
+                printf("[Wi-Fi] Associado em %u ms\n", (unsigned)stats.last_assoc_ms);
+                if (fast_attempt) {
+                    stats.fast_joins++;
+                }
+                if (fast_attempt && cache.ip != 0) {
+                    apply_cached_lease();
+                    state = WIFI_VERIFYING;
+                } else {
+                    state = WIFI_WAIT_DHCP;
+                }
+            } else if (status < 0 || now_ms - join_start_ms >= timeout) {
+                printf("[Wi-Fi] Falha na associação (status %d)\n", status);
+                if (fast_attempt) {
+                    stats.fast_fallbacks++;
+                }
+                // Caminho rápido falhou (AP trocado ou mudou de canal): varredura completa na hora
+                retry_later(now_ms, fast_attempt);
+            }
+            break;
+        }
+
+        case WIFI_VERIFYING:
+            if (gateway_resolved()) {
+                stats.cached_leases++;
+                lease_from_cache = true;
+                link_up(now_ms);
+            } else if (now_ms - assoc_ms >= WIFI_LINK_ARP_TIMEOUT_MS) {
+                printf("[Wi-Fi] Gateway em cache não respondeu, aguardando DHCP\n");
+                drop_cached_lease();
+                state = WIFI_WAIT_DHCP;
+            }
+            break;
+
+        case WIFI_WAIT_DHCP:
+            if (dhcp_supplied_address(sta_netif())) {
+                stats.last_dhcp_ms = now_ms - assoc_ms;
+                link_up(now_ms);
+                save_cache();
+            } else if (now_ms - assoc_ms >= WIFI_LINK_DHCP_TIMEOUT_MS) {
+                printf("[Wi-Fi] DHCP sem resposta\n");
+                retry_later(now_ms, false);
+            }
+            break;
+
+        case WIFI_UP:
+            if (cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) != CYW43_LINK_UP) {
+                printf("[Wi-Fi] Conexão perdida\n");
+                fast_attempt = false;
+                retry_later(now_ms, true);
+                break;
+            }
+            // Concessão em cache: registra a revalidação do DHCP quando ela chegar
+            if (stats.last_dhcp_ms == 0 && dhcp_supplied_address(sta_netif())) {
+                stats.last_dhcp_ms = now_ms - assoc_ms;
+                printf("[Wi-Fi] DHCP confirmou a concessão em %u ms\n", (unsigned)stats.last_dhcp_ms);
+                save_cache();
+            }
+            if (sample_rssi(now_ms)) {
+                start_roam_scan(now_ms);
+            }
+            break;
+
+        case WIFI_SCANNING:
+            if (!cyw43_wifi_scan_active(&cyw43_state)) {
+                finish_roam_scan(now_ms);
+            }
+            break;
+    }
+}
+
+bool wifi_link_connect_blocking(uint32_t timeout_ms) {
+    uint32_t start_ms = to_ms_since_boot(get_absolute_time());
+    uint32_t now_ms = start_ms;
+    while (!wifi_link_is_up() && now_ms - start_ms < timeout_ms) {
+        cyw43_arch_poll();
+        wifi_link_tick(now_ms);
+        sleep_ms(10);
+        now_ms = to_ms_since_boot(get_absolute_time());
+    }
+    return wifi_link_is_up();
+}
+
+bool wifi_link_is_up(void) {
+    return state == WIFI_UP || state == WIFI_SCANNING;
+}
+
+void wifi_link_get_stats(wifi_link_stats_t *out) {
+    *out = stats;
+}
@@ -0,0 +1,54 @@
+#ifndef WIFI_LINK_H
+#define WIFI_LINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Gerência da associação Wi-Fi com reconexão rápida: o BSSID, o canal e a concessão de IP
+ * da última conexão boa ficam em flash. A reconexão tenta primeiro o AP conhecido no canal
+ * conhecido (sem varredura) e reaproveita o IP após confirmar o gateway por ARP, enquanto o
+ * DHCP revalida em segundo plano. Qualquer falha recai na varredura completa com DHCP. */
+
+#define WIFI_LINK_FAST_JOIN_TIMEOUT_MS 3000
+#define WIFI_LINK_JOIN_TIMEOUT_MS      15000
+#define WIFI_LINK_ARP_TIMEOUT_MS       500
+#define WIFI_LINK_DHCP_TIMEOUT_MS      15000
+#define WIFI_LINK_RETRY_MS             5000
+
+/* Roaming: RSSI amostrado a cada 10 s (média móvel); abaixo do limiar por 1 min dispara uma
+ * varredura, e o rack só troca para outro AP do mesmo SSID pelo menos ROAM_MARGIN dB melhor. */
+#define WIFI_LINK_RSSI_PERIOD_MS       10000
+#define WIFI_LINK_ROAM_THRESHOLD_DBM   (-75)
+#define WIFI_LINK_ROAM_LOW_SAMPLES     6
+#define WIFI_LINK_ROAM_MARGIN_DB       8
+#define WIFI_LINK_ROAM_COOLDOWN_MS     300000
+
+typedef struct {
+    uint32_t connects;
+    uint32_t fast_joins;          // associações pelo BSSID/canal em cache
+    uint32_t fast_fallbacks;      // caminho rápido falhou e recaiu na varredura completa
+    uint32_t cached_leases;       // IP em cache confirmado pelo ARP do gateway
+    uint32_t last_assoc_ms;       // início da associação -> associado
+    uint32_t last_ip_ms;          // associado -> IP utilizável (cache ou DHCP)
+    uint32_t last_dhcp_ms;        // associado -> concessão DHCP (0 se ainda pendente)
+    int32_t rssi;                 // última leitura (dBm)
+    int32_t rssi_avg;             // média móvel (dBm)
+    int32_t rssi_min;             // pior leitura desde o boot (dBm)
+    uint32_t roam_scans;
+    uint32_t roams;
+    uint32_t last_roam_ms;        // saída do AP antigo -> IP utilizável no novo
+} wifi_link_stats_t;
+
+void wifi_link_init(const char *ssid, const char *password, uint32_t auth);
+
+// Avança a máquina de estados da associação; chamar a cada iteração do loop principal
+void wifi_link_tick(uint32_t now_ms);
+
+// Associação inicial: executa wifi_link_tick() até o IP estar utilizável ou o tempo esgotar
+bool wifi_link_connect_blocking(uint32_t timeout_ms);
+
+bool wifi_link_is_up(void);
+
+void wifi_link_get_stats(wifi_link_stats_t *stats);
+
+#endif /* WIFI_LINK_H */